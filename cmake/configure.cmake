@@ -213,6 +213,10 @@ if(WITH_HETERPS)
   add_definitions(-DPADDLE_WITH_HETERPS)
 endif()
 
+if(WITH_PS_SWISS_TABLE)
+  add_definitions(-DPADDLE_WITH_PS_SWISS_TABLE)
+endif()
+
 if(WITH_BRPC_RDMA)
   add_definitions(-DPADDLE_WITH_BRPC_RDMA)
 endif()
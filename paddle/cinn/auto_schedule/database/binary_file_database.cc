@@ -0,0 +1,149 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/auto_schedule/database/binary_file_database.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "paddle/cinn/auto_schedule/auto_schedule.pb.h"
+
+namespace cinn {
+namespace auto_schedule {
+
+namespace {
+
+constexpr char kMagic[] = "CINNTRC1";
+constexpr int64_t kMagicSize = sizeof(kMagic) - 1;
+
+bool ReadUint32(std::istream* is, uint32_t* value) {
+  return static_cast<bool>(
+      is->read(reinterpret_cast<char*>(value), sizeof(uint32_t)));
+}
+
+void WriteUint32(std::ostream* os, uint32_t value) {
+  os->write(reinterpret_cast<const char*>(&value), sizeof(uint32_t));
+}
+
+int64_t FileSize(const std::string& file_path) {
+  struct stat st;
+  if (stat(file_path.c_str(), &st) != 0) {
+    return -1;
+  }
+  return st.st_size;
+}
+
+}  // namespace
+
+BinaryFileDatabase::BinaryFileDatabase(int capacity_per_task,
+                                       const std::string& record_file_path)
+    : Database(capacity_per_task), record_file_path_(record_file_path) {
+  VLOG(3) << "Auto schedule will save/load tuning records on file:"
+          << record_file_path;
+  int64_t file_size = FileSize(record_file_path_);
+  if (file_size < 0) {
+    std::ofstream os(record_file_path_, std::ofstream::binary);
+    CHECK(os.good()) << "Cannot create new file: " << record_file_path_;
+    os.write(kMagic, kMagicSize);
+    file_size = kMagicSize;
+  }
+
+  reader_.open(record_file_path_, std::ifstream::binary);
+  CHECK(reader_.good()) << "Cannot open the file to read: "
+                        << record_file_path_;
+  char magic[kMagicSize];
+  CHECK(reader_.read(magic, kMagicSize) &&
+        std::memcmp(magic, kMagic, kMagicSize) == 0)
+      << "Not a tuning record file: " << record_file_path_;
+
+  // index the records by their task keys
+  int64_t valid_size = kMagicSize;
+  uint32_t key_size;
+  uint32_t record_size;
+  std::string task_key;
+  while (ReadUint32(&reader_, &key_size)) {
+    if (static_cast<int64_t>(reader_.tellg()) + key_size > file_size) {
+      break;
+    }
+    task_key.resize(key_size);
+    if (!reader_.read(&task_key[0], key_size) ||
+        !ReadUint32(&reader_, &record_size)) {
+      break;
+    }
+    int64_t offset = reader_.tellg();
+    if (offset + record_size > file_size) {
+      break;
+    }
+    reader_.seekg(record_size, std::ifstream::cur);
+    unloaded_records_[task_key].emplace_back(offset, record_size);
+    valid_size = offset + record_size;
+  }
+  if (valid_size < file_size) {
+    LOG(WARNING) << "Drop the incomplete tuning record at the end of "
+                 << record_file_path_;
+    CHECK_EQ(truncate(record_file_path_.c_str(), valid_size), 0)
+        << "Cannot truncate the file: " << record_file_path_;
+  }
+  reader_.clear();
+
+  writer_.open(record_file_path_,
+               std::ofstream::binary | std::ofstream::app);
+  CHECK(writer_.good()) << "Cannot open the file to write: "
+                        << record_file_path_;
+}
+
+void BinaryFileDatabase::LoadRecords(const std::string& task_key) {
+  auto it = unloaded_records_.find(task_key);
+  if (it == unloaded_records_.end()) {
+    return;
+  }
+  std::string buffer;
+  for (const auto& [offset, size] : it->second) {
+    buffer.resize(size);
+    reader_.seekg(offset);
+    CHECK(reader_.read(&buffer[0], size))
+        << "Failed to read the tuning record at " << offset << " of "
+        << record_file_path_;
+    proto::TuningRecord record_proto;
+    CHECK(record_proto.ParseFromString(buffer))
+        << "Failed to parse the tuning record at " << offset << " of "
+        << record_file_path_;
+    VLOG(4) << "Add a measured TuningRecord with task_key=" << task_key;
+    Insert(TuningRecord(record_proto));
+  }
+  unloaded_records_.erase(it);
+}
+
+void BinaryFileDatabase::LoadAllRecords() {
+  while (!unloaded_records_.empty()) {
+    LoadRecords(unloaded_records_.begin()->first);
+  }
+}
+
+bool BinaryFileDatabase::Commit(const TuningRecord& record) {
+  std::string buffer;
+  CHECK(record.ToProto().SerializeToString(&buffer))
+      << "Failed to serialize record, task key = " << record.task_key;
+  WriteUint32(&writer_, record.task_key.size());
+  writer_.write(record.task_key.data(), record.task_key.size());
+  WriteUint32(&writer_, buffer.size());
+  writer_.write(buffer.data(), buffer.size());
+  writer_.flush();
+  return writer_.good();
+}
+
+}  // namespace auto_schedule
+}  // namespace cinn
@@ -0,0 +1,69 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/cinn/auto_schedule/database/database.h"
+
+namespace cinn {
+namespace auto_schedule {
+
+// BinaryFileDatabase is a database implemented by an append-only binary file
+// to save/load underlying data, scaling to many more tasks than the JSON file.
+//
+// The file starts with a magic number, followed by the records in the order
+// they were added, each one as:
+//   uint32 key size | task key | uint32 record size | proto::TuningRecord
+// Only the task keys are read on opening, the records of a task are parsed
+// the first time the task is looked up. A record cut short by a crash while
+// it was appended is dropped from the end of the file.
+class BinaryFileDatabase : public Database {
+ public:
+  /*!
+   * \brief Build a BinaryFileDatabase object from a binary record file.
+   * \param capacity_per_task The max number of candidates stored.
+   * \param record_file_path The path of the record file, created if it is
+   * not found.
+   */
+  BinaryFileDatabase(int capacity_per_task,
+                     const std::string& record_file_path);
+  ~BinaryFileDatabase() override = default;
+
+ protected:
+  // append the newly added record to the record file
+  bool Commit(const TuningRecord& record) override;
+  // parse the records of task_key from the record file
+  void LoadRecords(const std::string& task_key) override;
+  // parse all the records not parsed yet from the record file
+  void LoadAllRecords() override;
+
+ private:
+  // the name of the binary file to save tuning records.
+  std::string record_file_path_;
+  std::ifstream reader_;
+  std::ofstream writer_;
+  // the (offset, size) in the file of the records not parsed yet of each task
+  std::unordered_map<std::string, std::vector<std::pair<int64_t, uint32_t>>>
+      unloaded_records_;
+};
+
+}  // namespace auto_schedule
+}  // namespace cinn
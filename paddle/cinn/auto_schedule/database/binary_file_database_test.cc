@@ -0,0 +1,110 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/auto_schedule/database/binary_file_database.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "paddle/cinn/auto_schedule/search_space/search_state.h"
+#include "paddle/cinn/ir/schedule/ir_schedule.h"
+
+namespace cinn {
+namespace auto_schedule {
+
+class TestBinaryFileDatabase : public ::testing::Test {
+ public:
+  void SetUp() override { std::remove(record_file_path.c_str()); }
+  void TearDown() override { std::remove(record_file_path.c_str()); }
+
+  // add the records of TestDatabase to a database of the file
+  void AddRecords() {
+    BinaryFileDatabase test_db(2, record_file_path);
+    auto state = SearchState(ir::IRSchedule());
+    test_db.AddRecord(TuningRecord("k1", state, 1.0));
+    test_db.AddRecord(TuningRecord("k2", state, 2.0));
+    test_db.AddRecord(TuningRecord("k2", state, 3.0));
+    test_db.AddRecord(TuningRecord("k3", state, 3.0));
+    test_db.AddRecord(TuningRecord("k3", state, 4.0));
+    test_db.AddRecord(TuningRecord("k3", state, 5.0));
+    test_db.AddRecord(TuningRecord("k4", state, 4.0));
+  }
+
+  std::string record_file_path = "/tmp/test_record.bin";
+};
+
+TEST_F(TestBinaryFileDatabase, SaveLoad) {
+  AddRecords();
+
+  BinaryFileDatabase test_db(2, record_file_path);
+  ASSERT_EQ(test_db.Count("k3"), 2);
+  auto records = test_db.LookUp("k3");
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].task_key, "k3");
+  EXPECT_EQ(records[0].execution_cost, 3.0);
+  EXPECT_EQ(records[1].execution_cost, 4.0);
+  ASSERT_EQ(test_db.Size(), 6);
+  ASSERT_TRUE(test_db.LookUp("k5").empty());
+}
+
+TEST_F(TestBinaryFileDatabase, AddToLoaded) {
+  AddRecords();
+
+  {
+    BinaryFileDatabase test_db(2, record_file_path);
+    // the stored records of k2 are loaded before the new one is added
+    test_db.AddRecord(
+        TuningRecord("k2", SearchState(ir::IRSchedule()), 0.5));
+    auto records = test_db.GetTopK("k2", 2);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].execution_cost, 0.5);
+    EXPECT_EQ(records[1].execution_cost, 2.0);
+  }
+
+  BinaryFileDatabase test_db(2, record_file_path);
+  auto records = test_db.GetTopK("k2", 1);
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0].execution_cost, 0.5);
+}
+
+TEST_F(TestBinaryFileDatabase, DropIncompleteRecord) {
+  AddRecords();
+  std::ifstream is(record_file_path,
+                   std::ifstream::binary | std::ifstream::ate);
+  int64_t file_size = is.tellg();
+  is.close();
+  // cut the last record short, as a crash while appending it would
+  ASSERT_EQ(truncate(record_file_path.c_str(), file_size - 3), 0);
+
+  {
+    BinaryFileDatabase test_db(2, record_file_path);
+    ASSERT_EQ(test_db.Count("k4"), 0);
+    ASSERT_EQ(test_db.Size(), 5);
+    test_db.AddRecord(
+        TuningRecord("k4", SearchState(ir::IRSchedule()), 6.0));
+  }
+
+  BinaryFileDatabase test_db(2, record_file_path);
+  auto records = test_db.LookUp("k4");
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0].execution_cost, 6.0);
+  ASSERT_EQ(test_db.Size(), 6);
+}
+
+}  // namespace auto_schedule
+}  // namespace cinn
@@ -18,6 +18,7 @@
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/json_util.h>
 
+#include "paddle/cinn/auto_schedule/database/binary_file_database.h"
 #include "paddle/cinn/auto_schedule/database/jsonfile_database.h"
 #include "paddle/cinn/auto_schedule/task/task_registry.h"
 #include "paddle/cinn/ir/schedule/ir_schedule.h"
@@ -52,6 +53,9 @@ std::unique_ptr<Database> Database::Make(const DatabaseConfig& config) {
   } else if (config.type == DatabaseType::kJSONFile) {
     return std::make_unique<JSONFileDatabase>(
         config.capacity_per_task, config.record_file_path, true);
+  } else if (config.type == DatabaseType::kBinaryFile) {
+    return std::make_unique<BinaryFileDatabase>(config.capacity_per_task,
+                                                config.record_file_path);
   }
 
   PADDLE_THROW(phi::errors::Unimplemented("Unimplemented database type."));
@@ -69,11 +73,13 @@ void Database::Insert(const TuningRecord& record) {
 bool Database::AddRecord(const TuningRecord& record) {
   CHECK(!record.task_key.empty()) << "task_key of TuningRecord can't be empty";
 
+  LoadRecords(record.task_key);
   Insert(record);
   return Commit(record);
 }
 
 std::vector<TuningRecord> Database::LookUp(const std::string& task_key) {
+  LoadRecords(task_key);
   auto fit = key2record_.find(task_key);
   if (fit == key2record_.end()) {
     return {};
@@ -87,6 +93,7 @@ std::vector<TuningRecord> Database::LookUp(const std::string& task_key) {
 
 std::vector<TuningRecord> Database::GetTopK(const std::string& task_key,
                                             int k) {
+  LoadRecords(task_key);
   auto fit = key2record_.find(task_key);
   if (fit == key2record_.end() || k <= 0) {
     return {};
@@ -110,6 +117,7 @@ std::vector<TuningRecord> Database::GetTopK(const std::string& task_key,
 }
 
 size_t Database::Size() {
+  LoadAllRecords();
   auto res = std::accumulate(key2record_.begin(),
                              key2record_.end(),
                              size_t(0),
@@ -120,6 +128,7 @@ size_t Database::Size() {
 }
 
 size_t Database::Count(const std::string& task_key) {
+  LoadRecords(task_key);
   auto fit = key2record_.find(task_key);
   if (fit == key2record_.end()) {
     return 0;
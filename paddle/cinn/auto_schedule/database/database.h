@@ -57,7 +57,7 @@ struct TuningRecord {
   };
 };
 
-enum class DatabaseType : int { kMemory, kJSONFile };
+enum class DatabaseType : int { kMemory, kJSONFile, kBinaryFile };
 
 struct DatabaseConfig {
   DatabaseType type = DatabaseType::kMemory;
@@ -72,7 +72,7 @@ struct DatabaseConfig {
 class Database {
  public:
   explicit Database(int capacity_per_task);
-  ~Database() = default;
+  virtual ~Database() = default;
 
   // Create a Database with the specific config
   static std::unique_ptr<Database> Make(const DatabaseConfig& config);
@@ -91,6 +91,10 @@ class Database {
  protected:
   // commit the newly added record into underlying storage
   virtual bool Commit(const TuningRecord& record) { return true; }
+  // load the records of task_key not in memory yet from underlying storage
+  virtual void LoadRecords(const std::string& task_key) {}
+  // load all the records not in memory yet from underlying storage
+  virtual void LoadAllRecords() {}
   // insert a newly added record into memory storage
   void Insert(const TuningRecord& record);
 
@@ -0,0 +1,332 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/auto_schedule/pir_group_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+
+#include "paddle/cinn/auto_schedule/database/binary_file_database.h"
+#include "paddle/cinn/auto_schedule/search_strategy/evolutionary_search.h"
+#include "paddle/cinn/auto_schedule/task/task_registry.h"
+#include "paddle/cinn/auto_schedule/task/tune_task.h"
+#include "paddle/cinn/backends/llvm/codegen_x86.h"
+#include "paddle/cinn/backends/llvm/execution_engine.h"
+#include "paddle/cinn/ir/module.h"
+#include "paddle/cinn/ir/schedule/ir_schedule.h"
+#include "paddle/cinn/ir/schedule/schedule_desc.h"
+#include "paddle/cinn/ir/utils/ir_copy.h"
+#include "paddle/cinn/runtime/cinn_runtime.h"
+#include "paddle/cinn/runtime/flags.h"
+#include "paddle/cinn/runtime/intrinsic.h"
+#include "paddle/cinn/utils/timer.h"
+#include "paddle/common/enforce.h"
+
+PD_DECLARE_string(cinn_tuning_record_path);
+PD_DECLARE_bool(auto_schedule_use_cost_model);
+
+namespace cinn {
+namespace auto_schedule {
+
+namespace {
+// The records kept of a task, the initial population of its next search.
+constexpr int kCapacityPerTask = 8;
+// The group schedule of a task is recorded with an empty trace, under the
+// key of the task with this suffix.
+constexpr char kDefaultScheduleSuffix[] = "@default";
+// The runs of a function measured, after a warmup run.
+constexpr int kMeasureRepeats = 10;
+// The rounds of search in a row without a valid schedule before giving up.
+constexpr int kMaxContinuousEmptyRounds = 3;
+
+using HostFunc = void (*)(void*, int32_t);
+
+cinn_buffer_t* NewRandomBuffer(const ir::Buffer& buffer) {
+  std::vector<int> shape;
+  for (const ir::Expr& dim : buffer->shape) {
+    PADDLE_ENFORCE_EQ(dim.is_constant(),
+                      true,
+                      phi::errors::InvalidArgument(
+                          "Only the groups of static shapes are tuned, but "
+                          "the shape of %s is dynamic.",
+                          buffer->name));
+    shape.push_back(static_cast<int>(dim.get_constant()));
+  }
+  cinn_buffer_t* data =
+      cinn_buffer_t::new_(cinn_device_kind_t::cinn_x86_device,
+                          runtime::ToRuntimeType(buffer->dtype),
+                          shape,
+                          32);
+  cinn_buffer_malloc(nullptr, data);
+  // Zeros keep the indices in range, and the floats away from the denormals.
+  std::memset(data->memory, 0, data->memory_size);
+  if (buffer->dtype.is_float(32)) {
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<float> dist(0.5f, 1.5f);
+    float* values = reinterpret_cast<float*>(data->memory);
+    std::generate_n(values, data->num_elements(), [&] { return dist(engine); });
+  }
+  return data;
+}
+
+// The names of the blocks the steps of a trace get by name.
+std::unordered_set<std::string> TraceBlockNames(
+    const ir::proto::ScheduleDesc& trace) {
+  std::unordered_set<std::string> names;
+  for (const auto& step : trace.steps()) {
+    for (const auto& attr : step.attrs()) {
+      if (attr.name() == "block_name") {
+        names.insert(attr.s());
+      }
+    }
+  }
+  return names;
+}
+
+std::unordered_set<std::string> BodyBlockNames(const ir::IRSchedule& ir_sch) {
+  std::unordered_set<std::string> names;
+  for (const ir::Expr& block : ir_sch.GetAllBlocks()) {
+    names.insert(block.As<ir::ScheduleBlockRealize>()
+                     ->schedule_block.As<ir::ScheduleBlock>()
+                     ->name);
+  }
+  return names;
+}
+}  // namespace
+
+PirGroupTuner::PirGroupTuner(const std::string& record_file_path)
+    : database_(std::make_unique<BinaryFileDatabase>(kCapacityPerTask,
+                                                     record_file_path)) {}
+
+PirGroupTuner* PirGroupTuner::Global() {
+  if (FLAGS_cinn_tuning_record_path.empty()) {
+    return nullptr;
+  }
+  static PirGroupTuner tuner(FLAGS_cinn_tuning_record_path);
+  return &tuner;
+}
+
+std::string PirGroupTuner::TaskKey(
+    const hlir::framework::pir::FusionInfo& fusion_info,
+    const cinn::common::Target& target) {
+  std::ostringstream os;
+  os << target << "-" << std::hex
+     << std::hash<std::string>()(fusion_info.SerializeToString());
+  return os.str();
+}
+
+bool PirGroupTuner::HasRecord(const std::string& task_key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !database_->GetTopK(task_key, 1).empty() ||
+         !database_->GetTopK(task_key + kDefaultScheduleSuffix, 1).empty();
+}
+
+std::optional<ir::Expr> PirGroupTuner::ApplyBest(const std::string& task_key,
+                                                 const ir::Expr& body) {
+  std::vector<TuningRecord> records;
+  std::vector<TuningRecord> default_records;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records = database_->GetTopK(task_key, 1);
+    default_records =
+        database_->GetTopK(task_key + kDefaultScheduleSuffix, 1);
+  }
+  if (records.empty() || (!default_records.empty() &&
+                          records[0].execution_cost >=
+                              default_records[0].execution_cost)) {
+    return std::nullopt;
+  }
+  try {
+    ir::IRSchedule ir_sch(ir::ModuleExpr({ir::ir_utils::IRCopy(body)}));
+    // The blocks are named after the values of the group, in the order the
+    // values are first named in the process, so the same group may name
+    // its blocks differently than when it was tuned.
+    const auto body_block_names = BodyBlockNames(ir_sch);
+    for (const auto& name : TraceBlockNames(records[0].trace)) {
+      if (!body_block_names.count(name)) {
+        LOG(WARNING) << "The tuned schedule of " << task_key
+                     << " gets block " << name
+                     << " the group does not have, the block names changed "
+                        "since it was tuned. The group schedule is applied "
+                        "instead, remove the records of the task from "
+                     << FLAGS_cinn_tuning_record_path << " to tune it again.";
+        return std::nullopt;
+      }
+    }
+    ir::ScheduleDesc::ReplayWithProto(records[0].trace, &ir_sch);
+    VLOG(3) << "Apply the tuned schedule of " << task_key << " of "
+            << records[0].execution_cost << " us";
+    return ir_sch.GetModule().GetExprs().front();
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to replay the tuned schedule of " << task_key
+                 << ": " << e.what();
+    return std::nullopt;
+  }
+}
+
+PirGroupTuner::TuneResult PirGroupTuner::Tune(
+    const std::string& task_key,
+    const ir::Expr& body,
+    const ir::Expr& default_body,
+    const cinn::common::Target& target,
+    const BuildFunction& build,
+    const TuningOptions& options) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cost_model_ == nullptr) {
+      cost_model_ = std::make_unique<ExprCostModel>();
+    }
+  }
+  InitialTaskRegistry::Global()->Regist(task_key, ir::ModuleExpr({body}));
+  TuneTask task;
+  task.target = target;
+  task.serialized_key = task_key;
+  task.lowered_funcs.push_back(
+      ir::_LoweredFunc_::Make(task_key, {}, ir::ir_utils::IRCopy(body), {}));
+
+  TuneResult result;
+  try {
+    result.default_cost =
+        Measure(build({ir::ir_utils::IRCopy(default_body)}), target)[0];
+    PADDLE_ENFORCE_EQ(std::isinf(result.default_cost),
+                      false,
+                      phi::errors::PreconditionNotMet(
+                          "The group schedule of %s failed to run.", task_key));
+    result.best_cost = result.default_cost;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      database_->AddRecord(TuningRecord(task_key + kDefaultScheduleSuffix,
+                                        SearchState(ir::IRSchedule()),
+                                        result.default_cost));
+    }
+    VLOG(3) << "Tune " << task_key << ", group schedule "
+            << result.default_cost << " us";
+
+    EvolutionarySearch search(task, *cost_model_, database_.get());
+    int measured_count = 0;
+    int continuous_empty_count = 0;
+    while (measured_count < options.num_measure_trials &&
+           continuous_empty_count <= kMaxContinuousEmptyRounds) {
+      // The search reads the records and the cost model.
+      std::vector<SearchState> states;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        states = search.SearchModuleExprEpsGreedy(options);
+      }
+      std::vector<SearchState> valid_states;
+      std::vector<ir::LoweredFunc> funcs;
+      for (const SearchState& state : states) {
+        try {
+          ir::Expr candidate = state->ir_schedule.GetModule().GetExprs()[0];
+          funcs.push_back(build({ir::ir_utils::IRCopy(candidate)}).front());
+          valid_states.push_back(state);
+        } catch (const std::exception& e) {
+          VLOG(4) << "Skip an invalid schedule of " << task_key << ": "
+                  << e.what();
+        }
+      }
+      if (valid_states.empty()) {
+        ++continuous_empty_count;
+        continue;
+      }
+      continuous_empty_count = 0;
+
+      std::vector<double> costs = Measure(funcs, target);
+      std::vector<const ir::ModuleExpr*> samples;
+      std::vector<float> labels;
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t i = 0; i < valid_states.size(); ++i) {
+        if (std::isinf(costs[i])) {
+          continue;
+        }
+        database_->AddRecord(TuningRecord(task_key, valid_states[i], costs[i]));
+        if (costs[i] < result.best_cost) {
+          result.best_cost = costs[i];
+          result.func_body =
+              valid_states[i]->ir_schedule.GetModule().GetExprs()[0];
+        }
+        samples.push_back(&valid_states[i]->ir_schedule.GetModule());
+        labels.push_back(costs[i]);
+      }
+      if (FLAGS_auto_schedule_use_cost_model && !samples.empty()) {
+        cost_model_->Update(samples, labels, target);
+      }
+      measured_count += valid_states.size();
+    }
+    VLOG(3) << "Tuned " << task_key << " with " << measured_count
+            << " schedules, the best " << result.best_cost << " us";
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to tune " << task_key << ": " << e.what();
+  }
+  return result;
+}
+
+std::vector<double> PirGroupTuner::Measure(
+    const std::vector<ir::LoweredFunc>& funcs,
+    const cinn::common::Target& target) {
+  ir::Module::Builder builder("pir_group_tuning", target);
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    ir::LoweredFunc func = funcs[i];
+    func->name = "candidate_" + std::to_string(i);
+    builder.AddFunction(func);
+  }
+  auto engine = backends::ExecutionEngine::Create(backends::ExecutionOptions());
+  engine->Link<backends::CodeGenX86>(builder.Build());
+
+  std::vector<cinn_buffer_t*> buffers;
+  std::vector<cinn_pod_value_t> args;
+  for (const ir::Argument& arg : funcs.front()->args) {
+    PADDLE_ENFORCE_EQ(arg.is_buffer(),
+                      true,
+                      phi::errors::InvalidArgument(
+                          "Only the groups of static shapes are tuned, but "
+                          "%s is a scalar argument.",
+                          arg.name()));
+    buffers.push_back(NewRandomBuffer(arg.buffer_arg()));
+    args.emplace_back(buffers.back());
+  }
+
+  // The measurements of the tunings in parallel would skew each other.
+  std::lock_guard<std::mutex> lock(measure_mutex_);
+  std::vector<double> costs;
+  for (const ir::LoweredFunc& func : funcs) {
+    auto fn = reinterpret_cast<HostFunc>(engine->Lookup(func->name));
+    if (fn == nullptr) {
+      LOG(WARNING) << "Failed to look up the candidate " << func->name;
+      costs.push_back(std::numeric_limits<double>::infinity());
+      continue;
+    }
+    fn(args.data(), args.size());
+    utils::Timer timer;
+    timer.Start();
+    for (int i = 0; i < kMeasureRepeats; ++i) {
+      fn(args.data(), args.size());
+    }
+    costs.push_back(timer.Stop() * 1000.0 / kMeasureRepeats);
+  }
+
+  for (cinn_buffer_t* buffer : buffers) {
+    cinn_buffer_free(nullptr, buffer);
+    cinn_buffer_t::delete_(buffer);
+  }
+  return costs;
+}
+
+}  // namespace auto_schedule
+}  // namespace cinn
@@ -0,0 +1,108 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/auto_schedule/cost_model/expr_cost_model.h"
+#include "paddle/cinn/auto_schedule/database/database.h"
+#include "paddle/cinn/auto_schedule/tuning.h"
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/hlir/framework/pir/fusion_info.h"
+#include "paddle/cinn/ir/ir.h"
+#include "paddle/cinn/ir/lowered_func.h"
+
+namespace cinn {
+namespace auto_schedule {
+
+/**
+ * Tunes the schedules of the fused groups of the PIR compilation on the
+ * host, and applies the best ones recorded at the next compilations.
+ *
+ * A group is a task keyed by its FusionInfo and the target. Its schedules
+ * are searched by EvolutionarySearch on the group function body before the
+ * group schedule, guided by an ExprCostModel learned from the measurements of
+ * all the tasks, and measured against the group schedule. The traces of the
+ * measured schedules are recorded to a BinaryFileDatabase, and the group is
+ * compiled with the best trace if it beats the group schedule.
+ */
+class PirGroupTuner {
+ public:
+  // Builds the functions of the group for scheduled function bodies, all
+  // with the same arguments.
+  using BuildFunction = std::function<std::vector<ir::LoweredFunc>(
+      const std::vector<ir::Expr>&)>;
+
+  explicit PirGroupTuner(const std::string& record_file_path);
+
+  // The tuner of the records at FLAGS_cinn_tuning_record_path, nullptr if
+  // the flag is empty.
+  static PirGroupTuner* Global();
+
+  // The key of the task of a group.
+  static std::string TaskKey(
+      const hlir::framework::pir::FusionInfo& fusion_info,
+      const cinn::common::Target& target);
+
+  // Whether the task is tuned, the group schedule winning or not.
+  bool HasRecord(const std::string& task_key);
+
+  // Returns the function body scheduled by the best recorded trace of the
+  // task, nullopt if none is recorded, the group schedule is faster, or the
+  // trace refers to blocks the body does not have.
+  std::optional<ir::Expr> ApplyBest(const std::string& task_key,
+                                    const ir::Expr& body);
+
+  struct TuneResult {
+    // The best schedule of the function body, if it runs faster than the
+    // group schedule.
+    std::optional<ir::Expr> func_body;
+    // The microseconds of the group schedule and of the best schedule.
+    double default_cost = 0;
+    double best_cost = 0;
+  };
+
+  // Searches and measures the schedules of the function body against
+  // default_body, the body scheduled by the group schedule.
+  TuneResult Tune(const std::string& task_key,
+                  const ir::Expr& body,
+                  const ir::Expr& default_body,
+                  const cinn::common::Target& target,
+                  const BuildFunction& build,
+                  const TuningOptions& options);
+
+ private:
+  // Returns the microseconds of the functions run on the same arguments,
+  // infinity for the functions failing to link.
+  std::vector<double> Measure(const std::vector<ir::LoweredFunc>& funcs,
+                              const cinn::common::Target& target);
+
+  // Guards the records and the cost model.
+  std::mutex mutex_;
+  // Held by the measurements, not to run concurrently.
+  std::mutex measure_mutex_;
+  std::unique_ptr<Database> database_;
+  // Created at the first tuning, not to load XGBoost when only the recorded
+  // traces are applied.
+  std::unique_ptr<ExprCostModel> cost_model_;
+};
+
+}  // namespace auto_schedule
+}  // namespace cinn
@@ -14,11 +14,17 @@
 
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #include <bitset>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 
+#include "paddle/cinn/auto_schedule/analysis/analyze_ir.h"
 #include "paddle/cinn/auto_schedule/auto_tuner.h"
+#include "paddle/cinn/auto_schedule/pir_group_tuner.h"
 #include "paddle/cinn/common/target.h"
 #include "paddle/cinn/frontend/net_builder.h"
 #include "paddle/cinn/frontend/optimize.h"
@@ -35,7 +41,8 @@
 #include "test/cpp/cinn/program_builder.h"
 
 /* This test is used as a tool to evaluate or compare performance of 3
- * schedules(no schedule, manual schedule, auto-schedule). One can specify which
+ * schedules(no schedule, manual schedule, auto-schedule), and the speedups of
+ * the host groups tuned by PirGroupTuner. One can specify which
  * schedules to be evaluated through `FLAGS_evaluate_knobs` and specify which
  * operator or model through `--gtest_filter=PerformanceTester.xx`, for example,
  * `FLAGS_evaluate_knobs=4
@@ -52,6 +59,8 @@ PD_DEFINE_string(resnet50_model_dir,
 // run no schedule test. Bit with index 1 controls manual schedule test, means
 // options = 2 = "010" will run manual schedule test. Bit with index 2 controls
 // auto schedule test, means options = 4 = "100" will run auto schedule test.
+// Bit with index 3 controls the host group tuning test, means options = 8 =
+// "1000" will tune the groups on the host and report their speedups.
 // The default value is -1, which means that this flag is disabled to set the
 // options
 PD_DEFINE_int32(evaluate_knobs,
@@ -76,9 +85,11 @@ class PerformanceTester : public ::testing::Test {
     int repeat_times = 2;
     // the num_tuning_rounds for auto tuning
     int num_tuning_rounds = 2;
+    // the num_measure_trials of the host group tuning
+    int num_host_tuning_trials = 20;
     // knobs to control which schedules will be measured, refer to
     // FLAGS_evaluate_knobs explanation
-    std::bitset<3> evaluate_knobs = 0UL;
+    std::bitset<4> evaluate_knobs = 0UL;
   };
 
   void Evaluate(const frontend::Program& program) {
@@ -87,9 +98,12 @@ class PerformanceTester : public ::testing::Test {
     }
     VLOG(3) << "evaluate_knobs = " << options_.evaluate_knobs;
 
-    auto worker_fn = [this, &program](const std::string& schedule_name,
-                                      BuildRuntimeProgramFn build_fn,
-                                      bool execute = true) {
+    // average milliseconds of the executed schedules
+    std::map<std::string, double> schedule_times;
+    auto worker_fn = [this, &program, &schedule_times](
+                         const std::string& schedule_name,
+                         BuildRuntimeProgramFn build_fn,
+                         bool execute = true) {
       Context::Global().ResetNameId();
       VLOG(3) << "Initialize graph.";
       auto graph = std::make_shared<hlir::framework::Graph>(program, target_);
@@ -103,7 +117,8 @@ class PerformanceTester : public ::testing::Test {
           (this->*build_fn)(graph.get(), graph_compiler.get());
       if (execute) {
         VLOG(3) << "Execute " << schedule_name << " program.";
-        runtime_program->ExecuteTest(options_.repeat_times);
+        schedule_times[schedule_name] =
+            runtime_program->ExecuteTest(options_.repeat_times);
       }
     };
 
@@ -128,6 +143,17 @@ class PerformanceTester : public ::testing::Test {
         worker_fn("auto schedule",
                   &PerformanceTester::BuildAutoScheduleProgram);
       }
+      if (options_.evaluate_knobs.test(3)) {
+        EvaluateHostGroupTuning(program);
+      }
+    }
+    if (schedule_times.count("manual schedule") &&
+        schedule_times.count("auto schedule")) {
+      LOG(INFO) << "manual schedule " << schedule_times["manual schedule"]
+                << " ms, auto schedule " << schedule_times["auto schedule"]
+                << " ms, speedup "
+                << schedule_times["manual schedule"] /
+                       schedule_times["auto schedule"];
     }
   }
 
@@ -210,6 +236,83 @@ class PerformanceTester : public ::testing::Test {
     return graph_compiler->Build();
   }
 
+  // Tunes each group with the tuner of the PIR compilation on the host, and
+  // reports the speedup of the tuned schedule over the group schedule.
+  void EvaluateHostGroupTuning(const frontend::Program& program) {
+    if (!std::holds_alternative<common::X86Arch>(target_.arch)) {
+      LOG(INFO) << "Skip the host group tuning on " << target_;
+      return;
+    }
+    Context::Global().ResetNameId();
+    auto graph = std::make_shared<hlir::framework::Graph>(program, target_);
+    hlir::framework::ApplyPass(graph.get(), "OpFusionPass");
+    const auto& dtype_dict =
+        graph->GetAttrs<absl::flat_hash_map<std::string, cinn::common::Type>>(
+            "inferdtype");
+    const auto& shape_dict = graph->GetAttrs<
+        absl::flat_hash_map<std::string, hlir::framework::shape_t>>(
+        "infershape");
+    auto op_lowerer =
+        hlir::framework::CreateOpLowerer(dtype_dict, shape_dict, target_);
+
+    // A path of its own, for the tests run in parallel not to share it.
+    char record_file_template[] = "/tmp/test_host_tuning_record_XXXXXX";
+    int record_fd = mkstemp(record_file_template);
+    ASSERT_GE(record_fd, 0);
+    close(record_fd);
+    const std::string record_file_path = record_file_template;
+    std::remove(record_file_path.c_str());
+    PirGroupTuner tuner(record_file_path);
+    TuningOptions tuning_options;
+    tuning_options.num_measure_trials = options_.num_host_tuning_trials;
+    tuning_options.num_samples_per_iteration = 4;
+
+    double total_default_cost = 0;
+    double total_best_cost = 0;
+    for (auto& group : graph->fusion_groups) {
+      std::vector<ir::LoweredFunc> init_funcs =
+          op_lowerer.Lower(group,
+                           /*apply_op_schedule = */ false,
+                           /*apply_group_schedule=*/false,
+                           /*apply_pass=*/false);
+      std::vector<ir::LoweredFunc> default_funcs =
+          op_lowerer.Lower(group,
+                           /*apply_op_schedule = */ true,
+                           /*apply_group_schedule=*/true,
+                           /*apply_pass=*/false);
+      if (init_funcs.size() != 1 || default_funcs.size() != 1) {
+        LOG(INFO) << "Skip the group " << group->GetFuncName() << " of "
+                  << init_funcs.size() << " functions";
+        continue;
+      }
+      auto build_fn = [&](const std::vector<ir::Expr>& bodies) {
+        std::vector<ir::LoweredFunc> funcs;
+        for (ir::Expr body : bodies) {
+          funcs.push_back(UpdateFuncWithNewBody(target_, init_funcs[0], body));
+        }
+        return funcs;
+      };
+      PirGroupTuner::TuneResult result = tuner.Tune(group->GetFuncName(),
+                                                    init_funcs[0]->body,
+                                                    default_funcs[0]->body,
+                                                    target_,
+                                                    build_fn,
+                                                    tuning_options);
+      LOG(INFO) << group->GetFuncName() << ": group schedule "
+                << result.default_cost << " us, tuned schedule "
+                << result.best_cost << " us, speedup "
+                << result.default_cost / result.best_cost;
+      total_default_cost += result.default_cost;
+      total_best_cost += result.best_cost;
+    }
+    if (total_best_cost > 0) {
+      LOG(INFO) << "All the groups: group schedule " << total_default_cost
+                << " us, tuned schedule " << total_best_cost
+                << " us, speedup " << total_default_cost / total_best_cost;
+    }
+    std::remove(record_file_path.c_str());
+  }
+
 #ifdef CINN_WITH_CUDA
   Target target_ = cinn::common::DefaultNVGPUTarget();
 #else
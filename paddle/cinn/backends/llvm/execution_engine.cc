@@ -16,7 +16,10 @@
 
 #include <absl/strings/string_view.h>
 #include <llvm/ADT/Triple.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/AsmParser/Parser.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/Config/llvm-config.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/Orc/Core.h>
@@ -34,8 +37,10 @@
 #include <llvm/PassRegistry.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Host.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
@@ -47,12 +52,16 @@
 #include <llvm/Transforms/Scalar/NewGVN.h>
 #include <llvm/Transforms/Scalar/Reassociate.h>
 #include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "paddle/cinn/backends/codegen_cuda_host.h"
 #include "paddle/cinn/backends/llvm/cinn_runtime_llvm_ir.h"
@@ -63,7 +72,12 @@
 #include "paddle/cinn/backends/llvm/runtime_symbol_registry.h"
 #include "paddle/cinn/ir/ir_printer.h"
 #include "paddle/cinn/runtime/intrinsic.h"
+#include "paddle/cinn/utils/multi_threading.h"
 #include "paddle/cinn/utils/profiler.h"
+#include "paddle/common/flags.h"
+
+PD_DECLARE_int32(cinn_llvm_compile_thread_num);
+PD_DECLARE_string(cinn_llvm_object_cache_dir);
 
 namespace cinn::backends {
 namespace {
@@ -86,25 +100,216 @@ void InitializeLLVMPasses() {
   // llvm::initializeTarget(registry);
   // llvm::initializeCodeGenPreparePass(registry);
 }
+
+// Splits m into up to num_parts modules of about as many instructions, each
+// defining a share of the external functions of m and its own copy of the
+// local ones, serialized to be compiled in a context of its own. Empty if m
+// is not worth splitting.
+std::vector<llvm::SmallVector<char, 0>> SplitModule(const llvm::Module &m,
+                                                    int num_parts) {
+  // Enough instructions for a partition to outweigh its cloning.
+  constexpr size_t kMinPartitionInstructions = 500;
+  std::vector<llvm::SmallVector<char, 0>> bitcodes;
+  if (num_parts <= 1 || !m.alias_empty() || !m.ifunc_empty()) {
+    return bitcodes;
+  }
+  for (auto &var : m.globals()) {
+    // The state of a mutable local variable can not be copied.
+    if (var.hasLocalLinkage() && !var.isConstant()) {
+      return bitcodes;
+    }
+  }
+  std::vector<const llvm::Function *> funcs;
+  size_t num_insts = 0;
+  for (auto &f : m) {
+    if (f.isDeclaration() || f.hasLocalLinkage() || f.isWeakForLinker()) {
+      continue;
+    }
+    funcs.push_back(&f);
+    num_insts += f.getInstructionCount();
+  }
+  num_parts = std::min<size_t>(
+      {static_cast<size_t>(num_parts),
+       funcs.size(),
+       num_insts / kMinPartitionInstructions});
+  if (num_parts <= 1) {
+    return bitcodes;
+  }
+
+  // The largest functions first, each to the smallest partition.
+  std::stable_sort(funcs.begin(),
+                   funcs.end(),
+                   [](const llvm::Function *a, const llvm::Function *b) {
+                     return a->getInstructionCount() >
+                            b->getInstructionCount();
+                   });
+  std::vector<size_t> part_insts(num_parts, 0);
+  std::unordered_map<const llvm::GlobalValue *, int> part_of;
+  for (auto *f : funcs) {
+    int part = std::min_element(part_insts.begin(), part_insts.end()) -
+               part_insts.begin();
+    part_of[f] = part;
+    part_insts[part] += f->getInstructionCount();
+  }
+
+  for (int i = 0; i < num_parts; ++i) {
+    llvm::ValueToValueMapTy vmap;
+    auto part =
+        llvm::CloneModule(m, vmap, [&](const llvm::GlobalValue *gv) {
+          if (gv->hasLocalLinkage() ||
+              (llvm::isa<llvm::Function>(gv) && gv->isWeakForLinker())) {
+            return true;
+          }
+          // The external variables are defined by the first partition.
+          auto it = part_of.find(gv);
+          return it == part_of.end() ? i == 0 : it->second == i;
+        });
+    // The copies of a weak function are local to their partition, not to
+    // clash in the JIT.
+    for (auto &f : *part) {
+      if (!f.isDeclaration() && f.isWeakForLinker()) {
+        f.setLinkage(llvm::GlobalValue::InternalLinkage);
+        f.setComdat(nullptr);
+      }
+    }
+    part->setModuleIdentifier(m.getModuleIdentifier() + ".part" +
+                              std::to_string(i));
+    bitcodes.emplace_back();
+    llvm::raw_svector_ostream os(bitcodes.back());
+    llvm::WriteBitcodeToFile(*part, os);
+  }
+  VLOG(3) << "Split the module of " << num_insts << " instructions into "
+          << num_parts << " partitions";
+  return bitcodes;
+}
+
+std::string HostDescription() {
+  llvm::StringMap<bool> host_features;
+  llvm::sys::getHostCPUFeatures(host_features);
+  std::vector<std::string> features;
+  for (auto &feature : host_features) {
+    if (feature.second) {
+      features.push_back(feature.first().str());
+    }
+  }
+  std::sort(features.begin(), features.end());
+  std::string host = std::string(LLVM_VERSION_STRING) + ";" +
+                     llvm::sys::getProcessTriple() + ";" +
+                     llvm::sys::getHostCPUName().str();
+  for (auto &feature : features) {
+    host += ";" + feature;
+  }
+  return host;
+}
 }  // namespace
-void NaiveObjectCache::notifyObjectCompiled(const llvm::Module *m,
-                                            llvm::MemoryBufferRef obj_buffer) {
-  cached_objects_[m->getModuleIdentifier()] =
-      llvm::MemoryBuffer::getMemBufferCopy(obj_buffer.getBuffer(),
-                                           obj_buffer.getBufferIdentifier());
+
+PersistentObjectCache::PersistentObjectCache(const std::string &cache_dir)
+    : host_(HostDescription()), cache_dir_(cache_dir) {
+  if (cache_dir_.empty()) return;
+  if (auto error = llvm::sys::fs::create_directories(cache_dir_)) {
+    LOG(WARNING) << "Failed to create the object cache directory "
+                 << cache_dir_ << ": " << error.message();
+    cache_dir_.clear();
+  }
 }
 
-std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
-    const llvm::Module *m) {
-  auto it = cached_objects_.find(m->getModuleIdentifier());
-  if (it == cached_objects_.end()) {
-    VLOG(1) << "No object for " << m->getModuleIdentifier()
-            << " in cache. Compiling.";
+std::string PersistentObjectCache::Key(const llvm::Module &m,
+                                       int opt_level) const {
+  std::string ir;
+  llvm::raw_string_ostream os(ir);
+  m.print(os, nullptr);
+  os.flush();
+  llvm::SHA1 hasher;
+  hasher.update(host_);
+  hasher.update(std::to_string(opt_level));
+  hasher.update(ir);
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+std::string PersistentObjectCache::ObjectPath(const std::string &key) const {
+  return cache_dir_ + "/" + key + ".o";
+}
+
+std::unique_ptr<llvm::MemoryBuffer> PersistentObjectCache::Get(
+    const std::string &key) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = cached_objects_.find(key);
+    if (it != cached_objects_.end()) {
+      VLOG(3) << "Object " << key << " loaded from memory.";
+      return llvm::MemoryBuffer::getMemBufferCopy(it->second->getBuffer(),
+                                                  key);
+    }
+  }
+  if (cache_dir_.empty()) {
     return nullptr;
   }
+  auto file = llvm::MemoryBuffer::getFile(ObjectPath(key));
+  if (!file) {
+    VLOG(3) << "No object " << key << " in cache. Compiling.";
+    return nullptr;
+  }
+  VLOG(3) << "Object " << key << " loaded from " << cache_dir_;
+  std::lock_guard<std::mutex> lock(mu_);
+  cached_objects_[key] =
+      llvm::MemoryBuffer::getMemBufferCopy((*file)->getBuffer(), key);
+  return std::move(*file);
+}
+
+void PersistentObjectCache::Put(const std::string &key,
+                                llvm::MemoryBufferRef obj) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    cached_objects_[key] =
+        llvm::MemoryBuffer::getMemBufferCopy(obj.getBuffer(), key);
+  }
+  if (cache_dir_.empty()) {
+    return;
+  }
+  // Written to a temporary file renamed to the object, the processes
+  // sharing cache_dir_ never reading a partial one.
+  int fd = -1;
+  llvm::SmallString<128> tmp_path;
+  if (auto error = llvm::sys::fs::createUniqueFile(
+          ObjectPath(key) + ".%%%%%%.tmp", fd, tmp_path)) {
+    LOG(WARNING) << "Failed to persist object " << key << ": "
+                 << error.message();
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << obj.getBuffer();
+  }
+  if (auto error = llvm::sys::fs::rename(tmp_path, ObjectPath(key))) {
+    LOG(WARNING) << "Failed to persist object " << key << ": "
+                 << error.message();
+    llvm::sys::fs::remove(tmp_path);
+  }
+}
 
-  VLOG(3) << "Object for " << m->getModuleIdentifier() << " loaded from cache.";
-  return llvm::MemoryBuffer::getMemBuffer(it->second->getMemBufferRef());
+void PersistentObjectCache::notifyObjectCompiled(
+    const llvm::Module *m, llvm::MemoryBufferRef obj_buffer) {
+  std::string key;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = pending_keys_.find(m);
+    if (it == pending_keys_.end()) return;
+    key = std::move(it->second);
+    pending_keys_.erase(it);
+  }
+  Put(key, obj_buffer);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> PersistentObjectCache::getObject(
+    const llvm::Module *m) {
+  // Keyed before the compile layer lowers m, for notifyObjectCompiled.
+  std::string key = Key(*m, /*opt_level=*/-1);
+  auto obj = Get(key);
+  if (obj == nullptr) {
+    std::lock_guard<std::mutex> lock(mu_);
+    pending_keys_[m] = std::move(key);
+  }
+  return obj;
 }
 
 /*static*/ std::unique_ptr<ExecutionEngine> ExecutionEngine::Create(
@@ -125,6 +330,15 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
 
   auto engine = std::make_unique<ExecutionEngine>(/*enable_object_cache=*/true,
                                                   std::move(module_symbols));
+  engine->opt_level_ = config.opt_level;
+  engine->num_compile_threads_ =
+      std::max(config.num_compile_threads > 0
+                   ? config.num_compile_threads
+                   : FLAGS_cinn_llvm_compile_thread_num,
+               1);
+  engine->cache_ = std::make_unique<PersistentObjectCache>(
+      config.object_cache_dir.empty() ? FLAGS_cinn_llvm_object_cache_dir
+                                      : config.object_cache_dir);
 
   auto compile_layer_creator =
       [&engine](llvm::orc::JITTargetMachineBuilder jtmb)
@@ -182,26 +396,28 @@ void ExecutionEngine::Link(const ir::Module &module) {
   ir_emitter->Compile(module);
   VLOG(3) << "ir_emitter->Compile(module) Succeed!";
   CHECK(!llvm::verifyModule(*m, &llvm::errs())) << "Invalid module found";
+  // Done with m before it may be kept, and freed by the next Link.
+  ir_emitter.reset();
+  b.reset();
 
-  auto machine = std::move(llvm::cantFail(
-      llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())
-          .createTargetMachine()));
-  LLVMModuleOptimizer optimize(machine.get(), 3, {}, true);
-  optimize(m.get());
-  CHECK(!llvm::verifyModule(*m, &llvm::errs()))
-      << "Invalid optimized module detected";
-  for (auto &f : *m) {
-    VLOG(5) << "function: " << DumpToString(f);
+  std::string object_key;
+  auto objects = CompileModule(m.get(), &object_key);
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    // For ExportObject, the object of a module compiled whole is in the
+    // cache, a split module is left as is and only compiled whole on export.
+    module_.reset();
+    module_context_.reset();
+    module_object_key_ = std::move(object_key);
+    if (module_object_key_.empty()) {
+      module_context_ = std::move(ctx);
+      module_ = std::move(m);
+    }
+    for (auto &obj : objects) {
+      llvm::cantFail(jit_->addObjectFile(std::move(obj)));
+    }
   }
 
-  llvm::raw_svector_ostream rawstream(buffer_);
-  llvm::legacy::PassManager pass_manager;
-  machine->addPassesToEmitFile(
-      pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
-  pass_manager.run(*m);
-
-  CHECK(AddModule(std::move(m), std::move(ctx)));
-
   if (VLOG_IS_ON(5)) {
     VLOG(5) << "======= dump jit execution session ======";
     std::string buffer;
@@ -232,9 +448,74 @@ bool ExecutionEngine::AddModule(std::unique_ptr<llvm::Module> module,
   return true;
 }
 
+std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+ExecutionEngine::CompileModule(llvm::Module *module, std::string *key) {
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+  auto bitcodes = SplitModule(*module, num_compile_threads_);
+  if (bitcodes.empty()) {
+    objects.push_back(CompilePartition(module, key));
+    return objects;
+  }
+  objects.resize(bitcodes.size());
+  auto worker_fn = [&](int index) {
+    llvm::LLVMContext context;
+    auto part = llvm::cantFail(llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(
+            llvm::StringRef(bitcodes[index].data(), bitcodes[index].size()),
+            "partition"),
+        context));
+    std::string part_key;
+    objects[index] = CompilePartition(part.get(), &part_key);
+  };
+  utils::parallel_run(worker_fn,
+                      utils::SequenceDispatcher(0, bitcodes.size()),
+                      bitcodes.size());
+  return objects;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> ExecutionEngine::CompilePartition(
+    llvm::Module *module, std::string *key) {
+  auto machine = std::move(llvm::cantFail(
+      llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())
+          .createTargetMachine()));
+  module->setTargetTriple(machine->getTargetTriple().str());
+  module->setDataLayout(machine->createDataLayout());
+  *key = cache_->Key(*module, opt_level_);
+  if (auto obj = cache_->Get(*key)) {
+    return obj;
+  }
+
+  LLVMModuleOptimizer optimize(machine.get(), opt_level_, {}, true);
+  optimize(module);
+  CHECK(!llvm::verifyModule(*module, &llvm::errs()))
+      << "Invalid optimized module detected";
+  for (auto &f : *module) {
+    VLOG(5) << "function: " << DumpToString(f);
+  }
+
+  llvm::SmallVector<char, 0> buffer;
+  llvm::raw_svector_ostream rawstream(buffer);
+  llvm::legacy::PassManager pass_manager;
+  machine->addPassesToEmitFile(
+      pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
+  pass_manager.run(*module);
+  auto obj = std::make_unique<llvm::SmallVectorMemoryBuffer>(std::move(buffer));
+  cache_->Put(*key, obj->getMemBufferRef());
+  return obj;
+}
+
 void ExecutionEngine::ExportObject(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (module_ != nullptr) {
+    CompilePartition(module_.get(), &module_object_key_);
+    module_.reset();
+    module_context_.reset();
+  }
+  CHECK(!module_object_key_.empty()) << "No module linked to export";
+  auto obj = cache_->Get(module_object_key_);
+  CHECK(obj != nullptr) << "No object of the module linked to export";
   FILE *of = fopen(path.c_str(), "w");
-  fwrite(buffer_.data(), 1, buffer_.size(), of);
+  fwrite(obj->getBufferStart(), 1, obj->getBufferSize(), of);
   fclose(of);
 }
 
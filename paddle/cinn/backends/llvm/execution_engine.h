@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
@@ -41,6 +42,7 @@
 #include <mutex>  // NOLINT
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "paddle/cinn/backends/llvm/codegen_x86.h"
@@ -50,21 +52,47 @@
 
 namespace cinn::backends {
 
-class NaiveObjectCache : public llvm::ObjectCache {
+// Caches the compiled objects by a hash of their LLVM IR and of the host,
+// in memory and, if cache_dir is not empty, as the files of cache_dir, so
+// that the processes compiling the same modules on the same host skip LLVM.
+class PersistentObjectCache : public llvm::ObjectCache {
  public:
+  explicit PersistentObjectCache(const std::string &cache_dir = "");
+
   void notifyObjectCompiled(const llvm::Module *,
                             llvm::MemoryBufferRef) override;
   std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override;
 
+  // The key of the object of m optimized at opt_level, -1 for m compiled
+  // without the LLVMModuleOptimizer.
+  std::string Key(const llvm::Module &m, int opt_level) const;
+  std::unique_ptr<llvm::MemoryBuffer> Get(const std::string &key);
+  void Put(const std::string &key, llvm::MemoryBufferRef obj);
+
  private:
+  std::string ObjectPath(const std::string &key) const;
+
+  // The llvm version and the host cpu the objects are compiled for.
+  std::string host_;
+  std::string cache_dir_;
+  std::mutex mu_;
   llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> cached_objects_;
+  // The keys of the modules being compiled by the compile layer.
+  std::unordered_map<const llvm::Module *, std::string> pending_keys_;
 };
 
 struct ExecutionOptions {
   int opt_level{3};
   bool enable_debug_info{false};
+  // The threads to optimize and compile a linked module with, the module
+  // split into as many partitions if large enough. The groups are already
+  // compiled in parallel, so it is 1 unless they are few and large.
+  // FLAGS_cinn_llvm_compile_thread_num if 0.
+  int num_compile_threads{0};
+  // The directory the compiled objects persist in.
+  // FLAGS_cinn_llvm_object_cache_dir if empty, not persisted if both are.
+  std::string object_cache_dir;
   // TODO(fc500110)
-  // int num_compile_threads{1};
   // bool enable_fast_math;
 };
 
@@ -81,6 +109,7 @@ class ExecutionEngine {
   template <typename CodeGenT = CodeGenLLVM>
   void Link(const ir::Module &module);
 
+  // Writes the object of the last linked module to path, compiled unsplit.
   void ExportObject(const std::string &path);
 
   bool AddModule(std::unique_ptr<llvm::Module> module,
@@ -89,22 +118,35 @@ class ExecutionEngine {
  protected:
   explicit ExecutionEngine(bool enable_object_cache,
                            RuntimeSymbols &&module_symbols)
-      : cache_(std::make_unique<NaiveObjectCache>()),
-        module_symbols_(std::move(module_symbols)) {}
+      : module_symbols_(std::move(module_symbols)) {}
 
   void RegisterRuntimeSymbols();
 
   bool SetupTargetTriple(llvm::Module *module);
 
+  // Optimizes and compiles module, split over num_compile_threads_ threads,
+  // to the objects of its partitions. key is set to the cache key of the
+  // object if module is compiled whole, and left empty otherwise.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> CompileModule(
+      llvm::Module *module, std::string *key);
+  std::unique_ptr<llvm::MemoryBuffer> CompilePartition(llvm::Module *module,
+                                                       std::string *key);
+
   // This may not be a compatible implementation.
   friend std::unique_ptr<ExecutionEngine> std::make_unique<ExecutionEngine>(
       bool &&, cinn::backends::RuntimeSymbols &&);
 
  private:
   mutable std::mutex mu_;
-  llvm::SmallString<0> buffer_;
+  int opt_level_{3};
+  int num_compile_threads_{1};
+  // The cache key of the object of the last linked module if compiled
+  // whole, else the module itself, unoptimized.
+  std::string module_object_key_;
+  std::unique_ptr<llvm::LLVMContext> module_context_;
+  std::unique_ptr<llvm::Module> module_;
   std::unique_ptr<llvm::orc::LLJIT> jit_;
-  std::unique_ptr<NaiveObjectCache> cache_;
+  std::unique_ptr<PersistentObjectCache> cache_;
   RuntimeSymbols module_symbols_;
 };
 
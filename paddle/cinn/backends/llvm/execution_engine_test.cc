@@ -24,6 +24,7 @@
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/raw_ostream.h>
 
@@ -348,5 +349,85 @@ TEST(ExecutionEngine, call_extern) {
   }
 }
 
+TEST(ExecutionEngine, parallel_link_and_object_cache) {
+  // Enough functions for the module to be split over the compile threads.
+  constexpr int kNumFuncs = 64;
+  ir::Module::Builder builder("parallel_module",
+                              cinn::common::DefaultHostTarget());
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+  for (int k = 0; k < kNumFuncs; ++k) {
+    lang::Placeholder<float> a("A", {M, N});
+    lang::Placeholder<float> b("B", {M, N});
+    Expr scale(static_cast<float>(k));
+    auto c = lang::Compute(
+        {M, N}, [&](auto i, auto j) { return a(i, j) * scale + b(i, j); }, "C");
+    auto stages = CreateStages({c});
+    builder.AddFunction(
+        lang::Lower("fn_" + std::to_string(k), stages, {a, b, c}, {}));
+  }
+  auto module = builder.Build();
+
+  llvm::SmallString<128> cache_dir;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("cinn_object_cache", cache_dir));
+  backends::ExecutionOptions options;
+  options.num_compile_threads = 4;
+  options.object_cache_dir = cache_dir.str().str();
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab = std::get<0>(_ab_bb_cb_);
+  auto &bb = std::get<1>(_ab_bb_cb_);
+  auto &cb = std::get<2>(_ab_bb_cb_);
+  auto run_and_check = [&](backends::ExecutionEngine *engine) {
+    for (int k = 0; k < kNumFuncs; ++k) {
+      auto fn = reinterpret_cast<void (*)(void *, int32_t)>(
+          engine->Lookup("fn_" + std::to_string(k)));
+      ASSERT_NE(fn, nullptr);
+      cinn_pod_value_t args[3] = {cinn_pod_value_t(ab),
+                                  cinn_pod_value_t(bb),
+                                  cinn_pod_value_t(cb)};
+      fn(args, 3);
+      auto *ad = reinterpret_cast<float *>(ab->memory);
+      auto *bd = reinterpret_cast<float *>(bb->memory);
+      auto *cd = reinterpret_cast<float *>(cb->memory);
+      for (int i = 0; i < kM * kN; ++i) {
+        ASSERT_NEAR(cd[i], ad[i] * k + bd[i], 1e-5);
+      }
+    }
+  };
+
+  auto engine = backends::ExecutionEngine::Create(options);
+  engine->Link<CodeGenX86>(module);
+  run_and_check(engine.get());
+
+  int num_objects = 0;
+  std::error_code error;
+  for (llvm::sys::fs::directory_iterator it(cache_dir, error), end;
+       it != end && !error;
+       it.increment(error)) {
+    if (llvm::StringRef(it->path()).endswith(".o")) ++num_objects;
+  }
+  // One cached object per partition.
+  EXPECT_GT(num_objects, 1);
+
+  // The partitions are exported as one object.
+  llvm::SmallString<128> object_path(cache_dir);
+  llvm::sys::path::append(object_path, "exported.obj");
+  engine->ExportObject(object_path.str().str());
+  EXPECT_TRUE(llvm::sys::fs::exists(object_path));
+  EXPECT_FALSE(llvm::sys::fs::exists(llvm::Twine(object_path) + ".1"));
+  uint64_t object_size = 0;
+  ASSERT_FALSE(llvm::sys::fs::file_size(object_path, object_size));
+  EXPECT_GT(object_size, 0UL);
+
+  // Linked from the persisted objects by an engine of its own.
+  auto cached_engine = backends::ExecutionEngine::Create(options);
+  cached_engine->Link<CodeGenX86>(module);
+  run_and_check(cached_engine.get());
+
+  llvm::sys::fs::remove_directories(cache_dir);
+}
+
 }  // namespace backends
 }  // namespace cinn
@@ -109,11 +109,16 @@ struct CINNKernelInfoAttributeStorage : public pir::AttributeStorage {
   }
 
   static std::size_t HashValue(const ParamKey& key) {
+    // The kernel compiled in the background has no fn_ptr until compiled.
+    if (key.fn_ptr == nullptr) {
+      return std::hash<const void*>()(key.async_kernel.get());
+    }
     return std::hash<int64_t>()(*(reinterpret_cast<int64_t*>(key.fn_ptr)));
   }
 
   bool operator==(const ParamKey& key) const {
-    return data_.fn_ptr == key.fn_ptr;
+    return data_.fn_ptr == key.fn_ptr &&
+           data_.async_kernel.get() == key.async_kernel.get();
   }
 
   const ParamKey& GetAsKey() const { return data_; }
@@ -40,6 +40,7 @@
 #include "paddle/cinn/hlir/dialect/operator/transforms/group_merge/move_generate_shape_ops_to_prologue_pass.h"
 #include "paddle/cinn/hlir/dialect/operator/transforms/group_merge/simplify_dim_expr_pass.h"
 #include "paddle/cinn/hlir/dialect/operator/transforms/group_merge/single_op_fallback_to_phi.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/horizontal_fusion_pass.h"
 #include "paddle/cinn/hlir/dialect/operator/transforms/insert_broadcast_pass.h"
 #include "paddle/cinn/hlir/dialect/operator/transforms/lowering_pass/lower_cinn_fusion_op_pass.h"
 #include "paddle/cinn/hlir/dialect/operator/transforms/pd_to_cinn_pass.h"
@@ -54,6 +55,7 @@ COMMON_DECLARE_bool(disable_dyshape_in_train);
 COMMON_DECLARE_bool(enable_cinn_accuracy_check);
 COMMON_DECLARE_bool(enable_fuse_parallel_matmul_pass);
 PD_DECLARE_bool(group_schedule_tiling_first);
+PD_DECLARE_bool(cinn_enable_horizontal_fusion);
 
 namespace cinn::dialect::ir {
 
@@ -217,6 +219,27 @@ int64_t GetOpCount(const ::pir::Operation* op) {
   return count;
 }
 
+// The trivial patterns of a group are only fused horizontally by the tiling
+// first group scheduler.
+void ApplyHorizontalFusionPass(
+    ::pir::Program* program,
+    const std::function<std::shared_ptr<pir::PassManager>()>&
+        CreatePassManager) {
+  if (!FLAGS_cinn_enable_horizontal_fusion ||
+      !FLAGS_group_schedule_tiling_first) {
+    return;
+  }
+  const int64_t num_fusion_ops =
+      GetOpCount<cinn::dialect::FusionOp>(program->module_op());
+  std::shared_ptr<pir::PassManager> pass_manager = CreatePassManager();
+  pass_manager->AddPass(cinn::dialect::ir::CreateHorizontalFusionPass());
+  pass_manager->Run(program);
+  LOG(INFO) << "FusionOp count before/after horizontal fusion : *****[ "
+            << num_fusion_ops << " / "
+            << GetOpCount<cinn::dialect::FusionOp>(program->module_op())
+            << " ]*****";
+}
+
 void ApplyCinnPass(::pir::Program* program,
                    const std::function<std::shared_ptr<pir::PassManager>()>&
                        CreatePassManager) {
@@ -226,6 +249,7 @@ void ApplyCinnPass(::pir::Program* program,
   PirToPyCodeConverter().SaveIfFlagEnabled("group_op_programs", *program);
   ApplyGroupOpPass(program, CreatePassManager);
   ApplyDivideGroupOpToFusionOpPass(program, CreatePassManager);
+  ApplyHorizontalFusionPass(program, CreatePassManager);
   PirToPyCodeConverter().SaveIfFlagEnabled("fusion_op_programs", *program);
   LOG(INFO) << "FusionOp count before lowering : *****[ "
             << GetOpCount<cinn::dialect::FusionOp>(program->module_op())
@@ -22,6 +22,7 @@
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
 #include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/dialect/operator/utils/utils.h"
 #include "paddle/pir/include/core/builtin_dialect.h"
 namespace cinn::dialect::details {
 
@@ -36,6 +37,16 @@ pir::Attribute ArrayAttributeToIntArrayAttribute(
   return attr_data;
 }
 
+std::vector<int64_t> GetInt64ArrayAttributeData(::pir::Operation* op,
+                                                const std::string& name) {
+  std::vector<int64_t> data;
+  const auto& array_attr = op->attribute<::pir::ArrayAttribute>(name);
+  for (size_t i = 0; i < array_attr.size(); ++i) {
+    data.push_back(array_attr.at(i).dyn_cast<::pir::Int64Attribute>().data());
+  }
+  return data;
+}
+
 const auto& handler_reduce_max_op =
     [&](::pir::Operation* op,
         const ::pir::Builder& builder) -> ::pir::Operation* {
@@ -58,6 +69,166 @@ const auto& handler_reduce_max_op =
   return pd_op;
 };
 
+const auto& handler_reduce_min_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::ReduceMinOp>();
+  auto attr = cinn_op.attributes();
+
+  pir::Attribute attr_axis = ArrayAttributeToIntArrayAttribute(
+      attr.at("dim").dyn_cast<::pir::ArrayAttribute>());
+  attr.insert({"axis", attr_axis});
+  attr.insert({"keepdim", attr["keep_dim"]});
+  attr.erase("dim");
+  attr.erase("keep_dim");
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::MinOp>(
+          cinn_op.operand_source(0), attr);
+  return pd_op;
+};
+
+const auto& handler_reduce_sum_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::ReduceSumOp>();
+  auto attr = cinn_op.attributes();
+
+  pir::Attribute attr_axis = ArrayAttributeToIntArrayAttribute(
+      attr.at("dim").dyn_cast<::pir::ArrayAttribute>());
+  attr.insert({"axis", attr_axis});
+  attr.insert({"keepdim", attr["keep_dim"]});
+  // The dtype of the sum is folded into the type of the result of reduce_sum.
+  attr.insert(
+      {"dtype",
+       paddle::dialect::DataTypeAttribute::get(
+           pir::IrContext::Instance(),
+           paddle::dialect::TransToPhiDataType(
+               cinn_op.result(0)
+                   .type()
+                   .dyn_cast<paddle::dialect::DenseTensorType>()
+                   .dtype()))});
+  attr.erase("dim");
+  attr.erase("keep_dim");
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::SumOp>(
+          cinn_op.operand_source(0), attr);
+  return pd_op;
+};
+
+const auto& handler_reduce_prod_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::ReduceProdOp>();
+  auto attr = cinn_op.attributes();
+
+  pir::Attribute attr_dims = ArrayAttributeToIntArrayAttribute(
+      attr.at("dim").dyn_cast<::pir::ArrayAttribute>());
+  attr.insert({"dims", attr_dims});
+  attr.insert({"reduce_all",
+               ::pir::BoolAttribute::get(pir::IrContext::Instance(), false)});
+  attr.erase("dim");
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::ProdOp>(
+          cinn_op.operand_source(0), attr);
+  return pd_op;
+};
+
+const auto& handler_reshape_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::ReshapeOp>();
+  std::vector<int64_t> shape;
+  const auto& shape_attr = op->attribute<::pir::ArrayAttribute>("shape");
+  for (size_t i = 0; i < shape_attr.size(); ++i) {
+    shape.push_back(shape_attr.at(i).dyn_cast<::pir::Int32Attribute>().data());
+  }
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::ReshapeOp>(
+          cinn_op.operand_source(0), shape);
+  return pd_op;
+};
+
+const auto& handler_scale_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::ScaleOp>();
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::ScaleOp>(
+          cinn_op.operand_source(0),
+          op->attribute<::pir::FloatAttribute>("scale").data(),
+          op->attribute<::pir::FloatAttribute>("bias").data(),
+          op->attribute<::pir::BoolAttribute>("bias_after_scale").data());
+  return pd_op;
+};
+
+const auto& handler_broadcast_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::BroadcastOp>();
+  const std::vector<int64_t> broadcast_axes =
+      GetInt64ArrayAttributeData(op, "broadcast_axes");
+  const std::vector<int64_t> out_shape =
+      GetInt64ArrayAttributeData(op, "out_shape");
+
+  // expand aligns the dims of x to the trailing dims of out_shape, -1 keeping
+  // the dim of x.
+  const int64_t offset =
+      static_cast<int64_t>(out_shape.size() - broadcast_axes.size());
+  for (size_t i = 0; i < broadcast_axes.size(); ++i) {
+    PADDLE_ENFORCE_EQ(
+        broadcast_axes[i],
+        offset + static_cast<int64_t>(i),
+        ::common::errors::Unimplemented(
+            "Only the broadcast to the trailing dims can be transformed to "
+            "expand, but axis %d of x is broadcast to dim %d.",
+            i,
+            broadcast_axes[i]));
+  }
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::ExpandOp>(
+          cinn_op.operand_source(0), out_shape);
+  return pd_op;
+};
+
+const auto& handler_slice_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto cinn_op = op->dyn_cast<cinn::dialect::SliceOp>();
+
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::SliceOp>(
+          cinn_op.operand_source(0),
+          GetInt64ArrayAttributeData(op, "axes"),
+          GetInt64ArrayAttributeData(op, "starts"),
+          GetInt64ArrayAttributeData(op, "ends"),
+          GetInt64ArrayAttributeData(op, "infer_flags"),
+          GetInt64ArrayAttributeData(op, "decrease_axis"));
+  return pd_op;
+};
+
+const auto& handler_yield_store_op =
+    [&](::pir::Operation* op,
+        const ::pir::Builder& builder) -> ::pir::Operation* {
+  VLOG(6) << "transform " << op->name() << " from cinn_op to pd_op";
+  auto pd_op =
+      const_cast<::pir::Builder*>(&builder)->Build<paddle::dialect::AssignOp>(
+          op->operand_source(0));
+  return pd_op;
+};
+
 bool CanApplyOn(::pir::Operation* op) {
   return op->dialect()->name() == "cinn_op";
 }
@@ -108,3 +279,27 @@ void RewriteCinnOpToPdOp(const ::pir::Block& src_block,
 REGISTER_TRANSFORM_RULES(reduce_max_op,
                          cinn::dialect::ReduceMaxOp::name(),
                          cinn::dialect::details::handler_reduce_max_op);
+REGISTER_TRANSFORM_RULES(reduce_min_op,
+                         cinn::dialect::ReduceMinOp::name(),
+                         cinn::dialect::details::handler_reduce_min_op);
+REGISTER_TRANSFORM_RULES(reduce_sum_op,
+                         cinn::dialect::ReduceSumOp::name(),
+                         cinn::dialect::details::handler_reduce_sum_op);
+REGISTER_TRANSFORM_RULES(reduce_prod_op,
+                         cinn::dialect::ReduceProdOp::name(),
+                         cinn::dialect::details::handler_reduce_prod_op);
+REGISTER_TRANSFORM_RULES(reshape_op,
+                         cinn::dialect::ReshapeOp::name(),
+                         cinn::dialect::details::handler_reshape_op);
+REGISTER_TRANSFORM_RULES(scale_op,
+                         cinn::dialect::ScaleOp::name(),
+                         cinn::dialect::details::handler_scale_op);
+REGISTER_TRANSFORM_RULES(broadcast_op,
+                         cinn::dialect::BroadcastOp::name(),
+                         cinn::dialect::details::handler_broadcast_op);
+REGISTER_TRANSFORM_RULES(slice_op,
+                         cinn::dialect::SliceOp::name(),
+                         cinn::dialect::details::handler_slice_op);
+REGISTER_TRANSFORM_RULES(yield_store_op,
+                         cinn::dialect::YieldStoreOp::name(),
+                         cinn::dialect::details::handler_yield_store_op);
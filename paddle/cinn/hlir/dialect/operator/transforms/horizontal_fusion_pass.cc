@@ -0,0 +1,388 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/hlir/dialect/operator/transforms/horizontal_fusion_pass.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/cinn/hlir/dialect/operator/ir/attribute_storage.h"
+#include "paddle/cinn/hlir/dialect/operator/ir/cinn_op.h"
+#include "paddle/cinn/hlir/dialect/operator/ir/manual_op.h"
+#include "paddle/cinn/hlir/dialect/operator/ir/op_attribute.h"
+#include "paddle/cinn/hlir/framework/pir/utils.h"
+#include "paddle/cinn/runtime/flags.h"
+#include "paddle/common/ddim.h"
+#include "paddle/common/enforce.h"
+#include "paddle/pir/include/core/builder.h"
+#include "paddle/pir/include/core/builtin_type.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_op.h"
+#include "paddle/pir/include/dialect/shape/utils/shape_analysis.h"
+
+PD_DECLARE_int32(cinn_horizontal_fusion_max_ops);
+
+namespace cinn {
+namespace dialect {
+namespace ir {
+namespace {
+
+using cinn::hlir::framework::pir::CompatibleInfo;
+
+// The space a trivial fusion op iterates over, which the trivial patterns
+// of a group are fused horizontally over when it is lowered.
+struct IterationSpace {
+  std::vector<int64_t> dims;
+  std::vector<int64_t> loop_ranges;
+
+  bool operator==(const IterationSpace& other) const {
+    return dims == other.dims && loop_ranges == other.loop_ranges;
+  }
+};
+
+// The fusion ops of a block to merge, in the order of the block.
+struct HorizontalGroup {
+  IterationSpace space;
+  std::vector<cinn::dialect::FusionOp> fusion_ops;
+  // The groups the fusion ops read, directly or through the ops which are
+  // not merged.
+  std::unordered_set<size_t> upstreams;
+};
+
+std::optional<cinn::dialect::GroupInfo> GetGroupInfo(
+    cinn::dialect::FusionOp fusion_op) {
+  if (!fusion_op.attributes().count("group_info")) {
+    return std::nullopt;
+  }
+  return fusion_op.attribute("group_info")
+      .dyn_cast<cinn::dialect::GroupInfoAttribute>()
+      .data();
+}
+
+// Returns the iteration space of the fusion op if it is trivial, and its
+// outputs share a static shape.
+std::optional<IterationSpace> GetIterationSpace(
+    cinn::dialect::FusionOp fusion_op) {
+  const auto& ops = fusion_op.GetOperators();
+  if (fusion_op->num_results() == 0) {
+    return std::nullopt;
+  }
+  // A single reshape falls back to phi, which launches no kernel.
+  if (ops.size() == 2 && ops.front()->isa<cinn::dialect::ReshapeOp>()) {
+    return std::nullopt;
+  }
+  for (auto* op : ops) {
+    if (op->isa<::pir::YieldOp>()) continue;
+    if (op->num_regions() > 0 ||
+        CompatibleInfo::OpKind(*op) > hlir::framework::kInjective) {
+      return std::nullopt;
+    }
+  }
+
+  IterationSpace space;
+  const auto& group_info = GetGroupInfo(fusion_op);
+  if (group_info.has_value()) {
+    if (!group_info->reduce_axis.empty() ||
+        group_info->op_pattern_kind > hlir::framework::kInjective) {
+      return std::nullopt;
+    }
+    space.loop_ranges = group_info->loop_ranges;
+  }
+  for (uint32_t i = 0; i < fusion_op->num_results(); ++i) {
+    auto type =
+        fusion_op->result(i).type().dyn_cast<::pir::DenseTensorType>();
+    if (!type) {
+      return std::nullopt;
+    }
+    const std::vector<int64_t> dims = ::common::vectorize(type.dims());
+    if (std::any_of(
+            dims.begin(), dims.end(), [](int64_t dim) { return dim < 0; })) {
+      return std::nullopt;
+    }
+    if (i == 0) {
+      space.dims = dims;
+    } else if (dims != space.dims) {
+      return std::nullopt;
+    }
+  }
+  return space;
+}
+
+// Returns the op of the block the value is defined by, or in, or nullptr if
+// it is defined out of the block.
+pir::Operation* DefiningOpIn(pir::Value value, pir::Block* block) {
+  pir::Operation* op = value ? value.defining_op() : nullptr;
+  while (op != nullptr && op->GetParent() != block) {
+    op = op->GetParentOp();
+  }
+  return op;
+}
+
+// The ops of the block which the op, or an op nested in it, reads.
+std::vector<pir::Operation*> UpstreamOpsIn(pir::Operation* op,
+                                           pir::Block* block) {
+  std::vector<pir::Operation*> upstreams;
+  op->Walk([&](pir::Operation* inner_op) {
+    for (uint32_t i = 0; i < inner_op->num_operands(); ++i) {
+      pir::Operation* upstream =
+          DefiningOpIn(inner_op->operand_source(i), block);
+      if (upstream != nullptr && upstream != op) {
+        upstreams.push_back(upstream);
+      }
+    }
+  });
+  return upstreams;
+}
+
+// Groups the fusion ops of the block greedily in its order. A fusion op
+// joins the first group of its iteration space it does not depend on, nor
+// makes depend on itself through the other groups.
+std::vector<HorizontalGroup> PlanHorizontalGroups(pir::Block* block,
+                                                  size_t max_group_size) {
+  std::vector<HorizontalGroup> groups;
+  std::unordered_map<pir::Operation*, size_t> op_to_group;
+  // The groups each op which is not grouped reads.
+  std::unordered_map<pir::Operation*, std::unordered_set<size_t>>
+      op_upstreams;
+
+  const auto DependsOn = [&](const std::unordered_set<size_t>& upstreams,
+                             size_t group) {
+    std::vector<size_t> stack(upstreams.begin(), upstreams.end());
+    std::unordered_set<size_t> visited;
+    while (!stack.empty()) {
+      const size_t current = stack.back();
+      stack.pop_back();
+      if (current == group) return true;
+      if (!visited.insert(current).second) continue;
+      stack.insert(stack.end(),
+                   groups[current].upstreams.begin(),
+                   groups[current].upstreams.end());
+    }
+    return false;
+  };
+
+  for (auto& op : *block) {
+    std::unordered_set<size_t> upstreams;
+    for (auto* upstream_op : UpstreamOpsIn(&op, block)) {
+      if (op_to_group.count(upstream_op)) {
+        upstreams.insert(op_to_group.at(upstream_op));
+      } else if (op_upstreams.count(upstream_op)) {
+        const auto& groups_read = op_upstreams.at(upstream_op);
+        upstreams.insert(groups_read.begin(), groups_read.end());
+      }
+    }
+    std::optional<IterationSpace> space;
+    if (op.isa<cinn::dialect::FusionOp>()) {
+      space = GetIterationSpace(op.dyn_cast<cinn::dialect::FusionOp>());
+    }
+    if (!space.has_value()) {
+      if (!upstreams.empty()) {
+        op_upstreams[&op] = std::move(upstreams);
+      }
+      continue;
+    }
+
+    size_t group_id = groups.size();
+    for (size_t i = 0; i < groups.size(); ++i) {
+      if (groups[i].fusion_ops.size() < max_group_size &&
+          groups[i].space == space.value() && !DependsOn(upstreams, i)) {
+        group_id = i;
+        break;
+      }
+    }
+    if (group_id == groups.size()) {
+      groups.push_back(HorizontalGroup{space.value(), {}, {}});
+    }
+    groups[group_id].fusion_ops.push_back(
+        op.dyn_cast<cinn::dialect::FusionOp>());
+    groups[group_id].upstreams.insert(upstreams.begin(), upstreams.end());
+    op_to_group[&op] = group_id;
+  }
+  return groups;
+}
+
+std::optional<cinn::dialect::GroupInfo> MergeGroupInfos(
+    const HorizontalGroup& group, const std::vector<pir::Operation*>& ops) {
+  std::vector<cinn::dialect::GroupInfo> group_infos;
+  for (auto fusion_op : group.fusion_ops) {
+    auto group_info = GetGroupInfo(fusion_op);
+    if (!group_info.has_value()) {
+      return std::nullopt;
+    }
+    group_infos.push_back(group_info.value());
+  }
+
+  cinn::dialect::GroupInfo merged(ops);
+  merged.loop_ranges = group_infos.front().loop_ranges;
+  merged.loop_ranges_expr = group_infos.front().loop_ranges_expr;
+  for (const auto& group_info : group_infos) {
+    if (!merged.group_id.empty()) {
+      merged.group_id += "_";
+    }
+    merged.group_id += group_info.group_id;
+    merged.op_pattern_kind =
+        std::max(merged.op_pattern_kind, group_info.op_pattern_kind);
+    merged.alignment_schedule_info.insert(
+        group_info.alignment_schedule_info.begin(),
+        group_info.alignment_schedule_info.end());
+  }
+  return merged;
+}
+
+// Merges the fusion ops of the group into one, in place of the last of them.
+cinn::dialect::FusionOp MergeHorizontalGroup(const HorizontalGroup& group) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Builder builder(ctx);
+  builder.set_insertion_point(group.fusion_ops.back());
+
+  std::vector<pir::Operation*> ops;
+  std::vector<pir::Type> output_types;
+  std::vector<pir::Value> yield_values;
+  for (auto fusion_op : group.fusion_ops) {
+    for (auto* op : fusion_op.GetOperators()) {
+      if (op->isa<::pir::YieldOp>()) {
+        for (uint32_t i = 0; i < op->num_operands(); ++i) {
+          yield_values.push_back(op->operand_source(i));
+        }
+      } else {
+        ops.push_back(op);
+      }
+    }
+    for (auto result : fusion_op->results()) {
+      output_types.push_back(result.type());
+    }
+  }
+
+  const auto& group_info = MergeGroupInfos(group, ops);
+  auto merged = group_info.has_value()
+                    ? builder.Build<cinn::dialect::FusionOp>(
+                          output_types, group_info.value())
+                    : builder.Build<cinn::dialect::FusionOp>(output_types);
+  pir::Block* fusion_block = merged.block();
+  for (auto* op : ops) {
+    op->MoveTo(fusion_block, fusion_block->end());
+  }
+  builder.SetInsertionPointToBlockEnd(fusion_block);
+  builder.Build<::pir::YieldOp>(yield_values);
+
+  auto& shape_analysis =
+      pir::ShapeAnalysisManager::Instance().Get(merged->GetParentProgram());
+  uint32_t index = 0;
+  for (auto fusion_op : group.fusion_ops) {
+    for (auto result : fusion_op->results()) {
+      shape_analysis.SetShapeOrDataForValue(
+          merged->result(index),
+          shape_analysis.GetShapeOrDataForValue(result));
+      result.ReplaceAllUsesWith(merged->result(index));
+      ++index;
+    }
+    fusion_op->Erase();
+  }
+  return merged;
+}
+
+// Reorders the ops of the block topologically, keeping the order of the
+// ops which are ready. The readers of a merged fusion op may come before it,
+// as it takes the place of the last fusion op it is merged from.
+void SortBlockTopologically(pir::Block* block) {
+  std::vector<pir::Operation*> ops;
+  std::unordered_map<pir::Operation*, size_t> op_to_index;
+  for (auto& op : *block) {
+    op_to_index[&op] = ops.size();
+    ops.push_back(&op);
+  }
+  std::vector<std::vector<size_t>> downstreams(ops.size());
+  std::vector<size_t> in_degrees(ops.size(), 0);
+  for (size_t i = 0; i < ops.size(); ++i) {
+    for (auto* upstream : UpstreamOpsIn(ops[i], block)) {
+      downstreams[op_to_index.at(upstream)].push_back(i);
+      ++in_degrees[i];
+    }
+  }
+
+  std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>
+      ready;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (in_degrees[i] == 0) ready.push(i);
+  }
+  pir::Block::OpListType sorted_ops;
+  while (!ready.empty()) {
+    const size_t current = ready.top();
+    ready.pop();
+    sorted_ops.push_back(ops[current]);
+    for (size_t downstream : downstreams[current]) {
+      if (--in_degrees[downstream] == 0) ready.push(downstream);
+    }
+  }
+  PADDLE_ENFORCE_EQ(sorted_ops.size(),
+                    ops.size(),
+                    ::common::errors::PreconditionNotMet(
+                        "The horizontal fusion makes a cycle of the ops."));
+  block->ResetOpListOrder(sorted_ops);
+}
+
+class HorizontalFusionPass : public pir::Pass {
+ public:
+  HorizontalFusionPass() : pir::Pass("horizontal_fusion", /*opt_level=*/1) {}
+
+  void Run(pir::Operation* op) override {
+    int64_t num_merged = 0;
+    for (uint32_t i = 0; i < op->num_regions(); ++i) {
+      for (auto& block : op->region(i)) {
+        num_merged += FuseBlock(&block);
+      }
+    }
+    AddStatistics(num_merged);
+  }
+
+  bool CanApplyOn(pir::Operation* op) const override {
+    return op->num_regions() > 0;
+  }
+
+ private:
+  // Returns the fusion ops merged into the others.
+  int64_t FuseBlock(pir::Block* block) const {
+    const size_t max_group_size =
+        std::max(FLAGS_cinn_horizontal_fusion_max_ops, 1);
+    int64_t num_merged = 0;
+    for (const auto& group : PlanHorizontalGroups(block, max_group_size)) {
+      if (group.fusion_ops.size() < 2) continue;
+      auto merged = MergeHorizontalGroup(group);
+      VLOG(4) << "Merge " << group.fusion_ops.size()
+              << " fusion ops horizontally into " << merged->num_results()
+              << " outputs of dims [" << ::common::make_ddim(group.space.dims)
+              << "]";
+      num_merged += group.fusion_ops.size() - 1;
+    }
+    if (num_merged > 0) {
+      SortBlockTopologically(block);
+    }
+    return num_merged;
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<pir::Pass> CreateHorizontalFusionPass() {
+  return std::make_unique<HorizontalFusionPass>();
+}
+
+}  // namespace ir
+}  // namespace dialect
+}  // namespace cinn
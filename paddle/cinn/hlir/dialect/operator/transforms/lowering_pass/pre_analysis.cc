@@ -19,6 +19,7 @@
 #include "paddle/common/flags.h"
 
 PD_DECLARE_bool(enable_cinn_compile_cache);
+PD_DECLARE_bool(cinn_async_compile);
 
 namespace cinn::dialect::ir::details {
 using cinn::hlir::framework::PirCompiler;
@@ -57,6 +58,10 @@ void FusionOpAnalysis::PreCompileGroup() {
   // Build and trigger compilaion cache.
   VLOG(4) << "Parallel Pre-Compile for Group with size: " << groups.size();
   PirCompiler pir_compiler(cinn::common::DefaultNVGPUTarget());
+  if (FLAGS_cinn_async_compile) {
+    pir_compiler.BuildAsync(groups, BuildFallbackProgram);
+    return;
+  }
   pir_compiler.Build(groups);
 }
 }  // namespace cinn::dialect::ir::details
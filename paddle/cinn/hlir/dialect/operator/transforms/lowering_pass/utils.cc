@@ -17,13 +17,21 @@
 #include "paddle/cinn/adt/generate_map_expr.h"
 #include "paddle/cinn/hlir/dialect/operator/ir/generate_shape_util.h"
 #include "paddle/cinn/hlir/dialect/operator/ir/op_attribute.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/cinn_to_pd_util.h"
 #include "paddle/cinn/hlir/dialect/operator/transforms/lowering_pass/collect_sym_expr.h"
 #include "paddle/cinn/hlir/dialect/runtime/ir/jit_kernel_op.h"
 #include "paddle/cinn/hlir/dialect/runtime/ir/runtime_dialect.h"
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
 #include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
 #include "paddle/cinn/hlir/framework/pir/utils.h"
 #include "paddle/cinn/hlir/framework/pir_compiler.h"
 #include "paddle/cinn/runtime/flags.h"
+#include "paddle/common/ddim.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/dialect/operator/utils/utils.h"
+#include "paddle/pir/include/core/builtin_op.h"
 
 PD_DECLARE_bool(cinn_enable_map_expr);
 PD_DECLARE_bool(enable_cinn_compile_cache);
@@ -32,6 +40,7 @@ namespace cinn::dialect::ir::details {
 
 using cinn::hlir::framework::CompilationCache;
 using cinn::hlir::framework::PirCompiler;
+using cinn::hlir::framework::pir::AsyncKernel;
 using cinn::hlir::framework::pir::CINNKernelInfo;
 using cinn::hlir::framework::pir::CompatibleInfo;
 
@@ -156,4 +165,59 @@ void UpdateGroupShapeOrDataExprs(OpLoweringGroupPtr group) {
       CreateGroupShapeOrDataExprs(group, shape_analysis));
 }
 
+std::shared_ptr<pir::Program> BuildFallbackProgram(
+    const OpLoweringGroupPtr& group) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  auto program = std::make_shared<::pir::Program>(ctx);
+  ::pir::Builder builder(ctx, program->block());
+  ::pir::IrMapping ir_mapping;
+  ::pir::CloneOptions clone_options(/*clone_regions=*/false,
+                                    /*clone_operands=*/true,
+                                    /*clone_successors=*/false);
+  try {
+    const auto& inputs = GetBlockOutsideInput(group->ops());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      auto type = inputs[i].type().dyn_cast<paddle::dialect::DenseTensorType>();
+      PADDLE_ENFORCE_EQ(static_cast<bool>(type),
+                        true,
+                        ::common::errors::Unimplemented(
+                            "Only the groups of dense tensor inputs can "
+                            "fall back to phi kernels."));
+      auto data_op = builder.Build<paddle::dialect::DataOp>(
+          AsyncKernel::FallbackInputName(i),
+          common::vectorize(type.dims()),
+          paddle::dialect::TransToPhiDataType(type.dtype()),
+          phi::Place());
+      ir_mapping.Add(inputs[i], data_op.out());
+    }
+
+    for (auto* op : group->ops()) {
+      auto* new_op = builder.Insert(op->Clone(ir_mapping, clone_options));
+      if (new_op->dialect()->name() != "cinn_op") continue;
+      // The transform rules build the pd op over the operands of the op, so
+      // the cinn op is rewritten once its operands are mapped.
+      builder.set_insertion_point(new_op);
+      auto* pd_op =
+          cinn::dialect::details::RewriteCinnOpToPdOp(new_op, builder);
+      for (uint32_t i = 0; i < op->num_results(); ++i) {
+        ir_mapping.Add(op->result(i), pd_op->result(i));
+      }
+      new_op->Erase();
+      builder.SetInsertionPointToBlockEnd(program->block());
+    }
+
+    const auto& outputs = group->output_values();
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      builder.Build<::pir::ShadowOutputOp>(ir_mapping.Lookup(outputs[i]),
+                                           AsyncKernel::FallbackOutputName(i));
+    }
+  } catch (const std::exception& e) {
+    VLOG(4) << "No fallback program for " << group->FuncName() << ": "
+            << e.what();
+    return nullptr;
+  }
+  return program;
+}
+
 }  // namespace cinn::dialect::ir::details
@@ -33,4 +33,9 @@ OpLoweringGroupPtr BuildOpLoweringGroup(pir::Operation* fusion_op_ptr);
 
 void UpdateGroupShapeOrDataExprs(OpLoweringGroupPtr group);
 
+// Builds the program of the phi kernels the group runs as while it is
+// compiled in the background, nullptr if some op of it has no phi kernel.
+std::shared_ptr<pir::Program> BuildFallbackProgram(
+    const OpLoweringGroupPtr& group);
+
 }  // namespace cinn::dialect::ir::details
@@ -0,0 +1,174 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+#include <thread>
+
+#include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
+#include "paddle/cinn/runtime/flags.h"
+#include "paddle/common/enforce.h"
+
+PD_DECLARE_int32(cinn_async_compile_thread_num);
+
+namespace cinn::hlir::framework::pir {
+
+namespace {
+
+class BackgroundCompilationPool {
+ public:
+  static BackgroundCompilationPool& Instance() {
+    // Never destroyed, as a compilation may still be running at exit.
+    static auto* pool = new BackgroundCompilationPool(
+        std::max(FLAGS_cinn_async_compile_thread_num, 1));
+    return *pool;
+  }
+
+  void Schedule(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  explicit BackgroundCompilationPool(int num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+      std::thread([this] { Loop(); }).detach();
+    }
+  }
+
+  void Loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !tasks_.empty(); });
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+};
+
+}  // namespace
+
+void ScheduleBackgroundCompilation(std::function<void()> task) {
+  BackgroundCompilationPool::Instance().Schedule(std::move(task));
+}
+
+AsyncKernel::AsyncKernel(
+    const std::string& fn_name,
+    const std::shared_ptr<::pir::Program>& fallback_program)
+    : fn_name_(fn_name),
+      fallback_program_(fallback_program),
+      schedule_time_(std::chrono::steady_clock::now()) {
+  AsyncCompilationStats::Instance().num_scheduled.fetch_add(1);
+}
+
+std::string AsyncKernel::FallbackInputName(size_t index) {
+  return "cinn_fallback_in_" + std::to_string(index);
+}
+
+std::string AsyncKernel::FallbackOutputName(size_t index) {
+  return "cinn_fallback_out_" + std::to_string(index);
+}
+
+const CINNKernelInfo& AsyncKernel::Wait() const {
+  if (!IsReady()) {
+    VLOG(4) << "Wait for the compilation of " << fn_name_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return IsReady() || !error_.empty(); });
+    PADDLE_ENFORCE_EQ(error_.empty(),
+                      true,
+                      ::common::errors::Fatal("Failed to compile %s: %s",
+                                              fn_name_,
+                                              error_));
+  }
+  return kernel_info_;
+}
+
+void AsyncKernel::AddFallbackRun() {
+  num_fallback_runs_.fetch_add(1, std::memory_order_relaxed);
+  AsyncCompilationStats::Instance().num_fallback_runs.fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void AsyncKernel::SetCompilationResult(
+    const std::shared_ptr<CompilationResult>& compilation_result) {
+  const int64_t time_to_compiled_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - schedule_time_)
+          .count();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    compilation_result_ = compilation_result;
+    kernel_info_ = compilation_result->GetKernelInfo();
+    ready_.store(true, std::memory_order_release);
+  }
+  cv_.notify_all();
+
+  auto& stats = AsyncCompilationStats::Instance();
+  stats.num_compiled.fetch_add(1);
+  stats.total_time_to_compiled_us.fetch_add(time_to_compiled_us);
+  int64_t max_us = stats.max_time_to_compiled_us.load();
+  while (max_us < time_to_compiled_us &&
+         !stats.max_time_to_compiled_us.compare_exchange_weak(
+             max_us, time_to_compiled_us)) {
+  }
+  VLOG(1) << "Compiled " << fn_name_ << " in the background "
+          << time_to_compiled_us / 1000.0 << " ms after scheduled, "
+          << stats.Summary();
+}
+
+void AsyncKernel::SetError(const std::string& error) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = error.empty() ? "unknown error" : error;
+  }
+  cv_.notify_all();
+  AsyncCompilationStats::Instance().num_failed.fetch_add(1);
+  LOG(WARNING) << "Failed to compile " << fn_name_ << " in the background"
+               << (fallback_program_ ? ", keep running its phi kernels: "
+                                     : ": ")
+               << error;
+}
+
+AsyncCompilationStats& AsyncCompilationStats::Instance() {
+  static AsyncCompilationStats stats;
+  return stats;
+}
+
+std::string AsyncCompilationStats::Summary() const {
+  const int64_t compiled = num_compiled.load();
+  std::ostringstream os;
+  os << "async compilation: " << compiled << "/" << num_scheduled.load()
+     << " compiled, " << num_failed.load() << " failed, time to compiled "
+     << (compiled > 0 ? total_time_to_compiled_us.load() / 1000.0 / compiled
+                      : 0.0)
+     << " ms on average and " << max_time_to_compiled_us.load() / 1000.0
+     << " ms at most, " << num_fallback_runs.load() << " fallback runs";
+  return os.str();
+}
+
+}  // namespace cinn::hlir::framework::pir
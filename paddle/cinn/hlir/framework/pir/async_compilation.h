@@ -0,0 +1,104 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "paddle/cinn/hlir/framework/pir/utils.h"
+#include "paddle/pir/include/core/program.h"
+
+namespace cinn::hlir::framework::pir {
+
+class CompilationResult;
+
+// Runs a compilation on the background pool of
+// FLAGS_cinn_async_compile_thread_num threads, in the order scheduled.
+void ScheduleBackgroundCompilation(std::function<void()> task);
+
+/**
+ * The kernel of a group compiled on the background pool.
+ *
+ * Until the kernel is compiled, the group may run as the phi kernels of its
+ * fallback program: a program of the pd_op dialect whose data ops are named
+ * by FallbackInputName and whose results are shadowed as FallbackOutputName,
+ * in the order of the inputs and outputs of the kernel. The group blocks on
+ * the compilation if it has no fallback program.
+ */
+class AsyncKernel final {
+ public:
+  AsyncKernel(const std::string& fn_name,
+              const std::shared_ptr<::pir::Program>& fallback_program);
+
+  static std::string FallbackInputName(size_t index);
+  static std::string FallbackOutputName(size_t index);
+
+  const std::string& fn_name() const { return fn_name_; }
+  // nullptr if some op of the group has no phi kernel.
+  ::pir::Program* fallback_program() const { return fallback_program_.get(); }
+
+  bool IsReady() const { return ready_.load(std::memory_order_acquire); }
+  // Blocks until the kernel is compiled, throwing if it failed.
+  const CINNKernelInfo& Wait() const;
+
+  // Counts a run of the fallback program.
+  void AddFallbackRun();
+  int64_t num_fallback_runs() const {
+    return num_fallback_runs_.load(std::memory_order_relaxed);
+  }
+
+  // Called once by the compilation, on the background pool.
+  void SetCompilationResult(
+      const std::shared_ptr<CompilationResult>& compilation_result);
+  void SetError(const std::string& error);
+
+ private:
+  std::string fn_name_;
+  std::shared_ptr<::pir::Program> fallback_program_;
+  std::chrono::steady_clock::time_point schedule_time_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable cv_;
+  std::atomic<bool> ready_{false};
+  // Written before ready_ or error_ is set.
+  std::shared_ptr<CompilationResult> compilation_result_;
+  CINNKernelInfo kernel_info_;
+  std::string error_;
+  std::atomic<int64_t> num_fallback_runs_{0};
+};
+
+// The counters of the kernels compiled on the background pool, over the
+// process.
+struct AsyncCompilationStats {
+  std::atomic<int64_t> num_scheduled{0};
+  std::atomic<int64_t> num_compiled{0};
+  std::atomic<int64_t> num_failed{0};
+  // The microseconds from the scheduling of the kernels to the end of their
+  // compilation.
+  std::atomic<int64_t> total_time_to_compiled_us{0};
+  std::atomic<int64_t> max_time_to_compiled_us{0};
+  // The runs of the fallback programs while the kernels were compiled.
+  std::atomic<int64_t> num_fallback_runs{0};
+
+  static AsyncCompilationStats& Instance();
+  std::string Summary() const;
+};
+
+}  // namespace cinn::hlir::framework::pir
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
 #include "paddle/cinn/hlir/framework/pir/op_lowering_group.h"
 
 namespace cinn::hlir::framework {
@@ -45,6 +46,27 @@ pir::CINNKernelInfo BackendResource::GenerateKernelInfo() const {
   kernel_info.int_args_map = GetIntArgsMap();
   return kernel_info;
 }
+
+pir::CINNKernelInfo CompilationResult::GetKernelInfo() {
+  if (async_kernel_) {
+    if (async_kernel_->IsReady()) {
+      return async_kernel_->Wait();
+    }
+    pir::CINNKernelInfo kernel_info;
+    kernel_info.fn_name = async_kernel_->fn_name();
+    kernel_info.fn_ptr = nullptr;
+    kernel_info.infer_shape_fn_ptr = nullptr;
+    kernel_info.async_kernel = async_kernel_;
+    return kernel_info;
+  }
+  PADDLE_ENFORCE_NOT_NULL(backend_resource_,
+                          ::common::errors::PreconditionNotMet(
+                              "Found backend_resource_ is nullptr, please "
+                              "call SetBackendResource first."));
+  pir::CINNKernelInfo kernel_info = backend_resource_->GenerateKernelInfo();
+  kernel_info.shape_specializer = shape_specializer_;
+  return kernel_info;
+}
 }  // namespace pir
 
 bool CompilationCache::Has(const CacheKey& key) const {
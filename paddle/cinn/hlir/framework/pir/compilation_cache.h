@@ -68,17 +68,23 @@ class CompilationResult final {
     backend_resource_ = other;
   }
 
-  pir::CINNKernelInfo GetKernelInfo() {
-    PADDLE_ENFORCE_NOT_NULL(backend_resource_,
-                            ::common::errors::PreconditionNotMet(
-                                "Found backend_resource_ is nullptr, please "
-                                "call SetBackendResource first."));
-    return backend_resource_->GenerateKernelInfo();
+  void SetShapeSpecializer(const std::shared_ptr<ShapeSpecializer>& other) {
+    shape_specializer_ = other;
   }
 
+  // The result of a group compiled in the background, its kernel being
+  // looked up from the async kernel once compiled.
+  void SetAsyncKernel(const std::shared_ptr<AsyncKernel>& other) {
+    async_kernel_ = other;
+  }
+
+  pir::CINNKernelInfo GetKernelInfo();
+
  private:
   Target target_;
   std::shared_ptr<BackendResource> backend_resource_{nullptr};
+  std::shared_ptr<ShapeSpecializer> shape_specializer_{nullptr};
+  std::shared_ptr<AsyncKernel> async_kernel_{nullptr};
 };
 
 }  // namespace pir
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "paddle/cinn/hlir/framework/pir/fusion_info.h"
+#include <sstream>
 #include "paddle/common/enforce.h"
 #include "paddle/common/flags.h"
 #include "paddle/pir/include/core/ir_printer.h"
@@ -36,8 +37,17 @@ std::ostream& operator<<(std::ostream& os, const AttributeInfo& attr_info) {
   return os;
 }
 
+void AttributeInfo::Serialize(std::ostream& os) const {
+  os << name_ << ":";
+  ::pir::IrPrinter(os).PrintAttribute(attr_);
+}
+
 std::size_t ValueInfo::hash() const { return type_.hash(); }
 
+void ValueInfo::Serialize(std::ostream& os) const {
+  ::pir::IrPrinter(os).PrintType(type_);
+}
+
 std::ostream& operator<<(std::ostream& os, const ValueInfo& value_info) {
   os << "ValueInfo - " << value_info.hash();
   if (VLOG_IS_ON(7)) {
@@ -81,6 +91,25 @@ std::size_t OperationInfo::hash() const {
   return seed;
 }
 
+void OperationInfo::Serialize(std::ostream& os) const {
+  os << name_ << "(";
+  for (const auto& info : input_infos_) {
+    info.Serialize(os);
+    os << ",";
+  }
+  os << ")->(";
+  for (const auto& info : output_infos_) {
+    info.Serialize(os);
+    os << ",";
+  }
+  os << "){";
+  for (const auto& info : attr_infos_) {
+    info.Serialize(os);
+    os << ",";
+  }
+  os << "}";
+}
+
 std::ostream& operator<<(std::ostream& os, const OperationInfo& op_info) {
   os << op_info.name_ << " - " << op_info.hash();
   if (VLOG_IS_ON(7)) {
@@ -102,6 +131,13 @@ std::size_t FusionOpInfo::hash() const {
   return seed;
 }
 
+void FusionOpInfo::Serialize(std::ostream& os) const {
+  op_info_.Serialize(os);
+  for (const auto& [value_index, op_index] : inner_dep_indices_) {
+    os << "(" << value_index << "<-" << op_index << ")";
+  }
+}
+
 std::ostream& operator<<(std::ostream& os, const FusionOpInfo& info) {
   os << info.op_info_ << ", inner_deps:{";
   for (const auto& [value_index, op_info_hash] : info.inner_deps_) {
@@ -139,11 +175,24 @@ void FusionInfo::ParseOpInfos(const OpLoweringGroup& group) {
     }
     return upstream_ops_index_hash;
   };
+  const auto GetInnerUpstreamOpIndices =
+      [&](const ::pir::Operation* op) -> std::map<size_t, size_t> {
+    std::map<size_t, size_t> upstream_ops_index;
+    for (size_t i = 0; i < op->num_operands(); ++i) {
+      const auto value = op->operand_source(i);
+      if (!value || !value.defining_op()) continue;
+      const auto it = op_mapper.find(value.defining_op());
+      if (it == op_mapper.end()) continue;
+      upstream_ops_index.emplace(i, it->second);
+    }
+    return upstream_ops_index;
+  };
 
   const auto sorted_ops = TopologySort(group);
   for (size_t i = 0; i < sorted_ops.size(); ++i) {
     const auto& op = sorted_ops[i];
-    op_infos_.emplace_back(*op, GetInnerUpstreamOps(op));
+    op_infos_.emplace_back(
+        *op, GetInnerUpstreamOps(op), GetInnerUpstreamOpIndices(op));
     op_mapper.insert({op, i});
   }
 }
@@ -189,6 +238,17 @@ std::size_t FusionInfo::hash() const {
   return seed;
 }
 
+std::string FusionInfo::SerializeToString() const {
+  std::ostringstream os;
+  for (const auto& dim_expr : input_dim_exprs_) os << dim_expr << ";";
+  os << "\n";
+  for (const auto& op_info : op_infos_) {
+    op_info.Serialize(os);
+    os << "\n";
+  }
+  return os.str();
+}
+
 std::ostream& operator<<(std::ostream& os, const FusionInfo& fusion_info) {
   os << "FusionInfo - " << fusion_info.hash();
   if (VLOG_IS_ON(5)) {
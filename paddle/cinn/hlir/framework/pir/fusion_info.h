@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #pragma once
+#include <map>
 #include <ostream>
+#include <string>
 #include "paddle/cinn/hlir/framework/pir/op_lowering_group.h"
 #include "paddle/pir/include/dialect/shape/utils/shape_or_data_expr.h"
 
@@ -25,6 +27,8 @@ class AttributeInfo {
       : name_(name), attr_(attr) {}
 
   std::size_t hash() const;
+  // Prints the attribute itself, unlike hash() stable across processes.
+  void Serialize(std::ostream &os) const;
   friend std::ostream &operator<<(std::ostream &os, const AttributeInfo &info);
 
  private:
@@ -37,6 +41,7 @@ class ValueInfo {
   explicit ValueInfo(const ::pir::Value &value) : type_(value.type()) {}
 
   std::size_t hash() const;
+  void Serialize(std::ostream &os) const;
   friend std::ostream &operator<<(std::ostream &os, const ValueInfo &info);
 
  private:
@@ -49,6 +54,7 @@ class OperationInfo {
   explicit OperationInfo(const ::pir::Operation &op);
 
   std::size_t hash() const;
+  void Serialize(std::ostream &os) const;
   friend std::ostream &operator<<(std::ostream &os, const OperationInfo &info);
 
  private:
@@ -71,6 +77,8 @@ class FusionOpInfo {
   OperationInfo op_info_;
   // oprand_source id : OperationInfo hash
   std::unordered_map<size_t, size_t> inner_deps_;
+  // oprand_source id : index of the defining op in the group
+  std::map<size_t, size_t> inner_dep_indices_;
 };
 
 class FusionInfo {
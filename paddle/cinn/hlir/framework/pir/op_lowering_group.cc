@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "paddle/cinn/hlir/framework/pir/op_lowering_group.h"
+#include "paddle/pir/include/core/ir_mapping.h"
+#include "paddle/pir/include/core/program.h"
 
 namespace cinn {
 namespace hlir {
@@ -163,6 +165,27 @@ std::shared_ptr<OpLoweringGroup> OpLoweringGroup::Clone(
   return new_group;
 }
 
+std::shared_ptr<OpLoweringGroup> OpLoweringGroup::CloneToProgram(
+    ::pir::Program* program) const {
+  ::pir::Block* block = program->block();
+  ::pir::IrMapping ir_mapping;
+  for (const auto& input : GetInputOpValues()) {
+    ir_mapping.Add(input, block->AddArg(input.type()));
+  }
+  auto new_group = Clone(block, &ir_mapping);
+  new_group->op_pattern_kind_ = this->op_pattern_kind_;
+  new_group->is_broadcast_leaf_ = this->is_broadcast_leaf_;
+  new_group->loop_ranges_expr_ = this->loop_ranges_expr_;
+  for (const auto& [value, new_value] : ir_mapping.GetMap<::pir::Value>()) {
+    auto iter = value_to_shape_or_data_exprs_.find(value);
+    if (iter != value_to_shape_or_data_exprs_.end()) {
+      new_group->value_to_shape_or_data_exprs_.emplace(new_value,
+                                                       iter->second);
+    }
+  }
+  return new_group;
+}
+
 std::ostream& operator<<(std::ostream& os, const OpLoweringGroup& group) {
   auto PrintSymbolDims = [&](const ::pir::Operation& op) {
     if (group.value_to_shape_or_data_exprs_.empty()) return;
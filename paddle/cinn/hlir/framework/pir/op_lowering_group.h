@@ -119,6 +119,11 @@ class OpLoweringGroup {
     return *map_expr_ctx_;
   }
 
+  const std::unordered_map<::pir::Value, symbol::ShapeOrDataDimExprs>&
+  value_to_shape_or_data_exprs() const {
+    return value_to_shape_or_data_exprs_;
+  }
+
   void set_value_to_shape_or_data_exprs(
       const std::unordered_map<::pir::Value, symbol::ShapeOrDataDimExprs>&
           value_to_shape_or_data_exprs) {
@@ -191,6 +196,13 @@ class OpLoweringGroup {
   std::shared_ptr<OpLoweringGroup> Clone(::pir::Block* target_block,
                                          ::pir::IrMapping* ir_mapping) const;
 
+  // Clones the group into the block of a program of its own, the inputs of
+  // the group becoming the arguments of the block, for the group to be
+  // lowered after its ops are erased. The DimExprs of the values are cloned
+  // along.
+  std::shared_ptr<OpLoweringGroup> CloneToProgram(
+      ::pir::Program* program) const;
+
  private:
   friend std::ostream& operator<<(std::ostream&, const OpLoweringGroup&);
 
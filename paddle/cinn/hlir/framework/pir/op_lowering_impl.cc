@@ -14,13 +14,16 @@
 
 #include "paddle/cinn/hlir/framework/pir/op_lowering_impl.h"
 
+#include <optional>
 #include <string>
 
 #include "paddle/cinn/adt/map_expr_ctx.h"
 #include "paddle/cinn/ast_gen_ius/tensor_group.h"
+#include "paddle/cinn/auto_schedule/pir_group_tuner.h"
 #include "paddle/cinn/backends/codegen_cuda_util.h"
 #include "paddle/cinn/hlir/dialect/operator/ir/manual_op.h"
 #include "paddle/cinn/hlir/framework/compile_error.h"
+#include "paddle/cinn/hlir/framework/pir/fusion_info.h"
 #include "paddle/cinn/hlir/framework/pir/op_lowering_util.h"
 #include "paddle/cinn/hlir/framework/pir/trivial_op_impl.h"
 #include "paddle/cinn/hlir/framework/pir/utils.h"
@@ -30,6 +33,7 @@
 #include "paddle/cinn/ir/group_schedule/base_group_scheduler.h"
 #include "paddle/cinn/ir/group_schedule/st_shape_group_scheduler.h"
 #include "paddle/cinn/ir/schedule/ir_schedule.h"
+#include "paddle/cinn/ir/utils/ir_copy.h"
 #include "paddle/cinn/lang/placeholder.h"
 #include "paddle/cinn/optim/eliminate_common_global_memory_read.h"
 #include "paddle/cinn/optim/if_fusion.h"
@@ -49,6 +53,8 @@ PD_DECLARE_bool(cinn_enable_map_expr);
 PD_DECLARE_bool(cinn_enable_map_expr_schedule);
 PD_DECLARE_bool(cinn_bucket_compile);
 PD_DECLARE_bool(cinn_new_group_scheduler);
+PD_DECLARE_bool(cinn_tune_host_groups);
+PD_DECLARE_int32(cinn_tuning_measure_trials);
 
 namespace cinn {
 namespace hlir {
@@ -72,6 +78,23 @@ NodeAttr CollectAttrs(const ::pir::Operation& op) {
   return node_attrs;
 }
 
+// Whether the schedules of the group of the arg tensors are tuned, the
+// tuning being on the host and for static shapes.
+bool IsTunableGroup(const common::Target& target,
+                    const std::vector<ir::Tensor>& arg_tensors) {
+  if (!std::holds_alternative<common::X86Arch>(target.arch)) {
+    return false;
+  }
+  for (const ir::Tensor& tensor : arg_tensors) {
+    for (const ir::Expr& dim : tensor->shape) {
+      if (!dim.is_constant()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace details
 
 std::shared_ptr<GroupInfo> OpLowererImpl::GetGroupInfo(
@@ -224,7 +247,26 @@ BucketLoweredFuncsWrapper OpLowererImpl::BucketLower(
     }
   }
 
-  if (apply_group_schedule) {
+  // The schedule tuned for the group replaces the group schedule.
+  auto_schedule::PirGroupTuner* group_tuner =
+      apply_group_schedule &&
+              details::IsTunableGroup(target_, group_func_arg_tensors)
+          ? auto_schedule::PirGroupTuner::Global()
+          : nullptr;
+  std::optional<ir::Expr> tuned_func_body;
+  std::string task_key;
+  ir::Expr unscheduled_func_body;
+  if (group_tuner != nullptr) {
+    unscheduled_func_body =
+        ir::ir_utils::IRCopy(ir_sch.GetModule().GetExprs().at(0));
+    task_key = auto_schedule::PirGroupTuner::TaskKey(FusionInfo(*group),
+                                                     target_);
+    tuned_func_body = group_tuner->ApplyBest(task_key, unscheduled_func_body);
+  }
+
+  if (tuned_func_body.has_value()) {
+    cond2func_bodies.emplace_back(ir::Expr(true), tuned_func_body.value());
+  } else if (apply_group_schedule) {
     std::unordered_set<std::string> output_tensor_names;
     for (auto value : group->GetGroupOutputValues()) {
       output_tensor_names.insert(ValueName(value));
@@ -245,6 +287,34 @@ BucketLoweredFuncsWrapper OpLowererImpl::BucketLower(
 
     cond2func_bodies = group_scheduler->GetIRs();
     VLOG(4) << "End   group_scheduler->GetIRs";
+
+    // A task is tuned once, the group schedule winning being recorded too.
+    if (group_tuner != nullptr && FLAGS_cinn_tune_host_groups &&
+        cond2func_bodies.size() == 1 && !group_tuner->HasRecord(task_key)) {
+      auto BuildFuncs = [&](const std::vector<ir::Expr>& func_bodies) {
+        std::vector<ir::Tensor> func_arg_tensors = group_func_arg_tensors;
+        std::vector<ir::Argument> func_args;
+        std::vector<ir::Tensor> infer_shape_args;
+        return PostProcess(group,
+                           tensor_map,
+                           apply_group_schedule,
+                           func_bodies,
+                           &func_arg_tensors,
+                           &func_args,
+                           &infer_shape_args);
+      };
+      auto_schedule::TuningOptions options;
+      options.num_measure_trials = FLAGS_cinn_tuning_measure_trials;
+      auto tune_result = group_tuner->Tune(task_key,
+                                           unscheduled_func_body,
+                                           cond2func_bodies[0].second,
+                                           target_,
+                                           BuildFuncs,
+                                           options);
+      if (tune_result.func_body.has_value()) {
+        cond2func_bodies = {{ir::Expr(true), tune_result.func_body.value()}};
+      }
+    }
   } else {
     cond2func_bodies.emplace_back(ir::Expr(true),
                                   ir_sch.GetModule().GetExprs()[0]);
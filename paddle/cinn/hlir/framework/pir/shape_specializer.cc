@@ -0,0 +1,218 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/hlir/framework/pir/shape_specializer.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
+#include "paddle/cinn/hlir/framework/pir/compilation_task.h"
+#include "paddle/cinn/runtime/flags.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/dialect/shape/utils/dim_expr_util.h"
+
+PD_DECLARE_bool(cinn_enable_map_expr);
+PD_DECLARE_int32(cinn_max_shape_specializations);
+PD_DECLARE_int32(cinn_shape_specialize_threshold);
+
+namespace cinn::hlir::framework::pir {
+
+namespace {
+
+// The shapes counted by a specializer at most, not to grow with the shapes
+// which are seldom run.
+constexpr size_t kMaxObservedShapes = 1024;
+
+void CollectSymbols(const std::vector<symbol::DimExpr>& dim_exprs,
+                    std::unordered_set<std::string>* symbols) {
+  for (const auto& dim_expr : dim_exprs) {
+    for (const auto& symbol : symbol::CollectDimExprSymbols(dim_expr)) {
+      symbols->insert(symbol);
+    }
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<ShapeSpecializer> ShapeSpecializer::Create(
+    const Target& target, const OpLoweringGroupPtr& group) {
+  if (FLAGS_cinn_enable_map_expr || FLAGS_cinn_max_shape_specializations <= 0) {
+    return nullptr;
+  }
+  std::vector<::pir::Value> values = group->GetInputOpValues();
+  const size_t num_inputs = values.size();
+  for (auto* op : group->ops()) {
+    for (auto result : op->results()) {
+      values.push_back(result);
+    }
+  }
+
+  std::unordered_set<std::string> symbols;
+  for (const auto& value : values) {
+    if (!value || !group->HasShapeOrDataExprs(value) ||
+        !group->GetShapeOrDataExprs(value)
+             .isa<symbol::TensorShapeOrDataDimExprs>()) {
+      VLOG(4) << "Not specialize " << group->FuncName()
+              << " without the DimExprs of a tensor for each value.";
+      return nullptr;
+    }
+    const auto& shape_or_data = group->GetShapeOrDataExprs(value);
+    CollectSymbols(shape_or_data.shape(), &symbols);
+    if (shape_or_data.data()) {
+      CollectSymbols(shape_or_data.data().value(), &symbols);
+    }
+  }
+  if (symbols.empty()) {
+    return nullptr;
+  }
+
+  // Bind each symbol to the first input dim it is.
+  std::vector<std::string> bound_symbols;
+  std::vector<CINNKernelInfo::ArgDimIdx> symbol_dims;
+  for (size_t i = 0; i < num_inputs; ++i) {
+    const auto& shape = group->GetShapeOrDataExprs(values[i]).shape();
+    for (size_t j = 0; j < shape.size(); ++j) {
+      if (!shape[j].isa<std::string>()) continue;
+      const std::string& symbol = shape[j].dyn_cast<std::string>();
+      if (symbols.erase(symbol) == 0) continue;
+      bound_symbols.push_back(symbol);
+      symbol_dims.push_back(CINNKernelInfo::ArgDimIdx{static_cast<int>(i),
+                                                      static_cast<int>(j)});
+    }
+  }
+  if (!symbols.empty()) {
+    VLOG(4) << "Not specialize " << group->FuncName() << " with "
+            << *symbols.begin() << " not an input dim.";
+    return nullptr;
+  }
+  return std::shared_ptr<ShapeSpecializer>(
+      new ShapeSpecializer(target, group, bound_symbols, symbol_dims));
+}
+
+ShapeSpecializer::ShapeSpecializer(
+    const Target& target,
+    const OpLoweringGroupPtr& group,
+    const std::vector<std::string>& symbols,
+    const std::vector<CINNKernelInfo::ArgDimIdx>& symbol_dims)
+    : target_(target),
+      program_(std::make_unique<::pir::Program>(::pir::IrContext::Instance())),
+      symbols_(symbols),
+      symbol_dims_(symbol_dims),
+      compile_([target](const OpLoweringGroupPtr& group,
+                        std::shared_ptr<CompilationResult>* result) {
+        GroupCompilationContext context(target, group);
+        *result = CompilationTask(&context)();
+        return (*result)->GetKernelInfo();
+      }) {
+  group_ = group->CloneToProgram(program_.get());
+  VLOG(4) << "Specialize " << group->FuncName() << " over "
+          << symbols_.size() << " symbolic dims.";
+}
+
+ShapeSpecializer::~ShapeSpecializer() = default;
+
+void ShapeSpecializer::Observe(const Shape& shape) {
+  if (exhausted_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_scheduled_ >= FLAGS_cinn_max_shape_specializations) {
+    return;
+  }
+  auto it = observed_counts_.find(shape);
+  if (it == observed_counts_.end()) {
+    if (observed_counts_.size() >= kMaxObservedShapes) {
+      observed_counts_.clear();
+    }
+    it = observed_counts_.emplace(shape, 0).first;
+  }
+  // A scheduled shape is counted -1, not to be scheduled again while the
+  // generic kernel runs it.
+  if (it->second < 0 || ++it->second < FLAGS_cinn_shape_specialize_threshold) {
+    return;
+  }
+  it->second = -1;
+  if (++num_scheduled_ >= FLAGS_cinn_max_shape_specializations) {
+    exhausted_.store(true, std::memory_order_relaxed);
+  }
+  ScheduleBackgroundCompilation(
+      [self = shared_from_this(), shape] { self->Specialize(shape); });
+}
+
+std::vector<std::pair<ShapeSpecializer::Shape, CINNKernelInfo>>
+ShapeSpecializer::GetKernelInfos(size_t begin) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::vector<std::pair<Shape, CINNKernelInfo>>(
+      kernel_infos_.begin() + std::min(begin, kernel_infos_.size()),
+      kernel_infos_.end());
+}
+
+OpLoweringGroupPtr ShapeSpecializer::MakeStaticGroup(
+    const Shape& shape) const {
+  std::unordered_map<symbol::DimExpr, symbol::DimExpr> substitution;
+  for (size_t i = 0; i < symbols_.size(); ++i) {
+    substitution.emplace(symbol::DimExpr{symbols_[i]},
+                         symbol::DimExpr{shape[i]});
+  }
+
+  // The ops are shared with group_, as the lowering does not modify them.
+  auto group = std::make_shared<OpLoweringGroup>(group_->ops());
+  group->mut_output_values() = group_->output_values();
+  group->mut_output_ops() = group_->output_ops();
+  group->set_op_pattern_kind(group_->op_pattern_kind());
+  group->set_reduce_axis(group_->reduce_axis());
+  group->set_alignment_schedule_info(group_->alignment_schedule_info());
+  for (const auto& [value, shape_or_data] :
+       group_->value_to_shape_or_data_exprs()) {
+    group->SetShapeOrDataExprs(
+        value, symbol::SubstituteShapeOrData(shape_or_data, substitution));
+  }
+
+  std::vector<int64_t> loop_ranges = group_->loop_ranges();
+  std::vector<symbol::DimExpr> loop_ranges_expr;
+  for (const auto& dim_expr : group_->loop_ranges_expr()) {
+    loop_ranges_expr.push_back(symbol::SimplifyDimExpr(
+        symbol::SubstituteDimExpr(dim_expr, substitution)));
+    const size_t i = loop_ranges_expr.size() - 1;
+    if (i < loop_ranges.size() && loop_ranges_expr[i].isa<int64_t>()) {
+      loop_ranges[i] = loop_ranges_expr[i].dyn_cast<int64_t>();
+    }
+  }
+  group->set_loop_ranges(loop_ranges);
+  group->set_loop_ranges_expr(loop_ranges_expr);
+  return group;
+}
+
+void ShapeSpecializer::Specialize(const Shape& shape) {
+  OpLoweringGroupPtr group = MakeStaticGroup(shape);
+  std::shared_ptr<CompilationResult> compilation_result;
+  CINNKernelInfo kernel_info;
+  try {
+    kernel_info = compile_(group, &compilation_result);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to specialize " << group_->FuncName()
+                 << " for a static shape: " << e.what();
+    return;
+  }
+  VLOG(4) << "Specialized " << group_->FuncName() << " as "
+          << kernel_info.fn_name;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  compilation_results_.push_back(compilation_result);
+  kernel_infos_.emplace_back(shape, kernel_info);
+  num_kernel_infos_.store(kernel_infos_.size(), std::memory_order_release);
+}
+
+}  // namespace cinn::hlir::framework::pir
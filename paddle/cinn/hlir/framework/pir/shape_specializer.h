@@ -0,0 +1,168 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/hlir/framework/pir/op_lowering_group.h"
+#include "paddle/cinn/hlir/framework/pir/utils.h"
+#include "paddle/pir/include/core/program.h"
+
+namespace cinn::hlir::framework::pir {
+
+class CompilationResult;
+
+/**
+ * Compiles the kernels of a dynamic shape group for the static shapes it
+ * frequently runs with.
+ *
+ * The kernel of a dynamic shape group branches over the extents of its
+ * symbolic dims at runtime, and computes its indices from them. The shape of
+ * a run is the values of the symbolic dims, read from the dims of the inputs
+ * they are bound to. Once a shape has been run with
+ * FLAGS_cinn_shape_specialize_threshold times, the group is compiled on the
+ * background compilation pool with its symbolic dims substituted by the
+ * values, up to FLAGS_cinn_max_shape_specializations shapes. A copy of the
+ * ops of the group is kept in a program of its own, the ops of the fusion
+ * being erased once it is lowered to a kernel.
+ */
+class ShapeSpecializer
+    : public std::enable_shared_from_this<ShapeSpecializer> {
+ public:
+  // The values of the symbolic dims, in the order of SymbolDims().
+  using Shape = std::vector<int64_t>;
+  // Compiles the kernel of a static shape group, setting the result which
+  // holds the module of the kernel.
+  using CompileFunction = std::function<CINNKernelInfo(
+      const OpLoweringGroupPtr& group,
+      std::shared_ptr<CompilationResult>* compilation_result)>;
+
+  // Returns nullptr if the group is of static shape, or has a symbolic dim
+  // which is not a dim of its inputs.
+  static std::shared_ptr<ShapeSpecializer> Create(
+      const Target& target, const OpLoweringGroupPtr& group);
+
+  ~ShapeSpecializer();
+
+  // The input dims of the kernel the symbolic dims are bound to.
+  const std::vector<CINNKernelInfo::ArgDimIdx>& SymbolDims() const {
+    return symbol_dims_;
+  }
+
+  // Counts a run of the generic kernel with the shape, and schedules the
+  // specialization for it once it is frequent.
+  void Observe(const Shape& shape);
+
+  // The number of kernels specialized so far, which only grows.
+  size_t NumKernelInfos() const {
+    return num_kernel_infos_.load(std::memory_order_acquire);
+  }
+
+  // The kernels specialized from the begin-th on, in the order they were
+  // specialized. A specializer is shared by the instructions of identical
+  // groups, each of them reads the kernels from where it left off.
+  std::vector<std::pair<Shape, CINNKernelInfo>> GetKernelInfos(size_t begin);
+
+  // Replaces the CompilationTask the specializations are compiled by.
+  void SetCompileFunction(const CompileFunction& compile) {
+    compile_ = compile;
+  }
+
+ private:
+  ShapeSpecializer(const Target& target,
+                   const OpLoweringGroupPtr& group,
+                   const std::vector<std::string>& symbols,
+                   const std::vector<CINNKernelInfo::ArgDimIdx>& symbol_dims);
+
+  // The copy of the group with the symbolic dims substituted by shape.
+  OpLoweringGroupPtr MakeStaticGroup(const Shape& shape) const;
+  // Compiles the kernel for shape, on the background compilation pool.
+  void Specialize(const Shape& shape);
+
+  Target target_;
+  std::unique_ptr<::pir::Program> program_;
+  // The copy of the group in program_.
+  OpLoweringGroupPtr group_;
+  std::vector<std::string> symbols_;
+  std::vector<CINNKernelInfo::ArgDimIdx> symbol_dims_;
+  CompileFunction compile_;
+
+  std::mutex mutex_;
+  // The runs of the shapes not scheduled yet.
+  std::map<Shape, int> observed_counts_;
+  int num_scheduled_{0};
+  // Set once num_scheduled_ reaches the limit, for Observe to return early.
+  std::atomic<bool> exhausted_{false};
+  // Hold the compiled modules the kernels of the specializations are in.
+  std::vector<std::shared_ptr<CompilationResult>> compilation_results_;
+  std::vector<std::pair<Shape, CINNKernelInfo>> kernel_infos_;
+  std::atomic<size_t> num_kernel_infos_{0};
+};
+
+/**
+ * Looks up the kernels specialized by a ShapeSpecializer by the shapes of the
+ * runs. The shapes without one are observed, for the specializer to compile
+ * the frequent ones, and left to the generic kernel.
+ */
+template <typename KernelT>
+class ShapeDispatcher {
+ public:
+  using MakeKernel =
+      std::function<std::unique_ptr<KernelT>(const CINNKernelInfo&)>;
+
+  ShapeDispatcher(const std::shared_ptr<ShapeSpecializer>& shape_specializer,
+                  const MakeKernel& make_kernel)
+      : shape_specializer_(shape_specializer), make_kernel_(make_kernel) {}
+
+  const std::vector<CINNKernelInfo::ArgDimIdx>& SymbolDims() const {
+    return shape_specializer_->SymbolDims();
+  }
+
+  // Returns the kernel specialized for shape, nullptr if there is none yet.
+  KernelT* Dispatch(const ShapeSpecializer::Shape& shape) {
+    if (shape_specializer_->NumKernelInfos() > kernels_.size()) {
+      for (const auto& [kernel_shape, kernel_info] :
+           shape_specializer_->GetKernelInfos(kernels_.size())) {
+        kernels_.emplace_back(kernel_shape, make_kernel_(kernel_info));
+      }
+    }
+    for (const auto& [kernel_shape, kernel] : kernels_) {
+      if (kernel_shape == shape) {
+        return kernel.get();
+      }
+    }
+    shape_specializer_->Observe(shape);
+    return nullptr;
+  }
+
+ private:
+  std::shared_ptr<ShapeSpecializer> shape_specializer_;
+  MakeKernel make_kernel_;
+  // At most FLAGS_cinn_max_shape_specializations, looked up one by one, in
+  // the order of the kernel infos of the specializer.
+  std::vector<std::pair<ShapeSpecializer::Shape, std::unique_ptr<KernelT>>>
+      kernels_;
+};
+
+}  // namespace cinn::hlir::framework::pir
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #pragma once
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,6 +30,9 @@ namespace framework {
 
 namespace pir {
 
+class AsyncKernel;
+class ShapeSpecializer;
+
 struct CINNKernelInfo {
   std::string fn_name;
   void* fn_ptr;
@@ -51,6 +55,12 @@ struct CINNKernelInfo {
   //     3: {1, 2}
   //   }
   std::map<int, ArgDimIdx> int_args_map;
+  // Compiles the kernels of the dynamic shape group for the static shapes it
+  // frequently runs with, nullptr if it is not specialized.
+  std::shared_ptr<ShapeSpecializer> shape_specializer;
+  // Set while the kernel is compiled in the background, fn_ptr and
+  // infer_shape_fn_ptr being nullptr meanwhile.
+  std::shared_ptr<AsyncKernel> async_kernel;
 };
 
 struct CompatibleInfo {
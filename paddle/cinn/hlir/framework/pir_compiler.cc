@@ -14,13 +14,17 @@
 
 #include "paddle/cinn/hlir/framework/pir_compiler.h"
 
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
+#include "paddle/cinn/hlir/framework/pir/shape_specializer.h"
 #include "paddle/cinn/hlir/framework/pir/utils.h"
 #include "paddle/cinn/utils/multi_threading.h"
 #include "paddle/common/enforce.h"
 #include "paddle/common/flags.h"
+#include "paddle/pir/include/core/ir_context.h"
 
 PD_DECLARE_bool(enable_cinn_compile_cache);
 PD_DECLARE_int64(cinn_compile_thread_num);
+PD_DECLARE_bool(cinn_specialize_dynamic_shape);
 
 namespace cinn::hlir::framework {
 
@@ -39,6 +43,8 @@ class CompilationContextMapper {
   }
 
   std::vector<pir::CINNKernelInfo> RecoverKernelInfos();
+  void SetShapeSpecializers(const Target& target,
+                            const std::vector<pir::OpLoweringGroupPtr>& groups);
   void UpdateGlobalCache();
   void SetFinalize(bool val) { is_finalized_ = val; }
 
@@ -83,11 +89,62 @@ std::vector<pir::CINNKernelInfo> PirCompiler::Build(
                         /*thread_num=*/thread_size);
   }
   VLOG(5) << "Finished compiling " << task_size << " Cinn Kernel info.";
+  if (FLAGS_cinn_specialize_dynamic_shape) {
+    ctx_mapper.SetShapeSpecializers(target_, groups);
+  }
   ctx_mapper.SetFinalize(true);
   ctx_mapper.UpdateGlobalCache();
   return ctx_mapper.RecoverKernelInfos();
 }
 
+void PirCompiler::BuildAsync(
+    const std::vector<pir::OpLoweringGroupPtr>& groups,
+    const std::function<std::shared_ptr<::pir::Program>(
+        const pir::OpLoweringGroupPtr&)>& BuildFallbackProgram) {
+  std::unordered_set<size_t> unique_infos;
+  for (const auto& group : groups) {
+    pir::FusionInfo fusion_info(*group);
+    if (CompilationCache::Instance().Has(fusion_info) ||
+        !unique_infos.insert(fusion_info.hash()).second) {
+      continue;
+    }
+    auto async_kernel = std::make_shared<pir::AsyncKernel>(
+        group->FuncName(), BuildFallbackProgram(group));
+    auto compilation_result = std::make_shared<pir::CompilationResult>(target_);
+    compilation_result->SetAsyncKernel(async_kernel);
+    CompilationCache::Instance().Insert(fusion_info, compilation_result);
+
+    // NOTE: The ops of the group are erased once it is lowered, and the
+    // programs are built on the calling thread, so the group is cloned and
+    // its specializer created before it is scheduled.
+    auto program =
+        std::make_shared<::pir::Program>(::pir::IrContext::Instance());
+    pir::OpLoweringGroupPtr cloned_group = group->CloneToProgram(program.get());
+    std::shared_ptr<pir::ShapeSpecializer> shape_specializer =
+        FLAGS_cinn_specialize_dynamic_shape
+            ? pir::ShapeSpecializer::Create(target_, cloned_group)
+            : nullptr;
+    VLOG(5) << "Schedule the compilation of " << group->FuncName()
+            << (async_kernel->fallback_program() ? " with" : " without")
+            << " a fallback program.";
+    pir::ScheduleBackgroundCompilation([target = target_,
+                                        program,
+                                        cloned_group,
+                                        shape_specializer,
+                                        async_kernel] {
+      try {
+        GroupCompilationContext context(target, cloned_group);
+        std::shared_ptr<pir::CompilationResult> result =
+            CompilationTask(&context)();
+        result->SetShapeSpecializer(shape_specializer);
+        async_kernel->SetCompilationResult(result);
+      } catch (const std::exception& e) {
+        async_kernel->SetError(e.what());
+      }
+    });
+  }
+}
+
 void CompilationContextMapper::Construct(
     const Target& target, const std::vector<pir::OpLoweringGroupPtr>& groups) {
   std::unordered_set<size_t> unique_infos;
@@ -138,6 +195,16 @@ CompilationContextMapper::RecoverKernelInfos() {
   return kernel_infos;
 }
 
+void CompilationContextMapper::SetShapeSpecializers(
+    const Target& target, const std::vector<pir::OpLoweringGroupPtr>& groups) {
+  // NOTE: Created after the compilation on the calling thread, as the ops of
+  // the groups are cloned into the programs of the specializers.
+  for (size_t i = 0; i < compilation_results_.size(); ++i) {
+    compilation_results_[i]->SetShapeSpecializer(
+        pir::ShapeSpecializer::Create(target, groups[mapper_index_[i]]));
+  }
+}
+
 void CompilationContextMapper::UpdateGlobalCache() {
   PADDLE_ENFORCE_EQ(
       is_finalized_,
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include "paddle/cinn/common/macros.h"
 #include "paddle/cinn/hlir/framework/pir/compilation_task.h"
@@ -27,6 +28,14 @@ class PirCompiler final {
   std::vector<pir::CINNKernelInfo> Build(
       const std::vector<pir::OpLoweringGroupPtr>& groups);
 
+  // Schedules the compilation of the groups not in the cache on the
+  // background pool, inserting their results into the cache at once. Their
+  // kernels run as the fallback programs built for them until compiled.
+  void BuildAsync(
+      const std::vector<pir::OpLoweringGroupPtr>& groups,
+      const std::function<std::shared_ptr<::pir::Program>(
+          const pir::OpLoweringGroupPtr&)>& BuildFallbackProgram);
+
  private:
   CINN_DISALLOW_COPY_AND_ASSIGN(PirCompiler);
 
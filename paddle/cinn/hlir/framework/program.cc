@@ -206,7 +206,7 @@ void Program::Execute(
   DeviceSynchronize(instrs_[0]->target_.arch, stream);
 }
 
-void Program::ExecuteTest(int repeat_) {
+double Program::ExecuteTest(int repeat_) {
   cinn::utils::Timer timer1;
   for (int i = 0; i < 100; i++) {
     for (auto& ins : instrs_) {
@@ -223,6 +223,7 @@ void Program::ExecuteTest(int repeat_) {
   double test_op_time = timer1.Stop() / repeat_;
   VLOG(3) << "Repeat times: [" << repeat_ << "], average op time: ["
           << test_op_time << "] ms";
+  return test_op_time;
 }
 
 }  // namespace framework
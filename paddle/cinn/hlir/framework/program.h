@@ -49,7 +49,8 @@ class Program {
       void* stream = nullptr,
       bool use_cache = true);
 
-  void ExecuteTest(int repeat_);
+  // Returns the average milliseconds of a run, after 100 warmup runs.
+  double ExecuteTest(int repeat_);
 
   /**
    * Get the number of instructions.
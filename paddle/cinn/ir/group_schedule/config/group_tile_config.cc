@@ -302,6 +302,22 @@ BuildDynamicShapeConfig(
   CINN_NOT_IMPLEMENTED;
 }
 
+std::unordered_map<BucketInfo, ScheduleConfig::TileConfig, BucketInfoHash>
+BuildHostConfig(const std::shared_ptr<ScheduleConfig::BaseInfo>& base_info,
+                const common::Target& target) {
+  // A single bucket, the host tactic derives its tiles from the extents.
+  BucketInfo bucket_info{/* sp_lower_bound = */ 1,
+                         /* sp_upper_bound = */ kMaxNumel,
+                         /* rb_lower_bound = */ 1,
+                         /* rb_upper_bound = */ kMaxNumel};
+  ScheduleConfig::TileConfig tile_config{
+      /* warp_num = */ 1,
+      /* tree_reduce_num = */ 1,
+      /* spatial_inner_num = */ 1,
+      /* reduce_method = */ NoneReduceMethod()};
+  return {{bucket_info, tile_config}};
+}
+
 std::unordered_map<BucketInfo, ScheduleConfig, BucketInfoHash>
 CombineBaseInfoAndConfig(
     const std::unordered_map<BucketInfo,
@@ -322,6 +338,11 @@ BuildScheduleConfig(
     const common::Target& target) {
   std::shared_ptr<ScheduleConfig::BaseInfo> base_info =
       InitBasicInfo(group_info);
+  if (std::holds_alternative<common::X86Arch>(target.arch)) {
+    VLOG(6) << "Building host config.";
+    return CombineBaseInfoAndConfig(BuildHostConfig(base_info, target),
+                                    base_info);
+  }
   if (!base_info->has_dynamic_reduce && !base_info->has_dynamic_spatial) {
     VLOG(6) << "Building static sptial and static reduce config.";
     return CombineBaseInfoAndConfig(
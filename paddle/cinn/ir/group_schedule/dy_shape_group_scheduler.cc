@@ -20,6 +20,7 @@
 #include "paddle/cinn/ir/group_schedule/tactic/compute_inline_tactic.h"
 #include "paddle/cinn/ir/group_schedule/tactic/optimize_reduction_tactic.h"
 #include "paddle/cinn/ir/group_schedule/tactic/tile_first_general_tactic.h"
+#include "paddle/cinn/ir/group_schedule/tactic/tile_first_host_tactic.h"
 #include "paddle/cinn/ir/group_schedule/tactic/tile_tactic.h"
 #include "paddle/cinn/ir/ir_analyzer/ir_analyzer.h"
 #include "paddle/cinn/ir/op/ir_operators.h"
@@ -36,6 +37,14 @@ void DynamicShapeGroupScheduler::Init() {
   VLOG(4) << "original group func body: \n"
           << ir_sch_->GetModule().GetExprs()[0];
   InitBuckets();
+  if (std::holds_alternative<common::X86Arch>(target_.arch)) {
+    // Without threads to keep the intermediates in, the elementwise
+    // producers are inlined into their consumers on the host.
+    tactics_.emplace_back(CreateComputeInlineTactic());
+    tactics_.emplace_back(CreateTileFirstHostTactic());
+    VLOG(4) << "CreateTileFirstHostTactic End";
+    return;
+  }
   tactics_.emplace_back(CreateTileFirstGeneralTactic());
   VLOG(4) << "CreateTileFirstGeneralTactic End";
 }
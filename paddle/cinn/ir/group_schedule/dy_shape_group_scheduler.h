@@ -21,7 +21,7 @@ namespace ir {
 
 /**
  * The class used for scheduling fusion groups with dynamic shape.
- * Note: Currently only CUDA backend is supported.
+ * Note: Currently only CUDA and X86 backends are supported.
  */
 class DynamicShapeGroupScheduler : public GroupScheduler {
  public:
@@ -0,0 +1,299 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/ir/group_schedule/tactic/tile_first_host_tactic.h"
+#include <algorithm>
+#include <set>
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/ir/ir.h"
+#include "paddle/cinn/ir/ir_analyzer/ir_analyzer.h"
+#include "paddle/cinn/ir/schedule/ir_schedule_util.h"
+#include "paddle/cinn/ir/utils/ir_nodes_collector.h"
+
+namespace cinn {
+namespace ir {
+
+namespace {
+
+// The data cache of a core assumed by the tiles: a tile of the spatial axis
+// touches at most kL2CacheBytes, the unit of the parallel tasks.
+constexpr int64_t kL2CacheBytes = 1024 * 1024;
+// Reductions of at least so many vectors are factorized over the lanes.
+constexpr int64_t kLongReduceVectors = 8;
+
+int64_t LargestDivisorNotAbove(int64_t n, int64_t limit) {
+  for (int64_t d = std::min(n, limit); d > 1; --d) {
+    if (n % d == 0) return d;
+  }
+  return 1;
+}
+
+bool IsConstantMultipleOf(const ir::Expr& extent, int64_t factor) {
+  return extent.is_constant() &&
+         static_cast<int64_t>(extent.get_constant()) % factor == 0;
+}
+
+}  // namespace
+
+int HostVectorBits() {
+#if defined(__x86_64__) || defined(__i386__)
+  static const int bits = __builtin_cpu_supports("avx512f") ? 512
+                          : __builtin_cpu_supports("avx2")  ? 256
+                                                            : 128;
+  return bits;
+#else
+  return 128;
+#endif
+}
+
+class TileFirstHostTactic final : public ScheduleTactic {
+ public:
+  void Init(ScheduleContext* context) override;
+
+  void Apply(ir::IRSchedule* sch, const std::string& block_id) override;
+
+  std::string TacticName() const override { return "TileFirstHostTactic"; }
+
+ private:
+  void MergeFlattenAxis(ir::IRSchedule* sch, const std::string& block_id);
+  void MergeReduceAxis(ir::IRSchedule* sch, const std::string& block_id);
+  void TileSpatialAxis(ir::IRSchedule* sch, const std::string& block_id);
+  void SplitInnerAxis(ir::IRSchedule* sch, const std::string& block_id);
+  void FactorizeLongReduction(ir::IRSchedule* sch,
+                              const std::string& block_id);
+  void Vectorize(ir::IRSchedule* sch, const std::string& block_id);
+  void Parallel(ir::IRSchedule* sch, const std::string& block_id);
+
+  bool IsReduceBlock(const std::string& block_id) const;
+  // The lanes of a vector of the type stored by the block, 1 for the types
+  // not vectorized.
+  int VectorLanes(ir::IRSchedule* sch, const std::string& block_id) const;
+  // The bytes loaded and stored by an iteration of the block.
+  int64_t IterationBytes(ir::IRSchedule* sch,
+                         const std::string& block_id) const;
+
+ private:
+  ScheduleContext* context_;
+  std::vector<int32_t> vec_flatten_axis_;
+  std::vector<int32_t> vec_reduce_axis_;
+  // The state of the block being scheduled.
+  int inner_axis_{0};
+  int lanes_{1};
+  bool vectorizable_{false};
+  bool factorized_{false};
+};
+
+void TileFirstHostTactic::Init(ScheduleContext* context) {
+  context_ = context;
+  // reduce axis have be re-order to last
+  vec_flatten_axis_.clear();
+  vec_reduce_axis_.clear();
+  int32_t reduce_start_idx = context_->config.base_info->data_rank -
+                             context_->config.base_info->reduce_axis.size();
+  for (int32_t i = 0; i < context_->config.base_info->data_rank; ++i) {
+    if (i >= reduce_start_idx) {
+      vec_reduce_axis_.push_back(i);
+    } else {
+      vec_flatten_axis_.push_back(i);
+    }
+  }
+}
+
+void TileFirstHostTactic::Apply(ir::IRSchedule* sch,
+                                const std::string& block_id) {
+  if (ir::IsReduceInitTensorName(block_id)) return;
+  inner_axis_ = 0;
+  lanes_ = 1;
+  vectorizable_ = false;
+  factorized_ = false;
+  // The blocks out of the iteration space of the group, left by the inline,
+  // are only parallelized.
+  if (sch->GetLoops(block_id).size() !=
+      static_cast<size_t>(context_->config.base_info->data_rank)) {
+    Parallel(sch, block_id);
+    return;
+  }
+  MergeReduceAxis(sch, block_id);
+  MergeFlattenAxis(sch, block_id);
+  TileSpatialAxis(sch, block_id);
+  VLOG(6) << "After TileSpatialAxis on block: [" << block_id
+          << "], loop nest:\n"
+          << sch->GetLoops(block_id)[0];
+  SplitInnerAxis(sch, block_id);
+  VLOG(6) << "After SplitInnerAxis on block: [" << block_id
+          << "], loop nest:\n"
+          << sch->GetLoops(block_id)[0];
+  FactorizeLongReduction(sch, block_id);
+  VLOG(6) << "After FactorizeLongReduction on block: [" << block_id
+          << "], loop nest:\n"
+          << sch->GetLoops(block_id)[0];
+  Vectorize(sch, block_id);
+  Parallel(sch, block_id);
+  VLOG(6) << "After Parallel on block: [" << block_id << "], loop nest:\n"
+          << sch->GetLoops(block_id)[0];
+}
+
+void TileFirstHostTactic::MergeFlattenAxis(ir::IRSchedule* sch,
+                                           const std::string& block_id) {
+  if (vec_flatten_axis_.size() >= 2) {
+    sch->Fuse(block_id, vec_flatten_axis_);
+  }
+}
+
+void TileFirstHostTactic::MergeReduceAxis(ir::IRSchedule* sch,
+                                          const std::string& block_id) {
+  if (vec_reduce_axis_.size() >= 2) {
+    sch->Fuse(block_id, vec_reduce_axis_);
+  }
+}
+
+void TileFirstHostTactic::TileSpatialAxis(ir::IRSchedule* sch,
+                                          const std::string& block_id) {
+  lanes_ = VectorLanes(sch, block_id);
+  int64_t iteration_bytes = IterationBytes(sch, block_id);
+  auto loops = sch->GetLoops(block_id);
+  ir::Expr sp_extent = loops[0].As<ir::For>()->extent;
+
+  if (vec_reduce_axis_.empty()) {
+    // Only a spatial axis, split into tiles of vectors: [tile, vector, lane].
+    if (lanes_ > 1 && IsConstantMultipleOf(sp_extent, lanes_)) {
+      int64_t vectors =
+          static_cast<int64_t>(sp_extent.get_constant()) / lanes_;
+      int64_t tile_vectors = LargestDivisorNotAbove(
+          vectors,
+          std::max<int64_t>(kL2CacheBytes / iteration_bytes / lanes_, 1));
+      sch->Split(loops[0],
+                 std::vector<int>({-1,
+                                   static_cast<int>(tile_vectors),
+                                   static_cast<int>(lanes_)}));
+      inner_axis_ = 2;
+      vectorizable_ = true;
+    } else if (sp_extent.is_constant()) {
+      int64_t tile = LargestDivisorNotAbove(
+          static_cast<int64_t>(sp_extent.get_constant()),
+          std::max<int64_t>(kL2CacheBytes / iteration_bytes, 1));
+      if (tile > 1) {
+        sch->Split(loops[0], std::vector<int>({-1, static_cast<int>(tile)}));
+      }
+    }
+    return;
+  }
+
+  // Rows of the reduce axis, a tile of rows fits the cache.
+  inner_axis_ = vec_flatten_axis_.empty() ? 0 : 1;
+  ir::Expr rd_extent = loops[inner_axis_].As<ir::For>()->extent;
+  if (vec_flatten_axis_.empty() || !sp_extent.is_constant() ||
+      !rd_extent.is_constant()) {
+    return;
+  }
+  int64_t row_bytes =
+      static_cast<int64_t>(rd_extent.get_constant()) * iteration_bytes;
+  int64_t rows =
+      LargestDivisorNotAbove(static_cast<int64_t>(sp_extent.get_constant()),
+                             std::max<int64_t>(kL2CacheBytes / row_bytes, 1));
+  if (rows > 1) {
+    sch->Split(loops[0], std::vector<int>({-1, static_cast<int>(rows)}));
+    inner_axis_ = 2;
+  }
+}
+
+void TileFirstHostTactic::SplitInnerAxis(ir::IRSchedule* sch,
+                                         const std::string& block_id) {
+  if (vec_reduce_axis_.empty() || lanes_ <= 1) return;
+  auto loops = sch->GetLoops(block_id);
+  ir::Expr extent = loops[inner_axis_].As<ir::For>()->extent;
+  bool divisible = IsConstantMultipleOf(extent, lanes_);
+  // The inner loop of a reduction carries the accumulation, it is only split
+  // in lanes to be factorized.
+  bool is_long = !extent.is_constant() ||
+                 extent.get_constant() >= kLongReduceVectors * lanes_;
+  if (IsReduceBlock(block_id) ? !is_long : !divisible) return;
+  sch->Split(loops[inner_axis_],
+             std::vector<int>({-1, static_cast<int>(lanes_)}));
+  vectorizable_ = divisible;
+  factorized_ = IsReduceBlock(block_id);
+}
+
+void TileFirstHostTactic::FactorizeLongReduction(ir::IRSchedule* sch,
+                                                 const std::string& block_id) {
+  if (!factorized_) return;
+  // The partial sums of the lanes go last in the rf tensor, contiguous in
+  // the lanes like the loads of the reduction:
+  //   rf[i, v] += A[i, k * lanes + v];  B[i] += rf[i, v]
+  auto loops = sch->GetLoops(block_id);
+  int rf_axis =
+      analyzer::GetStoreTensorOfSBlock(sch->GetBlock(block_id))->shape.size();
+  sch->FactorizeReduction(loops[inner_axis_ + 1],
+                          rf_axis,
+                          /* with_write_back_block_init = */ false);
+}
+
+void TileFirstHostTactic::Vectorize(ir::IRSchedule* sch,
+                                    const std::string& block_id) {
+  if (!vectorizable_) return;
+  if (factorized_) {
+    auto rf_loops = sch->GetLoops(block_id + "_rf");
+    sch->Vectorize(rf_loops.back(), lanes_);
+  } else {
+    auto loops = sch->GetLoops(block_id);
+    sch->Vectorize(loops.back(), lanes_);
+  }
+}
+
+void TileFirstHostTactic::Parallel(ir::IRSchedule* sch,
+                                   const std::string& block_id) {
+  // The outer loop of a reduce all is the reduction itself.
+  auto loops = sch->GetLoops(block_id);
+  if (vec_flatten_axis_.empty() || loops.empty()) return;
+  // A loop nest launches its outer parallel loop on the thread pool of
+  // cinn_backend_parallel_launch, in one chunk per thread.
+  sch->Parallel(loops[0]);
+  if (factorized_) {
+    sch->Parallel(sch->GetLoops(block_id + "_rf")[0]);
+  }
+}
+
+bool TileFirstHostTactic::IsReduceBlock(const std::string& block_id) const {
+  return context_->config.base_info->reduce_tensor_names.count(block_id) > 0;
+}
+
+int TileFirstHostTactic::VectorLanes(ir::IRSchedule* sch,
+                                     const std::string& block_id) const {
+  Type type =
+      analyzer::GetStoreTensorOfSBlock(sch->GetBlock(block_id))->type();
+  if (!type.is_float(32) && !type.is_float(64)) return 1;
+  return HostVectorBits() / type.bits();
+}
+
+int64_t TileFirstHostTactic::IterationBytes(
+    ir::IRSchedule* sch, const std::string& block_id) const {
+  ir::Expr block = sch->GetBlock(block_id);
+  ir::Tensor store_tensor = analyzer::GetStoreTensorOfSBlock(block);
+  std::set<std::string> tensor_names{store_tensor->name};
+  int64_t bytes = store_tensor->type().bytes();
+  for (const ir::Expr& tensor : ir::ir_utils::CollectLoadTensors(
+           block, [](const ir::Expr*) { return true; })) {
+    if (tensor_names.insert(tensor.as_tensor()->name).second) {
+      bytes += tensor.as_tensor()->type().bytes();
+    }
+  }
+  return std::max<int64_t>(bytes, 1);
+}
+
+std::unique_ptr<ScheduleTactic> CreateTileFirstHostTactic() {
+  return std::make_unique<TileFirstHostTactic>();
+}
+
+}  // namespace ir
+}  // namespace cinn
@@ -0,0 +1,32 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include "paddle/cinn/ir/group_schedule/tactic/schedule_tactic.h"
+
+namespace cinn {
+namespace ir {
+
+// The counterpart of TileFirstGeneralTactic for the host target: the
+// flattened spatial axis is tiled to the cache and parallelized, the inner
+// axis vectorized, and long reductions factorized over the vector lanes.
+std::unique_ptr<ScheduleTactic> CreateTileFirstHostTactic();
+
+// The vector width of the host in bits, 512 with AVX-512, 256 with AVX2.
+int HostVectorBits();
+
+}  // namespace ir
+}  // namespace cinn
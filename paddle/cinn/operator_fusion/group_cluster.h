@@ -14,12 +14,15 @@
 
 #pragma once
 
+#include <type_traits>
+
 #include "paddle/cinn/operator_fusion/backend/pattern.h"
 #include "paddle/cinn/operator_fusion/backend/pattern_fuser.h"
 #include "paddle/cinn/operator_fusion/frontend/pattern.h"
 #include "paddle/cinn/operator_fusion/frontend/pattern_fuser.h"
 #include "paddle/cinn/operator_fusion/pattern_graph.h"
 #include "paddle/cinn/operator_fusion/policy/general_topo_policy.h"
+#include "paddle/cinn/operator_fusion/policy/memory_footprint_policy.h"
 #include "paddle/cinn/operator_fusion/policy/relative_judge_policy.h"
 #include "paddle/cinn/operator_fusion/policy/shardable_axes_policy.h"
 
@@ -67,8 +70,20 @@ inline std::vector<fusion::PatternNodePtr<T>> ClusterOps(
   const auto& general_topo_policy =
       std::make_shared<fusion::GeneralTopoPolicy<T>>();
 
-  auto policy_manager =
-      fusion::PolicyManager<T>({relative_judge_policy, general_topo_policy});
+  std::vector<fusion::PolicyPtr<T>> policies = {relative_judge_policy,
+                                                general_topo_policy};
+  // The backend fuses the ops of a group into a single node, so the merges
+  // are judged by their memory only when the groups are clustered.
+  std::shared_ptr<fusion::MemoryFootprintPolicy<T>> memory_footprint_policy;
+  if constexpr (std::is_same_v<T, fusion::FrontendStage>) {
+    memory_footprint_policy =
+        fusion::MemoryFootprintPolicy<T>::CreateFromFlags(outputs);
+    if (memory_footprint_policy) {
+      policies.push_back(memory_footprint_policy);
+    }
+  }
+
+  auto policy_manager = fusion::PolicyManager<T>(policies);
 
   auto topo_manager = fusion::PolicyManager<T>({general_topo_policy});
 
@@ -76,6 +91,9 @@ inline std::vector<fusion::PatternNodePtr<T>> ClusterOps(
   fusion::PatternGraph<T> graph(
       content_without_yield, outputs, policy_manager, topo_manager);
   auto result = graph.ClusterOps();
+  if (memory_footprint_policy) {
+    memory_footprint_policy->ExportDecisions();
+  }
 
   VLOG(4) << "End Cluster Ops! result size:" << result.size();
   for (const auto& node : result) {
@@ -34,6 +34,8 @@ std::vector<PatternNodePtr<T>> PatternGraph<T>::ClusterOps() {
   ReduceLiftReduceTree();
   VLOG(4) << "[Group Cluster] After ReduceLiftReduceTree: " << GraphInfo();
 
+  policy_manager_.PlanFusion(SortByTopoOrder());
+
   // ReduceTreePattern + ReduceTreePattern fusion
   VLOG(4) << "[Group Cluster] Start ReduceTreeGrown";
   ReduceTreeGrown();
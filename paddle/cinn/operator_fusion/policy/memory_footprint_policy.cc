@@ -0,0 +1,431 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/operator_fusion/policy/memory_footprint_policy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>  // NOLINT
+#include <sstream>
+
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/operator_fusion/backend/pattern.h"
+#include "paddle/cinn/operator_fusion/backend/pattern_fuser.h"
+#include "paddle/cinn/operator_fusion/frontend/pattern.h"
+#include "paddle/cinn/operator_fusion/frontend/pattern_fuser.h"
+#include "paddle/cinn/runtime/flags.h"
+#include "paddle/common/ddim.h"
+#include "paddle/pir/include/core/builtin_type.h"
+
+PD_DECLARE_bool(cinn_enable_memory_aware_fusion);
+PD_DECLARE_int64(cinn_fusion_working_set_limit);
+PD_DECLARE_string(cinn_fusion_plan_algorithm);
+PD_DECLARE_string(cinn_fusion_decisions_path);
+
+namespace cinn::fusion {
+
+namespace {
+
+// The extent assumed for a dynamic dim.
+constexpr int64_t kDynamicDimEstimate = 1024;
+// The bytes the estimates saturate at, far below the overflow of their sums.
+constexpr int64_t kMaxEstimateBytes = int64_t{1} << 48;
+// The working set of a row kept in the L2 cache a core of the host has.
+constexpr int64_t kHostWorkingSetLimit = 256 * 1024;
+// The working set of a row kept in the shared memory of a block.
+constexpr int64_t kNVGPUWorkingSetLimit = 48 * 1024;
+
+int64_t ElementBytes(const pir::Type& dtype) {
+  if (dtype.isa<pir::Complex128Type>()) return 16;
+  if (dtype.isa<pir::Float64Type>() || dtype.isa<pir::Int64Type>() ||
+      dtype.isa<pir::IndexType>() || dtype.isa<pir::Complex64Type>()) {
+    return 8;
+  }
+  if (dtype.isa<pir::Float16Type>() || dtype.isa<pir::BFloat16Type>() ||
+      dtype.isa<pir::Int16Type>()) {
+    return 2;
+  }
+  if (dtype.isa<pir::Int8Type>() || dtype.isa<pir::UInt8Type>() ||
+      dtype.isa<pir::BoolType>()) {
+    return 1;
+  }
+  return 4;
+}
+
+pir::DenseTensorType GetTensorType(pir::Value value) {
+  if (!value || !value.type()) return pir::DenseTensorType();
+  return value.type().dyn_cast<pir::DenseTensorType>();
+}
+
+int64_t DimOrEstimate(int64_t dim) {
+  return dim < 0 ? kDynamicDimEstimate : dim;
+}
+
+// a * b of non-negative a and b, at most kMaxEstimateBytes.
+int64_t SaturatedMul(int64_t a, int64_t b) {
+  if (a != 0 && b > kMaxEstimateBytes / a) return kMaxEstimateBytes;
+  return std::min(a * b, kMaxEstimateBytes);
+}
+
+int64_t TensorBytes(pir::Value value) {
+  const auto& type = GetTensorType(value);
+  if (!type) return 0;
+  // Saturated, a few dynamic dims estimated overflowing int64.
+  int64_t bytes = ElementBytes(type.dtype());
+  for (int64_t dim : ::common::vectorize(type.dims())) {
+    bytes = SaturatedMul(bytes, DimOrEstimate(dim));
+  }
+  return bytes;
+}
+
+int64_t RowBytes(pir::Value value) {
+  const auto& type = GetTensorType(value);
+  if (!type) return 0;
+  const auto& dims = type.dims();
+  const int rank = dims.size();
+  const int64_t inner = rank == 0 ? 1 : DimOrEstimate(dims[rank - 1]);
+  return inner * ElementBytes(type.dtype());
+}
+
+int64_t NumRows(pir::Operation* sink_op) {
+  if (sink_op == nullptr || sink_op->num_results() == 0) return 1;
+  const int64_t row_bytes = RowBytes(sink_op->result(0));
+  if (row_bytes == 0) return 1;
+  return std::max<int64_t>(TensorBytes(sink_op->result(0)) / row_bytes, 1);
+}
+
+int64_t WorkingSetBytes(const std::vector<pir::Operation*>& ops) {
+  std::unordered_set<pir::Value> values;
+  for (auto* op : ops) {
+    for (const auto& operand : op->operands_source()) {
+      values.insert(operand);
+    }
+    for (const auto& result : op->results()) {
+      values.insert(result);
+    }
+  }
+  int64_t bytes = 0;
+  for (const auto& value : values) {
+    bytes += RowBytes(value);
+  }
+  return bytes;
+}
+
+std::string NodeName(pir::Operation* sink_op) {
+  return sink_op->name() + "_" + std::to_string(sink_op->id());
+}
+
+}  // namespace
+
+template <typename T>
+std::shared_ptr<MemoryFootprintPolicy<T>>
+MemoryFootprintPolicy<T>::CreateFromFlags(
+    const std::vector<pir::Value>& outputs) {
+  if (!FLAGS_cinn_enable_memory_aware_fusion) return nullptr;
+  int64_t working_set_limit = FLAGS_cinn_fusion_working_set_limit;
+  if (working_set_limit <= 0) {
+    working_set_limit = std::holds_alternative<cinn::common::NVGPUArch>(
+                            cinn::common::DefaultTarget().arch)
+                            ? kNVGPUWorkingSetLimit
+                            : kHostWorkingSetLimit;
+  }
+  PADDLE_ENFORCE_EQ(FLAGS_cinn_fusion_plan_algorithm == "greedy" ||
+                        FLAGS_cinn_fusion_plan_algorithm == "dp",
+                    true,
+                    phi::errors::InvalidArgument(
+                        "FLAGS_cinn_fusion_plan_algorithm should be 'greedy' "
+                        "or 'dp', but got '%s'.",
+                        FLAGS_cinn_fusion_plan_algorithm));
+  const auto algorithm = FLAGS_cinn_fusion_plan_algorithm == "dp"
+                             ? FusionPlanAlgorithm::kDP
+                             : FusionPlanAlgorithm::kGreedy;
+  return std::make_shared<MemoryFootprintPolicy<T>>(
+      outputs, working_set_limit, algorithm);
+}
+
+template <typename T>
+FusionCost MemoryFootprintPolicy<T>::EstimateCost(
+    const std::vector<pir::Operation*>& upstream_ops,
+    const std::vector<pir::Operation*>& downstream_ops,
+    pir::Operation* sink_op) const {
+  std::unordered_set<pir::Operation*> fused_ops(upstream_ops.begin(),
+                                                upstream_ops.end());
+  fused_ops.insert(downstream_ops.begin(), downstream_ops.end());
+  const std::unordered_set<pir::Operation*> downstream_op_set(
+      downstream_ops.begin(), downstream_ops.end());
+
+  FusionCost cost;
+  for (auto* op : upstream_ops) {
+    for (const auto& result : op->results()) {
+      bool used_by_downstream = false;
+      bool used_outside = outputs_.count(result) > 0;
+      for (auto it = result.use_begin(); it != result.use_end(); ++it) {
+        used_by_downstream |= downstream_op_set.count(it->owner()) > 0;
+        used_outside |= fused_ops.count(it->owner()) == 0;
+      }
+      if (!used_by_downstream) continue;
+      // The downstream reads the intermediate from the upstream, which no
+      // longer writes it unless it is used outside.
+      cost.saved_bytes += TensorBytes(result) * (used_outside ? 1 : 2);
+    }
+  }
+  std::vector<pir::Operation*> ops(upstream_ops);
+  ops.insert(ops.end(), downstream_ops.begin(), downstream_ops.end());
+  cost.working_set_bytes = WorkingSetBytes(ops);
+  cost.num_rows = NumRows(sink_op);
+  return cost;
+}
+
+template <typename T>
+int64_t MemoryFootprintPolicy<T>::Score(const FusionCost& cost) const {
+  // Each row spills the working set over the limit, and reloads it.
+  const int64_t spilled_bytes =
+      std::max<int64_t>(cost.working_set_bytes - working_set_limit_, 0) * 2;
+  return cost.saved_bytes - SaturatedMul(spilled_bytes, cost.num_rows);
+}
+
+template <typename T>
+bool MemoryFootprintPolicy<T>::CanFuse(const PatternNodePtr<T>& upstream,
+                                       const PatternNodePtr<T>& downstream) {
+  VLOG(4) << "Start MemoryFootprintPolicy";
+  FusionDecision decision;
+  decision.upstream = NodeName(upstream->sink_op());
+  decision.downstream = NodeName(downstream->sink_op());
+  decision.cost = EstimateCost(GetOpsInPattern(upstream->stmt_pattern()),
+                               GetOpsInPattern(downstream->stmt_pattern()),
+                               downstream->sink_op());
+  decision.score = Score(decision.cost);
+  auto it = planned_merges_.find(
+      MergeKey(upstream->sink_op(), downstream->sink_op()));
+  decision.planned = it != planned_merges_.end();
+  decision.accepted = decision.planned ? it->second : decision.score >= 0;
+  VLOG(4) << "MemoryFootprintPolicy: " << decision.upstream << " -> "
+          << decision.downstream << " saves " << decision.cost.saved_bytes
+          << " bytes with a working set of "
+          << decision.cost.working_set_bytes << " bytes, "
+          << (decision.accepted ? "accepted" : "rejected");
+  decisions_.push_back(decision);
+  return decision.accepted;
+}
+
+template <typename T>
+MemoryFootprintPolicy<T>::Components::Components(
+    const std::vector<PatternNodePtr<T>>& nodes) {
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    parents.push_back(i);
+    ops.push_back(GetOpsInPattern(nodes[i]->stmt_pattern()));
+    sink_ops.push_back(nodes[i]->sink_op());
+  }
+  node_sink_ops = sink_ops;
+}
+
+template <typename T>
+size_t MemoryFootprintPolicy<T>::Components::Find(size_t node) {
+  while (parents[node] != node) {
+    parents[node] = parents[parents[node]];
+    node = parents[node];
+  }
+  return node;
+}
+
+template <typename T>
+void MemoryFootprintPolicy<T>::Components::Merge(size_t upstream,
+                                                 size_t downstream) {
+  upstream = Find(upstream);
+  downstream = Find(downstream);
+  if (upstream == downstream) return;
+  // The merged component sinks at the downstream, its root.
+  parents[upstream] = downstream;
+  ops[downstream].insert(
+      ops[downstream].end(), ops[upstream].begin(), ops[upstream].end());
+  ops[upstream].clear();
+}
+
+template <typename T>
+void MemoryFootprintPolicy<T>::SetPlanned(const Components& components,
+                                          const MergeCandidate& merge,
+                                          bool accepted) {
+  planned_merges_[MergeKey(components.node_sink_ops[merge.upstream],
+                           components.node_sink_ops[merge.downstream])] =
+      accepted;
+}
+
+template <typename T>
+void MemoryFootprintPolicy<T>::PlanFusion(
+    const std::vector<PatternNodePtr<T>>& nodes) {
+  planned_merges_.clear();
+  std::unordered_map<PatternNodePtr<T>, size_t> node_index;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    node_index[nodes[i]] = i;
+  }
+  std::vector<MergeCandidate> merges;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i]->downstream().size() != 1) continue;
+    auto it = node_index.find(nodes[i]->downstream().at(0));
+    if (it == node_index.end()) continue;
+    merges.push_back(MergeCandidate{i, it->second});
+  }
+
+  Components components(nodes);
+  if (algorithm_ == FusionPlanAlgorithm::kDP) {
+    merges = PlanChains(merges, &components);
+  }
+  PlanGreedily(merges, &components);
+  VLOG(4) << "MemoryFootprintPolicy planned " << planned_merges_.size()
+          << " merges of " << nodes.size() << " nodes.";
+}
+
+template <typename T>
+std::vector<typename MemoryFootprintPolicy<T>::MergeCandidate>
+MemoryFootprintPolicy<T>::PlanChains(const std::vector<MergeCandidate>& merges,
+                                     Components* components) {
+  constexpr size_t kNone = std::numeric_limits<size_t>::max();
+  const size_t num_nodes = components->parents.size();
+  std::vector<size_t> next(num_nodes, kNone);
+  std::vector<int> num_upstream_merges(num_nodes, 0);
+  for (const auto& merge : merges) {
+    next[merge.upstream] = merge.downstream;
+    ++num_upstream_merges[merge.downstream];
+  }
+
+  // A chain starts at a node merged into its downstream, unless it is the
+  // only node merged into it, and goes on along the only upstreams merged.
+  // The merges into the nodes with more upstreams merged are left.
+  std::vector<MergeCandidate> merges_left;
+  for (size_t start = 0; start < num_nodes; ++start) {
+    if (next[start] == kNone || num_upstream_merges[start] == 1) continue;
+    std::vector<size_t> chain{start};
+    while (next[chain.back()] != kNone &&
+           num_upstream_merges[next[chain.back()]] == 1) {
+      chain.push_back(next[chain.back()]);
+    }
+    if (next[chain.back()] != kNone) {
+      merges_left.push_back(MergeCandidate{chain.back(), next[chain.back()]});
+    }
+
+    const size_t length = chain.size();
+    std::vector<int64_t> saved_bytes(length, 0);
+    for (size_t i = 0; i + 1 < length; ++i) {
+      saved_bytes[i] = EstimateCost(components->ops[chain[i]],
+                                    components->ops[chain[i + 1]],
+                                    components->sink_ops[chain[i + 1]])
+                           .saved_bytes;
+    }
+    // best[j] is the best score splitting the first j nodes, whose last
+    // segment starts at start_of[j].
+    std::vector<int64_t> best(length + 1, 0);
+    std::vector<size_t> start_of(length + 1, 0);
+    for (size_t j = 1; j <= length; ++j) {
+      best[j] = std::numeric_limits<int64_t>::min();
+      std::vector<pir::Operation*> segment_ops;
+      FusionCost cost;
+      cost.num_rows = NumRows(components->sink_ops[chain[j - 1]]);
+      for (size_t i = j; i-- > 0;) {
+        const auto& ops = components->ops[chain[i]];
+        segment_ops.insert(segment_ops.end(), ops.begin(), ops.end());
+        if (i + 1 < j) cost.saved_bytes += saved_bytes[i];
+        cost.working_set_bytes = WorkingSetBytes(segment_ops);
+        const int64_t score = best[i] + (i + 1 < j ? Score(cost) : 0);
+        if (score > best[j]) {
+          best[j] = score;
+          start_of[j] = i;
+        }
+      }
+    }
+    for (size_t j = length; j > 0; j = start_of[j]) {
+      const size_t i = start_of[j];
+      for (size_t k = i; k + 1 < j; ++k) {
+        SetPlanned(*components, MergeCandidate{chain[k], chain[k + 1]}, true);
+        components->Merge(chain[k], chain[k + 1]);
+      }
+      if (i > 0) {
+        SetPlanned(
+            *components, MergeCandidate{chain[i - 1], chain[i]}, false);
+      }
+    }
+  }
+  return merges_left;
+}
+
+template <typename T>
+void MemoryFootprintPolicy<T>::PlanGreedily(
+    const std::vector<MergeCandidate>& merges, Components* components) {
+  std::vector<std::pair<int64_t, MergeCandidate>> candidates;
+  for (const auto& merge : merges) {
+    const size_t upstream = components->Find(merge.upstream);
+    const size_t downstream = components->Find(merge.downstream);
+    const auto& cost = EstimateCost(components->ops[upstream],
+                                    components->ops[downstream],
+                                    components->sink_ops[downstream]);
+    candidates.emplace_back(cost.saved_bytes, merge);
+  }
+  std::stable_sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+  for (const auto& [_, merge] : candidates) {
+    const size_t upstream = components->Find(merge.upstream);
+    const size_t downstream = components->Find(merge.downstream);
+    if (upstream == downstream) continue;
+    const auto& cost = EstimateCost(components->ops[upstream],
+                                    components->ops[downstream],
+                                    components->sink_ops[downstream]);
+    const bool accepted = Score(cost) >= 0;
+    SetPlanned(*components, merge, accepted);
+    if (accepted) {
+      components->Merge(upstream, downstream);
+    }
+  }
+}
+
+template <typename T>
+std::string MemoryFootprintPolicy<T>::DecisionsDebugStr() const {
+  std::stringstream ss;
+  for (const auto& decision : decisions_) {
+    ss << "{\"upstream\": \"" << decision.upstream << "\", \"downstream\": \""
+       << decision.downstream
+       << "\", \"saved_bytes\": " << decision.cost.saved_bytes
+       << ", \"working_set_bytes\": " << decision.cost.working_set_bytes
+       << ", \"num_rows\": " << decision.cost.num_rows
+       << ", \"working_set_limit\": " << working_set_limit_
+       << ", \"score\": " << decision.score
+       << ", \"planned\": " << (decision.planned ? "true" : "false")
+       << ", \"accepted\": " << (decision.accepted ? "true" : "false")
+       << "}\n";
+  }
+  return ss.str();
+}
+
+template <typename T>
+void MemoryFootprintPolicy<T>::ExportDecisions() const {
+  const std::string& decisions = DecisionsDebugStr();
+  VLOG(4) << "MemoryFootprintPolicy decisions:\n" << decisions;
+  if (FLAGS_cinn_fusion_decisions_path.empty() || decisions.empty()) return;
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::ofstream os(FLAGS_cinn_fusion_decisions_path, std::ios::app);
+  if (!os.is_open()) {
+    LOG(WARNING) << "Failed to open " << FLAGS_cinn_fusion_decisions_path
+                 << " to export the fusion decisions.";
+    return;
+  }
+  os << decisions;
+}
+
+template class MemoryFootprintPolicy<FrontendStage>;
+template class MemoryFootprintPolicy<BackendStage>;
+
+}  // namespace cinn::fusion
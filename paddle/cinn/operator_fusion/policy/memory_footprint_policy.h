@@ -0,0 +1,133 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <map>
+#include <string>
+#include <utility>
+#include "paddle/cinn/operator_fusion/policy/policy_manager.h"
+#include "paddle/cinn/operator_fusion/utils.h"
+
+namespace cinn::fusion {
+
+enum class FusionPlanAlgorithm {
+  // Merge by the bytes saved, from the most, while the spills pay off.
+  kGreedy,
+  // Split each chain of single downstream merges by dynamic programming.
+  kDP,
+};
+
+// The memory estimated for a merge of pattern nodes.
+struct FusionCost {
+  // The bytes of the intermediates between the nodes which are no longer
+  // written to and read back from the global memory.
+  int64_t saved_bytes{0};
+  // The bytes a row of the fused kernel keeps live, a row being the
+  // innermost dim of each value it touches.
+  int64_t working_set_bytes{0};
+  // The rows the fused kernel iterates over.
+  int64_t num_rows{1};
+};
+
+struct FusionDecision {
+  std::string upstream;
+  std::string downstream;
+  FusionCost cost;
+  int64_t score{0};
+  // Whether decided by the plan, or by the score of the merge alone.
+  bool planned{false};
+  bool accepted{false};
+};
+
+/**
+ * Judges the merges of pattern nodes by the memory traffic they eliminate
+ * against the working set of the fused kernel.
+ *
+ * A merge scores the bytes it saves, less the bytes spilled and reloaded by
+ * each row whose working set exceeds the limit of the target. The merges of
+ * the nodes into their single downstreams are planned over the graph before
+ * the reduce trees are grown, the later merges taking the working set the
+ * earlier ones leave. The merges out of the plan are judged by their own
+ * score. This policy only vetoes merges, the other policies judging whether
+ * they are legal.
+ */
+template <typename T>
+class MemoryFootprintPolicy final : public Policy<T> {
+ public:
+  MemoryFootprintPolicy(const std::vector<pir::Value>& outputs,
+                        int64_t working_set_limit,
+                        FusionPlanAlgorithm algorithm)
+      : outputs_(outputs.begin(), outputs.end()),
+        working_set_limit_(working_set_limit),
+        algorithm_(algorithm) {}
+
+  // Returns nullptr unless FLAGS_cinn_enable_memory_aware_fusion.
+  static std::shared_ptr<MemoryFootprintPolicy<T>> CreateFromFlags(
+      const std::vector<pir::Value>& outputs);
+
+  bool CanFuse(const PatternNodePtr<T>& upstream,
+               const PatternNodePtr<T>& downstream) override;
+  void PlanFusion(const std::vector<PatternNodePtr<T>>& nodes) override;
+  std::string Name() { return "MemoryFootprintPolicy"; }
+
+  FusionCost EstimateCost(const std::vector<pir::Operation*>& upstream_ops,
+                          const std::vector<pir::Operation*>& downstream_ops,
+                          pir::Operation* sink_op) const;
+  int64_t Score(const FusionCost& cost) const;
+
+  const std::vector<FusionDecision>& decisions() const { return decisions_; }
+  std::string DecisionsDebugStr() const;
+  // Appends the decisions to FLAGS_cinn_fusion_decisions_path if set.
+  void ExportDecisions() const;
+
+ private:
+  using MergeKey = std::pair<pir::Operation*, pir::Operation*>;
+  // The merge of a node into its single downstream, by their indices.
+  struct MergeCandidate {
+    size_t upstream;
+    size_t downstream;
+  };
+  // The nodes merged by the plan so far, as a union find.
+  struct Components {
+    explicit Components(const std::vector<PatternNodePtr<T>>& nodes);
+    size_t Find(size_t node);
+    void Merge(size_t upstream, size_t downstream);
+
+    std::vector<size_t> parents;
+    // The ops and the sink op of each component, at its root.
+    std::vector<std::vector<pir::Operation*>> ops;
+    std::vector<pir::Operation*> sink_ops;
+    std::vector<pir::Operation*> node_sink_ops;
+  };
+
+  // Plans the merges along the chains of nodes with a single upstream
+  // merge, returning the merges left.
+  std::vector<MergeCandidate> PlanChains(
+      const std::vector<MergeCandidate>& merges, Components* components);
+  void PlanGreedily(const std::vector<MergeCandidate>& merges,
+                    Components* components);
+  void SetPlanned(const Components& components,
+                  const MergeCandidate& merge,
+                  bool accepted);
+
+  std::unordered_set<pir::Value> outputs_;
+  int64_t working_set_limit_;
+  FusionPlanAlgorithm algorithm_;
+  // Keyed by the sink ops of the nodes, which a merged node keeps of its
+  // downstream.
+  std::map<MergeKey, bool> planned_merges_;
+  std::vector<FusionDecision> decisions_;
+};
+
+}  // namespace cinn::fusion
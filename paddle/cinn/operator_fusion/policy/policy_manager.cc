@@ -40,6 +40,14 @@ std::vector<size_t> PolicyManager<T>::GetFakeReduceIterIdx(
   return {};
 }
 
+template <typename T>
+void PolicyManager<T>::PlanFusion(
+    const std::vector<PatternNodePtr<T>>& nodes) const {
+  for (const auto& policy : policies_) {
+    policy->PlanFusion(nodes);
+  }
+}
+
 template class PolicyManager<FrontendStage>;
 template class PolicyManager<BackendStage>;
 
@@ -28,6 +28,9 @@ class Policy {
       const PatternNodePtr<T>& upstream, const PatternNodePtr<T>& downstream) {
     return {};
   }
+  // Called with the nodes in topo order before the reduce trees are grown,
+  // for the policies deciding the merges over the whole graph.
+  virtual void PlanFusion(const std::vector<PatternNodePtr<T>>& nodes) {}
 };
 
 template <typename T>
@@ -43,6 +46,7 @@ class PolicyManager {
   std::vector<size_t> GetFakeReduceIterIdx(
       const PatternNodePtr<T>& upstream,
       const PatternNodePtr<T>& downstream) const;
+  void PlanFusion(const std::vector<PatternNodePtr<T>>& nodes) const;
 
  private:
   std::vector<PolicyPtr<T>> policies_;
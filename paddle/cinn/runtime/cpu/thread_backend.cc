@@ -17,13 +17,10 @@
 #include <algorithm>
 #include <vector>
 
-#ifdef CINN_USE_OPENMP
-#include <omp.h>
-#endif  // CINN_USE_OPENMP
-
 #include "paddle/cinn/backends/extern_func_jit_register.h"
 #include "paddle/cinn/backends/llvm/runtime_symbol_registry.h"
 #include "paddle/cinn/common/cas.h"
+#include "paddle/cinn/runtime/cpu/thread_pool.h"
 #include "paddle/cinn/runtime/intrinsic.h"
 #include "paddle/common/enforce.h"
 
@@ -47,19 +44,10 @@ int max_concurrency() {
 int cinn_backend_parallel_launch(FCINNParallelLambda flambda,
                                  void* datas,
                                  int num_task) {
-  int num_workers = max_concurrency();
-  if (num_task == 0) num_task = num_workers;
-#ifdef CINN_USE_OPENMP
-  omp_set_num_threads(num_task);
-#pragma omp parallel num_threads(num_task)
-  {
-    int thread_num = omp_get_thread_num();
-    (*flambda)(thread_num, num_task, datas);
-  }
-#else
-  PADDLE_THROW(phi::errors::Fatal(
-      "CINN host parallel launch need OpenMP! Please check."));
-#endif  // CINN_USE_OPENMP
+  auto runtime = cinn::runtime::cpu::GetHostParallelRuntime();
+  if (num_task == 0) num_task = runtime->NumThreads();
+  runtime->ParallelFor(
+      num_task, [&](int task_id) { (*flambda)(task_id, num_task, datas); });
   return 0;
 }
 
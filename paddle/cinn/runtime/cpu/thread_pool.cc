@@ -0,0 +1,191 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/runtime/cpu/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "paddle/cinn/runtime/cpu/thread_backend.h"
+#include "paddle/common/enforce.h"
+
+namespace cinn {
+namespace runtime {
+namespace cpu {
+
+namespace {
+// How long an idle worker spins for the next launch before it sleeps.
+constexpr auto kSpinTime = std::chrono::microseconds(100);
+// Whether this thread runs the tasks of a launch.
+thread_local bool in_parallel_launch = false;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64)
+  _mm_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+std::shared_ptr<HostParallelRuntime>* HostParallelRuntimeHolder() {
+  // Never destroyed, for the launches of the static destructors.
+  static auto* runtime = new std::shared_ptr<HostParallelRuntime>(
+      std::make_shared<WorkStealingThreadPool>(max_concurrency()));
+  return runtime;
+}
+}  // namespace
+
+std::shared_ptr<HostParallelRuntime> GetHostParallelRuntime() {
+  return std::atomic_load(HostParallelRuntimeHolder());
+}
+
+void SetHostParallelRuntime(std::shared_ptr<HostParallelRuntime> runtime) {
+  PADDLE_ENFORCE_NOT_NULL(
+      runtime,
+      phi::errors::InvalidArgument("The host parallel runtime is null."));
+  std::atomic_store(HostParallelRuntimeHolder(), std::move(runtime));
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(int num_threads)
+    : num_threads_(std::max(num_threads, 1)),
+      ranges_(new TaskRange[std::max(num_threads, 1)]) {
+  PADDLE_ENFORCE_LT(
+      num_threads_,
+      1 << kActiveBits,
+      phi::errors::InvalidArgument("Too many threads for the pool: %d.",
+                                   num_threads_));
+  workers_.reserve(num_threads_ - 1);
+  for (int i = 1; i < num_threads_; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mu_);
+    stop_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkStealingThreadPool::ParallelFor(int num_task,
+                                         const std::function<void(int)>& fn) {
+  if (num_task <= 1 || num_threads_ == 1 || in_parallel_launch) {
+    for (int i = 0; i < num_task; ++i) {
+      fn(i);
+    }
+    return;
+  }
+  // Queued behind the launch running, if any, rather than run serially.
+  std::lock_guard<std::mutex> launch_lock(launch_mu_);
+
+  int num_active = std::min(num_threads_, num_task);
+  for (int i = 0; i < num_active; ++i) {
+    ranges_[i].next.store(
+        static_cast<int>(static_cast<int64_t>(num_task) * i / num_active),
+        std::memory_order_relaxed);
+    ranges_[i].end =
+        static_cast<int>(static_cast<int64_t>(num_task) * (i + 1) / num_active);
+  }
+  fn_ = &fn;
+  num_pending_.store(num_task, std::memory_order_relaxed);
+  uint64_t sequence = (launch_.load(std::memory_order_relaxed) >> kActiveBits);
+  launch_.store(((sequence + 1) << kActiveBits) | num_active,
+                std::memory_order_seq_cst);
+  {
+    std::lock_guard<std::mutex> lock(sleep_mu_);
+    if (num_sleeping_ > 0) {
+      sleep_cv_.notify_all();
+    }
+  }
+
+  RunTasks(0, num_active);
+  for (int spins = 1; num_pending_.load(std::memory_order_acquire) > 0;
+       ++spins) {
+    if (spins % 1024 == 0) {
+      std::this_thread::yield();
+    } else {
+      CpuRelax();
+    }
+  }
+  // Closes the launch, then waits for the workers still looking at it.
+  launch_.store((sequence + 1) << kActiveBits, std::memory_order_seq_cst);
+  while (num_running_.load(std::memory_order_seq_cst) > 0) {
+    CpuRelax();
+  }
+}
+
+void WorkStealingThreadPool::RunTasks(int thread_id, int num_active) {
+  in_parallel_launch = true;
+  for (int i = 0; i < num_active; ++i) {
+    TaskRange& range = ranges_[(thread_id + i) % num_active];
+    int task;
+    while ((task = range.next.fetch_add(1, std::memory_order_relaxed)) <
+           range.end) {
+      (*fn_)(task);
+      num_pending_.fetch_sub(1, std::memory_order_release);
+    }
+  }
+  in_parallel_launch = false;
+}
+
+void WorkStealingThreadPool::WorkerLoop(int thread_id) {
+  uint64_t seen = 0;
+  while (true) {
+    uint64_t launch = launch_.load(std::memory_order_acquire);
+    auto spin_end = std::chrono::steady_clock::now() + kSpinTime;
+    for (int spins = 1; launch == seen; ++spins) {
+      if (spins % 64 == 0 && std::chrono::steady_clock::now() > spin_end) {
+        std::unique_lock<std::mutex> lock(sleep_mu_);
+        ++num_sleeping_;
+        sleep_cv_.wait(lock, [&] {
+          return stop_ || launch_.load(std::memory_order_acquire) != seen;
+        });
+        --num_sleeping_;
+        if (stop_) {
+          return;
+        }
+        spin_end = std::chrono::steady_clock::now() + kSpinTime;
+      } else {
+        CpuRelax();
+      }
+      launch = launch_.load(std::memory_order_acquire);
+    }
+    seen = launch;
+
+    int num_active = launch & ((1 << kActiveBits) - 1);
+    if (thread_id >= num_active) {
+      continue;
+    }
+    num_running_.fetch_add(1, std::memory_order_seq_cst);
+    // The launch may have been closed meanwhile, its ranges about to be
+    // reused.
+    if (launch_.load(std::memory_order_seq_cst) == launch) {
+      RunTasks(thread_id, num_active);
+    }
+    num_running_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+}  // namespace cpu
+}  // namespace runtime
+}  // namespace cinn
@@ -0,0 +1,117 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>
+#include <vector>
+
+namespace cinn {
+namespace runtime {
+namespace cpu {
+
+/**
+ * The runtime the tasks of cinn_backend_parallel_launch run on, pluggable so
+ * that an executor can run them on its own threads.
+ */
+class HostParallelRuntime {
+ public:
+  virtual ~HostParallelRuntime() = default;
+
+  // The threads the tasks of a launch run on, the launching one included.
+  virtual int NumThreads() const = 0;
+
+  // Runs fn(0), ..., fn(num_task - 1), returning once all have returned.
+  virtual void ParallelFor(int num_task,
+                           const std::function<void(int)>& fn) = 0;
+};
+
+// The runtime of the host parallel launches, a WorkStealingThreadPool of
+// max_concurrency() threads unless replaced.
+std::shared_ptr<HostParallelRuntime> GetHostParallelRuntime();
+
+// Replaces the runtime of the host parallel launches, the launches running
+// meanwhile finishing on the previous one.
+void SetHostParallelRuntime(std::shared_ptr<HostParallelRuntime> runtime);
+
+/**
+ * A persistent pool of num_threads - 1 workers and the launching thread.
+ *
+ * The tasks of a launch are split into a contiguous range per thread, the
+ * same tasks of a kernel going to the same thread at every launch to find
+ * their data in its cache. A thread done with its range steals the tasks
+ * left in the others, so that a late or preempted worker does not hold up
+ * the launch. The workers spin for a while between launches before they
+ * sleep, for the back to back kernels not to pay their wakeup.
+ *
+ * One launch runs at a time, not to oversubscribe the cores: a launch from
+ * the tasks of another runs its tasks on the launching thread, and a launch
+ * while another runs, e.g. from another thread of the executor, waits for
+ * it to finish.
+ */
+class WorkStealingThreadPool : public HostParallelRuntime {
+ public:
+  explicit WorkStealingThreadPool(int num_threads);
+  ~WorkStealingThreadPool() override;
+
+  int NumThreads() const override { return num_threads_; }
+
+  void ParallelFor(int num_task, const std::function<void(int)>& fn) override;
+
+ private:
+  // The tasks [next, end) of a thread, padded to a cache line not to be
+  // shared by the threads.
+  struct alignas(64) TaskRange {
+    std::atomic<int> next{0};
+    int end{0};
+  };
+
+  void WorkerLoop(int thread_id);
+  // Runs the tasks of thread_id, then steals those of the other threads of
+  // the launch.
+  void RunTasks(int thread_id, int num_active);
+
+  const int num_threads_;
+  std::vector<std::thread> workers_;
+  std::unique_ptr<TaskRange[]> ranges_;
+
+  // Serializes the launches.
+  std::mutex launch_mu_;
+  const std::function<void(int)>* fn_{nullptr};
+  // The sequence number of the launch shifted by kActiveBits, ored with
+  // the threads it runs on, 0 once it has finished. Published at once for a
+  // worker not to mix launches up.
+  static constexpr int kActiveBits = 16;
+  std::atomic<uint64_t> launch_{0};
+  // The tasks of the launch not run yet.
+  std::atomic<int> num_pending_{0};
+  // The workers looking at the launch, waited for before the ranges are
+  // reused by the next one.
+  std::atomic<int> num_running_{0};
+
+  std::mutex sleep_mu_;
+  std::condition_variable sleep_cv_;
+  int num_sleeping_{0};
+  bool stop_{false};
+};
+
+}  // namespace cpu
+}  // namespace runtime
+}  // namespace cinn
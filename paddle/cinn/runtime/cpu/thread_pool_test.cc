@@ -0,0 +1,91 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/runtime/cpu/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "paddle/cinn/runtime/cpu/thread_backend.h"
+
+namespace cinn {
+namespace runtime {
+namespace cpu {
+
+namespace {
+
+int CountTask(int task_id, int num_task, void* datas) {
+  reinterpret_cast<std::atomic<int>*>(datas)[task_id].fetch_add(1);
+  return 0;
+}
+
+}  // namespace
+
+TEST(WorkStealingThreadPool, RunsEveryTaskOnce) {
+  WorkStealingThreadPool pool(4);
+  for (int num_task : {1, 3, 4, 17, 1000}) {
+    std::vector<std::atomic<int>> counts(num_task);
+    for (int repeat = 0; repeat < 100; ++repeat) {
+      pool.ParallelFor(num_task, [&](int i) { counts[i].fetch_add(1); });
+    }
+    for (int i = 0; i < num_task; ++i) {
+      ASSERT_EQ(counts[i].load(), 100) << "task " << i << " of " << num_task;
+    }
+  }
+}
+
+TEST(WorkStealingThreadPool, NestedAndConcurrentLaunches) {
+  auto pool = std::make_shared<WorkStealingThreadPool>(4);
+  constexpr int kCallers = 4;
+  constexpr int kTasks = 16;
+  std::vector<std::atomic<int>> counts(kCallers * kTasks * kTasks);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < kCallers; ++c) {
+    callers.emplace_back([&, c] {
+      for (int repeat = 0; repeat < 100; ++repeat) {
+        pool->ParallelFor(kTasks, [&](int i) {
+          // Nested launches run on the launching thread.
+          pool->ParallelFor(kTasks, [&](int j) {
+            counts[(c * kTasks + i) * kTasks + j].fetch_add(1);
+          });
+        });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  for (auto& count : counts) {
+    ASSERT_EQ(count.load(), 100);
+  }
+}
+
+TEST(HostParallelRuntime, ParallelLaunch) {
+  auto previous = GetHostParallelRuntime();
+  SetHostParallelRuntime(std::make_shared<WorkStealingThreadPool>(4));
+  std::vector<std::atomic<int>> counts(4);
+  ASSERT_EQ(cinn_backend_parallel_launch(&CountTask, counts.data(), 0), 0);
+  for (auto& count : counts) {
+    ASSERT_EQ(count.load(), 1);
+  }
+  SetHostParallelRuntime(previous);
+}
+
+}  // namespace cpu
+}  // namespace runtime
+}  // namespace cinn
@@ -54,6 +54,17 @@ PD_DEFINE_int32(cinn_parallel_compile_thread,
                              (std::thread::hardware_concurrency() >> 1)),
                 "How much thread the parallel compile used.");
 
+PD_DEFINE_int32(cinn_llvm_compile_thread_num,
+                Int32FromEnv("FLAGS_cinn_llvm_compile_thread_num", 1),
+                "How many threads the LLVM optimization and code generation "
+                "of a host module is split over, on top of the threads of "
+                "cinn_parallel_compile_thread. 1 does not split it.");
+
+PD_DEFINE_string(cinn_llvm_object_cache_dir,
+                 StringFromEnv("FLAGS_cinn_llvm_object_cache_dir", ""),
+                 "The directory the objects compiled by LLVM persist in, "
+                 "keyed by a hash of their LLVM IR. Not persisted if empty.");
+
 PD_DEFINE_bool(cinn_use_op_fusion,
                BoolFromEnv("FLAGS_cinn_use_op_fusion", true),
                "Whether to use op fusion pass.");
@@ -222,6 +233,76 @@ PD_DEFINE_bool(auto_schedule_use_cost_model,
                "on-developing flag and it will be removed when "
                "cost model is stable.");
 
+PD_DEFINE_string(cinn_tuning_record_path,
+                 StringFromEnv("FLAGS_cinn_tuning_record_path", ""),
+                 "The binary file the tuned schedules of the host groups are "
+                 "recorded to and applied from. Not applied if empty.");
+
+PD_DEFINE_bool(cinn_tune_host_groups,
+               BoolFromEnv("FLAGS_cinn_tune_host_groups", false),
+               "Whether to tune the static shape groups on the host without "
+               "a tuned schedule recorded at FLAGS_cinn_tuning_record_path.");
+
+PD_DEFINE_int32(cinn_tuning_measure_trials,
+                Int32FromEnv("FLAGS_cinn_tuning_measure_trials", 40),
+                "How many schedules of a group are measured when tuned.");
+
+PD_DEFINE_bool(cinn_specialize_dynamic_shape,
+               BoolFromEnv("FLAGS_cinn_specialize_dynamic_shape", false),
+               "Whether to compile the dynamic shape groups in the background "
+               "for the static shapes they frequently run with.");
+
+PD_DEFINE_int32(cinn_max_shape_specializations,
+                Int32FromEnv("FLAGS_cinn_max_shape_specializations", 8),
+                "How many static shapes a dynamic shape group is specialized "
+                "for at most.");
+
+PD_DEFINE_int32(cinn_shape_specialize_threshold,
+                Int32FromEnv("FLAGS_cinn_shape_specialize_threshold", 4),
+                "How many times a dynamic shape group runs with a static "
+                "shape before it is specialized for the shape.");
+
+PD_DEFINE_bool(cinn_async_compile,
+               BoolFromEnv("FLAGS_cinn_async_compile", false),
+               "Whether to compile the groups in the background, running "
+               "their phi kernels until compiled. It takes effect with "
+               "FLAGS_enable_cinn_compile_cache.");
+
+PD_DEFINE_int32(cinn_async_compile_thread_num,
+                Int32FromEnv("FLAGS_cinn_async_compile_thread_num", 4),
+                "How many threads compile the groups in the background.");
+
+PD_DEFINE_bool(cinn_enable_memory_aware_fusion,
+               BoolFromEnv("FLAGS_cinn_enable_memory_aware_fusion", false),
+               "Whether to judge the merges of the group cluster by the "
+               "intermediate bytes they save against the working set of the "
+               "fused kernel.");
+
+PD_DEFINE_int64(cinn_fusion_working_set_limit,
+                Int64FromEnv("FLAGS_cinn_fusion_working_set_limit", 0L),
+                "The bytes a row of a fused kernel keeps live before it "
+                "spills, by the target if not positive.");
+
+PD_DEFINE_string(cinn_fusion_plan_algorithm,
+                 StringFromEnv("FLAGS_cinn_fusion_plan_algorithm", "greedy"),
+                 "How the memory aware fusion plans the merges, 'greedy' by "
+                 "the bytes they save or 'dp' over the chains they form.");
+
+PD_DEFINE_string(cinn_fusion_decisions_path,
+                 StringFromEnv("FLAGS_cinn_fusion_decisions_path", ""),
+                 "The file the decisions of the memory aware fusion are "
+                 "appended to as json lines, which is used for debug.");
+
+PD_DEFINE_bool(cinn_enable_horizontal_fusion,
+               BoolFromEnv("FLAGS_cinn_enable_horizontal_fusion", false),
+               "Whether to merge the independent trivial fusion ops of the "
+               "same static output shape into one kernel.");
+
+PD_DEFINE_int32(cinn_horizontal_fusion_max_ops,
+                Int32FromEnv("FLAGS_cinn_horizontal_fusion_max_ops", 8),
+                "The fusion ops merged into one kernel by the horizontal "
+                "fusion at most.");
+
 PD_DEFINE_bool(
     enhance_vertical_fusion_with_recompute,
     BoolFromEnv("FLAGS_enhance_vertical_fusion_with_recompute", true),
@@ -359,6 +359,44 @@ PHI_DEFINE_EXPORTED_bool(
 PHI_DEFINE_EXPORTED_int32(communicator_send_queue_size,
                           20,
                           "queue size to recv gradient before send");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_dense_accumulate
+ * Since Version: 2.6.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: Accumulate the dense gradients in place as the trainers send them,
+ *       instead of queueing a copy per batch and merging the copies before
+ *       sending. Only used by the async communicator.
+ */
+PHI_DEFINE_EXPORTED_bool(communicator_dense_accumulate,
+                         true,
+                         "accumulate dense gradients in place before send");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_dense_compress
+ * Since Version: 2.6.0
+ * Value Range: string, default=none
+ * Example: FLAGS_communicator_dense_compress=fp16
+ * Note: Lossy compression of the dense gradients pushed by the communicator,
+ *       one of none, fp16 and topk. The compression error is kept by the
+ *       trainer and added to the next push.
+ */
+PHI_DEFINE_EXPORTED_string(communicator_dense_compress,
+                           "none",
+                           "compression of dense pushes: none, fp16 or topk");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_dense_topk_ratio
+ * Since Version: 2.6.0
+ * Value Range: double, (0, 1], default=0.01
+ * Example:
+ * Note: Fraction of the values of each shard sent by the topk compression
+ *       of dense pushes, the ones of the largest magnitude.
+ */
+PHI_DEFINE_EXPORTED_double(communicator_dense_topk_ratio,
+                           0.01,
+                           "fraction of the dense gradient sent by topk");
 #endif
 
 /**
@@ -657,6 +695,77 @@ PHI_DEFINE_EXPORTED_bool(
     "If set true, the queue.pop will only get data from queue but not "
     "remove the data from queue for speed testing");
 
+/**
+ * Performance related FLAG
+ * Name: reader_prefetch_num_threads
+ * Since Version: 2.6.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_reader_prefetch_num_threads=4
+ * Note: Number of threads of each BufferedReader. Batches are still read from
+ * the underlying reader in order, the copies of different batches run in
+ * parallel.
+ */
+PHI_DEFINE_EXPORTED_int32(reader_prefetch_num_threads,
+                          1,
+                          "The number of prefetch threads of BufferedReader.");
+
+/**
+ * Performance related FLAG
+ * Name: fs_native_reader
+ * Since Version: 2.6.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, local files opened for reading without a converter (or with
+ * "cat") are read ahead and decompressed in process instead of through a
+ * shell pipe. Supports .gz, and .sz/.snappy when built with snappy. The
+ * .sz/.snappy files opened for writing the same way are compressed in process
+ * too, so that they read back.
+ */
+PHI_DEFINE_EXPORTED_bool(fs_native_reader,
+                         false,
+                         "Whether to read and decompress local files in "
+                         "process instead of through a shell pipe.");
+
+/**
+ * Performance related FLAG
+ * Name: fs_read_ahead_size
+ * Since Version: 2.6.0
+ * Value Range: int32, default=16777216
+ * Example: FLAGS_fs_read_ahead_size=67108864
+ * Note: Bytes read ahead of the consumer for each local file opened by the
+ * native reader.
+ */
+PHI_DEFINE_EXPORTED_int32(fs_read_ahead_size,
+                          16 << 20,
+                          "The read-ahead bytes of each local file.");
+
+/**
+ * Performance related FLAG
+ * Name: fs_read_direct_io
+ * Since Version: 2.6.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the native reader opens local files with O_DIRECT, which
+ * keeps large datasets read once out of the page cache.
+ */
+PHI_DEFINE_EXPORTED_bool(fs_read_direct_io,
+                         false,
+                         "Whether to read local files with O_DIRECT.");
+
+/**
+ * Performance related FLAG
+ * Name: fs_decompress_num_threads
+ * Since Version: 2.6.0
+ * Value Range: int32, default=4
+ * Example:
+ * Note: Size of the thread pool shared by all the native readers to
+ * decompress BGZF and snappy blocks in parallel, 0 to decompress in the
+ * reading threads.
+ */
+PHI_DEFINE_EXPORTED_int32(fs_decompress_num_threads,
+                          4,
+                          "The number of threads to decompress files.");
+
 /**
  * MKLDNN related FLAG
  * Name: use_mkldnn
@@ -729,6 +838,21 @@ PHI_DEFINE_EXPORTED_int32(
     "less FLAGS_max_inplace_grad_add, than it will be use several grad_add"
     "instead of sum. Default is 0.");
 
+/**
+ * Performance related FLAG
+ * Name: eager_grad_node_pool
+ * Since Version: 2.6.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: If True, the memory of released eager grad nodes is cached per thread
+ * and reused by the grad nodes created in the next step. The cache is trimmed
+ * to the working set of one step after each backward.
+ */
+PHI_DEFINE_EXPORTED_bool(eager_grad_node_pool,
+                         true,
+                         "Whether to reuse the memory of released eager grad "
+                         "nodes through a per-thread pool.");
+
 /**
  * Tensor.numpy() has a hack, and this flag can close this hack
  * [true]: set 0D Tensor to 1D Numpy
@@ -1602,6 +1726,36 @@ PHI_DEFINE_EXPORTED_bool(pir_apply_shape_optimization_pass,
                          "Whether to apply shape_optimization pass "
                          "to infer symbolic shape");
 
+/**
+ * Incremental shape inference of new IR FLAG
+ * Name: pir_incremental_shape_inference
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the pattern rewrites invalidate the symbolic shapes of the
+ * ops downstream of them, and shape_optimization pass only infers the ops
+ * without symbolic shapes once the program has been inferred.
+ */
+PHI_DEFINE_EXPORTED_bool(pir_incremental_shape_inference,
+                         false,
+                         "Whether to infer the symbolic shapes of the ops "
+                         "changed since the last inference only");
+
+/**
+ * Worklist pattern rewrite of new IR FLAG
+ * Name: pir_greedy_rewrite_by_worklist
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the greedy pattern rewrite visits the ops of the region once,
+ * and then only the ops affected by the rewrites, instead of scanning the
+ * whole region again until no pattern applies.
+ */
+PHI_DEFINE_EXPORTED_bool(pir_greedy_rewrite_by_worklist,
+                         false,
+                         "Whether to revisit only the ops affected by the "
+                         "rewrites in the greedy pattern rewrite");
+
 PHI_DEFINE_EXPORTED_string(
     cudnn_dir,  // NOLINT
     "",
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -62,6 +64,23 @@ PD_DEFINE_int32(pserver_communicate_compress_type,
                 0,
                 "none:0 snappy:1 gzip:2 zlib:3 lz4:4");
 
+PD_DEFINE_bool(pserver_zero_copy_sparse_push,
+               false,
+               "send the sparse pushes in the request attachment rather than "
+               "in the request message, without a copy into the message; "
+               "the servers are to read the attachment, so only turn it on "
+               "once they all do");
+
+PD_DEFINE_int32(pserver_hot_key_cache_size,
+                0,
+                "number of the hot keys of a sparse table cached by the "
+                "workers, 0 disables the hot key cache");
+
+PD_DEFINE_int32(pserver_hot_key_refresh_steps,
+                100,
+                "pulls between the refreshes of the hot key cache, and pushes "
+                "between the sends of the pushes of the hot keys it merges");
+
 PD_DEFINE_int32(pserver_max_async_call_num,
                 13,
                 "max task num in async_call_server");
@@ -91,6 +110,80 @@ inline size_t get_sparse_shard(uint32_t shard_num,
   return (key % shard_num) / local_shard_num;
 }
 
+// Writes the unique keys of sorted_kvs after is_training, then the number of
+// times each of them is pulled, see PullSparseValue::DeserializeFromBytes.
+// The request is written in one block moved to buf. Returns the unique keys.
+static uint32_t SerializePullSparseRequest(
+    const std::vector<std::pair<uint64_t, float *>> &sorted_kvs,
+    bool is_training,
+    butil::IOBuf *buf) {
+  size_t sorted_kv_size = sorted_kvs.size();
+  // The unique keys are unknown yet, room for all the keys in both parts.
+  char *block = AllocIOBufBlock(
+      sizeof(bool) + sorted_kv_size * (sizeof(uint64_t) + sizeof(uint32_t)));
+  memcpy(block, &is_training, sizeof(bool));
+  char *keys = block + sizeof(bool);
+  thread_local std::vector<uint32_t> keys_counter;
+  keys_counter.clear();
+  uint32_t kv_request_count = 0;
+  for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
+    uint32_t count = 1;
+    uint64_t last_key = sorted_kvs[kv_idx].first;
+    memcpy(keys + kv_request_count * sizeof(uint64_t),
+           &last_key,
+           sizeof(uint64_t));
+    while (kv_idx < sorted_kv_size - 1 &&
+           last_key == sorted_kvs[kv_idx + 1].first) {
+      ++kv_idx;
+      ++count;
+    }
+    keys_counter.push_back(count);
+    ++kv_request_count;
+  }
+  memcpy(keys + kv_request_count * sizeof(uint64_t),
+         keys_counter.data(),
+         kv_request_count * sizeof(uint32_t));
+  AppendIOBufBlock(
+      buf,
+      block,
+      sizeof(bool) + kv_request_count * (sizeof(uint64_t) + sizeof(uint32_t)));
+  return kv_request_count;
+}
+
+// Writes the keys, then the value_size bytes of value(i) of each key i, to
+// the request attachment with pserver_zero_copy_sparse_push, in one block
+// moved to it, or to the request data otherwise. brpc only compresses the
+// request message, so a compressed push keeps going through the data.
+template <class GetValue>
+static void SerializePushSparseRequest(const uint64_t *keys,
+                                       size_t num,
+                                       size_t value_size,
+                                       GetValue value,
+                                       PsRequestMessage *request,
+                                       brpc::Controller *cntl) {
+  size_t size = num * (sizeof(uint64_t) + value_size);
+  bool zero_copy = FLAGS_pserver_zero_copy_sparse_push &&
+                   FLAGS_pserver_communicate_compress_type == 0;
+  char *push_data_ptr = nullptr;
+  if (zero_copy) {
+    push_data_ptr = AllocIOBufBlock(size);
+  } else {
+    auto *push_data = request->mutable_data();
+    push_data->resize(size);
+    push_data_ptr = const_cast<char *>(push_data->data());
+  }
+  char *begin = push_data_ptr;
+  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
+  push_data_ptr += num * sizeof(uint64_t);
+  for (size_t i = 0; i < num; ++i) {
+    memcpy(push_data_ptr, value(i), value_size);
+    push_data_ptr += value_size;
+  }
+  if (zero_copy) {
+    AppendIOBufBlock(&cntl->request_attachment(), begin, size);
+  }
+}
+
 void DownpourPsClientService::service(
     ::google::protobuf::RpcController *controller,
     const PsRequestMessage *request,
@@ -345,6 +438,11 @@ int32_t BrpcPsClient::Initialize() {
       _push_sparse_task_queue_map[table_id] =
           ::paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      if (FLAGS_pserver_hot_key_cache_size > 0) {
+        _hot_key_caches[table_id].reset(
+            new SparseHotKeyCache(GetTableAccessor(table_id),
+                                  FLAGS_pserver_hot_key_refresh_steps));
+      }
     }
   }
 
@@ -468,6 +566,11 @@ std::future<int32_t> BrpcPsClient::PrintTableStat(uint32_t table_id) {
                   << ", feasign size: " << feasign_size
                   << ", mf size: " << mf_size << std::endl;
       });
+  auto *hot_key_cache = GetHotKeyCache(table_id);
+  if (hot_key_cache != nullptr) {
+    std::cout << "table id: " << table_id << ", hot key cache "
+              << hot_key_cache->GetStats().ToString() << std::endl;
+  }
   auto promise = std::make_shared<std::promise<int32_t>>();
   closure->add_promise(promise);
   std::future<int> fut = promise->get_future();
@@ -483,6 +586,119 @@ std::future<int32_t> BrpcPsClient::PrintTableStat(uint32_t table_id) {
   }
   return fut;
 }
+std::future<int32_t> BrpcPsClient::RefreshHotKeys(size_t table_id) {
+  auto *hot_key_cache = GetHotKeyCache(table_id);
+  if (hot_key_cache == nullptr) {
+    std::promise<int32_t> promise;
+    promise.set_value(-1);
+    return promise.get_future();
+  }
+  // Every server sends its k hottest keys, the k hottest of all are kept.
+  uint32_t k = FLAGS_pserver_hot_key_cache_size;
+  size_t request_call_num = _server_channels.size();
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [request_call_num, k, hot_key_cache](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        std::vector<std::pair<float, uint64_t>> hot_keys;
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_GET_HOT_KEYS) != 0) {
+            ret = -1;
+            break;
+          }
+          auto &res_io_buffer = closure->cntl(i)->response_attachment();
+          size_t num =
+              res_io_buffer.size() / (sizeof(uint64_t) + sizeof(float));
+          std::vector<uint64_t> keys(num);
+          std::vector<float> shows(num);
+          res_io_buffer.copy_to(keys.data(), num * sizeof(uint64_t));
+          res_io_buffer.copy_to(
+              shows.data(), num * sizeof(float), num * sizeof(uint64_t));
+          for (size_t j = 0; j < num; ++j) {
+            hot_keys.emplace_back(shows[j], keys[j]);
+          }
+        }
+        if (ret == 0) {
+          size_t n = std::min<size_t>(k, hot_keys.size());
+          std::partial_sort(hot_keys.begin(),
+                            hot_keys.begin() + n,
+                            hot_keys.end(),
+                            std::greater<std::pair<float, uint64_t>>());
+          std::vector<uint64_t> keys(n);
+          for (size_t j = 0; j < n; ++j) {
+            keys[j] = hot_keys[j].second;
+          }
+          hot_key_cache->SetHotKeys(keys);
+        }
+        hot_key_cache->EndRefresh();
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+  for (size_t i = 0; i < request_call_num; ++i) {
+    closure->request(i)->set_cmd_id(PS_GET_HOT_KEYS);
+    closure->request(i)->set_table_id(table_id);
+    closure->request(i)->set_client_id(_client_id);
+    closure->request(i)->add_params(reinterpret_cast<char *>(&k),
+                                    sizeof(uint32_t));
+    PsService_Stub rpc_stub(GetCmdChannel(i));
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
+
+std::future<int32_t> BrpcPsClient::PrefetchSparse(size_t table_id,
+                                                  const uint64_t *keys,
+                                                  size_t num) {
+  size_t request_call_num = _server_channels.size();
+  const auto &server_param = _config.server_param().downpour_server_param();
+  uint64_t shard_num = FLAGS_pserver_sparse_table_shard_num;
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.table_id() == table_id) {
+      shard_num = table_param.shard_num();
+      break;
+    }
+  }
+  std::vector<std::vector<uint64_t>> ids(request_call_num);
+  for (size_t i = 0; i < num; ++i) {
+    ids[get_sparse_shard(shard_num, request_call_num, keys[i])].push_back(
+        keys[i]);
+  }
+
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_PREFETCH_SPARSE) != 0) {
+            ret = -1;
+            break;
+          }
+        }
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+  for (size_t i = 0; i < request_call_num; ++i) {
+    uint32_t kv_size = ids[i].size();
+    auto *request = closure->request(i);
+    request->set_cmd_id(PS_PREFETCH_SPARSE);
+    request->set_table_id(table_id);
+    request->set_client_id(_client_id);
+    request->add_params(reinterpret_cast<char *>(&kv_size), sizeof(uint32_t));
+    request->set_data(reinterpret_cast<const char *>(ids[i].data()),
+                      kv_size * sizeof(uint64_t));
+    PsService_Stub rpc_stub(GetSparseChannel(i));
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
+
 std::future<int32_t> BrpcPsClient::SendCmd(
     uint32_t table_id, int cmd_id, const std::vector<std::string> &params) {
   size_t request_call_num = _server_channels.size();
@@ -682,6 +898,13 @@ std::future<int32_t> BrpcPsClient::CheckSavePrePatchDone() {
 
 std::future<int32_t> BrpcPsClient::Flush() {
   VLOG(0) << "BrpcPsClient::flush begin";
+  // The pushes of the hot keys merged in the caches go first.
+  for (auto &cache : _hot_key_caches) {
+    if (cache.second->HasPushes()) {
+      cache.second->RequestPushFlush();
+      PushSparse(cache.first, nullptr, nullptr, 0).wait();
+    }
+  }
   _flushing = true;
   std::promise<int> promise;
   std::future<int32_t> fut = promise.get_future();
@@ -1039,8 +1262,8 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
   }
 
   for (size_t shard_idx = 0; shard_idx < request_call_num; ++shard_idx) {
-    auto kvs = ids[shard_idx];
-    auto value_ptr = value_ptrs[shard_idx];
+    auto &kvs = ids[shard_idx];
+    auto &value_ptr = value_ptrs[shard_idx];
 
     size_t kv_size = kvs.size();
     uint32_t value_size = accessor->GetAccessorInfo().update_size;
@@ -1051,16 +1274,13 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
-    }
+    SerializePushSparseRequest(
+        kvs.data(),
+        kv_size,
+        value_size,
+        [&value_ptr](size_t i) { return value_ptr[i]; },
+        push_request,
+        closure->cntl(shard_idx));
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1106,6 +1326,37 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::PushDenseCompressedGradient(
+    int table_id,
+    DenseCompressType type,
+    const std::vector<std::string> &shards,
+    void *done) {
+  size_t request_call_num = _server_channels.size();
+  PADDLE_ENFORCE_EQ(shards.size(),
+                    request_call_num,
+                    platform::errors::InvalidArgument(
+                        "Expected a dense gradient shard per server, got %d "
+                        "shards for %d servers.",
+                        shards.size(),
+                        request_call_num));
+  DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+  for (size_t i = 0; i < request_call_num; ++i) {
+    closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
+    closure->request(i)->set_table_id(table_id);
+    closure->request(i)->set_client_id(_client_id);
+    // params(0) tells the server how to decode the data.
+    closure->request(i)->add_params(DenseCompressTypeName(type));
+    closure->request(i)->set_data(shards[i]);
+    PsService_Stub rpc_stub(GetDenseChannel(i));
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
+
 std::future<int32_t> BrpcPsClient::PushGlobalStep(int table_id,
                                                   int64_t *total_send_data,
                                                   void *done) {
@@ -1145,6 +1396,34 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       std::make_shared<CostTimer>("pserver_client_pull_sparse_local");
   size_t request_call_num = _server_channels.size();
 
+  // The hot keys are served by the cache, only the misses are pulled.
+  auto *hot_key_cache = GetHotKeyCache(table_id);
+  auto hot_misses =
+      std::make_shared<std::vector<std::pair<uint64_t, float *>>>();
+  std::vector<uint64_t> miss_keys;
+  std::vector<float *> miss_values;
+  if (hot_key_cache != nullptr) {
+    if (hot_key_cache->NextPull() && hot_key_cache->BeginRefresh()) {
+      RefreshHotKeys(table_id);
+    }
+    std::vector<size_t> misses;
+    hot_key_cache->Lookup(keys, select_values, num, &misses, hot_misses.get());
+    if (misses.empty()) {
+      std::promise<int32_t> promise;
+      promise.set_value(0);
+      return promise.get_future();
+    }
+    miss_keys.reserve(misses.size());
+    miss_values.reserve(misses.size());
+    for (auto i : misses) {
+      miss_keys.push_back(keys[i]);
+      miss_values.push_back(select_values[i]);
+    }
+    keys = miss_keys.data();
+    select_values = miss_values.data();
+    num = misses.size();
+  }
+
   auto shard_sorted_kvs = std::make_shared<
       std::vector<std::vector<std::pair<uint64_t, float *>>>>();
   shard_sorted_kvs->resize(request_call_num);
@@ -1169,7 +1448,8 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   size_t value_size = accessor->GetAccessorInfo().select_size;
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, hot_key_cache, hot_misses](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
@@ -1202,6 +1482,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
             }
           }
         }
+        if (ret == 0 && !hot_misses->empty()) {
+          hot_key_cache->Store(*hot_misses);
+        }
         closure->set_promise_value(ret);
       });
   closure->add_timer(timer);
@@ -1218,31 +1501,8 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
                 return k1.first < k2.first;
               });
 
-    uint64_t last_key = UINT64_MAX;
-    uint32_t kv_request_count = 0;
-    size_t sorted_kv_size = sorted_kvs.size();
-    auto &request_buffer = closure->cntl(i)->request_attachment();
-
-    request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
-    std::vector<uint32_t> keys_counter;
-    keys_counter.reserve(sorted_kv_size);
-
-    for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
-      ++kv_request_count;
-      uint32_t keys = 1;
-      last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append(reinterpret_cast<void *>(&last_key),
-                            sizeof(uint64_t));
-      while (kv_idx < sorted_kv_size - 1 &&
-             last_key == sorted_kvs[kv_idx + 1].first) {
-        ++kv_idx;
-        ++keys;
-      }
-      keys_counter.push_back(keys);
-    }
-
-    request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
-                          sizeof(uint32_t) * keys_counter.size());
+    uint32_t kv_request_count = SerializePullSparseRequest(
+        sorted_kvs, is_training, &closure->cntl(i)->request_attachment());
 
     if (kv_request_count == 0) {
       closure->Run();
@@ -1333,31 +1593,8 @@ std::future<int32_t> BrpcPsClient::PullSparseParam(float **select_values,
                 return k1.first < k2.first;
               });
 
-    uint64_t last_key = UINT64_MAX;
-    uint32_t kv_request_count = 0;
-    size_t sorted_kv_size = sorted_kvs.size();
-    auto &request_buffer = closure->cntl(i)->request_attachment();
-
-    request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
-    std::vector<uint32_t> keys_counter;
-    keys_counter.reserve(sorted_kv_size);
-
-    for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
-      ++kv_request_count;
-      uint32_t keys = 1;
-      last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append(reinterpret_cast<void *>(&last_key),
-                            sizeof(uint64_t));
-      while (kv_idx < sorted_kv_size - 1 &&
-             last_key == sorted_kvs[kv_idx + 1].first) {
-        ++kv_idx;
-        ++keys;
-      }
-      keys_counter.push_back(keys);
-    }
-
-    request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
-                          sizeof(uint32_t) * keys_counter.size());
+    uint32_t kv_request_count = SerializePullSparseRequest(
+        sorted_kvs, is_training, &closure->cntl(i)->request_attachment());
 
     if (kv_request_count == 0) {
       closure->Run();
@@ -1422,15 +1659,13 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
   push_request->set_table_id(table_id);
   push_request->set_client_id(_client_id);
   push_request->add_params((char *)&num, sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  push_data->resize(num * (sizeof(uint64_t) + value_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
-  push_data_ptr += num * sizeof(uint64_t);
-  for (uint32_t i = 0; i < num; ++i) {
-    memcpy(push_data_ptr, update_values[i], value_size);
-    push_data_ptr += value_size;
-  }
+  SerializePushSparseRequest(
+      keys,
+      num,
+      value_size,
+      [update_values](size_t i) { return update_values[i]; },
+      push_request,
+      closure->cntl(0));
   PsService_Stub rpc_stub(GetSparseChannel(pserver_idx));
   closure->cntl(0)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1558,9 +1793,34 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
       break;
     }
   }
-  for (size_t i = 0; i < num; ++i) {
-    size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
-    shard_sorted_kv_list[shard_id].push_back({keys[i], update_values[i]});
+  // The pushes of the hot keys are merged in the cache, and sent once every
+  // pserver_hot_key_refresh_steps pushes.
+  auto *hot_key_cache = GetHotKeyCache(table_id);
+  thread_local std::vector<uint64_t> hot_keys;
+  thread_local std::vector<std::string> hot_values;
+  hot_keys.clear();
+  if (hot_key_cache != nullptr) {
+    thread_local std::vector<size_t> cold;
+    cold.clear();
+    hot_key_cache->MergePushes(keys, update_values, num, &cold);
+    for (auto i : cold) {
+      size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
+      shard_sorted_kv_list[shard_id].push_back({keys[i], update_values[i]});
+    }
+    if (hot_key_cache->NextPush()) {
+      hot_key_cache->TakePushes(&hot_keys, &hot_values);
+    }
+  } else {
+    for (size_t i = 0; i < num; ++i) {
+      size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
+      shard_sorted_kv_list[shard_id].push_back({keys[i], update_values[i]});
+    }
+  }
+  for (size_t i = 0; i < hot_keys.size(); ++i) {
+    size_t shard_id =
+        get_sparse_shard(shard_num, request_call_num, hot_keys[i]);
+    shard_sorted_kv_list[shard_id].push_back(
+        {hot_keys[i], reinterpret_cast<const float *>(hot_values[i].data())});
   }
   auto sparse_task_data = _sparse_task_pool.get();
   sparse_task_data->shared_data.resize(request_call_num);
@@ -1856,22 +2116,14 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->set_client_id(_client_id);
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
   int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
-  for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
-  }
+  SerializePushSparseRequest(
+      merged_key_list.data(),
+      merged_kv_count,
+      update_size,
+      [&merged_value_list](size_t i) { return merged_value_list[i].data(); },
+      push_request,
+      closure->cntl(shard_idx));
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -27,6 +27,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_hot_cache.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -310,6 +311,15 @@ class BrpcPsClient : public PSClient {
   void PrintQueueSize();
   void PrintQueueSizeThread();
 
+  // Fetches the hot keys of the servers for the hot key cache of table_id,
+  // done every pserver_hot_key_refresh_steps pulls by PullSparse.
+  std::future<int32_t> RefreshHotKeys(size_t table_id);
+  // nullptr without pserver_hot_key_cache_size.
+  SparseHotKeyCache *GetHotKeyCache(size_t table_id) {
+    auto it = _hot_key_caches.find(table_id);
+    return it == _hot_key_caches.end() ? nullptr : it->second.get();
+  }
+
  protected:
   virtual size_t GetServerNums() { return _server_channels.size(); }
   inline brpc::Channel *GetSparseChannel(size_t server_id) {
@@ -360,6 +370,9 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // the read-through caches of the hot keys of the sparse tables
+  std::unordered_map<uint32_t, std::unique_ptr<SparseHotKeyCache>>
+      _hot_key_caches;
 
   std::thread _print_thread;
 
@@ -391,6 +404,12 @@ class BrpcPsClient : public PSClient {
                                             size_t total_send_data_size,
                                             void *done) override;
 
+  std::future<int32_t> PushDenseCompressedGradient(
+      int table_id,
+      DenseCompressType type,
+      const std::vector<std::string> &shards,
+      void *done) override;
+
   std::future<int32_t> PushSparseRawGradient(size_t table_id,
                                              const uint64_t *keys,
                                              const float **update_values,
@@ -409,6 +428,11 @@ class BrpcPsClient : public PSClient {
                                        const float **update_values,
                                        size_t num,
                                        void *done) override;
+  // Sends the keys to the servers holding them, for their tables to load
+  // them ahead of the pulls, see Table::Prefetch.
+  std::future<int32_t> PrefetchSparse(size_t table_id,
+                                      const uint64_t *keys,
+                                      size_t num) override;
   std::future<int32_t> PushSparse(size_t table_id,
                                   const uint64_t *keys,
                                   const float **update_values,
@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/communicator/dense_compressor.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -204,6 +205,8 @@ int32_t BrpcPsService::Initialize() {
   _service_handler_map[PS_CLEAR_ALL_TABLE] = &BrpcPsService::ClearAllTable;
   _service_handler_map[PS_PUSH_DENSE_PARAM] = &BrpcPsService::PushDenseParam;
   _service_handler_map[PS_PRINT_TABLE_STAT] = &BrpcPsService::PrintTableStat;
+  _service_handler_map[PS_GET_HOT_KEYS] = &BrpcPsService::GetHotKeys;
+  _service_handler_map[PS_PREFETCH_SPARSE] = &BrpcPsService::PrefetchSparse;
   _service_handler_map[PS_PULL_GEO_PARAM] = &BrpcPsService::PullGeoParam;
   _service_handler_map[PS_PUSH_SPARSE_PARAM] = &BrpcPsService::PushSparseParam;
   _service_handler_map[PS_BARRIER] = &BrpcPsService::Barrier;
@@ -392,6 +395,21 @@ int32_t BrpcPsService::PushDense(Table *table,
   table_context.push_context.values =
       (const float *)(request.data().data() + sizeof(uint32_t));
   table_context.num = num;
+  // Compressed by the communicator, see DenseGradCompressor.
+  std::vector<float> decoded;
+  if (request.params_size() > 0) {
+    try {
+      DenseGradCompressor::Decode(ParseDenseCompressType(request.params(0)),
+                                  request.data().data(),
+                                  req_buffer_size,
+                                  &decoded);
+    } catch (const std::exception &e) {
+      set_response_code(response, -1, e.what());
+      return 0;
+    }
+    table_context.push_context.values = decoded.data();
+    table_context.num = decoded.size();
+  }
   // const float *values = (const float *)(request.data().data() +
   // sizeof(uint32_t));
   if (table->Push(table_context) != 0) {
@@ -527,28 +545,38 @@ int32_t BrpcPsService::PullSparse(Table *table,
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
   auto dim = table->GetValueAccessor()->GetAccessorInfo().select_dim;
 
-  thread_local std::string req_buffer;
-  req_buffer.reserve(req_buffer_size);
-
-  const void *data = cntl->request_attachment().fetch(
-      const_cast<char *>(req_buffer.data()), req_buffer_size);
-
-  auto value = PullSparseValue(num, dim);
-
-  value.DeserializeFromBytes(const_cast<void *>(data));
-
-  auto res_data = butil::get_object<std::vector<float>>();
-  res_data->resize(num * dim);
+  // The keys follow is_training, so they are copied out to be aligned, see
+  // PullSparseValue::DeserializeFromBytes for the layout.
+  if (req_io_buffer.size() <
+      sizeof(bool) + num * (sizeof(uint64_t) + sizeof(uint32_t))) {
+    set_response_code(response, -1, "req attachment is too short");
+    return 0;
+  }
+  thread_local std::vector<uint64_t> keys;
+  thread_local std::vector<uint32_t> frequencies;
+  keys.resize(num);
+  frequencies.resize(num);
+  bool is_training = true;
+  req_io_buffer.copy_to(&is_training, sizeof(bool));
+  req_io_buffer.copy_to(keys.data(), num * sizeof(uint64_t), sizeof(bool));
+  req_io_buffer.copy_to(frequencies.data(),
+                        num * sizeof(uint32_t),
+                        sizeof(bool) + num * sizeof(uint64_t));
+
+  auto value = PullSparseValue(keys, frequencies, dim);
+  value.is_training_ = is_training;
+
+  // The table writes the values in the block moved to the response.
+  size_t res_size = num * dim * sizeof(float);
+  char *res_data = AllocIOBufBlock(res_size);
   TableContext table_context;
   table_context.value_type = Sparse;
   table_context.pull_context.pull_value = value;
-  table_context.pull_context.values = res_data->data();
+  table_context.pull_context.values = reinterpret_cast<float *>(res_data);
   table->Pull(table_context);
   // table->PullSparse(res_data->data(), value);
 
-  cntl->response_attachment().append(reinterpret_cast<char *>(res_data->data()),
-                                     res_data->size() * sizeof(float));
-  butil::return_object(res_data);
+  AppendIOBufBlock(&cntl->response_attachment(), res_data, res_size);
   return 0;
 }
 
@@ -559,8 +587,9 @@ int32_t BrpcPsService::PushSparse(Table *table,
   platform::RecordEvent record_event(
       "PsService->PushSparse", platform::TracerEventType::Communication, 1);
   CHECK_TABLE_EXIST(table, request, response)
-  auto &push_data = request.data();
-  if (push_data.empty()) {
+  // In the request attachment with pserver_zero_copy_sparse_push.
+  auto &req_io_buffer = cntl->request_attachment();
+  if (request.data().empty() && req_io_buffer.empty()) {
     // set_response_code(response, 0, "push sparse data is empty");
     return 0;
   }
@@ -574,6 +603,11 @@ int32_t BrpcPsService::PushSparse(Table *table,
   CostTimer timer("pserver_server_push_sparse");
   const uint32_t num =
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+  const char *push_data = request.data().data();
+  if (request.data().empty()) {
+    thread_local std::vector<uint64_t> push_buffer;
+    push_data = FetchIOBuf(req_io_buffer, req_io_buffer.size(), &push_buffer);
+  }
   /*
   Push Content:
   |---keysData---|---valuesData---|
@@ -581,9 +615,9 @@ int32_t BrpcPsService::PushSparse(Table *table,
   */
   TableContext table_context;
   table_context.value_type = Sparse;
-  table_context.push_context.keys = (const uint64_t *)push_data.data();
+  table_context.push_context.keys = (const uint64_t *)push_data;
   table_context.push_context.values =
-      (const float *)(push_data.data() + sizeof(uint64_t) * num);
+      (const float *)(push_data + sizeof(uint64_t) * num);
   table_context.num = num;
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
@@ -609,6 +643,70 @@ int32_t BrpcPsService::PrintTableStat(Table *table,
   return 0;
 }
 
+int32_t BrpcPsService::GetHotKeys(Table *table,
+                                  const PsRequestMessage &request,
+                                  PsResponseMessage &response,
+                                  brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 1) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.params is required at "
+                      "least 1 for num of hot keys");
+    return 0;
+  }
+  const uint32_t k =
+      *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+  std::vector<std::pair<uint64_t, float>> hot_keys;
+  if (table->GetHotKeys(k, &hot_keys) != 0) {
+    set_response_code(response, -1, "GetHotKeys failed");
+    return 0;
+  }
+  /*
+  Response Content:
+  |---keysData---|---countsData---|
+  |---8*{num}B---|---4*{num}B-----|
+  */
+  size_t size = hot_keys.size() * (sizeof(uint64_t) + sizeof(float));
+  char *data = AllocIOBufBlock(size);
+  uint64_t *keys = reinterpret_cast<uint64_t *>(data);
+  float *shows = reinterpret_cast<float *>(keys + hot_keys.size());
+  for (size_t i = 0; i < hot_keys.size(); ++i) {
+    keys[i] = hot_keys[i].first;
+    shows[i] = hot_keys[i].second;
+  }
+  AppendIOBufBlock(&cntl->response_attachment(), data, size);
+  return 0;
+}
+
+int32_t BrpcPsService::PrefetchSparse(Table *table,
+                                      const PsRequestMessage &request,
+                                      PsResponseMessage &response,
+                                      brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 1) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.params is required at "
+                      "least 1 for num of sparse_key");
+    return 0;
+  }
+  const uint32_t num =
+      *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+  if (request.data().size() < num * sizeof(uint64_t)) {
+    set_response_code(response, -1, "PsRequestMessage.data is too short");
+    return 0;
+  }
+  // copied out of the message to be aligned
+  std::vector<uint64_t> keys(num);
+  memcpy(keys.data(), request.data().data(), num * sizeof(uint64_t));
+  // returns before the keys are loaded
+  if (table->Prefetch(keys.data(), num) != 0) {
+    set_response_code(response, -1, "PrefetchSparse failed");
+  }
+  return 0;
+}
+
 int32_t BrpcPsService::LoadOneTable(Table *table,
                                     const PsRequestMessage &request,
                                     PsResponseMessage &response,
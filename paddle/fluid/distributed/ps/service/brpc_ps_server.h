@@ -167,6 +167,16 @@ class BrpcPsService : public PsBaseService {
                          PsResponseMessage &response,  // NOLINT
                          brpc::Controller *cntl);
 
+  int32_t GetHotKeys(Table *table,
+                     const PsRequestMessage &request,
+                     PsResponseMessage &response,  // NOLINT
+                     brpc::Controller *cntl);
+
+  int32_t PrefetchSparse(Table *table,
+                         const PsRequestMessage &request,
+                         PsResponseMessage &response,  // NOLINT
+                         brpc::Controller *cntl);
+
   int32_t PushGlobalStep(Table *table,
                          const PsRequestMessage &request,
                          PsResponseMessage &response,  // NOLINT
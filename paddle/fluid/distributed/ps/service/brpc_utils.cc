@@ -17,6 +17,8 @@ limitations under the License. */
 #include <arpa/inet.h>
 #include <netdb.h>
 
+#include <algorithm>
+
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -343,5 +345,44 @@ std::string GetIntTypeEndpoint(const std::string& ip, const uint32_t& port) {
   return int_ip_port;
 }
 
+// Below it, a block costs more than copying it in the blocks of the IOBuf.
+static const size_t kIOBufCopyLimit = 4096;
+
+char* AllocIOBufBlock(size_t size) {
+  char* block = static_cast<char*>(malloc(std::max<size_t>(size, 1)));
+  PADDLE_ENFORCE_NOT_NULL(
+      block,
+      platform::errors::ResourceExhausted(
+          "Fail to alloc an IOBuf block of %d bytes.", size));
+  return block;
+}
+
+void AppendIOBufBlock(butil::IOBuf* iobuf, char* block, size_t size) {
+  if (size < kIOBufCopyLimit ||
+      iobuf->append_user_data(block, size, free) != 0) {
+    iobuf->append(block, size);
+    free(block);
+  }
+}
+
+const char* FetchIOBuf(const butil::IOBuf& iobuf,
+                       size_t size,
+                       std::vector<uint64_t>* scratch) {
+  if (iobuf.size() < size) {
+    return nullptr;
+  }
+  if (size == 0) {
+    return "";
+  }
+  auto block = iobuf.backing_block(0);
+  if (block.size() >= size &&
+      reinterpret_cast<uintptr_t>(block.data()) % alignof(uint64_t) == 0) {
+    return block.data();
+  }
+  scratch->resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  iobuf.copy_to(scratch->data(), size);
+  return reinterpret_cast<const char*>(scratch->data());
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -94,5 +94,21 @@ void DeserializeSelectedRows(framework::Variable* var,
 
 std::string GetIntTypeEndpoint(const std::string& ip, const uint32_t& port);
 
+// A block of size bytes, to be filled by the caller and then moved into an
+// IOBuf by AppendIOBufBlock rather than copied into it.
+char* AllocIOBufBlock(size_t size);
+
+// Appends the first size bytes of block, of AllocIOBufBlock, to iobuf. The
+// block is referenced by iobuf as user data and freed with its last
+// reference, it is copied and freed at once if small.
+void AppendIOBufBlock(butil::IOBuf* iobuf, char* block, size_t size);
+
+// The first size bytes of iobuf, in place if they are in a single block of
+// it aligned for uint64_t, copied to scratch otherwise. nullptr if iobuf is
+// shorter.
+const char* FetchIOBuf(const butil::IOBuf& iobuf,
+                       size_t size,
+                       std::vector<uint64_t>* scratch);
+
 }  // namespace distributed
 }  // namespace paddle
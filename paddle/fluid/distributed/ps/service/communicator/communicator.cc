@@ -22,6 +22,10 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/utils/string/string_helper.h"
 
+COMMON_DECLARE_bool(communicator_dense_accumulate);
+COMMON_DECLARE_string(communicator_dense_compress);
+COMMON_DECLARE_double(communicator_dense_topk_ratio);
+
 #define LEARNING_RATE_DECAY_COUNTER "@LR_DECAY_COUNTER@"
 #define STEP_COUNTER "@PS_STEP_COUNTER@"
 
@@ -212,7 +216,28 @@ void Communicator::RpcSendDense(const CommContext &ctx,
     memcpy(data + pos, g, count * sizeof(float));
     pos += count;
   }
+  PushDenseData(table_id, dense_data.get());
+  return;
+}
+
+DenseGradCompressor *Communicator::DenseCompressor(int table_id) {
+  std::lock_guard<std::mutex> lock(dense_compressors_mutex_);
+  auto iter = dense_compressors_.find(table_id);
+  if (iter == dense_compressors_.end()) {
+    std::unique_ptr<DenseGradCompressor> compressor;
+    auto type = ParseDenseCompressType(FLAGS_communicator_dense_compress);
+    if (type != DenseCompressType::kNone) {
+      compressor = std::make_unique<DenseGradCompressor>(
+          type, FLAGS_communicator_dense_topk_ratio);
+    }
+    iter = dense_compressors_.emplace(table_id, std::move(compressor)).first;
+  }
+  return iter->second.get();
+}
 
+void Communicator::PushDenseData(int table_id,
+                                 std::vector<float> *dense_data) {
+  size_t request_call_num = _worker_ptr->GetServerNums();
   ++_async_call_num;
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
       request_call_num, [this, request_call_num](void *done) {
@@ -227,8 +252,23 @@ void Communicator::RpcSendDense(const CommContext &ctx,
         closure->set_promise_value(ret);
         --_async_call_num;
       });
-  auto status = _worker_ptr->PushDenseRawGradient(
-      table_id, data, dense_data->size(), closure);
+  std::future<int32_t> status;
+  auto *compressor = DenseCompressor(table_id);
+  if (compressor == nullptr) {
+    status = _worker_ptr->PushDenseRawGradient(
+        table_id, dense_data->data(), dense_data->size(), closure);
+  } else {
+    uint32_t num_per_shard = dense_data->size() / request_call_num;
+    std::vector<std::string> shards(request_call_num);
+    for (size_t i = 0; i < request_call_num; ++i) {
+      compressor->Encode(i,
+                         dense_data->data() + i * num_per_shard,
+                         num_per_shard,
+                         &shards[i]);
+    }
+    status = _worker_ptr->PushDenseCompressedGradient(
+        table_id, compressor->type(), shards, closure);
+  }
   status.wait();
   return;
 }
@@ -498,6 +538,18 @@ void AsyncCommunicator::SendByCommunicator() {
     auto send_recv_task = [this, &ctx] {
       auto &varnames = ctx.origin_varnames;
       auto &table_id = ctx.table_id;
+      if (dense_accumulators_.count(varnames[0]) > 0) {
+        if (SendDenseAccumulated(ctx) == 0) return;
+        if (!independent_recv_ &&
+            recv_varname_to_ctx_.find(table_id) != recv_varname_to_ctx_.end()) {
+          auto recv_varnames = recv_varname_to_ctx_.at(table_id);
+          RpcRecvDense(recv_varnames, table_id, recv_scope_);
+        }
+        if (independent_recv_) {
+          grad_num_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+      }
       size_t var_nums = varnames.size();
       auto &check_queue = send_varname_to_queue_[varnames[0]];
       std::vector<std::vector<std::shared_ptr<Variable>>> vars;
@@ -563,6 +615,66 @@ void AsyncCommunicator::SendByCommunicator() {
   return;
 }
 
+bool AsyncCommunicator::UseDenseAccumulator() {
+  return FLAGS_communicator_dense_accumulate;
+}
+
+int AsyncCommunicator::SendDenseAccumulated(const CommContext &ctx) {
+  auto &varnames = ctx.origin_varnames;
+  std::vector<DenseGradAccumulator *> accumulators;
+  accumulators.reserve(varnames.size());
+  for (auto &var_name : varnames) {
+    accumulators.push_back(dense_accumulators_.at(var_name).get());
+  }
+  // Wait for batches like the queues do: until max_merge_var_num_ batches
+  // are summed, or no new batch comes for send_wait_times_ * 10ms.
+  int64_t merged_var_num = accumulators[0]->Count();
+  int wait_times = 0;
+  while (merged_var_num < max_merge_var_num_ &&
+         wait_times < send_wait_times_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    int64_t count = accumulators[0]->Count();
+    if (count > merged_var_num) {
+      merged_var_num = count;
+      wait_times = 0;
+    } else {
+      wait_times++;
+    }
+  }
+  if (merged_var_num == 0) return 0;
+  for (auto *accumulator : accumulators) {
+    // Some variable has never been sent yet, so its place in the dense
+    // data is not known.
+    if (accumulator->Numel() == 0) return 0;
+  }
+
+  size_t request_call_num = _worker_ptr->GetServerNums();
+  uint32_t num_per_shard =
+      DenseDimPerShard(ctx.height_sections[0], request_call_num);
+  std::vector<float> dense_data(num_per_shard * request_call_num, 0.0f);
+  size_t pos = 0;
+  int64_t batches = 0;
+  for (size_t i = 0; i < accumulators.size(); ++i) {
+    size_t count = accumulators[i]->Numel();
+    PADDLE_ENFORCE_LE(pos + count,
+                      dense_data.size(),
+                      platform::errors::InvalidArgument(
+                          "Invalid dense size, cur pos[%d] data_num[%d] "
+                          "size[%d].",
+                          pos,
+                          count,
+                          dense_data.size()));
+    int64_t summed = accumulators[i]->Flush([&](const float *sum, size_t n) {
+      memcpy(dense_data.data() + pos, sum, n * sizeof(float));
+    });
+    if (i == 0) batches = summed;
+    pos += count;
+  }
+  VLOG(4) << "send " << batches << " accumulated batches of " << ctx.var_name;
+  PushDenseData(ctx.table_id, &dense_data);
+  return static_cast<int>(batches);
+}
+
 void AsyncCommunicator::PushDensePostProcessing() {
   if (independent_recv_) {
     grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -798,13 +910,19 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
   recv_scope_ = std::move(recv_scope);
   send_scope_ = std::make_unique<Scope>();
   xpu_temp_scope_ = std::make_unique<Scope>();
+  bool accumulate = UseDenseAccumulator();
   for (auto &iter : send_varname_to_ctx_) {
     auto &ctx = iter.second;
     auto &varnames = ctx.origin_varnames;
     for (auto &var_name : varnames) {
-      send_varname_to_queue_[var_name] =
-          std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
-              send_queue_size_);
+      if (accumulate && !ctx.is_sparse && !ctx.is_tensor_table) {
+        dense_accumulators_[var_name] =
+            std::make_unique<DenseGradAccumulator>();
+      } else {
+        send_varname_to_queue_[var_name] =
+            std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
+                send_queue_size_);
+      }
     }
   }
   send_threadpool_ = std::make_unique<::ThreadPool>(thread_pool_size_);
@@ -893,6 +1011,18 @@ void AsyncCommunicator::Send(const std::vector<std::string> &var_names,
   waiting_ = false;
   for (const auto &var_name : var_names) {
     auto *var = scope.FindVar(var_name);
+    auto accumulator = dense_accumulators_.find(var_name);
+    if (accumulator != dense_accumulators_.end()) {
+      const auto &tensor = var->Get<phi::DenseTensor>();
+      if (platform::is_cpu_place(tensor.place())) {
+        accumulator->second->Add(tensor.data<float>(), tensor.numel());
+      } else {
+        phi::DenseTensor cpu_tensor;
+        framework::TensorCopySync(tensor, platform::CPUPlace(), &cpu_tensor);
+        accumulator->second->Add(cpu_tensor.data<float>(), cpu_tensor.numel());
+      }
+      continue;
+    }
     auto tmp_grad_var = std::make_shared<Variable>();
     framework::CopyVariable(*var, tmp_grad_var.get());
     send_varname_to_queue_[var_name]->Push(tmp_grad_var);
@@ -17,13 +17,18 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <numeric>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -31,6 +36,7 @@ limitations under the License. */
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/service/communicator/communicator_common.h"
+#include "paddle/fluid/distributed/ps/service/communicator/dense_compressor.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/framework/channel.h"
@@ -227,6 +233,94 @@ inline void MergeVars(const std::string &var_name,
   }
 }
 
+// Sums the gradients of a dense variable in place as the trainers send them,
+// instead of queueing a copy per batch for MergeVars. The sum lives in one of
+// two buffers: the trainers add into the active one stripe by stripe, so that
+// several of them add at the same time, and the send thread swaps the buffers
+// before reading the sum out of the inactive one.
+class DenseGradAccumulator {
+ public:
+  // Number of floats guarded by each stripe lock.
+  static constexpr size_t kStripeSize = 16 * 1024;
+
+  void Add(const float *grad, size_t numel) {
+    Init(numel);
+    std::shared_lock<std::shared_mutex> lock(swap_mutex_);
+    float *sum = buffers_[active_].data();
+    size_t num_stripes = stripe_mutexes_.size();
+    // Start at a stripe of its own, so that the trainers do not queue up
+    // behind each other on the same stripes.
+    size_t first =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) % num_stripes;
+    for (size_t i = 0; i < num_stripes; ++i) {
+      size_t stripe = (first + i) % num_stripes;
+      size_t begin = stripe * kStripeSize;
+      size_t end = std::min(numel, begin + kStripeSize);
+      std::lock_guard<std::mutex> stripe_lock(stripe_mutexes_[stripe]);
+      for (size_t j = begin; j < end; ++j) {
+        sum[j] += grad[j];
+      }
+    }
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Number of gradients added since the last Flush.
+  int64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+  // 0 until the first Add.
+  size_t Numel() const { return numel_.load(std::memory_order_acquire); }
+
+  // Swap the buffers, call fn(sum, numel) on the gradients added since the
+  // last flush if there are any, and return their number. Only one thread may
+  // flush at a time.
+  template <typename Fn>
+  int64_t Flush(Fn &&fn) {
+    int taken = 0;
+    int64_t count = 0;
+    {
+      std::unique_lock<std::shared_mutex> lock(swap_mutex_);
+      taken = active_;
+      active_ = 1 - active_;
+      count = count_.exchange(0, std::memory_order_relaxed);
+    }
+    if (count > 0) {
+      auto &buffer = buffers_[taken];
+      fn(static_cast<const float *>(buffer.data()), buffer.size());
+      std::fill(buffer.begin(), buffer.end(), 0.0f);
+    }
+    return count;
+  }
+
+ private:
+  void Init(size_t numel) {
+    if (Numel() == 0) {
+      std::unique_lock<std::shared_mutex> lock(swap_mutex_);
+      if (Numel() == 0) {
+        buffers_[0].assign(numel, 0.0f);
+        buffers_[1].assign(numel, 0.0f);
+        stripe_mutexes_ =
+            std::vector<std::mutex>((numel + kStripeSize - 1) / kStripeSize);
+        numel_.store(numel, std::memory_order_release);
+      }
+    }
+    PADDLE_ENFORCE_EQ(Numel(),
+                      numel,
+                      platform::errors::InvalidArgument(
+                          "The dense gradient has %d values, but the previous "
+                          "ones had %d.",
+                          numel,
+                          Numel()));
+  }
+
+  // Shared by the trainers adding, exclusive to swap the buffers.
+  std::shared_mutex swap_mutex_;
+  std::vector<std::mutex> stripe_mutexes_;
+  std::vector<float> buffers_[2];
+  int active_ = 0;
+  std::atomic<int64_t> count_{0};
+  std::atomic<size_t> numel_{0};
+};
+
 using RpcCtxMap = std::unordered_map<std::string, CommContext>;
 using RecvCtxMap = std::unordered_map<uint64_t, std::vector<std::string>>;
 using SparseValue = std::unordered_map<int64_t, std::vector<float>>;
@@ -265,6 +359,9 @@ class Communicator {
                                  const Scope &scope);
   // 3. send dense grad
   virtual void RpcSendDense(const CommContext &ctx, const Scope &scope);
+  // push dense_data, laid out as RpcSendDense does, compressed according to
+  // FLAGS_communicator_dense_compress
+  void PushDenseData(int table_id, std::vector<float> *dense_data);
   // 4. send sparse grad
   virtual void RpcSendSparse(const std::string &var_name,
                              int table_id,
@@ -409,6 +506,10 @@ class Communicator {
   }
 
   void InitGFlag(const std::string &gflags);
+
+  // nullptr when the dense pushes are not compressed.
+  DenseGradCompressor *DenseCompressor(int table_id);
+
   ::paddle::distributed::PSParameter _ps_param;
   ::paddle::distributed::PaddlePSEnvironment _ps_env;
   int servers_ = 0;
@@ -421,6 +522,10 @@ class Communicator {
   Scope *recv_scope_;  // should be global scope
   std::unique_ptr<Scope> xpu_temp_scope_;
   std::atomic<uint32_t> _async_call_num{0};
+
+  std::mutex dense_compressors_mutex_;
+  std::unordered_map<int, std::unique_ptr<DenseGradCompressor>>
+      dense_compressors_;
 };
 
 class AsyncCommunicator : public Communicator {
@@ -464,6 +569,14 @@ class AsyncCommunicator : public Communicator {
 
   virtual void SendByCommunicator();
 
+  // Whether the dense gradients are summed by DenseGradAccumulator instead of
+  // being queued, the barriers of HalfAsyncCommunicator count queued batches.
+  virtual bool UseDenseAccumulator();
+
+  // Send the sum of the dense gradients of ctx accumulated since the last
+  // call, returns the number of summed batches.
+  int SendDenseAccumulated(const CommContext &ctx);
+
   virtual void RecvByCommunicator();
 
   virtual void RecvNoBarrier();
@@ -500,6 +613,8 @@ class AsyncCommunicator : public Communicator {
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
+  std::unordered_map<std::string, std::unique_ptr<DenseGradAccumulator>>
+      dense_accumulators_;
   std::unique_ptr<::ThreadPool> send_threadpool_{nullptr};
 
   int min_send_grad_num_before_recv_;
@@ -544,6 +659,8 @@ class HalfAsyncCommunicator : public AsyncCommunicator {
 
   void SendByCommunicator() override;
 
+  bool UseDenseAccumulator() override { return false; }
+
   void Clean() override;
 
   void Barrier() override;
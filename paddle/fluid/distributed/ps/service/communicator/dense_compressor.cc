@@ -0,0 +1,190 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/communicator/dense_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+DenseCompressType ParseDenseCompressType(const std::string &name) {
+  if (name == "none") return DenseCompressType::kNone;
+  if (name == "fp16") return DenseCompressType::kFp16;
+  if (name == "topk") return DenseCompressType::kTopK;
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "Unknown dense compression %s, expected none, fp16 or topk.", name));
+}
+
+const char *DenseCompressTypeName(DenseCompressType type) {
+  switch (type) {
+    case DenseCompressType::kFp16:
+      return "fp16";
+    case DenseCompressType::kTopK:
+      return "topk";
+    default:
+      return "none";
+  }
+}
+
+DenseGradCompressor::DenseGradCompressor(DenseCompressType type,
+                                         double topk_ratio)
+    : type_(type), topk_ratio_(topk_ratio) {
+  PADDLE_ENFORCE_EQ(
+      topk_ratio > 0 && topk_ratio <= 1,
+      true,
+      platform::errors::InvalidArgument(
+          "The topk ratio must be in (0, 1], but got %f.", topk_ratio));
+}
+
+std::vector<float> *DenseGradCompressor::Residual(size_t shard,
+                                                  uint32_t num) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (residuals_.size() <= shard) {
+    residuals_.resize(shard + 1);
+  }
+  auto *residual = &residuals_[shard];
+  if (residual->size() != num) {
+    residual->assign(num, 0);
+  }
+  return residual;
+}
+
+void DenseGradCompressor::Encode(size_t shard,
+                                 const float *grad,
+                                 uint32_t num,
+                                 std::string *out) {
+  out->clear();
+  out->append(reinterpret_cast<const char *>(&num), sizeof(uint32_t));
+  if (type_ == DenseCompressType::kNone) {
+    out->append(reinterpret_cast<const char *>(grad), num * sizeof(float));
+    return;
+  }
+
+  float *residual = Residual(shard, num)->data();
+  if (type_ == DenseCompressType::kFp16) {
+    size_t offset = out->size();
+    out->resize(offset + num * sizeof(uint16_t));
+    uint16_t *half = reinterpret_cast<uint16_t *>(&(*out)[offset]);
+    // The largest finite fp16, beyond which the value would round to inf and
+    // the residual to -inf. The clamped off part is sent in later rounds.
+    constexpr float kMaxFp16 = 65504.0f;
+    for (uint32_t i = 0; i < num; ++i) {
+      float value = grad[i] + residual[i];
+      phi::dtype::float16 rounded(
+          std::min(std::max(value, -kMaxFp16), kMaxFp16));
+      half[i] = rounded.x;
+      residual[i] = value - static_cast<float>(rounded);
+    }
+    return;
+  }
+
+  // topk: the residual becomes the compensated gradient, the sent values are
+  // taken out of it.
+  for (uint32_t i = 0; i < num; ++i) {
+    residual[i] += grad[i];
+  }
+  uint32_t k = static_cast<uint32_t>(std::ceil(topk_ratio_ * num));
+  k = std::min(std::max<uint32_t>(k, 1), num);
+  std::vector<uint32_t> index(num);
+  std::iota(index.begin(), index.end(), 0);
+  if (k < num) {
+    std::nth_element(index.begin(),
+                     index.begin() + k,
+                     index.end(),
+                     [residual](uint32_t a, uint32_t b) {
+                       return std::fabs(residual[a]) > std::fabs(residual[b]);
+                     });
+    index.resize(k);
+    std::sort(index.begin(), index.end());
+  }
+  size_t offset = out->size();
+  out->resize(offset + sizeof(uint32_t) + k * sizeof(uint32_t) +
+              k * sizeof(float));
+  char *p = &(*out)[offset];
+  memcpy(p, &k, sizeof(uint32_t));
+  memcpy(p + sizeof(uint32_t), index.data(), k * sizeof(uint32_t));
+  float *values =
+      reinterpret_cast<float *>(p + sizeof(uint32_t) + k * sizeof(uint32_t));
+  for (uint32_t j = 0; j < k; ++j) {
+    values[j] = residual[index[j]];
+    residual[index[j]] = 0;
+  }
+}
+
+void DenseGradCompressor::Decode(DenseCompressType type,
+                                 const char *data,
+                                 size_t size,
+                                 std::vector<float> *out) {
+  auto check_size = [size](size_t expected) {
+    PADDLE_ENFORCE_GE(size,
+                      expected,
+                      platform::errors::InvalidArgument(
+                          "Truncated %d bytes dense gradient, expected at "
+                          "least %d bytes.",
+                          size,
+                          expected));
+  };
+  check_size(sizeof(uint32_t));
+  uint32_t num = 0;
+  memcpy(&num, data, sizeof(uint32_t));
+  data += sizeof(uint32_t);
+  out->assign(num, 0);
+
+  switch (type) {
+    case DenseCompressType::kNone:
+      check_size(sizeof(uint32_t) + num * sizeof(float));
+      memcpy(out->data(), data, num * sizeof(float));
+      break;
+    case DenseCompressType::kFp16:
+      check_size(sizeof(uint32_t) + num * sizeof(uint16_t));
+      for (uint32_t i = 0; i < num; ++i) {
+        uint16_t half = 0;
+        memcpy(&half, data + i * sizeof(uint16_t), sizeof(uint16_t));
+        (*out)[i] =
+            static_cast<float>(phi::dtype::raw_uint16_to_float16(half));
+      }
+      break;
+    case DenseCompressType::kTopK: {
+      check_size(2 * sizeof(uint32_t));
+      uint32_t k = 0;
+      memcpy(&k, data, sizeof(uint32_t));
+      data += sizeof(uint32_t);
+      check_size(2 * sizeof(uint32_t) + k * (sizeof(uint32_t) + sizeof(float)));
+      const char *values = data + k * sizeof(uint32_t);
+      for (uint32_t j = 0; j < k; ++j) {
+        uint32_t i = 0;
+        memcpy(&i, data + j * sizeof(uint32_t), sizeof(uint32_t));
+        PADDLE_ENFORCE_LT(i,
+                          num,
+                          platform::errors::InvalidArgument(
+                              "Index %d of the topk dense gradient is out of "
+                              "its %d values.",
+                              i,
+                              num));
+        memcpy(&(*out)[i], values + j * sizeof(float), sizeof(float));
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
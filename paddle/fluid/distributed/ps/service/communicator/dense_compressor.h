@@ -0,0 +1,71 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+enum class DenseCompressType : uint8_t { kNone = 0, kFp16 = 1, kTopK = 2 };
+
+// "none", "fp16" or "topk", throws on other names.
+DenseCompressType ParseDenseCompressType(const std::string &name);
+
+const char *DenseCompressTypeName(DenseCompressType type);
+
+/**
+ * Lossy compression of the dense gradient shards pushed to the servers.
+ *
+ * An encoded shard starts with the uint32 number of values, like the raw
+ * payload of PushDenseRawGradient, followed by
+ *   fp16: the values as uint16 half floats,
+ *   topk: the uint32 number k of sent values, their uint32 indices in
+ *         ascending order, then the k float values.
+ * The values dropped or rounded off are kept per shard and added to the
+ * next gradient of the shard (error feedback), so that nothing is lost in
+ * the long run. Shards may be encoded concurrently, but not a given shard.
+ **/
+class DenseGradCompressor {
+ public:
+  DenseGradCompressor(DenseCompressType type, double topk_ratio);
+
+  DenseCompressType type() const { return type_; }
+
+  void Encode(size_t shard, const float *grad, uint32_t num, std::string *out);
+
+  // Decode a shard encoded as type, out is resized to its number of values.
+  static void Decode(DenseCompressType type,
+                     const char *data,
+                     size_t size,
+                     std::vector<float> *out);
+
+ private:
+  std::vector<float> *Residual(size_t shard, uint32_t num);
+
+  DenseCompressType type_;
+  double topk_ratio_;
+  std::mutex mutex_;
+  // A deque, so that growing it keeps the residuals of other shards.
+  std::deque<std::vector<float>> residuals_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -66,6 +66,22 @@ int32_t PSClient::Configure(  // called in FleetWrapper::InitWorker
   return Initialize();
 }
 
+std::future<int32_t> PSClient::PushDenseCompressedGradient(
+    int table_id,
+    DenseCompressType type,
+    const std::vector<std::string> &shards,
+    void *done) {
+  std::vector<float> dense_data;
+  std::vector<float> shard_data;
+  for (const auto &shard : shards) {
+    DenseGradCompressor::Decode(type, shard.data(), shard.size(), &shard_data);
+    dense_data.insert(dense_data.end(), shard_data.begin(), shard_data.end());
+  }
+  // The raw push copies or consumes the data before returning.
+  return PushDenseRawGradient(
+      table_id, dense_data.data(), dense_data.size(), done);
+}
+
 PSClient *PSClientFactory::Create(const PSParameter &ps_config) {
   const auto &config = ps_config.server_param();
   if (!config.has_downpour_server_param()) {
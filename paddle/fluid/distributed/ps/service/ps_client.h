@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/communicator/dense_compressor.h"
 #include "paddle/fluid/distributed/ps/service/env.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
 #include "paddle/fluid/distributed/ps/service/sparse_shard_value.h"
@@ -192,6 +193,17 @@ class PSClient {
     return fut;
   }
 
+  // Hint that keys of table_id are about to be pulled, so that a table kept
+  // on SSD loads them into memory in the background.
+  virtual std::future<int32_t> PrefetchSparse(size_t table_id UNUSED,
+                                              const uint64_t *keys UNUSED,
+                                              size_t num UNUSED) {
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(0);
+    return fut;
+  }
+
   // 确保所有积攒中的请求都发起发送
   virtual std::future<int32_t> Flush() = 0;
   // server优雅退出
@@ -265,6 +277,15 @@ class PSClient {
                                                     size_t total_send_data_size,
                                                     void *done) = 0;
 
+  // Push a dense gradient already split and encoded per server by
+  // DenseGradCompressor, shards[i] being the payload of server i. The
+  // default decodes the shards on the client and pushes them raw.
+  virtual std::future<int32_t> PushDenseCompressedGradient(
+      int table_id,
+      DenseCompressType type,
+      const std::vector<std::string> &shards,
+      void *done);
+
   virtual std::future<int32_t> PushSparseRawGradient(
       size_t table_id,
       const uint64_t *keys,
@@ -283,6 +283,14 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+::std::future<int32_t> PsLocalClient::PrefetchSparse(size_t table_id,
+                                                     const uint64_t* keys,
+                                                     size_t num) {
+  auto* table_ptr = GetTable(table_id);
+  table_ptr->Prefetch(keys, num);
+  return done();
+}
+
 ::std::future<int32_t> PsLocalClient::PushSparseRawGradient(
     size_t table_id,
     const uint64_t* keys,
@@ -0,0 +1,249 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+
+namespace paddle {
+namespace distributed {
+
+struct SparseHotKeyCacheStats {
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  // Pushes of hot keys merged in the cache, and the merged pushes sent.
+  std::atomic<uint64_t> merged_pushes{0};
+  std::atomic<uint64_t> sent_pushes{0};
+  std::atomic<uint64_t> refreshes{0};
+
+  double HitRatio() const {
+    uint64_t total = hits.load() + misses.load();
+    return total == 0 ? 0.0 : static_cast<double>(hits.load()) / total;
+  }
+  std::string ToString() const {
+    return "hits[" + std::to_string(hits.load()) + "] misses[" +
+           std::to_string(misses.load()) + "] merged_pushes[" +
+           std::to_string(merged_pushes.load()) + "] sent_pushes[" +
+           std::to_string(sent_pushes.load()) + "] refreshes[" +
+           std::to_string(refreshes.load()) + "]";
+  }
+};
+
+/**
+ * Worker side read-through cache of a sparse table for its hot keys, the
+ * keys pulled the most of late reported by the servers. The value pulled for
+ * a hot key is served from the cache until the next refresh, once every
+ * refresh_steps pulls, so it is at most refresh_steps pulls stale; the
+ * pushes of the hot keys are merged in the cache and sent once every
+ * refresh_steps pushes, rather than with every push.
+ *
+ * The lookups and the merges take a batch of keys under one lock, the
+ * pulls and pushes of a table running on several threads.
+ **/
+class SparseHotKeyCache {
+ public:
+  SparseHotKeyCache(ValueAccessor* accessor, int refresh_steps)
+      : _accessor(accessor),
+        _select_dim(accessor->GetAccessorInfo().select_dim),
+        _update_size(accessor->GetAccessorInfo().update_size),
+        _refresh_steps(std::max(refresh_steps, 1)) {}
+
+  // Counts a pull, true at the first pull and once every refresh_steps
+  // pulls, when the hot keys are to be refreshed. The cached values are
+  // dropped then.
+  bool NextPull() {
+    if (_pull_steps++ % _refresh_steps != 0) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry : _entries) {
+      entry.second.cached = false;
+    }
+    _stats.refreshes.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  // Counts a push, true once every refresh_steps pushes or after
+  // RequestPushFlush, when the merged pushes are to be sent.
+  bool NextPush() {
+    return ++_push_steps % _refresh_steps == 0 || _flush_pushes.exchange(false);
+  }
+  void RequestPushFlush() { _flush_pushes = true; }
+  // Whether this caller is to fetch the hot keys, the others go on with the
+  // previous ones meanwhile.
+  bool BeginRefresh() { return !_refreshing.exchange(true); }
+  void EndRefresh() { _refreshing = false; }
+
+  // Replaces the hot keys. The values of the keys no longer hot are dropped,
+  // their merged pushes kept until sent.
+  void SetHotKeys(const std::vector<uint64_t>& keys) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_map<uint64_t, Entry> entries;
+    entries.reserve(keys.size());
+    for (auto key : keys) {
+      entries[key];
+    }
+    for (auto& entry : _entries) {
+      auto it = entries.find(entry.first);
+      if (it != entries.end()) {
+        it->second = std::move(entry.second);
+      } else if (entry.second.pushed) {
+        entry.second.hot = false;
+        entries[entry.first] = std::move(entry.second);
+      }
+    }
+    _entries.swap(entries);
+  }
+
+  // Copies the cached values of keys to values, and appends the index of
+  // the other keys to misses. The hot ones among them are appended to
+  // hot_misses, to be stored once pulled.
+  void Lookup(const uint64_t* keys,
+              float** values,
+              size_t num,
+              std::vector<size_t>* misses,
+              std::vector<std::pair<uint64_t, float*>>* hot_misses) {
+    size_t hits = 0;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (size_t i = 0; i < num; ++i) {
+        auto it = _entries.find(keys[i]);
+        if (it == _entries.end() || !it->second.hot) {
+          misses->push_back(i);
+        } else if (!it->second.cached) {
+          misses->push_back(i);
+          hot_misses->emplace_back(keys[i], values[i]);
+        } else {
+          memcpy(values[i],
+                 it->second.value.data(),
+                 _select_dim * sizeof(float));
+          ++hits;
+        }
+      }
+    }
+    _stats.hits.fetch_add(hits, std::memory_order_relaxed);
+    _stats.misses.fetch_add(num - hits, std::memory_order_relaxed);
+  }
+
+  // Caches the pulled values of hot keys, of Lookup.
+  void Store(const std::vector<std::pair<uint64_t, float*>>& pulled) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& kv : pulled) {
+      auto it = _entries.find(kv.first);
+      // Stays a miss if the hot keys changed in the meantime.
+      if (it == _entries.end() || !it->second.hot) {
+        continue;
+      }
+      it->second.value.assign(kv.second, kv.second + _select_dim);
+      it->second.cached = true;
+    }
+  }
+
+  // Merges the pushes of the hot keys in the cache, and appends the index of
+  // the other keys to cold.
+  void MergePushes(const uint64_t* keys,
+                   const float** update_values,
+                   size_t num,
+                   std::vector<size_t>* cold) {
+    size_t merged = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < num; ++i) {
+      auto it = _entries.find(keys[i]);
+      if (it == _entries.end() || !it->second.hot) {
+        cold->push_back(i);
+        continue;
+      }
+      auto& entry = it->second;
+      if (!entry.pushed) {
+        entry.push.assign(reinterpret_cast<const char*>(update_values[i]),
+                          _update_size);
+        entry.pushed = true;
+      } else {
+        float* merged_value = reinterpret_cast<float*>(&entry.push[0]);
+        _accessor->Merge(&merged_value, &update_values[i], 1);
+      }
+      ++merged;
+    }
+    _stats.merged_pushes.fetch_add(merged, std::memory_order_relaxed);
+  }
+
+  // Moves the merged pushes out of the cache, forgetting the keys no longer
+  // hot.
+  void TakePushes(std::vector<uint64_t>* keys,
+                  std::vector<std::string>* update_values) {
+    keys->clear();
+    update_values->clear();
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end();) {
+      auto& entry = it->second;
+      if (entry.pushed) {
+        keys->push_back(it->first);
+        update_values->emplace_back(std::move(entry.push));
+        entry.push.clear();
+        entry.pushed = false;
+      }
+      if (!entry.hot) {
+        it = _entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    _stats.sent_pushes.fetch_add(keys->size(), std::memory_order_relaxed);
+  }
+
+  bool HasPushes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry : _entries) {
+      if (entry.second.pushed) return true;
+    }
+    return false;
+  }
+
+  const SparseHotKeyCacheStats& GetStats() const { return _stats; }
+
+ private:
+  struct Entry {
+    bool hot = true;
+    bool cached = false;
+    bool pushed = false;
+    std::vector<float> value;
+    // The merged update, of update_size bytes.
+    std::string push;
+  };
+
+  ValueAccessor* _accessor;
+  size_t _select_dim;
+  size_t _update_size;
+  uint64_t _refresh_steps;
+  std::atomic<uint64_t> _pull_steps{0};
+  std::atomic<uint64_t> _push_steps{0};
+  std::atomic<bool> _flush_pushes{false};
+  std::atomic<bool> _refreshing{false};
+  std::mutex _mutex;
+  std::unordered_map<uint64_t, Entry> _entries;
+  SparseHotKeyCacheStats _stats;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -246,6 +246,11 @@ int32_t CtrCommonAccessor::Merge(float** update_values,
 int32_t CtrCommonAccessor::Update(float** update_values,
                                   const float** push_values,
                                   size_t num) {
+  size_t batch = num > 1 ? num : 0;
+  std::vector<float*> w(batch), sgd(batch);
+  std::vector<float*> embedx_w(batch), embedx_sgd(batch);
+  std::vector<const float*> grad(batch), embedx_grad(batch);
+  std::vector<float> scale(batch);
   for (size_t value_item = 0; value_item < num; ++value_item) {
     float* update_value = update_values[value_item];
     const float* push_value = push_values[value_item];
@@ -265,16 +270,37 @@ int32_t CtrCommonAccessor::Update(float** update_values,
     }
     VLOG(3) << "accessor show scale:" << _show_scale
             << ", push_show:" << push_show;
-    _embed_sgd_rule->UpdateValue(
-        update_value + common_feature_value.EmbedWIndex(),
-        update_value + common_feature_value.EmbedG2SumIndex(),
-        push_value + CtrCommonPushValue::EmbedGIndex(),
-        push_show);
-    _embedx_sgd_rule->UpdateValue(
-        update_value + common_feature_value.EmbedxWIndex(),
-        update_value + common_feature_value.EmbedxG2SumIndex(),
-        push_value + CtrCommonPushValue::EmbedxGIndex(),
-        push_show);
+    if (num == 1) {
+      _embed_sgd_rule->UpdateValue(
+          update_value + common_feature_value.EmbedWIndex(),
+          update_value + common_feature_value.EmbedG2SumIndex(),
+          push_value + CtrCommonPushValue::EmbedGIndex(),
+          push_show);
+      _embedx_sgd_rule->UpdateValue(
+          update_value + common_feature_value.EmbedxWIndex(),
+          update_value + common_feature_value.EmbedxG2SumIndex(),
+          push_value + CtrCommonPushValue::EmbedxGIndex(),
+          push_show);
+      continue;
+    }
+    w[value_item] = update_value + common_feature_value.EmbedWIndex();
+    sgd[value_item] = update_value + common_feature_value.EmbedG2SumIndex();
+    grad[value_item] = push_value + CtrCommonPushValue::EmbedGIndex();
+    scale[value_item] = push_show;
+    embedx_w[value_item] = update_value + common_feature_value.EmbedxWIndex();
+    embedx_sgd[value_item] =
+        update_value + common_feature_value.EmbedxG2SumIndex();
+    embedx_grad[value_item] = push_value + CtrCommonPushValue::EmbedxGIndex();
+  }
+  if (num > 1) {
+    // The sgd rules update all the values at once, embed then embedx.
+    _embed_sgd_rule->UpdateValueBatch(
+        w.data(), sgd.data(), grad.data(), scale.data(), num);
+    _embedx_sgd_rule->UpdateValueBatch(embedx_w.data(),
+                                       embedx_sgd.data(),
+                                       embedx_grad.data(),
+                                       scale.data(),
+                                       num);
   }
   return 0;
 }
@@ -0,0 +1,222 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+struct SparseAdmissionStats {
+  // New keys given a row, and new keys seen too few times to get one.
+  std::atomic<uint64_t> admitted{0};
+  std::atomic<uint64_t> rejected{0};
+  // Rows dropped by the eviction to the memory budget, and its rounds.
+  std::atomic<uint64_t> evicted{0};
+  std::atomic<uint64_t> eviction_rounds{0};
+
+  std::string ToString() const {
+    return "admitted[" + std::to_string(admitted.load()) + "] rejected[" +
+           std::to_string(rejected.load()) + "] evicted[" +
+           std::to_string(evicted.load()) + "] eviction_rounds[" +
+           std::to_string(eviction_rounds.load()) + "]";
+  }
+};
+
+/**
+ * Count-min sketch of the occurrences of the keys: depth rows of width
+ * saturating counters, a key counting in one counter per row and its count
+ * being the minimum of them, never below its real count. Only the minimal
+ * counters of a key are incremented (conservative update), and all the
+ * counters are halved every 8 * width additions, so that the occurrences of
+ * long ago fade out.
+ *
+ * Not thread safe, a shard is only accessed by its own task pool thread.
+ **/
+template <typename CounterT>
+class BasicCountMinSketch {
+ public:
+  static constexpr size_t kDepth = 4;
+  // The counters saturate at this count.
+  static constexpr uint32_t kMaxCount = std::numeric_limits<CounterT>::max();
+
+  // width is rounded up to a power of 2.
+  explicit BasicCountMinSketch(size_t width) {
+    _width_bits = 1;
+    while ((static_cast<size_t>(1) << _width_bits) < width) {
+      ++_width_bits;
+    }
+    _width = static_cast<size_t>(1) << _width_bits;
+    _counters.assign(kDepth * _width, 0);
+    _decay_period = 8 * _width;
+  }
+
+  // Counts one more occurrence of key, returns its count.
+  uint32_t Add(uint64_t key) {
+    size_t index[kDepth];
+    CounterT count = kMaxCount;
+    Index(key, index);
+    for (size_t d = 0; d < kDepth; ++d) {
+      count = std::min(count, _counters[index[d]]);
+    }
+    if (count < kMaxCount) {
+      for (size_t d = 0; d < kDepth; ++d) {
+        if (_counters[index[d]] == count) {
+          ++_counters[index[d]];
+        }
+      }
+      ++count;
+    }
+    if (++_additions >= _decay_period) {
+      Decay();
+    }
+    return count;
+  }
+
+  uint32_t Estimate(uint64_t key) const {
+    size_t index[kDepth];
+    CounterT count = kMaxCount;
+    Index(key, index);
+    for (size_t d = 0; d < kDepth; ++d) {
+      count = std::min(count, _counters[index[d]]);
+    }
+    return count;
+  }
+
+  void Decay() {
+    for (auto& counter : _counters) {
+      counter >>= 1;
+    }
+    _additions = 0;
+  }
+
+  size_t width() const { return _width; }
+  // Additions since the last decay, 0 right after one.
+  size_t additions() const { return _additions; }
+
+ private:
+  // A counter per row, from the high bits of the mixed key times an odd
+  // constant of the row.
+  void Index(uint64_t key, size_t* index) const {
+    static const uint64_t kSeeds[kDepth] = {0x9E3779B97F4A7C15ULL,
+                                            0xC2B2AE3D27D4EB4FULL,
+                                            0x165667B19E3779F9ULL,
+                                            0xD6E8FEB86659FD93ULL};
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    for (size_t d = 0; d < kDepth; ++d) {
+      index[d] = d * _width + ((key * kSeeds[d]) >> (64 - _width_bits));
+    }
+  }
+
+  size_t _width_bits;
+  size_t _width;
+  std::vector<CounterT> _counters;
+  size_t _decay_period;
+  size_t _additions = 0;
+};
+
+// Counts the new keys of a shard, to only give a key a row once it was seen
+// threshold times.
+using CountMinSketch = BasicCountMinSketch<uint8_t>;
+
+/**
+ * The keys pulled the most of late from a shard: the pulls are counted by a
+ * count-min sketch, and the capacity keys of the highest count kept aside
+ * with their counts, halved along with the sketch. A pulled key replaces the
+ * coldest of them once its count is higher.
+ *
+ * Not thread safe, a shard is only accessed by its own task pool thread.
+ **/
+class HotKeyTracker {
+ public:
+  HotKeyTracker(size_t capacity, size_t width)
+      : _capacity(capacity), _sketch(width) {
+    _candidates.reserve(capacity);
+  }
+
+  void Add(uint64_t key) {
+    uint32_t count = _sketch.Add(key);
+    if (_sketch.additions() == 0) {
+      for (auto& candidate : _candidates) {
+        candidate.second >>= 1;
+      }
+      _min_count >>= 1;
+    }
+    auto it = _candidates.find(key);
+    if (it != _candidates.end()) {
+      it->second = count;
+      return;
+    }
+    if (_candidates.size() < _capacity) {
+      _candidates.emplace(key, count);
+      if (_candidates.size() == _capacity) {
+        UpdateMinCount();
+      }
+      return;
+    }
+    if (count <= _min_count) {
+      return;
+    }
+    // the counts only grow between decays, so the coldest is looked for
+    // only when a key gets hotter than it
+    auto coldest = _candidates.begin();
+    for (auto cit = _candidates.begin(); cit != _candidates.end(); ++cit) {
+      if (cit->second < coldest->second) {
+        coldest = cit;
+      }
+    }
+    if (count <= coldest->second) {
+      _min_count = coldest->second;
+      return;
+    }
+    _candidates.erase(coldest);
+    _candidates.emplace(key, count);
+    UpdateMinCount();
+  }
+
+  // The kept keys and their counts, in no order.
+  void Get(std::vector<std::pair<uint64_t, uint32_t>>* hot_keys) const {
+    hot_keys->assign(_candidates.begin(), _candidates.end());
+  }
+
+  size_t capacity() const { return _capacity; }
+
+ private:
+  void UpdateMinCount() {
+    _min_count = UINT32_MAX;
+    for (auto& candidate : _candidates) {
+      _min_count = std::min(_min_count, candidate.second);
+    }
+  }
+
+  size_t _capacity;
+  BasicCountMinSketch<uint16_t> _sketch;
+  std::unordered_map<uint64_t, uint32_t> _candidates;
+  // not above the count of any kept key
+  uint32_t _min_count = 0;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -20,6 +20,7 @@
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/common/chunk_allocator.h"
+#include "paddle/fluid/distributed/ps/table/depends/swiss_hash_map.h"
 
 namespace paddle {
 namespace distributed {
@@ -41,11 +42,37 @@ class FixedFeatureValue {
   std::vector<float> _data;
 };
 
-template <class KEY, class VALUE>
+// The maps of the buckets of a shard, from a key to its value in the
+// allocator of the shard. WITH_PS_SWISS_TABLE builds the shards on
+// SwissHashMap rather than mct::closed_hash_map.
+#ifdef PADDLE_WITH_PS_SWISS_TABLE
+template <class KEY>
+using ShardBucketMap = SwissHashMap<KEY, mct::Pointer, std::hash<KEY>>;
+#else
+template <class KEY>
+using ShardBucketMap = mct::closed_hash_map<KEY, mct::Pointer, std::hash<KEY>>;
+#endif
+
+// Loads the probe of a hash ahead of its lookup, if the map can.
+template <class MAP>
+struct ShardMapPrefetcher {
+  static void Prefetch(const MAP& map, size_t hash) {}
+};
+
+template <class KEY, class MAPPED, class HASH>
+struct ShardMapPrefetcher<SwissHashMap<KEY, MAPPED, HASH>> {
+  static void Prefetch(const SwissHashMap<KEY, MAPPED, HASH>& map,
+                       size_t hash) {
+    map.prefetch(hash);
+  }
+};
+
+template <class KEY, class VALUE, class MAP = ShardBucketMap<KEY>>
 struct alignas(64) SparseTableShard {
  public:
-  typedef typename mct::closed_hash_map<KEY, mct::Pointer, std::hash<KEY>>
-      map_type;
+  typedef MAP map_type;
+  // How many keys ahead find_batch prefetches.
+  static const size_t kPrefetchDistance = 8;
   struct iterator {
     typename map_type::iterator it;
     size_t bucket;
@@ -136,6 +163,25 @@ struct alignas(64) SparseTableShard {
     }
     return {it, bucket, _buckets};
   }
+  // Prefetch the lookup of key, to find it a few keys later.
+  void prefetch(const KEY& key) {
+    size_t hash = _hasher(key);
+    ShardMapPrefetcher<map_type>::Prefetch(_buckets[compute_bucket(hash)],
+                                           hash);
+  }
+  // Finds n keys, values[i] being the value of keys[i] or null if missing.
+  void find_batch(const KEY* keys, size_t n, VALUE** values) {
+    for (size_t i = 0; i < n && i < kPrefetchDistance; ++i) {
+      prefetch(keys[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (i + kPrefetchDistance < n) {
+        prefetch(keys[i + kPrefetchDistance]);
+      }
+      auto it = find(keys[i]);
+      values[i] = it == end() ? nullptr : it.value_ptr();
+    }
+  }
   VALUE& operator[](const KEY& key) { return emplace(key).first.value(); }
   std::pair<iterator, bool> insert(const KEY& key, const VALUE& val) {
     return emplace(key, val);
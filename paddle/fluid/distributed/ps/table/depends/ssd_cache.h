@@ -0,0 +1,270 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
+
+namespace paddle {
+namespace distributed {
+
+struct SSDCacheStats {
+  // Lookups served from memory, reloaded from SSD (or from the write-back
+  // buffer), and not found anywhere.
+  std::atomic<uint64_t> mem_hits{0};
+  std::atomic<uint64_t> ssd_hits{0};
+  std::atomic<uint64_t> misses{0};
+  // RocksDB reads (one per Get or MultiGet call) and their total time.
+  std::atomic<uint64_t> ssd_reads{0};
+  std::atomic<uint64_t> ssd_read_us{0};
+  std::atomic<uint64_t> evicted{0};
+  std::atomic<uint64_t> prefetched{0};
+  std::atomic<uint64_t> write_batches{0};
+  std::atomic<uint64_t> written_keys{0};
+
+  void AddSSDRead(uint64_t us) {
+    ssd_reads.fetch_add(1, std::memory_order_relaxed);
+    ssd_read_us.fetch_add(us, std::memory_order_relaxed);
+  }
+
+  double HitRatio() const {
+    double hits = mem_hits.load();
+    double total = hits + ssd_hits.load() + misses.load();
+    return total > 0 ? hits / total : 0.0;
+  }
+
+  double AvgSSDReadUs() const {
+    uint64_t reads = ssd_reads.load();
+    return reads > 0 ? static_cast<double>(ssd_read_us.load()) / reads : 0.0;
+  }
+
+  std::string ToString() const {
+    return "hit_ratio[" + std::to_string(HitRatio()) + "] mem_hits[" +
+           std::to_string(mem_hits.load()) + "] ssd_hits[" +
+           std::to_string(ssd_hits.load()) + "] misses[" +
+           std::to_string(misses.load()) + "] ssd_reads[" +
+           std::to_string(ssd_reads.load()) + "] avg_ssd_read_us[" +
+           std::to_string(AvgSSDReadUs()) + "] evicted[" +
+           std::to_string(evicted.load()) + "] prefetched[" +
+           std::to_string(prefetched.load()) + "] write_batches[" +
+           std::to_string(write_batches.load()) + "] written_keys[" +
+           std::to_string(written_keys.load()) + "]";
+  }
+};
+
+/**
+ * Residency policy of the keys of a shard in memory: CLOCK with a small
+ * access frequency per key (GCLOCK). Every access bumps the frequency of the
+ * key up to max_freq; the clock hand sweeps the keys, decrementing their
+ * frequency, and evicts the ones it finds at 0. Frequently used keys thus
+ * survive several sweeps, while a key touched once goes on the next sweep.
+ *
+ * Not thread safe, a shard is only accessed by its own task pool thread.
+ **/
+class ClockPolicy {
+ public:
+  explicit ClockPolicy(uint8_t max_freq = 3) : max_freq_(max_freq) {}
+
+  void Touch(uint64_t key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      index_.emplace(key, slots_.size());
+      slots_.push_back({key, 1, true});
+      return;
+    }
+    auto& freq = slots_[it->second].freq;
+    if (freq < max_freq_) ++freq;
+  }
+
+  void Erase(uint64_t key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return;
+    slots_[it->second].used = false;
+    index_.erase(it);
+    ++dead_;
+  }
+
+  size_t Size() const { return index_.size(); }
+
+  // Append up to n victims to victims and forget them.
+  void Evict(size_t n, std::vector<uint64_t>* victims) {
+    n = std::min(n, index_.size());
+    size_t evicted = 0;
+    while (evicted < n) {
+      if (hand_ >= slots_.size()) {
+        hand_ = 0;
+        Compact();
+      }
+      auto& slot = slots_[hand_++];
+      if (!slot.used) continue;
+      if (slot.freq > 0) {
+        --slot.freq;
+        continue;
+      }
+      victims->push_back(slot.key);
+      slot.used = false;
+      index_.erase(slot.key);
+      ++dead_;
+      ++evicted;
+    }
+  }
+
+  void Clear() {
+    slots_.clear();
+    index_.clear();
+    hand_ = 0;
+    dead_ = 0;
+  }
+
+ private:
+  struct Slot {
+    uint64_t key;
+    uint8_t freq;
+    bool used;
+  };
+
+  // Drop the slots of the erased keys once they are half of the clock, only
+  // called when the hand is back at the start.
+  void Compact() {
+    if (dead_ * 2 < slots_.size()) return;
+    size_t n = 0;
+    for (auto& slot : slots_) {
+      if (!slot.used) continue;
+      index_[slot.key] = n;
+      slots_[n++] = slot;
+    }
+    slots_.resize(n);
+    dead_ = 0;
+  }
+
+  uint8_t max_freq_;
+  std::vector<Slot> slots_;
+  std::unordered_map<uint64_t, size_t> index_;
+  size_t hand_ = 0;
+  size_t dead_ = 0;
+};
+
+/**
+ * Asynchronous write-back of the values evicted from a shard to its RocksDB
+ * column: evicted values are buffered and written by one WriteBatch per
+ * batch_size keys on a background pool, at most one batch of the shard being
+ * in flight. A key reloaded before its value reaches RocksDB is taken back
+ * from the buffer, or read from RocksDB once the batch holding it is written.
+ **/
+class SSDWriteBack {
+ public:
+  SSDWriteBack(RocksDBHandler* db,
+               int shard_id,
+               size_t batch_size,
+               ::ThreadPool* pool,
+               SSDCacheStats* stats)
+      : db_(db),
+        shard_id_(shard_id),
+        batch_size_(std::max<size_t>(batch_size, 1)),
+        pool_(pool),
+        stats_(stats) {}
+
+  ~SSDWriteBack() { Flush(); }
+
+  void Put(uint64_t key, const float* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_[key].assign(reinterpret_cast<const char*>(data),
+                         size * sizeof(float));
+    if (pending_.size() >= batch_size_) {
+      SubmitLocked(&lock);
+    }
+  }
+
+  // Take the value of key back if it has not been written yet, returns
+  // false if key is (or is about to be) in RocksDB, or was never evicted.
+  bool Take(uint64_t key, std::string* value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool written = false;
+    while (writing_ && in_flight_.count(key) > 0) {
+      cond_.wait(lock);
+      written = true;
+    }
+    auto it = pending_.find(key);
+    if (it == pending_.end()) return false;
+    *value = std::move(it->second);
+    pending_.erase(it);
+    if (written) {
+      // An older value has just been written, the key lives in memory now.
+      db_->del_data(
+          shard_id_, reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+    }
+    return true;
+  }
+
+  // Write all the buffered values and wait for them.
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!pending_.empty()) {
+      SubmitLocked(&lock);
+    }
+    cond_.wait(lock, [this] { return !writing_; });
+  }
+
+ private:
+  void SubmitLocked(std::unique_lock<std::mutex>* lock) {
+    cond_.wait(*lock, [this] { return !writing_; });
+    in_flight_.swap(pending_);
+    pending_.clear();
+    writing_ = true;
+    pool_->enqueue([this] {
+      // in_flight_ is only read by Take while writing_ is set.
+      rocksdb::WriteBatch batch;
+      for (auto& kv : in_flight_) {
+        batch.Put(rocksdb::Slice(reinterpret_cast<const char*>(&kv.first),
+                                 sizeof(uint64_t)),
+                  rocksdb::Slice(kv.second));
+      }
+      db_->write_batch(shard_id_, &batch);
+      stats_->write_batches.fetch_add(1, std::memory_order_relaxed);
+      stats_->written_keys.fetch_add(in_flight_.size(),
+                                     std::memory_order_relaxed);
+      std::lock_guard<std::mutex> guard(mutex_);
+      in_flight_.clear();
+      writing_ = false;
+      cond_.notify_all();
+    });
+  }
+
+  RocksDBHandler* db_;
+  int shard_id_;
+  size_t batch_size_;
+  ::ThreadPool* pool_;
+  SSDCacheStats* stats_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::unordered_map<uint64_t, std::string> pending_;
+  std::unordered_map<uint64_t, std::string> in_flight_;
+  bool writing_ = false;
+};
+
+}  // namespace distributed
+}  // namespace paddle
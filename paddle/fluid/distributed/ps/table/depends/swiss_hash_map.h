@@ -0,0 +1,317 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+/**
+ * Open addressing hash map in the layout of the swiss tables: a control byte
+ * per slot, holding the 7 low bits of the hash of its key, or empty, or
+ * deleted, and the slots in a separate array. The slots are probed by
+ * aligned groups of 16, whose control bytes are matched against the hash at
+ * once with SSE2; the keys are only compared for the matching bytes, and a
+ * lookup stops at the first group with an empty slot.
+ *
+ * It has the part of the interface of mct::closed_hash_map used by
+ * SparseTableShard, find_with_hash and insert_with_hash taking the hash of
+ * the key, and prefetch to load the first probed group ahead of a lookup.
+ * As in mct, inserting may rehash and invalidate the iterators, erasing
+ * does not move the other slots.
+ **/
+template <class KEY, class MAPPED, class HASH = std::hash<KEY>>
+class SwissHashMap {
+ public:
+  typedef KEY key_type;
+  typedef MAPPED mapped_type;
+  typedef std::pair<KEY, MAPPED> value_type;
+
+  static constexpr size_t kGroupSize = 16;
+
+  struct iterator {
+    int8_t* ctrl;
+    value_type* slot;
+    int8_t* ctrl_end;
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.ctrl == b.ctrl;
+    }
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return a.ctrl != b.ctrl;
+    }
+    value_type& operator*() const { return *slot; }
+    value_type* operator->() const { return slot; }
+    iterator& operator++() {
+      ++ctrl;
+      ++slot;
+      SkipEmpty();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+    void SkipEmpty() {
+      while (ctrl != ctrl_end && *ctrl < 0) {
+        ++ctrl;
+        ++slot;
+      }
+    }
+  };
+
+  SwissHashMap() {}
+  SwissHashMap(const SwissHashMap&) = delete;
+  ~SwissHashMap() {
+    clear();
+    free(_ctrl);
+    free(_slots);
+  }
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  size_t capacity() const { return _capacity; }
+  // Bytes of the control bytes and the slots.
+  size_t memory_size() const {
+    return _capacity * (sizeof(int8_t) + sizeof(value_type));
+  }
+  // Grows once the full and deleted slots reach x of the capacity.
+  void max_load_factor(float x) {
+    _max_load_factor = std::min(std::max(x, 0.1f), 0.9375f);
+    _growth_left = GrowthCapacity() - std::min(GrowthCapacity(), _used);
+  }
+
+  iterator begin() {
+    iterator it = {_ctrl, _slots, _ctrl + _capacity};
+    it.SkipEmpty();
+    return it;
+  }
+  iterator end() {
+    return {_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity};
+  }
+
+  void prefetch(size_t hash) const {
+    if (_capacity == 0) return;
+    size_t offset = (H1(hash) & _group_mask) * kGroupSize;
+    __builtin_prefetch(_ctrl + offset);
+    __builtin_prefetch(_slots + offset);
+  }
+
+  iterator find(const KEY& key) { return find_with_hash(key, _hasher(key)); }
+  iterator find_with_hash(const KEY& key, size_t hash) {
+    if (_capacity == 0) return end();
+    size_t group = H1(hash) & _group_mask;
+    int8_t h2 = H2(hash);
+    for (size_t probe = 1;; ++probe) {
+      size_t offset = group * kGroupSize;
+      for (uint32_t mask = Match(_ctrl + offset, h2); mask != 0;
+           mask &= mask - 1) {
+        size_t i = offset + __builtin_ctz(mask);
+        if (_slots[i].first == key) {
+          return {_ctrl + i, _slots + i, _ctrl + _capacity};
+        }
+      }
+      if (Match(_ctrl + offset, kEmpty) != 0) return end();
+      group = (group + probe) & _group_mask;
+    }
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return insert_with_hash(value, _hasher(value.first));
+  }
+  std::pair<iterator, bool> insert_with_hash(const value_type& value,
+                                             size_t hash) {
+    iterator it = find_with_hash(value.first, hash);
+    if (it != end()) return {it, false};
+    if (_growth_left == 0) {
+      // Drop the deleted slots in place if they are many, grow otherwise.
+      size_t capacity = _capacity;
+      if (_size * 2 >= GrowthCapacity(capacity)) {
+        capacity = std::max(capacity * 2, kGroupSize);
+        while (_size >= GrowthCapacity(capacity)) {
+          capacity *= 2;
+        }
+      }
+      Rehash(capacity);
+    }
+    size_t i = FindFree(hash);
+    if (_ctrl[i] == kEmpty) {
+      --_growth_left;
+      ++_used;
+    }
+    _ctrl[i] = H2(hash);
+    new (_slots + i) value_type(value);
+    ++_size;
+    return {{_ctrl + i, _slots + i, _ctrl + _capacity}, true};
+  }
+
+  iterator erase(iterator it) {
+    quick_erase(it);
+    ++it;
+    return it;
+  }
+  void quick_erase(iterator it) {
+    size_t i = it.ctrl - _ctrl;
+    it.slot->~value_type();
+    --_size;
+    // A lookup never went past a group with an empty slot, so the slot can
+    // be empty again rather than deleted.
+    size_t offset = i / kGroupSize * kGroupSize;
+    if (Match(_ctrl + offset, kEmpty) != 0) {
+      _ctrl[i] = kEmpty;
+      ++_growth_left;
+      --_used;
+    } else {
+      _ctrl[i] = kDeleted;
+    }
+  }
+  size_t erase(const KEY& key) {
+    iterator it = find(key);
+    if (it == end()) return 0;
+    quick_erase(it);
+    return 1;
+  }
+
+  void clear() {
+    for (size_t i = 0; i < _capacity; ++i) {
+      if (_ctrl[i] >= 0) {
+        _slots[i].~value_type();
+      }
+    }
+    if (_capacity > 0) {
+      memset(_ctrl, kEmpty, _capacity);
+    }
+    _size = 0;
+    _used = 0;
+    _growth_left = GrowthCapacity();
+  }
+
+ private:
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  // The hash of std::hash is the key itself, mix it before splitting it in
+  // the group of H1 and the control byte of H2.
+  static size_t Mix(size_t hash) {
+    uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+  static size_t H1(size_t hash) { return Mix(hash) >> 7; }
+  static int8_t H2(size_t hash) { return Mix(hash) & 0x7F; }
+
+  // Bit i is set if the control byte i of the group is c.
+  static uint32_t Match(const int8_t* group, int8_t c) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupSize; ++i) {
+      mask |= static_cast<uint32_t>(group[i] == c) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // Bit i is set if the slot i of the group is empty or deleted.
+  static uint32_t MatchFree(const int8_t* group) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return _mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupSize; ++i) {
+      mask |= static_cast<uint32_t>(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
+
+  size_t GrowthCapacity(size_t capacity) const {
+    return capacity * _max_load_factor;
+  }
+  size_t GrowthCapacity() const { return GrowthCapacity(_capacity); }
+
+  size_t FindFree(size_t hash) const {
+    size_t group = H1(hash) & _group_mask;
+    for (size_t probe = 1;; ++probe) {
+      size_t offset = group * kGroupSize;
+      uint32_t mask = MatchFree(_ctrl + offset);
+      if (mask != 0) return offset + __builtin_ctz(mask);
+      group = (group + probe) & _group_mask;
+    }
+  }
+
+  void Rehash(size_t capacity) {
+    int8_t* old_ctrl = _ctrl;
+    value_type* old_slots = _slots;
+    size_t old_capacity = _capacity;
+
+    _ctrl = static_cast<int8_t*>(malloc(capacity));
+    // The slots of a group start on a cache line.
+    _slots = static_cast<value_type*>(
+        aligned_alloc(std::max<size_t>(64, alignof(value_type)),
+                      (capacity * sizeof(value_type) + 63) / 64 * 64));
+    PADDLE_ENFORCE_EQ(
+        _ctrl != nullptr && _slots != nullptr,
+        true,
+        paddle::platform::errors::ResourceExhausted(
+            "Fail to alloc a hash map of %d slots.", capacity));
+    memset(_ctrl, kEmpty, capacity);
+    _capacity = capacity;
+    _group_mask = capacity / kGroupSize - 1;
+    _used = _size;
+    _growth_left = GrowthCapacity() - _size;
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0) continue;
+      size_t hash = _hasher(old_slots[i].first);
+      size_t j = FindFree(hash);
+      _ctrl[j] = H2(hash);
+      new (_slots + j) value_type(std::move(old_slots[i]));
+      old_slots[i].~value_type();
+    }
+    free(old_ctrl);
+    free(old_slots);
+  }
+
+  int8_t* _ctrl = nullptr;
+  value_type* _slots = nullptr;
+  // A power of 2 of at least kGroupSize, or 0 before the first insert.
+  size_t _capacity = 0;
+  size_t _group_mask = 0;
+  size_t _size = 0;
+  // The full and deleted slots.
+  size_t _used = 0;
+  size_t _growth_left = 0;
+  float _max_load_factor = 0.875f;
+  HASH _hasher;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -13,6 +13,9 @@
 // limitations under the License.
 
 #include <omp.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
 #include <sstream>
 
 #include "glog/logging.h"
@@ -38,10 +41,56 @@ PD_DEFINE_bool(pserver_enable_create_feasign_randomly,
 PD_DEFINE_int32(pserver_table_save_max_retry,
                 3,
                 "pserver_table_save_max_retry");
+PD_DEFINE_int32(pserver_sparse_update_batch,
+                64,
+                "number of the pushed keys of a shard updated at once by the "
+                "sgd rules, 1 updates them one by one");
+PD_DEFINE_int32(pserver_admission_threshold,
+                0,
+                "number of pushes of a new key before it gets a row in a "
+                "MemorySparseTable, 0 or 1 creates it on its first push, "
+                "at most 255");
+PD_DEFINE_int32(pserver_admission_sketch_width,
+                65536,
+                "counters per row of the count-min sketch counting the new "
+                "keys of a shard for pserver_admission_threshold");
+PD_DEFINE_int64(pserver_sparse_memory_budget_mb,
+                0,
+                "memory of the rows of a MemorySparseTable in MB, above which "
+                "a background thread evicts the coldest rows, 0 disables it");
+PD_DEFINE_int32(pserver_hot_key_refresh_interval_ms,
+                1000,
+                "interval at which the hot keys of a MemorySparseTable are "
+                "recomputed, the workers asking in between get the last ones");
+PD_DEFINE_int32(pserver_hot_key_sketch_width,
+                4096,
+                "counters per row of the count-min sketch counting the pulls "
+                "of the keys of a shard for the hot keys");
+PD_DEFINE_int32(pserver_eviction_interval_ms,
+                10000,
+                "interval of the eviction of MemorySparseTable rows to "
+                "pserver_sparse_memory_budget_mb");
 
 namespace paddle {
 namespace distributed {
 
+// Memory of a row besides its floats: the value, its key and its map slot.
+static const size_t kSparseRowOverhead =
+    sizeof(FixedFeatureValue) + sizeof(uint64_t) + sizeof(void *);
+// Shows sampled per shard to find the show below which rows are evicted.
+static const size_t kEvictionSamples = 1024;
+
+MemorySparseTable::~MemorySparseTable() {
+  if (_eviction_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_eviction_mutex);
+      _eviction_stop = true;
+    }
+    _eviction_cond.notify_all();
+    _eviction_thread.join();
+  }
+}
+
 int32_t MemorySparseTable::Initialize() {
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_sparse_update_all");
@@ -51,6 +100,10 @@ int32_t MemorySparseTable::Initialize() {
   for (auto &shards_task : _shards_task_pool) {
     shards_task.reset(new ::ThreadPool(1));
   }
+  if (FLAGS_pserver_sparse_memory_budget_mb > 0 && EnableEviction() &&
+      !_eviction_thread.joinable()) {
+    _eviction_thread = std::thread([this] { EvictionLoop(); });
+  }
   VLOG(0) << "initalize MemorySparseTable succ";
   return 0;
 }
@@ -76,6 +129,24 @@ int32_t MemorySparseTable::InitializeValue() {
           << " _task_pool_size:" << _task_pool_size;
 
   _local_shards.reset(new shard_type[_real_local_shard_num]);
+  _admission_threshold = std::max(FLAGS_pserver_admission_threshold, 0);
+  if (_admission_threshold > CountMinSketch::kMaxCount) {
+    LOG(WARNING) << "pserver_admission_threshold "
+                 << FLAGS_pserver_admission_threshold
+                 << " is clamped to the saturation count of the sketch "
+                 << CountMinSketch::kMaxCount;
+    _admission_threshold = CountMinSketch::kMaxCount;
+  }
+  _admission_sketches.clear();
+  if (_admission_threshold > 1) {
+    for (int i = 0; i < _real_local_shard_num; ++i) {
+      _admission_sketches.emplace_back(
+          new CountMinSketch(FLAGS_pserver_admission_sketch_width));
+    }
+  }
+  // created by the first GetHotKeys, not to count the pulls before
+  _hot_key_trackers.clear();
+  _hot_key_trackers.resize(_real_local_shard_num);
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -101,11 +172,15 @@ int32_t MemorySparseTable::InitializeValue() {
               << "]";
     _local_shards_new.reset(new shard_type[_real_local_shard_num]);  // NOLINT
   }
+  if (_config.binary_snapshot()) {
+    _snapshot_deltas.reset(new SnapshotDelta[_real_local_shard_num]);
+  }
   return 0;
 }
 
 int32_t MemorySparseTable::Load(const std::string &path,
                                 const std::string &param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(table_path);
 
@@ -129,6 +204,9 @@ int32_t MemorySparseTable::Load(const std::string &path,
   if (load_param == 5) {
     return LoadPatch(file_list, load_param);
   }
+  if (::paddle::string::ends_with(file_list[0], PSERVER_SNAPSHOT_SUFFIX)) {
+    return LoadSnapshot(file_list);
+  }
 
   size_t file_start_idx = _shard_idx * _avg_local_shard_num;
 
@@ -204,6 +282,7 @@ int32_t MemorySparseTable::Load(const std::string &path,
 
 int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
                                      int load_param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   if (!_config.enable_revert()) {
     LOG(INFO) << "MemorySparseTable should be enabled revert.";
     return 0;
@@ -314,6 +393,7 @@ void MemorySparseTable::CheckSavePrePatchDone() {
 
 int32_t MemorySparseTable::Save(const std::string &dirname,
                                 const std::string &param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   if (_real_local_shard_num == 0) {
     _local_show_threshold = -1;
     return 0;
@@ -332,6 +412,12 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     return 0;
   }
 
+  if (_config.binary_snapshot() &&
+      (save_param == 0 || save_param == 3 ||
+       save_param == kDeltaSnapshotParam)) {
+    return SaveSnapshot(dirname, save_param);
+  }
+
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
   TopkCalculator tk(_real_local_shard_num, tk_size);
@@ -375,9 +461,7 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
 #ifdef PADDLE_WITH_GPU_GRAPH
     // for incremental training, batch_model increase unseenday before save
     if (save_param == 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateStatAfterSave(i, save_param);
     }
 #endif
     do {
@@ -427,14 +511,10 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     } while (is_write_failed);
     feasign_size_all += feasign_size;
 #ifndef PADDLE_WITH_GPU_GRAPH
-    for (auto it = shard.begin(); it != shard.end(); ++it) {
-      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-    }
+    UpdateStatAfterSave(i, save_param);
 #else
     if (save_param != 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateStatAfterSave(i, save_param);
     }
 #endif
     LOG(INFO) << "MemorySparseTable save prefix success, path: "
@@ -448,6 +528,7 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
 #ifdef PADDLE_WITH_GPU_GRAPH
 int32_t MemorySparseTable::Save_v2(const std::string &dirname,
                                    const std::string &param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   auto *save_filtered_slots = _value_accessor->GetSaveFilteredSlots();
   if (save_filtered_slots == nullptr || (save_filtered_slots->size()) <= 0) {
     return Save(dirname, param);
@@ -540,9 +621,7 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
 #ifdef PADDLE_WITH_GPU_GRAPH
     // for incremental training, batch_model increase unseenday before save
     if (save_param == 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateStatAfterSave(i, save_param);
     }
 #endif
     do {
@@ -633,14 +712,10 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
     feasign_size_all += feasign_size;
     feasign_size_all_for_slot_feature += feasign_size_for_slot_feature;
 #ifndef PADDLE_WITH_GPU_GRAPH
-    for (auto it = shard.begin(); it != shard.end(); ++it) {
-      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-    }
+    UpdateStatAfterSave(i, save_param);
 #else
     if (save_param != 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateStatAfterSave(i, save_param);
     }
 #endif
     LOG(INFO) << "MemorySparseTable save prefix&feature success, path: "
@@ -655,6 +730,7 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
 #endif
 
 int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   if (!_config.enable_revert()) {
     LOG(INFO) << "MemorySparseTable should be enabled revert.";
     return 0;
@@ -743,6 +819,238 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
   return 0;
 }
 
+int32_t MemorySparseTable::SaveSnapshot(const std::string &dirname,
+                                        int save_param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
+  bool delta = save_param == kDeltaSnapshotParam;
+  std::string table_path = TableDir(dirname);
+  _afs_client.remove(::paddle::string::format_string(
+      "%s/part-%03d-*", table_path.c_str(), _shard_idx));
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  std::atomic<uint64_t> feasign_size_all{0};
+
+  SparseSnapshotHeader header;
+  if (_config.compress_in_save()) {
+    header.flags |= SparseSnapshotHeader::kCompressed;
+  }
+  if (delta) {
+    header.flags |= SparseSnapshotHeader::kDelta;
+  }
+  header.value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  header.mf_dim = _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+  header.embedx_dim = _config.accessor().embedx_dim();
+  header.accessor_class = _config.accessor().accessor_class();
+
+#ifdef PADDLE_WITH_HETERPS
+  int thread_num = _real_local_shard_num;
+#else
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+#endif
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config;
+    // the blocks are compressed by the snapshot itself, no converter
+    channel_config.path =
+        ::paddle::string::format_string("%s/part-%03d-%05d%s",
+                                        table_path.c_str(),
+                                        _shard_idx,
+                                        file_start_idx + i,
+                                        PSERVER_SNAPSHOT_SUFFIX);
+    SparseSnapshotHeader shard_header = header;
+    shard_header.shard_id = file_start_idx + i;
+    if (delta) {
+      shard_header.steps = _snapshot_deltas[i].steps;
+    }
+    bool is_write_failed = false;
+    uint64_t feasign_size = 0;
+    int retry_num = 0;
+    int err_no = 0;
+    auto &shard = _local_shards[i];
+#ifdef PADDLE_WITH_GPU_GRAPH
+    if (save_param == 3) {
+      UpdateStatAfterSave(i, save_param);
+    }
+#endif
+    do {
+      err_no = 0;
+      is_write_failed = false;
+      auto write_channel =
+          _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      SparseSnapshotWriter writer(write_channel.get(), shard_header);
+      int ret = 0;
+      if (delta) {
+        auto &shard_delta = _snapshot_deltas[i];
+        for (auto key : shard_delta.updated) {
+          auto itr = shard.find(key);
+          if (itr != shard.end() && ret == 0) {
+            ret = writer.Append(key, itr.value().data(), itr.value().size());
+          }
+        }
+        for (auto key : shard_delta.erased) {
+          if (ret == 0) {
+            ret = writer.Append(key, nullptr, 0);
+          }
+        }
+      } else {
+        for (auto it = shard.begin(); it != shard.end() && ret == 0; ++it) {
+          if (_value_accessor->Save(it.value().data(), save_param)) {
+            ret = writer.Append(
+                it.key(), it.value().data(), it.value().size());
+          }
+        }
+      }
+      if (ret == 0) {
+        ret = writer.Finish();
+      }
+      feasign_size = writer.record_num();
+      write_channel->close();
+      if (ret != 0 || err_no == -1) {
+        ++retry_num;
+        is_write_failed = true;
+        LOG(ERROR) << "MemorySparseTable save snapshot failed, retry it! "
+                   << "path:" << channel_config.path
+                   << " , retry_num=" << retry_num;
+        _afs_client.remove(channel_config.path);
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable save snapshot failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_write_failed);
+    feasign_size_all += feasign_size;
+    if (_snapshot_deltas) {
+      _snapshot_deltas[i].Clear();
+    }
+#ifndef PADDLE_WITH_GPU_GRAPH
+    if (!delta) {
+#else
+    if (!delta && save_param != 3) {
+#endif
+      UpdateStatAfterSave(i, save_param);
+    }
+    LOG(INFO) << "MemorySparseTable save snapshot success, path: "
+              << channel_config.path << " feasign_size: " << feasign_size;
+  }
+  LOG(INFO) << "MemorySparseTable save " << (delta ? "delta " : "")
+            << "snapshot feasign_size: " << feasign_size_all;
+  return 0;
+}
+
+int32_t MemorySparseTable::LoadSnapshot(
+    const std::vector<std::string> &file_list) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
+  size_t file_start_idx = _shard_idx * _avg_local_shard_num;
+  if (file_start_idx >= file_list.size()) {
+    return 0;
+  }
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  uint32_t mf_dim = _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+
+#ifdef PADDLE_WITH_HETERPS
+  int thread_num = _real_local_shard_num;
+#else
+  int thread_num = _real_local_shard_num < 15 ? _real_local_shard_num : 15;
+#endif
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config;
+    channel_config.path = file_list[file_start_idx + i];
+    VLOG(1) << "MemorySparseTable::load snapshot " << channel_config.path
+            << " into local shard " << i;
+    bool is_read_failed = false;
+    // The steps change the rows in place, unlike the records they are not to
+    // be applied again on retry.
+    bool steps_replayed = false;
+    int retry_num = 0;
+    int err_no = 0;
+    do {
+      is_read_failed = false;
+      err_no = 0;
+      auto read_channel =
+          _afs_client.open_r(channel_config, 1024 * 1024 * 40, &err_no);
+      auto &shard = _local_shards[i];
+      try {
+        SparseSnapshotReader reader(read_channel.get());
+        const auto &header = reader.ReadHeader();
+        PADDLE_ENFORCE_EQ(
+            header.value_dim == value_dim && header.mf_dim == mf_dim,
+            true,
+            platform::errors::InvalidArgument(
+                "Snapshot %s of values of dim %d (mf %d) by %s does not "
+                "match the table accessor of dim %d (mf %d).",
+                channel_config.path,
+                header.value_dim,
+                header.mf_dim,
+                header.accessor_class,
+                value_dim,
+                mf_dim));
+        if (header.delta() && !steps_replayed) {
+          ReplaySteps(i, header.steps);
+          steps_replayed = true;
+        }
+        reader.ForEach([&shard](uint64_t key, const char *data, uint32_t dim) {
+          if (dim == 0) {
+            shard.erase(key);
+            return;
+          }
+          auto &value = shard[key];
+          value.resize(dim);
+          memcpy(value.data(), data, dim * sizeof(float));
+        });
+        read_channel->close();
+        if (err_no == -1) {
+          ++retry_num;
+          is_read_failed = true;
+          LOG(ERROR) << "MemorySparseTable load snapshot failed after read, "
+                     << "retry it! path:" << channel_config.path
+                     << " , retry_num=" << retry_num;
+        }
+      } catch (const std::exception &e) {
+        ++retry_num;
+        is_read_failed = true;
+        LOG(ERROR) << "MemorySparseTable load snapshot failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num
+                   << " , error: " << e.what();
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable load snapshot failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_read_failed);
+    // the loaded values are the base of the next delta
+    if (_snapshot_deltas) {
+      _snapshot_deltas[i].Clear();
+    }
+  }
+  LOG(INFO) << "MemorySparseTable load snapshot success, path from "
+            << file_list[file_start_idx] << " to "
+            << file_list[file_start_idx + _real_local_shard_num - 1];
+  return 0;
+}
+
+void MemorySparseTable::ReplaySteps(
+    int shard_id, const std::vector<SparseSnapshotStep> &steps) {
+  auto &shard = _local_shards[shard_id];
+  for (const auto &step : steps) {
+    for (auto it = shard.begin(); it != shard.end();) {
+      if (step.type == SparseSnapshotStep::kShrink) {
+        if (_value_accessor->Shrink(it.value().data())) {
+          it = shard.erase(it);
+          continue;
+        }
+      } else if (step.type == SparseSnapshotStep::kUpdateStatAfterSave) {
+        _value_accessor->UpdateStatAfterSave(it.value().data(), step.param);
+      } else {
+        PADDLE_THROW(platform::errors::InvalidArgument(
+            "Unknown sparse snapshot step %d.", step.type));
+      }
+      ++it;
+    }
+  }
+}
+
 int64_t MemorySparseTable::CacheShuffle(
     const std::string &path,
     const std::string &param,
@@ -752,6 +1060,7 @@ int64_t MemorySparseTable::CacheShuffle(
     ::paddle::framework::Channel<std::pair<uint64_t, std::string>>
         &shuffled_channel,
     const std::vector<Table *> &table_ptrs) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   LOG(INFO) << "cache shuffle with cache threshold: " << cache_threshold;
   int save_param = atoi(param.c_str());  // batch_model:0  xbox:1
   if (!_config.enable_sparse_table_cache() || cache_threshold < 0) {
@@ -943,9 +1252,196 @@ int64_t MemorySparseTable::LocalMFSize() {
 std::pair<int64_t, int64_t> MemorySparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
   int64_t mf_size = LocalMFSize();
+  if (!_admission_sketches.empty() || _eviction_thread.joinable()) {
+    VLOG(0) << "MemorySparseTable admission stat: "
+            << _admission_stats.ToString();
+  }
   return {feasign_size, mf_size};
 }
 
+int32_t MemorySparseTable::GetHotKeys(
+    size_t k, std::vector<std::pair<uint64_t, float>>* hot_keys) {
+  hot_keys->clear();
+  if (k == 0) {
+    return 0;
+  }
+  // The workers ask in turn, the first one past the interval recomputes.
+  std::lock_guard<std::mutex> lock(_hot_keys_mutex);
+  auto now = std::chrono::steady_clock::now();
+  if (_hot_keys_k == k &&
+      now - _hot_keys_time < std::chrono::milliseconds(
+                                 FLAGS_pserver_hot_key_refresh_interval_ms)) {
+    *hot_keys = _hot_keys;
+    return 0;
+  }
+  typedef std::pair<uint32_t, uint64_t> CountKey;
+  // The k keys of the highest count of each shard, from its tracker, only
+  // touched by the task pool thread of the shard.
+  std::vector<std::vector<std::pair<uint64_t, uint32_t>>> shard_hot_keys(
+      _real_local_shard_num);
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id, k, &shard_hot_keys]() -> int {
+              auto& tracker = _hot_key_trackers[shard_id];
+              if (tracker == nullptr || tracker->capacity() < k) {
+                tracker.reset(new HotKeyTracker(
+                    k, FLAGS_pserver_hot_key_sketch_width));
+              }
+              tracker->Get(&shard_hot_keys[shard_id]);
+              return 0;
+            });
+  }
+  std::vector<std::pair<CountKey, int>> candidates;
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id].wait();
+    for (auto& key_count : shard_hot_keys[shard_id]) {
+      candidates.emplace_back(CountKey(key_count.second, key_count.first),
+                              shard_id);
+    }
+  }
+  size_t n = std::min(k, candidates.size());
+  std::partial_sort(candidates.begin(),
+                    candidates.begin() + n,
+                    candidates.end(),
+                    std::greater<std::pair<CountKey, int>>());
+  std::vector<size_t> shard_hot_num(_real_local_shard_num, 0);
+  hot_keys->reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    const auto& count_key = candidates[i].first;
+    hot_keys->emplace_back(count_key.second,
+                           static_cast<float>(count_key.first));
+    ++shard_hot_num[candidates[i].second];
+  }
+  // The shards holding many of the hot keys are the hot spots of the pulls.
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    if (shard_hot_num[shard_id] > 0) {
+      VLOG(3) << "MemorySparseTable shard " << shard_id << " has "
+              << shard_hot_num[shard_id] << " of the " << n << " hot keys";
+    }
+  }
+  VLOG(3) << "MemorySparseTable " << n << " hot keys, hottest pulled "
+          << (n > 0 ? hot_keys->front().second : 0) << " times, "
+          << (n > 0 ? hot_keys->back().second : 0) << " for the last";
+  _hot_keys = *hot_keys;
+  _hot_keys_k = k;
+  _hot_keys_time = now;
+  return 0;
+}
+
+void MemorySparseTable::EvictionLoop() {
+  const int64_t budget_bytes = FLAGS_pserver_sparse_memory_budget_mb << 20;
+  std::unique_lock<std::mutex> lock(_eviction_mutex);
+  while (!_eviction_cond.wait_for(
+      lock,
+      std::chrono::milliseconds(FLAGS_pserver_eviction_interval_ms),
+      [this] { return _eviction_stop; })) {
+    lock.unlock();
+    EvictColdRows(budget_bytes);
+    lock.lock();
+  }
+}
+
+int64_t MemorySparseTable::EvictColdRows(int64_t budget_bytes) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
+  // The rows pulled by pointers are held by the caller.
+  if (_pulled_by_ptr.load()) {
+    return 0;
+  }
+  const size_t value_col =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  // No need to scan the shards while even extended rows would fit.
+  if (LocalSize() * (value_col * sizeof(float) + kSparseRowOverhead) <=
+      static_cast<size_t>(budget_bytes)) {
+    return 0;
+  }
+  _admission_stats.eviction_rounds.fetch_add(1, std::memory_order_relaxed);
+
+  // The bytes of the rows of each shard, and a sample of their shows.
+  std::vector<int64_t> shard_bytes(_real_local_shard_num, 0);
+  std::vector<std::vector<float>> shows(_real_local_shard_num);
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id, &shard_bytes, &shows]() -> int {
+              auto &shard = _local_shards[shard_id];
+              size_t stride = std::max<size_t>(
+                  shard.size() / kEvictionSamples, 1);
+              size_t i = 0;
+              for (auto it = shard.begin(); it != shard.end(); ++it, ++i) {
+                shard_bytes[shard_id] +=
+                    it.value().size() * sizeof(float) + kSparseRowOverhead;
+                if (i % stride == 0) {
+                  shows[shard_id].push_back(
+                      _value_accessor->GetField(it.value().data(), "show"));
+                }
+              }
+              return 0;
+            });
+  }
+  int64_t total_bytes = 0;
+  std::vector<float> samples;
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id].wait();
+    total_bytes += shard_bytes[shard_id];
+    samples.insert(
+        samples.end(), shows[shard_id].begin(), shows[shard_id].end());
+  }
+  if (total_bytes <= budget_bytes || samples.empty()) {
+    return 0;
+  }
+
+  // Down to 90% of the budget, not to evict again at the next round.
+  double fraction = 1.0 - 0.9 * budget_bytes / total_bytes;
+  size_t nth = std::min(static_cast<size_t>(fraction * samples.size()),
+                        samples.size() - 1);
+  std::nth_element(samples.begin(), samples.begin() + nth, samples.end());
+  float threshold = samples[nth];
+
+  std::atomic<int64_t> evicted{0};
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id, fraction, threshold, &shard_bytes, &evicted]()
+                -> int {
+              auto &shard = _local_shards[shard_id];
+              int64_t to_free = fraction * shard_bytes[shard_id];
+              int64_t freed = 0, count = 0;
+              // Checked again after the pulls by pointers of the shard
+              // which were queued before the eviction.
+              if (_pulled_by_ptr.load()) {
+                return 0;
+              }
+              for (auto it = shard.begin();
+                   it != shard.end() && freed < to_free;) {
+                if (_value_accessor->GetField(it.value().data(), "show") <=
+                    threshold) {
+                  freed +=
+                      it.value().size() * sizeof(float) + kSparseRowOverhead;
+                  ++count;
+                  MarkErased(shard_id, it.key());
+                  it = shard.erase(it);
+                } else {
+                  ++it;
+                }
+              }
+              evicted.fetch_add(count);
+              return 0;
+            });
+  }
+  for (auto &task : tasks) {
+    task.wait();
+  }
+  _admission_stats.evicted.fetch_add(evicted.load(),
+                                     std::memory_order_relaxed);
+  VLOG(0) << "MemorySparseTable evicted " << evicted.load()
+          << " rows of show <= " << threshold << ", rows took " << total_bytes
+          << " bytes for a budget of " << budget_bytes;
+  return evicted.load();
+}
+
 int32_t MemorySparseTable::Pull(TableContext &context) {
   CHECK(context.value_type == Sparse);
   if (context.use_ptr) {
@@ -1004,17 +1500,27 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
              mf_value_size,
              select_value_size]() -> int {
               auto &local_shard = _local_shards[shard_id];
+              auto *hot_key_tracker = GetHotKeyTracker(shard_id);
               float data_buffer[value_size];  // NOLINT
               float *data_buffer_ptr = data_buffer;
 
               auto &keys = task_keys[shard_id];
-              for (auto &item : keys) {
+              const size_t distance = shard_type::kPrefetchDistance;
+              for (size_t k = 0; k < keys.size(); ++k) {
+                if (k + distance < keys.size()) {
+                  local_shard.prefetch(keys[k + distance].first);
+                }
+                auto &item = keys[k];
                 uint64_t key = item.first;
+                if (hot_key_tracker != nullptr) {
+                  hot_key_tracker->Add(key);
+                }
                 auto itr = local_shard.find(key);
                 size_t data_size = value_size - mf_value_size;
                 if (itr == local_shard.end()) {
                   // ++missed_keys;
-                  if (FLAGS_pserver_create_value_when_push) {
+                  if (FLAGS_pserver_create_value_when_push ||
+                      !Admit(shard_id, key)) {
                     memset(data_buffer, 0, sizeof(float) * data_size);
                   } else {
                     auto &feature_value = local_shard[key];
@@ -1023,6 +1529,7 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
                     _value_accessor->Create(&data_buffer_ptr, 1);
                     memcpy(
                         data_ptr, data_buffer_ptr, data_size * sizeof(float));
+                    MarkUpdated(shard_id, key);
                   }
                 } else {
                   data_size = itr.value().size();
@@ -1055,6 +1562,10 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                                          size_t num,
                                          uint16_t pass_id) {
   CostTimer timer("pscore_sparse_select_all");
+  if (!_pulled_by_ptr.exchange(true) && _eviction_thread.joinable()) {
+    LOG(WARNING) << "MemorySparseTable rows are pulled by pointers, which "
+                    "disables the eviction";
+  }
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
       _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
@@ -1096,6 +1607,8 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                 } else {
                   ret = itr.value_ptr();
                 }
+                // updated in place by the caller
+                MarkUpdated(shard_id, key);
                 int pull_data_idx = item.second;
                 pull_values[pull_data_idx] = reinterpret_cast<char *>(ret);
               }
@@ -1141,7 +1654,27 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
           auto &local_shard_new = _local_shards_new[shard_id];
           float data_buffer[value_col];  // NOLINT
           float *data_buffer_ptr = data_buffer;
-          for (auto &item : keys) {
+          // The values already extended are updated in place by batches,
+          // flushed before a value is inserted into the shard.
+          const size_t batch_size =
+              std::max(FLAGS_pserver_sparse_update_batch, 1);
+          std::vector<float *> batch_values;
+          std::vector<const float *> batch_updates;
+          auto flush_batch = [&]() {
+            if (!batch_values.empty()) {
+              _value_accessor->Update(batch_values.data(),
+                                      batch_updates.data(),
+                                      batch_values.size());
+              batch_values.clear();
+              batch_updates.clear();
+            }
+          };
+          const size_t distance = shard_type::kPrefetchDistance;
+          for (size_t k = 0; k < keys.size(); ++k) {
+            if (k + distance < keys.size()) {
+              local_shard.prefetch(keys[k + distance].first);
+            }
+            auto &item = keys[k];
             uint64_t key = item.first;
             uint64_t push_data_idx = item.second;
             const float *update_data =
@@ -1152,6 +1685,10 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                   !_value_accessor->CreateValue(1, update_data)) {
                 continue;
               }
+              if (!Admit(shard_id, key)) {
+                continue;
+              }
+              flush_batch();
               auto value_size = value_col - mf_value_col;
               auto &feature_value = local_shard[key];
               feature_value.resize(value_size);
@@ -1167,7 +1704,12 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
             size_t value_size = feature_value.size();
 
             if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
+              batch_values.push_back(value_data);
+              batch_updates.push_back(update_data);
+              if (batch_values.size() >= batch_size ||
+                  _config.enable_revert()) {
+                flush_batch();
+              }
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
               memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
@@ -1180,6 +1722,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               }
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
+            MarkUpdated(shard_id, key);
             if (_config.enable_revert()) {
               FixedFeatureValue *feature_value_new = &(local_shard_new[key]);
               auto new_size = feature_value.size();
@@ -1189,6 +1732,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                      new_size * sizeof(float));
             }
           }
+          flush_batch();
           return 0;
         });
   }
@@ -1221,7 +1765,27 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
           auto &local_shard = _local_shards[shard_id];
           float data_buffer[value_col];  // NOLINT
           float *data_buffer_ptr = data_buffer;
-          for (auto &item : keys) {
+          // The values already extended are updated in place by batches,
+          // flushed before a value is inserted into the shard.
+          const size_t batch_size =
+              std::max(FLAGS_pserver_sparse_update_batch, 1);
+          std::vector<float *> batch_values;
+          std::vector<const float *> batch_updates;
+          auto flush_batch = [&]() {
+            if (!batch_values.empty()) {
+              _value_accessor->Update(batch_values.data(),
+                                      batch_updates.data(),
+                                      batch_values.size());
+              batch_values.clear();
+              batch_updates.clear();
+            }
+          };
+          const size_t distance = shard_type::kPrefetchDistance;
+          for (size_t k = 0; k < keys.size(); ++k) {
+            if (k + distance < keys.size()) {
+              local_shard.prefetch(keys[k + distance].first);
+            }
+            auto &item = keys[k];
             uint64_t key = item.first;
             uint64_t push_data_idx = item.second;
             const float *update_data = values[push_data_idx];
@@ -1231,6 +1795,10 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                   !_value_accessor->CreateValue(1, update_data)) {
                 continue;
               }
+              if (!Admit(shard_id, key)) {
+                continue;
+              }
+              flush_batch();
               auto value_size = value_col - mf_value_col;
               auto &feature_value = local_shard[key];
               feature_value.resize(value_size);
@@ -1244,7 +1812,11 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
             float *value_data = feature_value.data();
             size_t value_size = feature_value.size();
             if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
+              batch_values.push_back(value_data);
+              batch_updates.push_back(update_data);
+              if (batch_values.size() >= batch_size) {
+                flush_batch();
+              }
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
               memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
@@ -1256,7 +1828,9 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               }
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
+            MarkUpdated(shard_id, key);
           }
+          flush_batch();
           return 0;
         });
   }
@@ -1270,6 +1844,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
 int32_t MemorySparseTable::Flush() { return 0; }
 
 int32_t MemorySparseTable::Shrink(const std::string &param) {
+  std::lock_guard<std::recursive_mutex> pause(_shards_pause_mutex);
   VLOG(0) << "MemorySparseTable::Shrink";
   std::atomic<uint32_t> shrink_size_all{0};
   int thread_num = _real_local_shard_num;
@@ -1281,12 +1856,14 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
     auto &shard = _local_shards[shard_id];
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->Shrink(it.value().data())) {
+        MarkShrunk(shard_id, it.key());
         it = shard.erase(it);
         ++feasign_size;
       } else {
         ++it;
       }
     }
+    RecordStep(shard_id, SparseSnapshotStep::kShrink, 0);
     shrink_size_all += feasign_size;
   }
   VLOG(0) << "MemorySparseTable::Shrink success, shrink size:"
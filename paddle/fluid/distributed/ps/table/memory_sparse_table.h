@@ -18,17 +18,25 @@
 #include <assert.h>
 #include <pthread.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "Eigen/Dense"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
+#include "paddle/fluid/distributed/ps/table/depends/admission_filter.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+#include "paddle/fluid/distributed/ps/table/sparse_snapshot.h"
 #include "paddle/utils/string/string_helper.h"
 
 #define PSERVER_SAVE_SUFFIX ".shard"
@@ -40,7 +48,7 @@ class MemorySparseTable : public Table {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
   MemorySparseTable() {}
-  virtual ~MemorySparseTable() {}
+  virtual ~MemorySparseTable();
 
   // unused method end
   static int32_t sparse_local_shard_num(uint32_t shard_num,
@@ -91,6 +99,11 @@ class MemorySparseTable : public Table {
   int64_t LocalMFSize();
 
   std::pair<int64_t, int64_t> PrintTableStat() override;
+  // The keys pulled the most of late, from the hot key trackers of the
+  // shards, recomputed at most every pserver_hot_key_refresh_interval_ms.
+  // Logs how the hot keys spread over the local shards.
+  int32_t GetHotKeys(
+      size_t k, std::vector<std::pair<uint64_t, float>>* hot_keys) override;
   int32_t PullSparse(float* values, const PullSparseValue& pull_value);
 
   int32_t PullSparsePtr(int shard_id,
@@ -114,11 +127,99 @@ class MemorySparseTable : public Table {
   virtual void Revert();
   virtual void CheckSavePrePatchDone();
 
+  // Evicts the rows of the lowest show until the rows of the table take
+  // less than 90% of budget_bytes, if they take more. Runs every
+  // pserver_eviction_interval_ms on a background thread once
+  // pserver_sparse_memory_budget_mb is set. Returns the evicted rows.
+  int64_t EvictColdRows(int64_t budget_bytes);
+  const SparseAdmissionStats& GetAdmissionStats() const {
+    return _admission_stats;
+  }
+
  protected:
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
 
+  // Binary snapshots, see sparse_snapshot.h. save_param 0 and 3 write a full
+  // snapshot, kDeltaSnapshotParam the keys updated since the last one.
+  static constexpr int kDeltaSnapshotParam = 6;
+  int32_t SaveSnapshot(const std::string& path, int save_param);
+  int32_t LoadSnapshot(const std::vector<std::string>& file_list);
+  // Applies the steps of a delta snapshot to the rows of the local shard.
+  void ReplaySteps(int shard_id, const std::vector<SparseSnapshotStep>& steps);
+
+  // Whether a new key gets a row, only once pushed or pulled
+  // pserver_admission_threshold times.
+  bool Admit(int shard_id, uint64_t key) {
+    if (_admission_sketches.empty()) {
+      return true;
+    }
+    if (_admission_sketches[shard_id]->Add(key) >= _admission_threshold) {
+      _admission_stats.admitted.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    _admission_stats.rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  // The rows of SSDSparseTable go to SSD under its own memory budget, and
+  // HeterPS holds the rows it pulls by their pointers.
+  virtual bool EnableEviction() {
+#ifdef PADDLE_WITH_HETERPS
+    return false;
+#else
+    return true;
+#endif
+  }
+  void EvictionLoop();
+  // The tracker of the keys pulled from the shard, null until hot keys are
+  // asked for.
+  HotKeyTracker* GetHotKeyTracker(int shard_id) {
+    return _hot_key_trackers.empty() ? nullptr
+                                     : _hot_key_trackers[shard_id].get();
+  }
+
+  void MarkUpdated(int shard_id, uint64_t key) {
+    if (_snapshot_deltas) {
+      auto& delta = _snapshot_deltas[shard_id];
+      delta.updated.insert(key);
+      if (!delta.erased.empty()) delta.erased.erase(key);
+    }
+  }
+  // Applies UpdateStatAfterSave of the accessor to every row of the shard,
+  // as a step the next delta snapshot replays rather than a change of every
+  // row.
+  void UpdateStatAfterSave(int shard_id, int save_param) {
+    auto& shard = _local_shards[shard_id];
+    for (auto it = shard.begin(); it != shard.end(); ++it) {
+      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+    }
+    RecordStep(shard_id, SparseSnapshotStep::kUpdateStatAfterSave, save_param);
+  }
+  void RecordStep(int shard_id, uint32_t type, int32_t param) {
+    if (_snapshot_deltas) {
+      SparseSnapshotStep step;
+      step.type = type;
+      step.param = param;
+      _snapshot_deltas[shard_id].steps.push_back(step);
+    }
+  }
+  // The shrink of a row is replayed from its step, unless the row was
+  // updated since the last snapshot, i.e. does not shrink the same way
+  // from the row of the snapshot.
+  void MarkShrunk(int shard_id, uint64_t key) {
+    if (_snapshot_deltas && _snapshot_deltas[shard_id].updated.erase(key)) {
+      _snapshot_deltas[shard_id].erased.insert(key);
+    }
+  }
+  void MarkErased(int shard_id, uint64_t key) {
+    if (_snapshot_deltas) {
+      auto& delta = _snapshot_deltas[shard_id];
+      delta.updated.erase(key);
+      delta.erased.insert(key);
+    }
+  }
+
   int _task_pool_size = 24;
   int _avg_local_shard_num;
   int _real_local_shard_num;
@@ -136,6 +237,45 @@ class MemorySparseTable : public Table {
   std::unique_ptr<shard_type[]> _local_shards_new;
   std::unique_ptr<shard_type[]> _local_shards_patch_model;
   std::thread _save_patch_model_thread;
+
+  // for delta snapshot, the keys of each local shard updated or erased since
+  // the last snapshot, only touched by the task pool thread of the shard, and
+  // the steps applied to all of its rows.
+  struct SnapshotDelta {
+    std::unordered_set<uint64_t> updated;
+    std::unordered_set<uint64_t> erased;
+    std::vector<SparseSnapshotStep> steps;
+
+    void Clear() {
+      updated.clear();
+      erased.clear();
+      steps.clear();
+    }
+  };
+  std::unique_ptr<SnapshotDelta[]> _snapshot_deltas;
+
+  // the occurrences of the keys not in each local shard yet, only touched by
+  // the task pool thread of the shard, empty without admission.
+  std::vector<std::unique_ptr<CountMinSketch>> _admission_sketches;
+  uint32_t _admission_threshold = 0;
+  SparseAdmissionStats _admission_stats;
+  std::thread _eviction_thread;
+  std::mutex _eviction_mutex;
+  std::condition_variable _eviction_cond;
+  bool _eviction_stop = false;
+  // Held by the eviction, and by the paths iterating the local shards out of
+  // their task pools, which are not to see rows erased under them.
+  std::recursive_mutex _shards_pause_mutex;
+  // Set once rows are pulled by pointers, which stops the eviction for good.
+  std::atomic<bool> _pulled_by_ptr{false};
+
+  // the hot key tracker of each local shard, only touched by the task pool
+  // thread of the shard, and the hot keys last computed from them.
+  std::vector<std::unique_ptr<HotKeyTracker>> _hot_key_trackers;
+  std::mutex _hot_keys_mutex;
+  std::vector<std::pair<uint64_t, float>> _hot_keys;
+  size_t _hot_keys_k = 0;
+  std::chrono::steady_clock::time_point _hot_keys_time;
 };
 
 }  // namespace distributed
@@ -215,6 +215,11 @@ int32_t SparseAccessor::Merge(float** update_values,
 int32_t SparseAccessor::Update(float** update_values,
                                const float** push_values,
                                size_t num) {
+  size_t batch = num > 1 ? num : 0;
+  std::vector<float*> w(batch), sgd(batch);
+  std::vector<float*> embedx_w(batch), embedx_sgd(batch);
+  std::vector<const float*> grad(batch), embedx_grad(batch);
+  std::vector<float> scale(batch);
   for (size_t value_item = 0; value_item < num; ++value_item) {
     float* update_value = update_values[value_item];
     const float* push_value = push_values[value_item];
@@ -228,16 +233,37 @@ int32_t SparseAccessor::Update(float** update_values,
         (push_show - push_click) * _config.ctr_accessor_param().nonclk_coeff() +
         push_click * _config.ctr_accessor_param().click_coeff();
     update_value[sparse_feature_value.UnseenDaysIndex()] = 0;
-    _embed_sgd_rule->UpdateValue(
-        update_value + sparse_feature_value.EmbedWIndex(),
-        update_value + sparse_feature_value.EmbedG2SumIndex(),
-        push_value + SparsePushValue::EmbedGIndex(),
-        push_show);
-    _embedx_sgd_rule->UpdateValue(
-        update_value + sparse_feature_value.EmbedxWIndex(),
-        update_value + sparse_feature_value.EmbedxG2SumIndex(),
-        push_value + SparsePushValue::EmbedxGIndex(),
-        push_show);
+    if (num == 1) {
+      _embed_sgd_rule->UpdateValue(
+          update_value + sparse_feature_value.EmbedWIndex(),
+          update_value + sparse_feature_value.EmbedG2SumIndex(),
+          push_value + SparsePushValue::EmbedGIndex(),
+          push_show);
+      _embedx_sgd_rule->UpdateValue(
+          update_value + sparse_feature_value.EmbedxWIndex(),
+          update_value + sparse_feature_value.EmbedxG2SumIndex(),
+          push_value + SparsePushValue::EmbedxGIndex(),
+          push_show);
+      continue;
+    }
+    w[value_item] = update_value + sparse_feature_value.EmbedWIndex();
+    sgd[value_item] = update_value + sparse_feature_value.EmbedG2SumIndex();
+    grad[value_item] = push_value + SparsePushValue::EmbedGIndex();
+    scale[value_item] = push_show;
+    embedx_w[value_item] = update_value + sparse_feature_value.EmbedxWIndex();
+    embedx_sgd[value_item] =
+        update_value + sparse_feature_value.EmbedxG2SumIndex();
+    embedx_grad[value_item] = push_value + SparsePushValue::EmbedxGIndex();
+  }
+  if (num > 1) {
+    // The sgd rules update all the values at once, embed then embedx.
+    _embed_sgd_rule->UpdateValueBatch(
+        w.data(), sgd.data(), grad.data(), scale.data(), num);
+    _embedx_sgd_rule->UpdateValueBatch(embedx_w.data(),
+                                       embedx_sgd.data(),
+                                       embedx_grad.data(),
+                                       scale.data(),
+                                       num);
   }
   return 0;
 }
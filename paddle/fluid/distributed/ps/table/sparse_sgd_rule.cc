@@ -14,6 +14,10 @@
 
 #include "paddle/fluid/distributed/ps/table/sparse_sgd_rule.h"
 
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
 #include "glog/logging.h"
 
 #include "paddle/common/flags.h"
@@ -23,6 +27,115 @@ PD_DEFINE_bool(enable_show_scale_gradient, true, "enable show scale gradient");
 namespace paddle {
 namespace distributed {
 
+namespace {
+
+// The vectors of the batched kernels, of the widest instruction set paddle is
+// built with. The float kernels work on VecF, the ones accumulating in double
+// as their scalar version does load HalfF floats into VecD doubles. The
+// kernels keep the order of the scalar operations and clip w with max then
+// min, which also sends NaN to the min bound like BoundValue.
+#if defined(__AVX512F__)
+#define PS_SGD_RULE_SIMD
+typedef __m512 VecF;
+typedef __m256 HalfF;
+typedef __m512d VecD;
+constexpr size_t kFloatLanes = 16;
+constexpr size_t kDoubleLanes = 8;
+inline VecF LoadF(const float *p) { return _mm512_loadu_ps(p); }
+inline void StoreF(float *p, VecF v) { _mm512_storeu_ps(p, v); }
+inline VecF SetF(float x) { return _mm512_set1_ps(x); }
+inline VecF AddF(VecF a, VecF b) { return _mm512_add_ps(a, b); }
+inline VecF SubF(VecF a, VecF b) { return _mm512_sub_ps(a, b); }
+inline VecF MulF(VecF a, VecF b) { return _mm512_mul_ps(a, b); }
+inline VecF DivF(VecF a, VecF b) { return _mm512_div_ps(a, b); }
+inline VecF SqrtF(VecF a) { return _mm512_sqrt_ps(a); }
+inline VecF BoundF(VecF w, VecF lo, VecF hi) {
+  return _mm512_min_ps(_mm512_max_ps(w, lo), hi);
+}
+inline HalfF LoadH(const float *p) { return _mm256_loadu_ps(p); }
+inline void StoreH(float *p, HalfF v) { _mm256_storeu_ps(p, v); }
+inline HalfF SetH(float x) { return _mm256_set1_ps(x); }
+inline HalfF AddH(HalfF a, HalfF b) { return _mm256_add_ps(a, b); }
+inline HalfF DivH(HalfF a, HalfF b) { return _mm256_div_ps(a, b); }
+inline HalfF SqrtH(HalfF a) { return _mm256_sqrt_ps(a); }
+inline VecD ToD(HalfF a) { return _mm512_cvtps_pd(a); }
+inline HalfF ToH(VecD a) { return _mm512_cvtpd_ps(a); }
+inline VecD SetD(double x) { return _mm512_set1_pd(x); }
+inline VecD ZeroD() { return _mm512_setzero_pd(); }
+inline VecD AddD(VecD a, VecD b) { return _mm512_add_pd(a, b); }
+inline VecD SubD(VecD a, VecD b) { return _mm512_sub_pd(a, b); }
+inline VecD MulD(VecD a, VecD b) { return _mm512_mul_pd(a, b); }
+inline VecD BoundD(VecD w, VecD lo, VecD hi) {
+  return _mm512_min_pd(_mm512_max_pd(w, lo), hi);
+}
+inline double SumD(VecD a) { return _mm512_reduce_add_pd(a); }
+#elif defined(__AVX__)
+#define PS_SGD_RULE_SIMD
+typedef __m256 VecF;
+typedef __m128 HalfF;
+typedef __m256d VecD;
+constexpr size_t kFloatLanes = 8;
+constexpr size_t kDoubleLanes = 4;
+inline VecF LoadF(const float *p) { return _mm256_loadu_ps(p); }
+inline void StoreF(float *p, VecF v) { _mm256_storeu_ps(p, v); }
+inline VecF SetF(float x) { return _mm256_set1_ps(x); }
+inline VecF AddF(VecF a, VecF b) { return _mm256_add_ps(a, b); }
+inline VecF SubF(VecF a, VecF b) { return _mm256_sub_ps(a, b); }
+inline VecF MulF(VecF a, VecF b) { return _mm256_mul_ps(a, b); }
+inline VecF DivF(VecF a, VecF b) { return _mm256_div_ps(a, b); }
+inline VecF SqrtF(VecF a) { return _mm256_sqrt_ps(a); }
+inline VecF BoundF(VecF w, VecF lo, VecF hi) {
+  return _mm256_min_ps(_mm256_max_ps(w, lo), hi);
+}
+inline HalfF LoadH(const float *p) { return _mm_loadu_ps(p); }
+inline void StoreH(float *p, HalfF v) { _mm_storeu_ps(p, v); }
+inline HalfF SetH(float x) { return _mm_set1_ps(x); }
+inline HalfF AddH(HalfF a, HalfF b) { return _mm_add_ps(a, b); }
+inline HalfF DivH(HalfF a, HalfF b) { return _mm_div_ps(a, b); }
+inline HalfF SqrtH(HalfF a) { return _mm_sqrt_ps(a); }
+inline VecD ToD(HalfF a) { return _mm256_cvtps_pd(a); }
+inline HalfF ToH(VecD a) { return _mm256_cvtpd_ps(a); }
+inline VecD SetD(double x) { return _mm256_set1_pd(x); }
+inline VecD ZeroD() { return _mm256_setzero_pd(); }
+inline VecD AddD(VecD a, VecD b) { return _mm256_add_pd(a, b); }
+inline VecD SubD(VecD a, VecD b) { return _mm256_sub_pd(a, b); }
+inline VecD MulD(VecD a, VecD b) { return _mm256_mul_pd(a, b); }
+inline VecD BoundD(VecD w, VecD lo, VecD hi) {
+  return _mm256_min_pd(_mm256_max_pd(w, lo), hi);
+}
+inline double SumD(VecD a) {
+  double sum[kDoubleLanes];
+  _mm256_storeu_pd(sum, a);
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+#endif
+
+// Prefetch the rows of the value updated after the current one.
+inline void PrefetchRows(float **w,
+                         float **sgd,
+                         const float **grad,
+                         size_t next,
+                         size_t num) {
+  if (next < num) {
+    __builtin_prefetch(w[next], 1);
+    __builtin_prefetch(sgd[next], 1);
+    __builtin_prefetch(grad[next], 0);
+  }
+}
+
+}  // namespace
+
+void SparseValueSGDRule::UpdateValueBatch(float **w,
+                                          float **sgd,
+                                          const float **grad,
+                                          const float *scale,
+                                          size_t num) {
+  for (size_t k = 0; k < num; ++k) {
+    PrefetchRows(w, sgd, grad, k + 1, num);
+    UpdateValueWork(w[k], sgd[k], grad[k], scale[k]);
+  }
+}
+
 void SparseNaiveSGDRule::LoadConfig(const SparseCommonSGDRuleParameter &param,
                                     size_t emb_dim) {
   _embedding_dim = emb_dim;
@@ -51,6 +164,34 @@ void SparseNaiveSGDRule::UpdateValueWork(float *w,
   }
 }
 
+void SparseNaiveSGDRule::UpdateValueBatch(float **w,
+                                          float **sgd,
+                                          const float **grad,
+                                          const float *scale,
+                                          size_t num) {
+#ifdef PS_SGD_RULE_SIMD
+  const VecF lr = SetF(learning_rate_);
+  const VecF min_bound = SetF(_min_bound);
+  const VecF max_bound = SetF(_max_bound);
+#endif
+  for (size_t k = 0; k < num; ++k) {
+    PrefetchRows(w, sgd, grad, k + 1, num);
+    float *w_k = w[k];
+    const float *g = grad[k];
+    size_t i = 0;
+#ifdef PS_SGD_RULE_SIMD
+    for (; i + kFloatLanes <= _embedding_dim; i += kFloatLanes) {
+      VecF value = SubF(LoadF(w_k + i), MulF(lr, LoadF(g + i)));
+      StoreF(w_k + i, BoundF(value, min_bound, max_bound));
+    }
+#endif
+    for (; i < _embedding_dim; ++i) {
+      w_k[i] -= learning_rate_ * g[i];
+      BoundValue(w_k[i]);
+    }
+  }
+}
+
 void SparseNaiveSGDRule::InitValueWork(float *value,
                                        float *sgd,
                                        bool zero_init) {
@@ -106,6 +247,47 @@ void SparseAdaGradSGDRule::UpdateValueWork(float *w,
   g2sum += add_g2sum / _embedding_dim;
 }
 
+void SparseAdaGradSGDRule::UpdateValueBatch(float **w,
+                                            float **sgd,
+                                            const float **grad,
+                                            const float *scale,
+                                            size_t num) {
+#ifdef PS_SGD_RULE_SIMD
+  const VecD lr = SetD(learning_rate_);
+  const VecD min_bound = SetD(_min_bound);
+  const VecD max_bound = SetD(_max_bound);
+#endif
+  for (size_t k = 0; k < num; ++k) {
+    PrefetchRows(w, sgd, grad, k + 1, num);
+    float *w_k = w[k];
+    const float *g = grad[k];
+    float &g2sum = sgd[k][G2SumIndex()];
+    float ratio = sqrt(_initial_g2sum / (_initial_g2sum + g2sum));
+    double add_g2sum = 0;
+    size_t i = 0;
+#ifdef PS_SGD_RULE_SIMD
+    const HalfF grad_scale = SetH(scale[k]);
+    const VecD lr_ratio = SetD(ratio);
+    VecD add = ZeroD();
+    for (; i + kDoubleLanes <= _embedding_dim; i += kDoubleLanes) {
+      VecD scaled_grad = ToD(DivH(LoadH(g + i), grad_scale));
+      VecD value = SubD(ToD(LoadH(w_k + i)),
+                        MulD(MulD(lr, scaled_grad), lr_ratio));
+      StoreH(w_k + i, ToH(BoundD(value, min_bound, max_bound)));
+      add = AddD(add, MulD(scaled_grad, scaled_grad));
+    }
+    add_g2sum = SumD(add);
+#endif
+    for (; i < _embedding_dim; ++i) {
+      double scaled_grad = g[i] / scale[k];
+      w_k[i] -= learning_rate_ * scaled_grad * ratio;
+      BoundValue(w_k[i]);
+      add_g2sum += scaled_grad * scaled_grad;
+    }
+    g2sum += add_g2sum / _embedding_dim;
+  }
+}
+
 void SparseAdaGradSGDRule::InitValueWork(float *value,
                                          float *sgd,
                                          bool zero_init) {
@@ -159,6 +341,47 @@ void StdAdaGradSGDRule::UpdateValueWork(float *w,
   }
 }
 
+void StdAdaGradSGDRule::UpdateValueBatch(float **w,
+                                         float **sgd,
+                                         const float **grad,
+                                         const float *scale,
+                                         size_t num) {
+#ifdef PS_SGD_RULE_SIMD
+  const VecD lr = SetD(learning_rate_);
+  const VecD min_bound = SetD(_min_bound);
+  const VecD max_bound = SetD(_max_bound);
+  const HalfF initial_g2sum = SetH(_initial_g2sum);
+#endif
+  for (size_t k = 0; k < num; ++k) {
+    PrefetchRows(w, sgd, grad, k + 1, num);
+    float *w_k = w[k];
+    float *g2sum = sgd[k] + G2SumIndex();
+    const float *g = grad[k];
+    size_t i = 0;
+#ifdef PS_SGD_RULE_SIMD
+    const HalfF grad_scale = SetH(scale[k]);
+    for (; i + kDoubleLanes <= _embedding_dim; i += kDoubleLanes) {
+      HalfF g2sum_i = LoadH(g2sum + i);
+      VecD ratio = ToD(
+          SqrtH(DivH(initial_g2sum, AddH(initial_g2sum, g2sum_i))));
+      VecD scaled_grad = ToD(DivH(LoadH(g + i), grad_scale));
+      VecD value =
+          SubD(ToD(LoadH(w_k + i)), MulD(MulD(lr, scaled_grad), ratio));
+      StoreH(w_k + i, ToH(BoundD(value, min_bound, max_bound)));
+      StoreH(g2sum + i,
+             ToH(AddD(ToD(g2sum_i), MulD(scaled_grad, scaled_grad))));
+    }
+#endif
+    for (; i < _embedding_dim; ++i) {
+      double scaled_grad = g[i] / scale[k];
+      w_k[i] -= learning_rate_ * scaled_grad *
+                sqrt(_initial_g2sum / (_initial_g2sum + g2sum[i]));
+      BoundValue(w_k[i]);
+      g2sum[i] += scaled_grad * scaled_grad;
+    }
+  }
+}
+
 void StdAdaGradSGDRule::InitValueWork(float *value,
                                       float *sgd,
                                       bool zero_init) {
@@ -227,6 +450,60 @@ void SparseAdamSGDRule::UpdateValueWork(float *w,
   (*beta2_pow) *= _beta2_decay_rate;
 }
 
+void SparseAdamSGDRule::UpdateValueBatch(float **w,
+                                         float **sgd,
+                                         const float **grad,
+                                         const float *scale,
+                                         size_t num) {
+#ifdef PS_SGD_RULE_SIMD
+  const VecF beta1 = SetF(_beta1_decay_rate);
+  const VecF beta2 = SetF(_beta2_decay_rate);
+  const VecF one_minus_beta1 = SetF(1 - _beta1_decay_rate);
+  const VecF one_minus_beta2 = SetF(1 - _beta2_decay_rate);
+  const VecF epsilon = SetF(_ada_epsilon);
+  const VecF min_bound = SetF(_min_bound);
+  const VecF max_bound = SetF(_max_bound);
+#endif
+  for (size_t k = 0; k < num; ++k) {
+    PrefetchRows(w, sgd, grad, k + 1, num);
+    float *w_k = w[k];
+    float *gsum = sgd[k] + GSumIndex();
+    float *g2sum = sgd[k] + G2SumIndex();
+    float *beta1_pow = sgd[k] + Beta1PowIndex();
+    float *beta2_pow = sgd[k] + Beta2PowIndex();
+    const float *g = grad[k];
+
+    float lr = learning_rate_;
+    lr *= sqrt(1 - *beta2_pow) / (1 - *beta1_pow);
+    size_t i = 0;
+#ifdef PS_SGD_RULE_SIMD
+    const VecF lr_k = SetF(lr);
+    for (; i + kFloatLanes <= _embedding_dim; i += kFloatLanes) {
+      VecF g_i = LoadF(g + i);
+      VecF gsum_i = AddF(MulF(beta1, LoadF(gsum + i)),
+                         MulF(one_minus_beta1, g_i));
+      VecF g2sum_i = AddF(MulF(beta2, LoadF(g2sum + i)),
+                          MulF(MulF(one_minus_beta2, g_i), g_i));
+      VecF value = SubF(
+          LoadF(w_k + i),
+          MulF(lr_k, DivF(gsum_i, AddF(SqrtF(g2sum_i), epsilon))));
+      StoreF(gsum + i, gsum_i);
+      StoreF(g2sum + i, g2sum_i);
+      StoreF(w_k + i, BoundF(value, min_bound, max_bound));
+    }
+#endif
+    for (; i < _embedding_dim; ++i) {
+      gsum[i] = _beta1_decay_rate * gsum[i] + (1 - _beta1_decay_rate) * g[i];
+      g2sum[i] =
+          _beta2_decay_rate * g2sum[i] + (1 - _beta2_decay_rate) * g[i] * g[i];
+      w_k[i] = w_k[i] - lr * (gsum[i] / (sqrt(g2sum[i]) + _ada_epsilon));
+      BoundValue(w_k[i]);
+    }
+    (*beta1_pow) *= _beta1_decay_rate;
+    (*beta2_pow) *= _beta2_decay_rate;
+  }
+}
+
 void SparseAdamSGDRule::InitValueWork(float *value,
                                       float *sgd,
                                       bool zero_init) {
@@ -51,6 +51,15 @@ class SparseValueSGDRule {
                    float scale = 1) {
     UpdateValueWork(w, sgd, push_value, scale);
   }
+  // Updates num values as num calls of UpdateValue would, in order: the i-th
+  // one from its w[i], sgd[i] and grad[i] rows and scale[i]. The rules
+  // override it with SIMD kernels; the rows of the next value are prefetched
+  // while updating the current one.
+  virtual void UpdateValueBatch(float** w,
+                                float** sgd,
+                                const float** grad,
+                                const float* scale,
+                                size_t num);
   template <class T>
   void BoundValue(T& w) {  // NOLINT
     if (!(w >= _min_bound)) {
@@ -82,6 +91,11 @@ class SparseNaiveSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** w,
+                                float** sgd,
+                                const float** grad,
+                                const float* scale,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 0; }
 
@@ -97,6 +111,11 @@ class SparseAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** w,
+                                float** sgd,
+                                const float** grad,
+                                const float* scale,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 1; }
   size_t G2SumIndex() { return 0; }
@@ -134,6 +153,11 @@ class StdAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** w,
+                                float** sgd,
+                                const float** grad,
+                                const float* scale,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim; }
   size_t G2SumIndex() { return 0; }
@@ -151,6 +175,11 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** w,
+                                float** sgd,
+                                const float** grad,
+                                const float* scale,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim * 2 + 2; }
   size_t GSumIndex() { return 0; }
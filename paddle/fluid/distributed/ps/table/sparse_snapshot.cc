@@ -0,0 +1,222 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/sparse_snapshot.h"
+
+#include <cstring>
+
+#ifdef PADDLE_WITH_SNAPPY
+#include <snappy.h>
+#endif
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+static const char kSnapshotMagic[8] = {
+    'P', 'D', 'S', 'P', 'S', 'N', 'A', 'P'};
+
+SparseSnapshotWriter::SparseSnapshotWriter(FsWriteChannel* channel,
+                                           const SparseSnapshotHeader& header,
+                                           size_t block_size)
+    : channel_(channel), header_(header), block_size_(block_size) {
+#ifndef PADDLE_WITH_SNAPPY
+  header_.flags &= ~SparseSnapshotHeader::kCompressed;
+#endif
+  std::string buf(kSnapshotMagic, sizeof(kSnapshotMagic));
+  uint32_t fields[] = {header_.version,
+                       header_.flags,
+                       header_.shard_id,
+                       header_.value_dim,
+                       header_.mf_dim,
+                       header_.embedx_dim,
+                       static_cast<uint32_t>(header_.accessor_class.size())};
+  buf.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+  buf.append(header_.accessor_class);
+  uint32_t num_steps = header_.steps.size();
+  buf.append(reinterpret_cast<const char*>(&num_steps), sizeof(uint32_t));
+  for (const auto& step : header_.steps) {
+    buf.append(reinterpret_cast<const char*>(&step.type), sizeof(uint32_t));
+    buf.append(reinterpret_cast<const char*>(&step.param), sizeof(int32_t));
+  }
+  Write(buf.data(), buf.size());
+}
+
+int SparseSnapshotWriter::Append(uint64_t key,
+                                 const float* value,
+                                 uint32_t dim) {
+  auto& records = blocks_[dim];
+  records.append(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+  if (dim > 0) {
+    records.append(reinterpret_cast<const char*>(value), dim * sizeof(float));
+  }
+  ++record_num_;
+  if (records.size() >= block_size_) {
+    return WriteBlock(dim, &records);
+  }
+  return status_;
+}
+
+int SparseSnapshotWriter::Finish() {
+  for (auto& block : blocks_) {
+    if (!block.second.empty()) {
+      WriteBlock(block.first, &block.second);
+    }
+  }
+  uint32_t end[4] = {0, 0, 0, 0};
+  Write(reinterpret_cast<const char*>(end), sizeof(end));
+  return Write(reinterpret_cast<const char*>(&record_num_), sizeof(uint64_t));
+}
+
+int SparseSnapshotWriter::WriteBlock(uint32_t dim, std::string* records) {
+  uint32_t stride = sizeof(uint64_t) + dim * sizeof(float);
+  const std::string* stored = records;
+#ifdef PADDLE_WITH_SNAPPY
+  if (header_.compressed()) {
+    snappy::Compress(records->data(), records->size(), &compressed_);
+    stored = &compressed_;
+  }
+#endif
+  uint32_t block[4] = {dim,
+                       static_cast<uint32_t>(records->size() / stride),
+                       static_cast<uint32_t>(records->size()),
+                       static_cast<uint32_t>(stored->size())};
+  Write(reinterpret_cast<const char*>(block), sizeof(block));
+  Write(stored->data(), stored->size());
+  records->clear();
+  return status_;
+}
+
+int SparseSnapshotWriter::Write(const char* data, size_t size) {
+  if (status_ == 0 && channel_->write(data, size) != 0) {
+    status_ = -1;
+  }
+  return status_;
+}
+
+SparseSnapshotReader::SparseSnapshotReader(FsReadChannel* channel)
+    : channel_(channel) {}
+
+void SparseSnapshotReader::Read(char* data, size_t size) {
+  PADDLE_ENFORCE_EQ(
+      static_cast<size_t>(channel_->read(data, size)),
+      size,
+      platform::errors::Unavailable("Sparse snapshot is truncated."));
+}
+
+const SparseSnapshotHeader& SparseSnapshotReader::ReadHeader() {
+  char magic[sizeof(kSnapshotMagic)];
+  Read(magic, sizeof(magic));
+  PADDLE_ENFORCE_EQ(
+      memcmp(magic, kSnapshotMagic, sizeof(magic)),
+      0,
+      platform::errors::InvalidArgument("Not a sparse snapshot file."));
+  uint32_t fields[7];
+  Read(reinterpret_cast<char*>(fields), sizeof(fields));
+  header_.version = fields[0];
+  header_.flags = fields[1];
+  header_.shard_id = fields[2];
+  header_.value_dim = fields[3];
+  header_.mf_dim = fields[4];
+  header_.embedx_dim = fields[5];
+  header_.accessor_class.resize(fields[6]);
+  Read(&header_.accessor_class[0], fields[6]);
+  PADDLE_ENFORCE_EQ(
+      header_.version >= 1 &&
+          header_.version <= SparseSnapshotHeader::kVersion,
+      true,
+      platform::errors::InvalidArgument(
+          "Unsupported sparse snapshot version %d.", header_.version));
+  header_.steps.clear();
+  if (header_.version >= 2) {
+    uint32_t num_steps = 0;
+    Read(reinterpret_cast<char*>(&num_steps), sizeof(uint32_t));
+    header_.steps.resize(num_steps);
+    for (auto& step : header_.steps) {
+      Read(reinterpret_cast<char*>(&step.type), sizeof(uint32_t));
+      Read(reinterpret_cast<char*>(&step.param), sizeof(int32_t));
+    }
+  }
+#ifndef PADDLE_WITH_SNAPPY
+  PADDLE_ENFORCE_EQ(header_.compressed(),
+                    false,
+                    platform::errors::Unimplemented(
+                        "Sparse snapshot is snappy compressed, but paddle is "
+                        "built without snappy."));
+#endif
+  return header_;
+}
+
+uint64_t SparseSnapshotReader::ForEach(
+    const std::function<void(uint64_t key, const char* value, uint32_t dim)>&
+        fn) {
+  uint64_t record_num = 0;
+  while (true) {
+    uint32_t block[4];
+    Read(reinterpret_cast<char*>(block), sizeof(block));
+    uint32_t dim = block[0], count = block[1];
+    uint32_t raw_size = block[2], stored_size = block[3];
+    if (dim == 0 && count == 0) {
+      break;
+    }
+    size_t stride = sizeof(uint64_t) + dim * sizeof(float);
+    PADDLE_ENFORCE_EQ(static_cast<size_t>(raw_size),
+                      count * stride,
+                      platform::errors::InvalidArgument(
+                          "Corrupted sparse snapshot block of %d records of "
+                          "dim %d in %d bytes.",
+                          count,
+                          dim,
+                          raw_size));
+    stored_.resize(stored_size);
+    Read(&stored_[0], stored_size);
+    const std::string* records = &stored_;
+#ifdef PADDLE_WITH_SNAPPY
+    if (header_.compressed()) {
+      PADDLE_ENFORCE_EQ(
+          snappy::Uncompress(stored_.data(), stored_.size(), &records_) &&
+              records_.size() == raw_size,
+          true,
+          platform::errors::InvalidArgument(
+              "Corrupted snappy block in sparse snapshot."));
+      records = &records_;
+    }
+#endif
+    PADDLE_ENFORCE_EQ(records->size(),
+                      static_cast<size_t>(raw_size),
+                      platform::errors::InvalidArgument(
+                          "Corrupted sparse snapshot block."));
+    const char* p = records->data();
+    for (uint32_t i = 0; i < count; ++i, p += stride) {
+      uint64_t key = 0;
+      memcpy(&key, p, sizeof(uint64_t));
+      fn(key, dim > 0 ? p + sizeof(uint64_t) : nullptr, dim);
+    }
+    record_num += count;
+  }
+  uint64_t expected = 0;
+  Read(reinterpret_cast<char*>(&expected), sizeof(uint64_t));
+  PADDLE_ENFORCE_EQ(
+      record_num,
+      expected,
+      platform::errors::InvalidArgument(
+          "Sparse snapshot has %d records, but its end says %d.",
+          record_num,
+          expected));
+  return record_num;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,135 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/common/afs_warpper.h"
+
+#define PSERVER_SNAPSHOT_SUFFIX ".snap"
+
+namespace paddle {
+namespace distributed {
+
+/**
+ * Binary snapshot of a shard of a sparse table, one file per shard:
+ *
+ *   header: "PDSPSNAP", uint32 version, uint32 flags, uint32 shard id,
+ *           uint32 value dim, uint32 mf dim, uint32 embedx dim, then the
+ *           accessor class as an uint32 length and its bytes. Since version
+ *           2, the uint32 number of steps, then each step as an uint32 type
+ *           and an int32 param.
+ *   blocks: uint32 record dim, uint32 record count, uint32 raw size,
+ *           uint32 stored size, then the stored bytes, snappy compressed
+ *           when the file has the kCompressed flag. Once uncompressed, a
+ *           block is count fixed-stride records of the uint64 key and its
+ *           dim floats; values without their mf part go to other blocks
+ *           than the extended ones. The records of dim 0 are the keys
+ *           erased since the previous snapshot, in delta snapshots.
+ *   end:    a block of dim 0 and count 0, followed by the uint64 number of
+ *           records of the file, which tells a complete file from a
+ *           truncated one.
+ **/
+// A step the table applied to all the rows of the shard since the previous
+// snapshot, which a delta replays in order over the previous snapshot before
+// its records, instead of recording every row the step changed.
+struct SparseSnapshotStep {
+  // ValueAccessor::Shrink, erasing the rows it returns true for.
+  static constexpr uint32_t kShrink = 1;
+  // ValueAccessor::UpdateStatAfterSave with param as the save param.
+  static constexpr uint32_t kUpdateStatAfterSave = 2;
+
+  uint32_t type = 0;
+  int32_t param = 0;
+};
+
+struct SparseSnapshotHeader {
+  static constexpr uint32_t kVersion = 2;
+  static constexpr uint32_t kCompressed = 1;
+  // Only the keys updated since the previous snapshot, to be loaded over it.
+  static constexpr uint32_t kDelta = 2;
+
+  uint32_t version = kVersion;
+  uint32_t flags = 0;
+  uint32_t shard_id = 0;
+  uint32_t value_dim = 0;
+  uint32_t mf_dim = 0;
+  uint32_t embedx_dim = 0;
+  std::string accessor_class;
+  std::vector<SparseSnapshotStep> steps;
+
+  bool compressed() const { return flags & kCompressed; }
+  bool delta() const { return flags & kDelta; }
+};
+
+class SparseSnapshotWriter {
+ public:
+  // Blocks are written once block_size bytes of records of a dim are
+  // buffered. Compression falls back to raw blocks without snappy.
+  SparseSnapshotWriter(FsWriteChannel* channel,
+                       const SparseSnapshotHeader& header,
+                       size_t block_size = 4 << 20);
+
+  // The writes return 0, or -1 once the channel failed. Appending a key of
+  // dim 0 records its erasure.
+  int Append(uint64_t key, const float* value, uint32_t dim);
+  int Finish();
+
+  uint64_t record_num() const { return record_num_; }
+
+ private:
+  int WriteBlock(uint32_t dim, std::string* records);
+  int Write(const char* data, size_t size);
+
+  FsWriteChannel* channel_;
+  SparseSnapshotHeader header_;
+  size_t block_size_;
+  uint64_t record_num_ = 0;
+  int status_ = 0;
+  // Records buffered per dim, at most a base and an extended dim in practice.
+  std::map<uint32_t, std::string> blocks_;
+  std::string compressed_;
+};
+
+class SparseSnapshotReader {
+ public:
+  explicit SparseSnapshotReader(FsReadChannel* channel);
+
+  // Throws if the file is not a snapshot of this version or an older one.
+  const SparseSnapshotHeader& ReadHeader();
+
+  // Calls fn on every record, value points to the dim floats of the record,
+  // not aligned, or is null for an erased key. Throws on a corrupted or
+  // truncated file, returns the number of records.
+  uint64_t ForEach(
+      const std::function<void(uint64_t key, const char* value, uint32_t dim)>&
+          fn);
+
+ private:
+  void Read(char* data, size_t size);
+
+  FsReadChannel* channel_;
+  SparseSnapshotHeader header_;
+  std::string stored_;
+  std::string records_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
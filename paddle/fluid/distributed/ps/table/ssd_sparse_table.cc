@@ -25,6 +25,13 @@ PD_DECLARE_bool(pserver_create_value_when_push);
 PD_DECLARE_bool(pserver_enable_create_feasign_randomly);
 PD_DEFINE_bool(pserver_open_strict_check, false, "pserver_open_strict_check");
 PD_DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
+PD_DEFINE_int64(pserver_ssd_cache_capacity,
+                0,
+                "max feasigns of a ssd table kept in memory, the coldest "
+                "ones are written back to ssd, 0 for no limit");
+PD_DEFINE_int32(pserver_ssd_write_back_batch,
+                1024,
+                "feasigns per asynchronous rocksdb write batch of ssd table");
 PADDLE_DEFINE_EXPORTED_string(rocksdb_path,
                               "database",
                               "path of sparse table rocksdb file");
@@ -36,9 +43,25 @@ int32_t SSDSparseTable::Initialize() {
   MemorySparseTable::Initialize();
   _db = ::paddle::distributed::RocksDBHandler::GetInstance();
   _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  if (FLAGS_pserver_ssd_cache_capacity > 0 && _real_local_shard_num > 0) {
+    _shard_mem_capacity = std::max<int64_t>(
+        FLAGS_pserver_ssd_cache_capacity / _real_local_shard_num, 1);
+  }
+  _clock_policies.resize(_real_local_shard_num);
+  _write_back_pool.reset(
+      new ::ThreadPool(std::max(std::min(_real_local_shard_num, 8), 1)));
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    _write_backs.emplace_back(
+        new SSDWriteBack(_db,
+                         i,
+                         FLAGS_pserver_ssd_write_back_batch,
+                         _write_back_pool.get(),
+                         &_cache_stats));
+  }
   VLOG(0) << "initialize SSDSparseTable succ";
   VLOG(0) << "SSD FLAGS_pserver_print_missed_key_num_every_push:"
           << FLAGS_pserver_print_missed_key_num_every_push;
+  VLOG(0) << "SSD memory capacity per shard: " << _shard_mem_capacity;
   return 0;
 }
 
@@ -105,22 +128,27 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                &missed_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                auto* hot_key_tracker = GetHotKeyTracker(shard_id);
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                uint64_t mem_hits = 0;
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
+                  if (hot_key_tracker != nullptr) {
+                    hot_key_tracker->Add(key);
+                  }
                   auto itr = local_shard.find(key);
                   size_t data_size = value_size - mf_value_size;
+                  // only the keys resident in the shard enter the clock
+                  bool resident = true;
                   if (itr == local_shard.end()) {
                     // pull rocksdb
                     std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
+                    if (!LoadFromSSD(shard_id, key, &tmp_string)) {
                       ++missed_keys;
                       if (FLAGS_pserver_create_value_when_push) {
                         memset(data_buffer, 0, sizeof(float) * data_size);
+                        resident = false;
                       } else {
                         auto& feature_value = local_shard[key];
                         feature_value.resize(data_size);
@@ -142,16 +170,17 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                       memcpy(const_cast<float*>(feature_value.data()),
                              data_buffer_ptr,
                              data_size * sizeof(float));
-                      _db->del_data(shard_id,
-                                    reinterpret_cast<char*>(&key),
-                                    sizeof(uint64_t));
                     }
                   } else {
+                    ++mem_hits;
                     data_size = itr.value().size();
                     memcpy(data_buffer_ptr,
                            itr.value().data(),
                            data_size * sizeof(float));
                   }
+                  if (_shard_mem_capacity > 0 && resident) {
+                    _clock_policies[shard_id].Touch(key);
+                  }
                   for (size_t mf_idx = data_size; mf_idx < value_size;
                        ++mf_idx) {
                     data_buffer[mf_idx] = 0.0;
@@ -162,6 +191,11 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                   _value_accessor->Select(
                       &select_data, (const float**)&data_buffer_ptr, 1);
                 }
+                _cache_stats.mem_hits.fetch_add(mem_hits,
+                                                std::memory_order_relaxed);
+                if (_shard_mem_capacity > 0) {
+                  EvictShard(shard_id);
+                }
                 return 0;
               });
     }
@@ -195,10 +229,31 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
     auto& local_shard = _local_shards[shard_id];
     float data_buffer[value_size];  // NOLINT
     float* data_buffer_ptr = data_buffer;
+    uint64_t mem_hits = 0;
+    uint64_t ssd_hits = 0;
+    uint64_t misses = 0;
+    std::string evicted_value;
+    // Prefetches of the shard run on its task pool, while the values are
+    // filled in here.
+    WaitPrefetchTasks();
 
     for (size_t i = 0; i < num; ++i) {
       uint64_t key = pull_keys[i];
       auto itr = local_shard.find(key);
+      if (itr == local_shard.end() &&
+          _write_backs[shard_id]->Take(key, &evicted_value)) {
+        // not written back yet
+        auto& feature_value = local_shard[key];
+        feature_value.resize(evicted_value.size() / sizeof(float));
+        memcpy(const_cast<float*>(feature_value.data()),
+               evicted_value.data(),
+               evicted_value.size());
+        ++ssd_hits;
+        ret = &feature_value;
+        _value_accessor->UpdatePassId(ret->data(), pass_id);
+        pull_values[i] = reinterpret_cast<char*>(ret);
+        continue;
+      }
       if (itr == local_shard.end()) {
         cur_ctx->batch_index.push_back(i);
         cur_ctx->batch_keys.emplace_back(
@@ -209,11 +264,13 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
           auto fut =
               _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
                   [this, shard_id, cur_ctx]() -> int {
+                    int64_t start = butil::gettimeofday_us();
                     _db->multi_get(shard_id,
                                    cur_ctx->batch_keys.size(),
                                    cur_ctx->batch_keys.data(),
                                    cur_ctx->batch_values.data(),
                                    cur_ctx->status.data());
+                    _cache_stats.AddSSDRead(butil::gettimeofday_us() - start);
                     return 0;
                   });
           cur_ctx = context.switch_item();
@@ -231,6 +288,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                        data_buffer_ptr,
                        init_size * sizeof(float));
                 ret = &feature_value;
+                ++misses;
               } else {
                 int data_size =
                     cur_ctx->batch_values[idx].size() / sizeof(float);
@@ -245,6 +303,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                               reinterpret_cast<char*>(&cur_key),
                               sizeof(uint64_t));
                 ret = &feature_value;
+                ++ssd_hits;
               }
               _value_accessor->UpdatePassId(ret->data(), pass_id);
               int pull_data_idx = cur_ctx->batch_index[idx];
@@ -256,6 +315,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
           tasks.push_back(std::move(fut));
         }
       } else {
+        ++mem_hits;
         ret = itr.value_ptr();
         // int pull_data_idx = keys[i].second;
         _value_accessor->UpdatePassId(ret->data(), pass_id);
@@ -268,11 +328,13 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
       auto fut =
           _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
               [this, shard_id, cur_ctx]() -> int {
+                int64_t start = butil::gettimeofday_us();
                 _db->multi_get(shard_id,
                                cur_ctx->batch_keys.size(),
                                cur_ctx->batch_keys.data(),
                                cur_ctx->batch_values.data(),
                                cur_ctx->status.data());
+                _cache_stats.AddSSDRead(butil::gettimeofday_us() - start);
                 return 0;
               });
       tasks.push_back(std::move(fut));
@@ -294,6 +356,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                  data_buffer_ptr,
                  init_size * sizeof(float));
           ret = &feature_value;
+          ++misses;
         } else {
           int data_size = cur_ctx->batch_values[idx].size() / sizeof(float);
           // from rocksdb to mem
@@ -306,6 +369,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
           _db->del_data(
               shard_id, reinterpret_cast<char*>(&cur_key), sizeof(uint64_t));
           ret = &feature_value;
+          ++ssd_hits;
         }
         _value_accessor->UpdatePassId(ret->data(), pass_id);
         int pull_data_idx = cur_ctx->batch_index[idx];
@@ -313,6 +377,9 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
       }
       cur_ctx->reset();
     }
+    _cache_stats.mem_hits.fetch_add(mem_hits, std::memory_order_relaxed);
+    _cache_stats.ssd_hits.fetch_add(ssd_hits, std::memory_order_relaxed);
+    _cache_stats.misses.fetch_add(misses, std::memory_order_relaxed);
   }
   return 0;
 }
@@ -349,12 +416,23 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                std::string ssd_value;
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
                   const float* update_data =
                       values + push_data_idx * update_value_col;
                   auto itr = local_shard.find(key);
+                  if (itr == local_shard.end() && _shard_mem_capacity > 0 &&
+                      LoadFromSSD(shard_id, key, &ssd_value)) {
+                    // evicted since its pull
+                    auto& feature_value = local_shard[key];
+                    feature_value.resize(ssd_value.size() / sizeof(float));
+                    memcpy(const_cast<float*>(feature_value.data()),
+                           ssd_value.data(),
+                           ssd_value.size());
+                    itr = local_shard.find(key);
+                  }
                   if (itr == local_shard.end()) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
                         !_value_accessor->CreateValue(1, update_data)) {
@@ -369,6 +447,9 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            value_size * sizeof(float));
                     itr = local_shard.find(key);
                   }
+                  if (_shard_mem_capacity > 0) {
+                    _clock_policies[shard_id].Touch(key);
+                  }
                   auto& feature_value = itr.value();
                   float* value_data = const_cast<float*>(feature_value.data());
                   size_t value_size = feature_value.size();
@@ -392,6 +473,9 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            value_size * sizeof(float));
                   }
                 }
+                if (_shard_mem_capacity > 0) {
+                  EvictShard(shard_id);
+                }
                 return 0;
               });
     }
@@ -450,11 +534,22 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                std::string ssd_value;
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
                   const float* update_data = values[push_data_idx];
                   auto itr = local_shard.find(key);
+                  if (itr == local_shard.end() && _shard_mem_capacity > 0 &&
+                      LoadFromSSD(shard_id, key, &ssd_value)) {
+                    // evicted since its pull
+                    auto& feature_value = local_shard[key];
+                    feature_value.resize(ssd_value.size() / sizeof(float));
+                    memcpy(const_cast<float*>(feature_value.data()),
+                           ssd_value.data(),
+                           ssd_value.size());
+                    itr = local_shard.find(key);
+                  }
                   if (itr == local_shard.end()) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
                         !_value_accessor->CreateValue(1, update_data)) {
@@ -469,6 +564,9 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            value_size * sizeof(float));
                     itr = local_shard.find(key);
                   }
+                  if (_shard_mem_capacity > 0) {
+                    _clock_policies[shard_id].Touch(key);
+                  }
                   auto& feature_value = itr.value();
                   float* value_data = const_cast<float*>(feature_value.data());
                   size_t value_size = feature_value.size();
@@ -492,6 +590,9 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            value_size * sizeof(float));
                   }
                 }
+                if (_shard_mem_capacity > 0) {
+                  EvictShard(shard_id);
+                }
                 return 0;
               });
     }
@@ -503,6 +604,7 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
 }
 
 int32_t SSDSparseTable::Shrink(const std::string& param) {
+  WaitCacheTasks();
   int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
   omp_set_num_threads(thread_num);
 #pragma omp parallel for schedule(dynamic)
@@ -543,29 +645,172 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
 }
 
 int32_t SSDSparseTable::UpdateTable() {
+  WaitCacheTasks();
   int count = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
     auto& shard = _local_shards[i];
-    // from mem to ssd
+    // from mem to ssd, written in batches while the next shards are scanned
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->SaveSSD(it.value().data())) {
-        _db->put(i,
-                 reinterpret_cast<const char*>(&it.key()),
-                 sizeof(uint64_t),
-                 reinterpret_cast<const char*>(it.value().data()),
-                 it.value().size() * sizeof(float));
+        _write_backs[i]->Put(it.key(), it.value().data(), it.value().size());
+        _clock_policies[i].Erase(it.key());
         count++;
         it = shard.erase(it);
       } else {
         ++it;
       }
     }
+  }
+  WaitCacheTasks();
+  for (int i = 0; i < _real_local_shard_num; ++i) {
     _db->flush(i);
   }
   LOG(INFO) << "Table>> update count: " << count;
   return 0;
 }
 
+bool SSDSparseTable::LoadFromSSD(int shard_id,
+                                 uint64_t key,
+                                 std::string* value) {
+  if (_write_backs[shard_id]->Take(key, value)) {
+    _cache_stats.ssd_hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  int64_t start = butil::gettimeofday_us();
+  int ret = _db->get(
+      shard_id, reinterpret_cast<char*>(&key), sizeof(uint64_t), *value);
+  _cache_stats.AddSSDRead(butil::gettimeofday_us() - start);
+  if (ret > 0) {
+    _cache_stats.misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  _cache_stats.ssd_hits.fetch_add(1, std::memory_order_relaxed);
+  _db->del_data(shard_id, reinterpret_cast<char*>(&key), sizeof(uint64_t));
+  return true;
+}
+
+void SSDSparseTable::EvictShard(int shard_id) {
+  auto& local_shard = _local_shards[shard_id];
+  if (local_shard.size() <= _shard_mem_capacity) {
+    return;
+  }
+  // evict a little more than needed, not to come back on every push
+  size_t num = local_shard.size() - _shard_mem_capacity +
+               std::max<size_t>(_shard_mem_capacity / 16, 1);
+  std::vector<uint64_t> victims;
+  _clock_policies[shard_id].Evict(num, &victims);
+  uint64_t evicted = 0;
+  for (auto key : victims) {
+    auto itr = local_shard.find(key);
+    if (itr == local_shard.end()) {
+      continue;  // erased by shrink or save since its last access
+    }
+    auto& feature_value = itr.value();
+    _write_backs[shard_id]->Put(
+        key, feature_value.data(), feature_value.size());
+    local_shard.quick_erase(itr);
+    ++evicted;
+  }
+  _cache_stats.evicted.fetch_add(evicted, std::memory_order_relaxed);
+}
+
+int32_t SSDSparseTable::Prefetch(const uint64_t* keys, size_t num) {
+  auto task_keys = std::make_shared<std::vector<std::vector<uint64_t>>>(
+      _real_local_shard_num);
+  for (size_t i = 0; i < num; ++i) {
+    int shard_id = (keys[i] % _sparse_table_shard_num) % _avg_local_shard_num;
+    (*task_keys)[shard_id].push_back(keys[i]);
+  }
+  std::lock_guard<std::mutex> guard(_prefetch_mutex);
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    if ((*task_keys)[shard_id].empty()) {
+      continue;
+    }
+    _prefetch_tasks.push_back(
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id, task_keys]() -> int {
+              auto& keys = (*task_keys)[shard_id];
+              auto& local_shard = _local_shards[shard_id];
+              auto load = [&](uint64_t key, const char* data, size_t size) {
+                auto& feature_value = local_shard[key];
+                feature_value.resize(size / sizeof(float));
+                memcpy(const_cast<float*>(feature_value.data()), data, size);
+                if (_shard_mem_capacity > 0) {
+                  _clock_policies[shard_id].Touch(key);
+                }
+              };
+              uint64_t loaded = 0;
+              std::string value;
+              std::vector<uint64_t> cold_keys;
+              for (auto key : keys) {
+                if (local_shard.find(key) != local_shard.end()) {
+                  continue;
+                }
+                if (_write_backs[shard_id]->Take(key, &value)) {
+                  load(key, value.data(), value.size());
+                  ++loaded;
+                } else {
+                  cold_keys.push_back(key);
+                }
+              }
+              // one sorted MultiGet for the keys only on ssd, new keys are
+              // left to be created by their pull
+              std::sort(cold_keys.begin(), cold_keys.end());
+              cold_keys.erase(std::unique(cold_keys.begin(), cold_keys.end()),
+                              cold_keys.end());
+              std::vector<rocksdb::Slice> slices;
+              slices.reserve(cold_keys.size());
+              for (auto& key : cold_keys) {
+                slices.emplace_back(reinterpret_cast<const char*>(&key),
+                                    sizeof(uint64_t));
+              }
+              std::vector<rocksdb::PinnableSlice> values(cold_keys.size());
+              std::vector<rocksdb::Status> status(cold_keys.size());
+              if (!cold_keys.empty()) {
+                int64_t start = butil::gettimeofday_us();
+                _db->multi_get(shard_id,
+                               slices.size(),
+                               slices.data(),
+                               values.data(),
+                               status.data());
+                _cache_stats.AddSSDRead(butil::gettimeofday_us() - start);
+              }
+              for (size_t i = 0; i < cold_keys.size(); ++i) {
+                if (!status[i].ok()) {
+                  continue;
+                }
+                load(cold_keys[i], values[i].data(), values[i].size());
+                _db->del_data(shard_id, slices[i].data(), sizeof(uint64_t));
+                ++loaded;
+              }
+              _cache_stats.prefetched.fetch_add(loaded,
+                                                std::memory_order_relaxed);
+              // the prefetched keys are the most recently touched, the
+              // coldest ones make room for them
+              if (_shard_mem_capacity > 0) {
+                EvictShard(shard_id);
+              }
+              return 0;
+            }));
+  }
+  return 0;
+}
+
+void SSDSparseTable::WaitPrefetchTasks() {
+  std::lock_guard<std::mutex> guard(_prefetch_mutex);
+  for (auto& task : _prefetch_tasks) {
+    task.wait();
+  }
+  _prefetch_tasks.clear();
+}
+
+void SSDSparseTable::WaitCacheTasks() {
+  WaitPrefetchTasks();
+  for (auto& write_back : _write_backs) {
+    write_back->Flush();
+  }
+}
+
 int64_t SSDSparseTable::LocalSize() {
   int64_t local_size = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
@@ -576,6 +821,7 @@ int64_t SSDSparseTable::LocalSize() {
 
 int32_t SSDSparseTable::Save(const std::string& path,
                              const std::string& param) {
+  WaitCacheTasks();
   std::lock_guard<std::mutex> guard(_table_mutex);
 #ifdef PADDLE_WITH_HETERPS
   int save_param = atoi(param.c_str());
@@ -595,6 +841,7 @@ int32_t SSDSparseTable::Save(const std::string& path,
 #ifdef PADDLE_WITH_GPU_GRAPH
 int32_t SSDSparseTable::Save_v2(const std::string& path,
                                 const std::string& param) {
+  WaitCacheTasks();
   auto* save_filtered_slots = _value_accessor->GetSaveFilteredSlots();
   if (save_filtered_slots && (save_filtered_slots->size()) <= 0) {
     return Save(path, param);
@@ -2343,6 +2590,7 @@ int64_t SSDSparseTable::CacheShuffle(
     const std::vector<Table*>& table_ptrs) {
   LOG(INFO) << "cache shuffle with cache threshold: " << cache_threshold
             << " param:" << param;
+  WaitCacheTasks();
   int save_param = atoi(param.c_str());  // batch_model:0  xbox:1
   if (!_config.enable_sparse_table_cache() || cache_threshold < 0) {
     LOG(WARNING)
@@ -2499,6 +2747,7 @@ int32_t SSDSparseTable::SaveCache(
 
 int32_t SSDSparseTable::Load(const std::string& path,
                              const std::string& param) {
+  WaitCacheTasks();
   VLOG(0) << "LOAD FLAGS_rocksdb_path:" << FLAGS_rocksdb_path;
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(table_path);
@@ -2919,10 +3168,12 @@ int32_t SSDSparseTable::LoadWithBinary(const std::string& path, int param) {
 
 std::pair<int64_t, int64_t> SSDSparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
+  VLOG(0) << "SSDSparseTable cache stat: " << _cache_stats.ToString();
   return {feasign_size, -1};
 }
 
 int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
+  WaitCacheTasks();
   std::lock_guard<std::mutex> guard(_table_mutex);
   VLOG(0) << "cache_table";
   std::atomic<uint32_t> count{0};
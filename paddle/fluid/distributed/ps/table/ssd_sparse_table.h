@@ -16,6 +16,7 @@
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
+#include "paddle/fluid/distributed/ps/table/depends/ssd_cache.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
 
 namespace paddle {
@@ -60,7 +61,7 @@ class SSDSparseTable : public MemorySparseTable {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
   SSDSparseTable() {}
-  virtual ~SSDSparseTable() {}
+  virtual ~SSDSparseTable() { WaitCacheTasks(); }
 
   int32_t Initialize() override;
   int32_t InitializeShard() override;
@@ -128,12 +129,43 @@ class SSDSparseTable : public MemorySparseTable {
 
   int32_t CacheTable(uint16_t pass_id) override;
 
+  // Load the keys found on SSD into memory on the shard task pools, e.g. the
+  // feasigns of the next pass while the current one trains.
+  int32_t Prefetch(const uint64_t* keys, size_t num) override;
+
+  const SSDCacheStats& GetCacheStats() const { return _cache_stats; }
+
+ protected:
+  bool EnableEviction() override { return false; }
+
  private:
+  // Take key back from the write-back buffer or RocksDB, false if it is in
+  // neither.
+  bool LoadFromSSD(int shard_id, uint64_t key, std::string* value);
+  // Write the coldest keys of the shard back to SSD until the shard fits in
+  // its part of FLAGS_pserver_ssd_cache_capacity.
+  void EvictShard(int shard_id);
+  // Wait for the prefetches, before filling the shards outside their pools.
+  void WaitPrefetchTasks();
+  // Wait for the prefetches and the write-backs, before scanning the shards
+  // or RocksDB.
+  void WaitCacheTasks();
+
   RocksDBHandler* _db;
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
   std::vector<paddle::framework::Channel<std::string>> _fs_channel;
   std::mutex _table_mutex;
+
+  // Memory tier limit per shard, 0 if the keys are only moved to SSD by
+  // UpdateTable and CacheTable.
+  size_t _shard_mem_capacity{0};
+  SSDCacheStats _cache_stats;
+  std::vector<ClockPolicy> _clock_policies;
+  std::unique_ptr<::ThreadPool> _write_back_pool;
+  std::vector<std::unique_ptr<SSDWriteBack>> _write_backs;
+  std::mutex _prefetch_mutex;
+  std::vector<std::future<int>> _prefetch_tasks;
 };
 
 }  // namespace distributed
@@ -158,6 +158,16 @@ class Table {
   virtual void *GetShard(size_t shard_idx) = 0;
   virtual std::pair<int64_t, int64_t> PrintTableStat() { return {0, 0}; }
   virtual int32_t CacheTable(uint16_t pass_id UNUSED) { return 0; }
+  // hint that keys are about to be pulled, returns before they are loaded
+  virtual int32_t Prefetch(const uint64_t *keys UNUSED, size_t num UNUSED) {
+    return 0;
+  }
+  // the k keys pulled the most, hottest first, for the workers to cache
+  virtual int32_t GetHotKeys(
+      size_t k UNUSED,
+      std::vector<std::pair<uint64_t, float>> *hot_keys UNUSED) {
+    return 0;
+  }
 
   // for patch model
   virtual void Revert() {}
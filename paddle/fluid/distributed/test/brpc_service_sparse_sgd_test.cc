@@ -12,8 +12,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <random>
 #include <string>
 #include <thread>  // NOLINT
 
@@ -26,11 +32,16 @@ limitations under the License. */
 #include "paddle/fluid/platform/place.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
+PD_DECLARE_int32(pserver_hot_key_refresh_interval_ms);
+
 namespace paddle {
 namespace distributed {
 class DownpourBrpcClosure;
 class PSClient;
 class PSServer;
+PD_DECLARE_bool(pserver_zero_copy_sparse_push);
+PD_DECLARE_int32(pserver_hot_key_cache_size);
+PD_DECLARE_int32(pserver_hot_key_refresh_steps);
 }  // namespace distributed
 namespace framework {
 class Variable;
@@ -310,4 +321,182 @@ void RunBrpcPushSparse() {
   server_thread.join();
 }
 
+// Runs the rank-th server of host_sign_list_, in a forked process.
+void RunServerProcess(uint32_t rank) {
+  ::paddle::distributed::PSParameter server_proto = GetServerProto();
+  auto _ps_env = paddle::distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, host_sign_list_.size());
+  std::shared_ptr<paddle::distributed::PSServer> server(
+      paddle::distributed::PSServerFactory::Create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec(1);
+  server->Configure(server_proto, _ps_env, rank, empty_vec);
+  server->Start(ip_, port_ + 1 + rank);
+}
+
+std::shared_ptr<paddle::distributed::PSClient> CreateBenchmarkClient() {
+  ::paddle::distributed::PSParameter worker_proto = GetWorkerProto();
+  paddle::distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.SetPsServers(&host_sign_list_, host_sign_list_.size());
+  std::map<uint64_t, std::vector<paddle::distributed::Region>> dense_regions;
+  dense_regions.insert(
+      std::pair<uint64_t, std::vector<paddle::distributed::Region>>(0, {}));
+  std::shared_ptr<paddle::distributed::PSClient> client(
+      paddle::distributed::PSClientFactory::Create(worker_proto));
+  client->Configure(worker_proto, dense_regions, _ps_env, 0);
+  return client;
+}
+
+// Pulls and pushes the keys, returns the milliseconds of the pull.
+double PullAndPush(paddle::distributed::PSClient* client,
+                                const std::vector<uint64_t>& keys) {
+  std::vector<float> values(keys.size() * 10);
+  std::vector<float> grads(keys.size() * 13, 0.01);
+  std::vector<float*> value_ptrs(keys.size());
+  std::vector<const float*> grad_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    value_ptrs[i] = values.data() + i * 10;
+    grad_ptrs[i] = grads.data() + i * 13;
+  }
+  auto begin = std::chrono::steady_clock::now();
+  auto pull_status =
+      client->PullSparse(value_ptrs.data(), 0, keys.data(), keys.size(), true);
+  EXPECT_EQ(pull_status.get(), 0);
+  double pull_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+  EXPECT_EQ(
+      client->PushSparse(0, keys.data(), grad_ptrs.data(), keys.size()).get(),
+      0);
+  return pull_ms;
+}
+
+// Pulls and pushes of many keys to two servers in other processes: with
+// the sparse pushes in the request attachment and in the request message,
+// then Zipf distributed keys with and without the hot key cache. Runs
+// before the other tests, to fork before brpc started any thread.
+void RunBrpcSparseBenchmark() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  const uint32_t server_num = 2;
+  host_sign_list_.clear();
+  for (uint32_t rank = 0; rank < server_num; ++rank) {
+    auto ph_host = paddle::distributed::PSHost(ip_, port_ + 1 + rank, rank);
+    host_sign_list_.push_back(ph_host.SerializeToString());
+  }
+  std::vector<pid_t> server_pids;
+  // the servers recompute the hot keys at every refresh of the short run
+  FLAGS_pserver_hot_key_refresh_interval_ms = 0;
+  for (uint32_t rank = 0; rank < server_num; ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      RunServerProcess(rank);
+      _exit(0);
+    }
+    server_pids.push_back(pid);
+  }
+  FLAGS_pserver_hot_key_refresh_interval_ms = 1000;
+  sleep(1);
+
+  auto client = CreateBenchmarkClient();
+  const size_t key_num = 100000;
+  const int rounds = 20;
+  std::vector<uint64_t> keys(key_num);
+  std::vector<float> values(key_num * 10);
+  std::vector<float> grads(key_num * 13, 0.01);
+  std::vector<float*> value_ptrs(key_num);
+  std::vector<const float*> grad_ptrs(key_num);
+  for (size_t i = 0; i < key_num; ++i) {
+    keys[i] = i * 7919;
+    value_ptrs[i] = values.data() + i * 10;
+    grad_ptrs[i] = grads.data() + i * 13;
+  }
+  client->PullSparse(value_ptrs.data(), 0, keys.data(), key_num, true).wait();
+
+  for (bool zero_copy : {false, true}) {
+    paddle::distributed::FLAGS_pserver_zero_copy_sparse_push = zero_copy;
+    double pull_ms = 0, push_ms = 0;
+    for (int r = 0; r < rounds; ++r) {
+      auto begin = std::chrono::steady_clock::now();
+      auto pull_status = client->PullSparse(
+          value_ptrs.data(), 0, keys.data(), key_num, true);
+      ASSERT_EQ(pull_status.get(), 0);
+      auto pulled = std::chrono::steady_clock::now();
+      auto* closure = new paddle::distributed::DownpourBrpcClosure(
+          server_num, [server_num](void* done) {
+            auto* closure = (paddle::distributed::DownpourBrpcClosure*)done;
+            int ret = 0;
+            for (size_t i = 0; i < server_num; ++i) {
+              ret |= closure->check_response(
+                  i, paddle::distributed::PS_PUSH_SPARSE_TABLE);
+            }
+            closure->set_promise_value(ret);
+          });
+      auto push_status = client->PushSparseRawGradient(
+          0, keys.data(), grad_ptrs.data(), key_num, closure);
+      ASSERT_EQ(push_status.get(), 0);
+      auto pushed = std::chrono::steady_clock::now();
+      pull_ms +=
+          std::chrono::duration<double, std::milli>(pulled - begin).count();
+      push_ms +=
+          std::chrono::duration<double, std::milli>(pushed - pulled).count();
+    }
+    std::cout << "sparse brpc benchmark of " << key_num
+              << " keys, zero copy push " << zero_copy << ": pull "
+              << pull_ms / rounds << " ms, push " << push_ms / rounds
+              << " ms" << std::endl;
+  }
+  paddle::distributed::FLAGS_pserver_zero_copy_sparse_push = false;
+
+  // Zipf distributed batches, the same for both clients.
+  std::vector<double> weights(key_num);
+  for (size_t i = 0; i < key_num; ++i) {
+    weights[i] = 1.0 / std::pow(i + 1, 1.1);
+  }
+  std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+  std::mt19937 rng(0);
+  std::vector<std::vector<uint64_t>> batches(200, std::vector<uint64_t>(2000));
+  for (auto& batch : batches) {
+    for (auto& key : batch) {
+      key = keys[zipf(rng)];
+    }
+  }
+  paddle::distributed::FLAGS_pserver_hot_key_cache_size = 1000;
+  paddle::distributed::FLAGS_pserver_hot_key_refresh_steps = 20;
+  auto cached_client = CreateBenchmarkClient();
+  paddle::distributed::FLAGS_pserver_hot_key_cache_size = 0;
+  for (auto* zipf_client : {client.get(), cached_client.get()}) {
+    std::vector<double> pull_ms;
+    for (auto& batch : batches) {
+      pull_ms.push_back(PullAndPush(zipf_client, batch));
+    }
+    zipf_client->Flush();
+    std::sort(pull_ms.begin(), pull_ms.end());
+    std::cout << "sparse brpc zipf benchmark, hot key cache "
+              << (zipf_client == cached_client.get()) << ": pull p50 "
+              << pull_ms[pull_ms.size() / 2] << " ms, p99 "
+              << pull_ms[pull_ms.size() * 99 / 100] << " ms" << std::endl;
+  }
+  auto* hot_key_cache =
+      dynamic_cast<paddle::distributed::BrpcPsClient*>(cached_client.get())
+          ->GetHotKeyCache(0);
+  ASSERT_NE(hot_key_cache, nullptr);
+  const auto& stats = hot_key_cache->GetStats();
+  std::cout << "hot key cache: " << stats.ToString() << std::endl;
+  EXPECT_GT(stats.HitRatio(), 0.3);
+  // the repeated pushes of a hot key are sent once
+  EXPECT_GT(stats.merged_pushes.load(), stats.sent_pushes.load());
+
+  client->StopServer();
+  client->FinalizeWorker();
+  cached_client->FinalizeWorker();
+  for (auto pid : server_pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+  }
+  host_sign_list_.clear();
+}
+
+TEST(RunBrpcPushSparse, Benchmark) { RunBrpcSparseBenchmark(); }
+
 TEST(RunBrpcPushSparse, Run) { RunBrpcPushSparse(); }
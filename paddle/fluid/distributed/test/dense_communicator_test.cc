@@ -0,0 +1,253 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/service/communicator/communicator.h"
+#include "paddle/fluid/distributed/ps/service/communicator/dense_compressor.h"
+#include "paddle/fluid/distributed/ps/service/ps_client.h"
+#include "paddle/fluid/framework/scope.h"
+
+COMMON_DECLARE_string(communicator_dense_compress);
+
+namespace paddle {
+namespace distributed {
+
+const int64_t kDim = 100;
+const int kTrainers = 4;
+const int kBatches = 5;
+
+TEST(DenseGradCompressor, Fp16) {
+  DenseGradCompressor compressor(DenseCompressType::kFp16, 1.0);
+  std::vector<float> grad(1000, 1.0f + 1.0f / 3000.0f);
+  std::vector<float> decoded;
+  std::vector<double> sent(grad.size(), 0);
+  std::string shard;
+  const int rounds = 100;
+  for (int r = 0; r < rounds; ++r) {
+    compressor.Encode(0, grad.data(), grad.size(), &shard);
+    EXPECT_EQ(shard.size(), sizeof(uint32_t) + grad.size() * sizeof(uint16_t));
+    DenseGradCompressor::Decode(
+        DenseCompressType::kFp16, shard.data(), shard.size(), &decoded);
+    ASSERT_EQ(decoded.size(), grad.size());
+    for (size_t i = 0; i < grad.size(); ++i) {
+      sent[i] += decoded[i];
+    }
+  }
+  // A single fp16 rounds 1/3000 off, the error feedback sends it later.
+  for (size_t i = 0; i < grad.size(); ++i) {
+    EXPECT_NEAR(sent[i], rounds * grad[i], 1e-3);
+  }
+}
+
+// The values beyond the range of fp16 are sent saturated, the rest of them
+// in the following rounds.
+TEST(DenseGradCompressor, Fp16Saturate) {
+  DenseGradCompressor compressor(DenseCompressType::kFp16, 1.0);
+  std::vector<float> grad = {1e5f, -1e5f, 1.0f};
+  std::vector<float> zero(grad.size(), 0);
+  std::vector<float> decoded;
+  std::string shard;
+  compressor.Encode(0, grad.data(), grad.size(), &shard);
+  DenseGradCompressor::Decode(
+      DenseCompressType::kFp16, shard.data(), shard.size(), &decoded);
+  ASSERT_EQ(decoded.size(), grad.size());
+  EXPECT_EQ(decoded[0], 65504.0f);
+  EXPECT_EQ(decoded[1], -65504.0f);
+  EXPECT_EQ(decoded[2], 1.0f);
+
+  compressor.Encode(0, zero.data(), zero.size(), &shard);
+  DenseGradCompressor::Decode(
+      DenseCompressType::kFp16, shard.data(), shard.size(), &decoded);
+  EXPECT_NEAR(decoded[0], 1e5f - 65504.0f, 16.0f);
+  EXPECT_NEAR(decoded[1], 65504.0f - 1e5f, 16.0f);
+  EXPECT_EQ(decoded[2], 0.0f);
+}
+
+TEST(DenseGradCompressor, TopK) {
+  DenseGradCompressor compressor(DenseCompressType::kTopK, 0.1);
+  std::vector<float> grad(1000);
+  for (size_t i = 0; i < grad.size(); ++i) {
+    grad[i] = (i % 2 ? -1.0f : 1.0f) * (1.0f + i % 7);
+  }
+  std::vector<float> decoded;
+  std::vector<float> sent(grad.size(), 0);
+  std::string shard;
+  const int rounds = 50;
+  for (int r = 0; r < rounds; ++r) {
+    compressor.Encode(3, grad.data(), grad.size(), &shard);
+    EXPECT_EQ(shard.size(), 2 * sizeof(uint32_t) + 100 * 2 * sizeof(float));
+    DenseGradCompressor::Decode(
+        DenseCompressType::kTopK, shard.data(), shard.size(), &decoded);
+    ASSERT_EQ(decoded.size(), grad.size());
+    int non_zeros = 0;
+    for (size_t i = 0; i < grad.size(); ++i) {
+      sent[i] += decoded[i];
+      non_zeros += decoded[i] != 0;
+    }
+    EXPECT_EQ(non_zeros, 100);
+  }
+  // What has not been sent yet is at most a few rounds of gradient.
+  for (size_t i = 0; i < grad.size(); ++i) {
+    EXPECT_LE(std::fabs(rounds * grad[i] - sent[i]), 20 * std::fabs(grad[i]));
+  }
+
+  shard.resize(shard.size() - 1);
+  EXPECT_ANY_THROW(DenseGradCompressor::Decode(
+      DenseCompressType::kTopK, shard.data(), shard.size(), &decoded));
+  EXPECT_ANY_THROW(ParseDenseCompressType("int8"));
+}
+
+TEST(DenseGradAccumulator, ConcurrentAdd) {
+  DenseGradAccumulator accumulator;
+  const size_t numel = 3 * DenseGradAccumulator::kStripeSize + 5;
+  std::vector<float> grad(numel, 1.0f);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kTrainers; ++t) {
+    threads.emplace_back([&] {
+      for (int b = 0; b < kBatches; ++b) {
+        accumulator.Add(grad.data(), grad.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(accumulator.Count(), kTrainers * kBatches);
+  int64_t count = accumulator.Flush([&](const float *sum, size_t n) {
+    ASSERT_EQ(n, numel);
+    for (size_t i = 0; i < n; ++i) {
+      ASSERT_FLOAT_EQ(sum[i], kTrainers * kBatches);
+    }
+  });
+  EXPECT_EQ(count, kTrainers * kBatches);
+  EXPECT_EQ(accumulator.Count(), 0);
+
+  // The flushed buffer is zeroed for its next turn.
+  accumulator.Add(grad.data(), grad.size());
+  accumulator.Flush([](const float *, size_t) {});
+  accumulator.Add(grad.data(), grad.size());
+  accumulator.Flush([](const float *sum, size_t) { EXPECT_EQ(sum[0], 1.0f); });
+  EXPECT_ANY_THROW(accumulator.Add(grad.data(), numel - 1));
+}
+
+static PSParameter GetLocalProto() {
+  PSParameter proto;
+  auto *server_param = proto.mutable_server_param()
+                           ->mutable_downpour_server_param();
+  server_param->mutable_service_param()->set_client_class("PsLocalClient");
+  auto *table = server_param->add_downpour_table_param();
+  table->set_table_id(0);
+  table->set_table_class("MemoryDenseTable");
+  table->set_shard_num(256);
+  table->set_type(PS_DENSE_TABLE);
+  auto *accessor = table->mutable_accessor();
+  accessor->set_accessor_class("CommMergeAccessor");
+  accessor->set_fea_dim(kDim);
+  accessor->set_embedx_dim(1);
+  auto *common = table->mutable_common();
+  common->set_name("sgd");
+  common->set_table_name("MergedDense");
+  common->set_trainer_num(1);
+  common->set_sync(false);
+  common->add_params("Param");
+  common->add_dims(kDim);
+  common->add_initializers("fill_constant&1.0");
+  common->add_params("LearningRate");
+  common->add_dims(1);
+  common->add_initializers("fill_constant&1.0");
+  return proto;
+}
+
+// Every trainer sends kBatches gradients of x, equal to the trainer id + 1 in
+// every value, through an AsyncCommunicator pushing to a PsLocalClient, and
+// the sgd table ends with 1 - the sum of all the gradients.
+static void RunAsyncCommunicator(const std::string &compress) {
+  FLAGS_communicator_dense_compress = compress;
+  static PaddlePSEnvironment env;
+  PSParameter proto = GetLocalProto();
+  std::shared_ptr<PSClient> client(PSClientFactory::Create(proto));
+  ASSERT_NE(client, nullptr);
+  std::map<uint64_t, std::vector<Region>> regions;
+  client->Configure(proto, regions, env, 0);
+
+  std::map<std::string, std::string> envs = {
+      {"barrier_table_id", "0"},
+      {"trainer_id", "0"},
+      {"trainers", "1"},
+      {"communicator_independent_recv_thread", "1"},
+      {"communicator_min_send_grad_num_before_recv", "1"},
+      {"communicator_thread_pool_size", "2"},
+      {"communicator_max_merge_var_num", "1000"},
+      {"communicator_send_wait_times", "1"},
+      {"communicator_send_queue_size", "2"},
+      {"need_global_step", "0"}};
+  AsyncCommunicator communicator(envs);
+  communicator.InitEnvs();
+  communicator._worker_ptr = client;
+  RpcCtxMap send_ctx;
+  send_ctx["x@GRAD"] = CommContext("x@GRAD",
+                                   {"x@GRAD"},
+                                   {"127.0.0.1:0"},
+                                   {kDim},
+                                   {"x@GRAD"},
+                                   0,
+                                   true,
+                                   false,
+                                   false,
+                                   0);
+  framework::Scope recv_scope;
+  communicator.InitImpl(send_ctx, RecvCtxMap(), &recv_scope);
+
+  std::vector<std::thread> trainers;
+  for (int t = 0; t < kTrainers; ++t) {
+    trainers.emplace_back([&, t] {
+      framework::Scope scope;
+      auto *x = scope.Var("x@GRAD")->GetMutable<phi::DenseTensor>();
+      float *g = x->mutable_data<float>(phi::make_ddim({1, kDim}),
+                                        platform::CPUPlace());
+      std::fill(g, g + kDim, static_cast<float>(t + 1));
+      for (int b = 0; b < kBatches; ++b) {
+        communicator.Send({"x@GRAD"}, scope);
+      }
+    });
+  }
+  for (auto &trainer : trainers) {
+    trainer.join();
+  }
+  communicator.SendByCommunicator();
+
+  std::vector<float> param(kDim);
+  std::vector<Region> pull_regions = {Region(param.data(), param.size())};
+  client->PullDense(pull_regions.data(), pull_regions.size(), 0).wait();
+  float expected = 1.0f - kBatches * kTrainers * (kTrainers + 1) / 2;
+  for (int64_t i = 0; i < kDim; ++i) {
+    EXPECT_FLOAT_EQ(param[i], expected);
+  }
+  FLAGS_communicator_dense_compress = "none";
+}
+
+TEST(AsyncCommunicator, DenseAccumulate) { RunAsyncCommunicator("none"); }
+
+// The sums are small integers, which fp16 keeps exact.
+TEST(AsyncCommunicator, DenseCompressFp16) { RunAsyncCommunicator("fp16"); }
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,6 +14,11 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <unordered_map>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -46,5 +51,150 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+// The swiss map agrees with std::unordered_map through inserts, erases
+// while iterating and the rehashes dropping the deleted slots.
+TEST(SwissHashMap, MatchUnorderedMap) {
+  SwissHashMap<uint64_t, uint64_t> map;
+  std::unordered_map<uint64_t, uint64_t> expected;
+  std::mt19937_64 rng(0);
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < 5000; ++i) {
+      uint64_t key = rng() % 20000;
+      auto res = map.insert({key, key * 3});
+      EXPECT_EQ(res.second, expected.emplace(key, key * 3).second);
+      EXPECT_EQ(res.first->first, key);
+    }
+    for (auto it = map.begin(); it != map.end();) {
+      if (it->first % 3 == static_cast<uint64_t>(round % 3)) {
+        expected.erase(it->first);
+        it = map.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    size_t count = 0;
+    for (auto it = map.begin(); it != map.end(); ++it, ++count) {
+      ASSERT_EQ(expected.at(it->first), it->second);
+    }
+    ASSERT_EQ(count, expected.size());
+    for (uint64_t key = 0; key < 20000; ++key) {
+      auto it = map.find(key);
+      ASSERT_EQ(it != map.end(), expected.count(key) > 0) << key;
+    }
+  }
+  EXPECT_EQ(map.erase(expected.begin()->first), 1UL);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST(SwissTableShard, FindBatch) {
+  typedef SparseTableShard<uint64_t,
+                           FixedFeatureValue,
+                           SwissHashMap<uint64_t, mct::Pointer>>
+      shard_type;
+  shard_type shard;
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    keys.push_back(key * 7919);
+    if (key % 2 == 0) {
+      auto& value = shard[key * 7919];
+      value.resize(1);
+      value.data()[0] = key;
+    }
+  }
+  EXPECT_EQ(shard.size(), 500UL);
+  std::vector<FixedFeatureValue*> values(keys.size());
+  shard.find_batch(keys.data(), keys.size(), values.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i % 2 == 0) {
+      ASSERT_NE(values[i], nullptr);
+      ASSERT_FLOAT_EQ(values[i]->data()[0], i);
+    } else {
+      ASSERT_EQ(values[i], nullptr);
+    }
+  }
+  size_t count = 0;
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    ++count;
+  }
+  EXPECT_EQ(count, 500UL);
+  for (auto it = shard.begin(); it != shard.end();) {
+    it = shard.erase(it);
+  }
+  EXPECT_TRUE(shard.empty());
+}
+
+template <class SHARD>
+static void BenchmarkShard(const std::string& name,
+                           const std::vector<uint64_t>& keys) {
+  SHARD shard;
+  auto start = std::chrono::steady_clock::now();
+  for (auto key : keys) {
+    shard[key].resize(1);
+  }
+  auto inserted = std::chrono::steady_clock::now();
+  // Every lookup reads its value, as the tables do.
+  size_t found = 0;
+  for (auto key : keys) {
+    found += shard.find(key).value().size();
+  }
+  auto looked_up = std::chrono::steady_clock::now();
+  const size_t batch = 256;
+  std::vector<FixedFeatureValue*> values(batch);
+  for (size_t i = 0; i < keys.size(); i += batch) {
+    size_t n = std::min(batch, keys.size() - i);
+    shard.find_batch(keys.data() + i, n, values.data());
+    for (size_t j = 0; j < n; ++j) {
+      found += values[j]->size();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  ASSERT_EQ(found, 2 * keys.size());
+  auto mops = [&](std::chrono::steady_clock::time_point a,
+                  std::chrono::steady_clock::time_point b) {
+    return keys.size() / std::chrono::duration<double, std::micro>(b - a)
+                             .count();
+  };
+  std::cout << name << ": insert " << mops(start, inserted)
+            << " Mops, find " << mops(inserted, looked_up)
+            << " Mops, find_batch " << mops(looked_up, end) << " Mops"
+            << std::endl;
+}
+
+// Lookup and insert throughput of the shards on the two maps, and the bytes
+// per key of the maps, without the values.
+TEST(BENCHMARK, ShardMap) {
+  const size_t num = 1 << 20;
+  std::vector<uint64_t> keys(num);
+  std::mt19937_64 rng(0);
+  for (auto& key : keys) {
+    key = rng();
+  }
+  BenchmarkShard<SparseTableShard<
+      uint64_t,
+      FixedFeatureValue,
+      mct::closed_hash_map<uint64_t, mct::Pointer, std::hash<uint64_t>>>>(
+      "mct shard", keys);
+  BenchmarkShard<SparseTableShard<uint64_t,
+                                  FixedFeatureValue,
+                                  SwissHashMap<uint64_t, mct::Pointer>>>(
+      "swiss shard", keys);
+
+  mct::closed_hash_map<uint64_t, mct::Pointer, std::hash<uint64_t>> mct_map;
+  SwissHashMap<uint64_t, mct::Pointer> swiss_map;
+  for (auto key : keys) {
+    mct_map.insert({key, NULL});
+    swiss_map.insert({key, NULL});
+  }
+  std::cout << "bytes per key: mct "
+            << static_cast<double>(mct_map.bucket_count() *
+                                   sizeof(std::pair<uint64_t, mct::Pointer>)) /
+                   num
+            << " (slots only), swiss "
+            << static_cast<double>(swiss_map.memory_size()) / num << std::endl;
+}
+
 }  // namespace distributed
 }  // namespace paddle
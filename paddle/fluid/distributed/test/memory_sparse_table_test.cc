@@ -17,14 +17,25 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <map>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/table/depends/admission_filter.h"
+#include "paddle/fluid/distributed/ps/table/sparse_snapshot.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
 
+PD_DECLARE_int32(pserver_admission_threshold);
+PD_DECLARE_int32(pserver_hot_key_refresh_interval_ms);
+
 namespace paddle {
 namespace distributed {
 
@@ -152,5 +163,374 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+TEST(SparseSnapshot, WriteRead) {
+  std::string path = "./sparse_snapshot_test.snap";
+  SparseSnapshotHeader header;
+  header.flags = SparseSnapshotHeader::kCompressed;
+  header.shard_id = 3;
+  header.value_dim = 4;
+  header.mf_dim = 2;
+  header.accessor_class = "CtrCommonAccessor";
+  {
+    FsWriteChannel channel;
+    channel.open(std::shared_ptr<FILE>(fopen(path.c_str(), "wb"), fclose),
+                 FsChannelConfig());
+    // blocks of 3 records, of dims 2 and 4
+    SparseSnapshotWriter writer(&channel, header, 3 * (8 + 4 * 4));
+    for (uint64_t key = 0; key < 10; ++key) {
+      float value[4] = {key * 1.0f, key * 2.0f, key * 3.0f, key * 4.0f};
+      ASSERT_EQ(writer.Append(key, value, key % 2 ? 4 : 2), 0);
+    }
+    ASSERT_EQ(writer.Append(42, nullptr, 0), 0);
+    ASSERT_EQ(writer.Finish(), 0);
+    EXPECT_EQ(writer.record_num(), 11UL);
+  }
+
+  FsReadChannel channel;
+  channel.open(std::shared_ptr<FILE>(fopen(path.c_str(), "rb"), fclose),
+               FsChannelConfig());
+  SparseSnapshotReader reader(&channel);
+  const auto &read_header = reader.ReadHeader();
+  EXPECT_EQ(read_header.shard_id, 3U);
+  EXPECT_EQ(read_header.value_dim, 4U);
+  EXPECT_EQ(read_header.accessor_class, "CtrCommonAccessor");
+  std::map<uint64_t, std::vector<float>> records;
+  uint64_t num =
+      reader.ForEach([&](uint64_t key, const char *data, uint32_t dim) {
+        auto &value = records[key];
+        value.resize(dim);
+        if (dim > 0) {
+          memcpy(value.data(), data, dim * sizeof(float));
+        }
+      });
+  EXPECT_EQ(num, 11UL);
+  ASSERT_EQ(records.size(), 11UL);
+  EXPECT_TRUE(records[42].empty());
+  for (uint64_t key = 0; key < 10; ++key) {
+    ASSERT_EQ(records[key].size(), key % 2 ? 4UL : 2UL);
+    EXPECT_EQ(records[key][1], key * 2.0f);
+  }
+
+  // a truncated snapshot is an error
+  truncate(path.c_str(), 40);
+  FsReadChannel truncated;
+  truncated.open(std::shared_ptr<FILE>(fopen(path.c_str(), "rb"), fclose),
+                 FsChannelConfig());
+  SparseSnapshotReader truncated_reader(&truncated);
+  EXPECT_ANY_THROW({
+    truncated_reader.ReadHeader();
+    truncated_reader.ForEach([](uint64_t, const char *, uint32_t) {});
+  });
+  remove(path.c_str());
+}
+
+static Table *CreateSnapshotTable() {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  table_config.set_binary_snapshot(true);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(0);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  FsClientParameter fs_config;
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return table;
+}
+
+static std::vector<float> PullAll(Table *table,
+                                  const std::vector<uint64_t> &keys) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  std::vector<float> values(keys.size() * 11);
+  TableContext context;
+  context.value_type = Sparse;
+  context.pull_context.pull_value = PullSparseValue(keys, fres, 8);
+  context.pull_context.values = values.data();
+  table->Pull(context);
+  return values;
+}
+
+static void PushAll(Table *table, const std::vector<uint64_t> &keys) {
+  std::vector<float> grads;
+  for (auto key : keys) {
+    for (int j = 0; j < 12; ++j) {
+      grads.push_back(0.01 * (key % 5 + j));
+    }
+  }
+  TableContext context;
+  context.value_type = Sparse;
+  context.push_context.keys = keys.data();
+  context.push_context.values = grads.data();
+  context.num = keys.size();
+  table->Push(context);
+}
+
+// A base snapshot and a delta of the keys pushed after it restore the table.
+TEST(MemorySparseTable, BinarySnapshot) {
+  std::vector<uint64_t> keys(1000), updated_keys(100);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  for (size_t i = 0; i < updated_keys.size(); ++i) {
+    updated_keys[i] = i * 7;
+  }
+  Table *table = CreateSnapshotTable();
+  PushAll(table, keys);
+  ASSERT_EQ(table->Save("./snapshot_test_base", "0"), 0);
+  PushAll(table, updated_keys);
+  PushAll(table, {100000});
+  ASSERT_EQ(table->Save("./snapshot_test_delta", "6"), 0);
+
+  Table *loaded = CreateSnapshotTable();
+  ASSERT_EQ(loaded->Load("./snapshot_test_base", "0"), 0);
+  ASSERT_EQ(loaded->Load("./snapshot_test_delta", "0"), 0);
+  keys.push_back(100000);
+  auto expected = PullAll(table, keys);
+  auto values = PullAll(loaded, keys);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i], expected[i]) << "value " << i;
+  }
+  delete table;
+  delete loaded;
+}
+
+static std::map<uint64_t, std::vector<float>> DumpRows(Table *table) {
+  std::map<uint64_t, std::vector<float>> rows;
+  for (size_t i = 0; i < 10; ++i) {
+    auto *shard =
+        static_cast<MemorySparseTable::shard_type *>(table->GetShard(i));
+    for (auto it = shard->begin(); it != shard->end(); ++it) {
+      rows[it.key()].assign(it.value().data(),
+                            it.value().data() + it.value().size());
+    }
+  }
+  return rows;
+}
+
+// The records of the snapshot of the 10 local shards of table in dirname.
+static uint64_t CountSnapshotRecords(Table *table, const std::string &dirname) {
+  uint64_t num = 0;
+  for (int i = 0; i < 10; ++i) {
+    std::string path = ::paddle::string::format_string(
+        "%s/part-000-%05d%s",
+        table->TableDir(dirname).c_str(),
+        i,
+        PSERVER_SNAPSHOT_SUFFIX);
+    FsReadChannel channel;
+    channel.open(std::shared_ptr<FILE>(fopen(path.c_str(), "rb"), fclose),
+                 FsChannelConfig());
+    SparseSnapshotReader reader(&channel);
+    reader.ReadHeader();
+    num += reader.ForEach([](uint64_t, const char *, uint32_t) {});
+  }
+  return num;
+}
+
+// The stats updated after the base, and the rows decayed or dropped by a
+// shrink, are restored by the delta too, which replays them instead of
+// holding every row.
+TEST(MemorySparseTable, BinarySnapshotAfterShrink) {
+  std::vector<uint64_t> keys(1000), hot_keys(100);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  for (size_t i = 0; i < hot_keys.size(); ++i) {
+    hot_keys[i] = i * 7;
+  }
+  Table *table = CreateSnapshotTable();
+  PushAll(table, keys);
+  for (int i = 0; i < 10; ++i) {
+    PushAll(table, hot_keys);
+  }
+  // unseen_days of every row is increased after a base of param 3
+  ASSERT_EQ(table->Save("./snapshot_shrink_test_base", "3"), 0);
+  ASSERT_EQ(table->Shrink(""), 0);
+  PushAll(table, {100000});
+  ASSERT_EQ(table->Save("./snapshot_shrink_test_delta", "6"), 0);
+  EXPECT_EQ(CountSnapshotRecords(table, "./snapshot_shrink_test_delta"), 1UL);
+
+  Table *loaded = CreateSnapshotTable();
+  ASSERT_EQ(loaded->Load("./snapshot_shrink_test_base", "0"), 0);
+  ASSERT_EQ(loaded->Load("./snapshot_shrink_test_delta", "0"), 0);
+  auto expected = DumpRows(table);
+  EXPECT_GE(expected.size(), hot_keys.size());
+  EXPECT_EQ(DumpRows(loaded), expected);
+  delete table;
+  delete loaded;
+}
+
+TEST(CountMinSketch, Count) {
+  CountMinSketch sketch(1024);
+  for (uint64_t key = 0; key < 100; ++key) {
+    for (uint64_t i = 0; i <= key % 4; ++i) {
+      sketch.Add(key);
+    }
+  }
+  // never below the real count, and exact for a few keys in a wide sketch
+  for (uint64_t key = 0; key < 100; ++key) {
+    EXPECT_EQ(sketch.Estimate(key), key % 4 + 1);
+  }
+  EXPECT_EQ(sketch.Estimate(100000), 0U);
+  sketch.Decay();
+  EXPECT_EQ(sketch.Estimate(3), 2U);
+}
+
+// New keys only get a row at their pserver_admission_threshold-th push.
+TEST(MemorySparseTable, Admission) {
+  FLAGS_pserver_admission_threshold = 3;
+  Table *table = CreateSnapshotTable();
+  FLAGS_pserver_admission_threshold = 0;
+  auto *sparse_table = dynamic_cast<MemorySparseTable *>(table);
+  std::vector<uint64_t> keys(1000);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  PushAll(table, keys);
+  PushAll(table, keys);
+  EXPECT_EQ(sparse_table->LocalSize(), 0);
+  PushAll(table, keys);
+  EXPECT_EQ(sparse_table->LocalSize(), static_cast<int64_t>(keys.size()));
+  // the rows are updated from then on
+  PushAll(table, keys);
+  const auto &stats = sparse_table->GetAdmissionStats();
+  EXPECT_EQ(stats.admitted.load(), keys.size());
+  EXPECT_EQ(stats.rejected.load(), 2 * keys.size());
+  delete table;
+}
+
+// A threshold above the saturation of the sketch still admits the keys.
+TEST(MemorySparseTable, AdmissionThresholdClamped) {
+  FLAGS_pserver_admission_threshold = 1000;
+  Table *table = CreateSnapshotTable();
+  FLAGS_pserver_admission_threshold = 0;
+  auto *sparse_table = dynamic_cast<MemorySparseTable *>(table);
+  std::vector<uint64_t> keys(10);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  for (uint32_t i = 1; i < CountMinSketch::kMaxCount; ++i) {
+    PushAll(table, keys);
+  }
+  EXPECT_EQ(sparse_table->LocalSize(), 0);
+  PushAll(table, keys);
+  EXPECT_EQ(sparse_table->LocalSize(), static_cast<int64_t>(keys.size()));
+  delete table;
+}
+
+// The rows of the lowest show go first once over the memory budget.
+TEST(MemorySparseTable, EvictColdRows) {
+  Table *table = CreateSnapshotTable();
+  auto *sparse_table = dynamic_cast<MemorySparseTable *>(table);
+  std::vector<uint64_t> keys(1000), hot_keys(100);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  for (size_t i = 0; i < hot_keys.size(); ++i) {
+    hot_keys[i] = i * 7;
+  }
+  PushAll(table, keys);
+  for (int i = 0; i < 10; ++i) {
+    PushAll(table, hot_keys);
+  }
+  EXPECT_EQ(sparse_table->EvictColdRows(INT64_MAX), 0);
+  int64_t evicted = sparse_table->EvictColdRows(40000);
+  EXPECT_GT(evicted, 0);
+  EXPECT_EQ(sparse_table->LocalSize(),
+            static_cast<int64_t>(keys.size()) - evicted);
+  EXPECT_GE(sparse_table->LocalSize(), static_cast<int64_t>(hot_keys.size()));
+  const auto &stats = sparse_table->GetAdmissionStats();
+  EXPECT_EQ(stats.evicted.load(), static_cast<uint64_t>(evicted));
+  EXPECT_EQ(stats.eviction_rounds.load(), 1UL);
+  delete table;
+}
+
+// The rows pulled by pointers are held by the caller, so never evicted.
+TEST(MemorySparseTable, NoEvictionOncePulledByPtr) {
+  Table *table = CreateSnapshotTable();
+  auto *sparse_table = dynamic_cast<MemorySparseTable *>(table);
+  std::vector<uint64_t> keys(1000);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  PushAll(table, keys);
+  std::vector<char *> ptrs(keys.size());
+  TableContext context;
+  context.value_type = Sparse;
+  context.use_ptr = true;
+  context.shard_id = 0;
+  context.pull_context.keys = keys.data();
+  context.pull_context.ptr_values = ptrs.data();
+  context.num = keys.size();
+  ASSERT_EQ(table->Pull(context), 0);
+  EXPECT_EQ(sparse_table->EvictColdRows(40000), 0);
+  EXPECT_EQ(sparse_table->LocalSize(), static_cast<int64_t>(keys.size()));
+  delete table;
+}
+
+// The keys pulled the most of late are kept, a colder one gives way to a
+// key pulled more.
+TEST(HotKeyTracker, Add) {
+  HotKeyTracker tracker(2, 1024);
+  for (int i = 0; i < 3; ++i) tracker.Add(1);
+  tracker.Add(2);
+  for (int i = 0; i < 2; ++i) tracker.Add(3);
+  std::vector<std::pair<uint64_t, uint32_t>> hot_keys;
+  tracker.Get(&hot_keys);
+  std::sort(hot_keys.begin(), hot_keys.end());
+  ASSERT_EQ(hot_keys.size(), 2UL);
+  EXPECT_EQ(hot_keys[0], std::make_pair(uint64_t(1), 3U));
+  EXPECT_EQ(hot_keys[1], std::make_pair(uint64_t(3), 2U));
+}
+
+// The keys pulled the most since the hot keys were first asked for are the
+// hot keys, hottest first.
+TEST(MemorySparseTable, GetHotKeys) {
+  FLAGS_pserver_hot_key_refresh_interval_ms = 0;
+  Table *table = CreateSnapshotTable();
+  std::vector<uint64_t> keys(1000);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  std::vector<std::pair<uint64_t, float>> hot_keys;
+  ASSERT_EQ(table->GetHotKeys(5, &hot_keys), 0);
+  EXPECT_TRUE(hot_keys.empty());
+  PullAll(table, keys);
+  // key 5 * i is pulled 10 - i more times
+  for (int r = 0; r < 10; ++r) {
+    std::vector<uint64_t> pulled;
+    for (int i = 0; i < 10 - r; ++i) {
+      pulled.push_back(5 * i);
+    }
+    PullAll(table, pulled);
+  }
+  ASSERT_EQ(table->GetHotKeys(5, &hot_keys), 0);
+  ASSERT_EQ(hot_keys.size(), 5UL);
+  for (size_t i = 0; i < hot_keys.size(); ++i) {
+    EXPECT_EQ(hot_keys[i].first, 5 * i);
+    EXPECT_EQ(hot_keys[i].second, 11 - i);
+  }
+
+  // served from the last ones within the interval
+  FLAGS_pserver_hot_key_refresh_interval_ms = 1000000;
+  PullAll(table, {999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999});
+  ASSERT_EQ(table->GetHotKeys(5, &hot_keys), 0);
+  ASSERT_EQ(hot_keys.size(), 5UL);
+  EXPECT_EQ(hot_keys[0].first, 0UL);
+  FLAGS_pserver_hot_key_refresh_interval_ms = 1000;
+  delete table;
+}
+
 }  // namespace distributed
 }  // namespace paddle
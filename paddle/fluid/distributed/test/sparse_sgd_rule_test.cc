@@ -14,8 +14,12 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/ps/table/sparse_sgd_rule.h"
 
+#include <chrono>  // NOLINT
 #include <cmath>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
@@ -205,5 +209,137 @@ TEST(downpour_sparse_adam_test, test_init_and_update) {
     ASSERT_FLOAT_EQ(value[i], label[i]) << "i is " << i;
   }
 }
+
+static SparseCommonSGDRuleParameter BatchRuleParam() {
+  SparseCommonSGDRuleParameter param;
+  for (auto* bounds : {param.mutable_naive()->mutable_weight_bounds(),
+                       param.mutable_adagrad()->mutable_weight_bounds(),
+                       param.mutable_adam()->mutable_weight_bounds()}) {
+    bounds->Add(-1.0);
+    bounds->Add(1.0);
+  }
+  param.mutable_naive()->set_learning_rate(0.05);
+  param.mutable_adagrad()->set_learning_rate(0.05);
+  param.mutable_adagrad()->set_initial_g2sum(3.0);
+  param.mutable_adam()->set_learning_rate(0.001);
+  param.mutable_adam()->set_beta1_decay_rate(0.9);
+  param.mutable_adam()->set_beta2_decay_rate(0.999);
+  param.mutable_adam()->set_ada_epsilon(1e-08);
+  return param;
+}
+
+static const char* kBatchRuleNames[] = {"naive",
+                                        "adagrad",
+                                        "adagrad_v2",
+                                        "std_adagrad",
+                                        "adam",
+                                        "shared_adam"};
+
+static std::vector<std::shared_ptr<SparseValueSGDRule>> BatchRules(
+    size_t dim) {
+  std::vector<std::shared_ptr<SparseValueSGDRule>> rules = {
+      std::make_shared<SparseNaiveSGDRule>(),
+      std::make_shared<SparseAdaGradSGDRule>(),
+      std::make_shared<SparseAdaGradV2SGDRule>(),
+      std::make_shared<StdAdaGradSGDRule>(),
+      std::make_shared<SparseAdamSGDRule>(),
+      std::make_shared<SparseSharedAdamSGDRule>()};
+  for (auto& rule : rules) {
+    rule->LoadConfig(BatchRuleParam(), dim);
+  }
+  return rules;
+}
+
+// num values of dim weights and their sgd rows, and their gradients, a
+// value updated twice in a batch included.
+struct BatchRows {
+  BatchRows(SparseValueSGDRule* rule, size_t num, size_t dim)
+      : stride(dim + rule->Dim()),
+        values(num * stride),
+        grads(num * dim),
+        scales(num) {
+    std::mt19937 rng(num);
+    std::uniform_real_distribution<float> dist(-1.0, 1.0);
+    for (size_t k = 0; k < num; ++k) {
+      rule->InitValue(&values[k * stride], &values[k * stride + dim], true);
+      for (size_t i = 0; i < dim; ++i) {
+        values[k * stride + i] = dist(rng) * 0.5;
+        grads[k * dim + i] = dist(rng) * 5;
+      }
+      scales[k] = 1 + k % 7;
+      size_t row = k == num - 1 ? 0 : k;
+      w.push_back(&values[row * stride]);
+      sgd.push_back(&values[row * stride + dim]);
+      grad.push_back(&grads[k * dim]);
+    }
+  }
+
+  size_t stride;
+  std::vector<float> values;
+  std::vector<float> grads;
+  std::vector<float> scales;
+  std::vector<float*> w;
+  std::vector<float*> sgd;
+  std::vector<const float*> grad;
+};
+
+// The batched update matches the one of UpdateValue, up to the rounding of
+// the vectorized sums, for dims with and without a tail out of the vectors.
+TEST(sparse_sgd_rule_batch_test, match_scalar) {
+  for (size_t dim : {1, 8, 37}) {
+    auto rules = BatchRules(dim);
+    for (size_t r = 0; r < rules.size(); ++r) {
+      auto* rule = rules[r].get();
+      const size_t num = 50;
+      BatchRows scalar(rule, num, dim);
+      BatchRows batch(rule, num, dim);
+      for (int step = 0; step < 3; ++step) {
+        for (size_t k = 0; k < num; ++k) {
+          rule->UpdateValue(
+              scalar.w[k], scalar.sgd[k], scalar.grad[k], scalar.scales[k]);
+        }
+        rule->UpdateValueBatch(batch.w.data(),
+                               batch.sgd.data(),
+                               batch.grad.data(),
+                               batch.scales.data(),
+                               num);
+      }
+      for (size_t i = 0; i < scalar.values.size(); ++i) {
+        ASSERT_NEAR(scalar.values[i],
+                    batch.values[i],
+                    1e-5 * std::max(1.0f, std::fabs(scalar.values[i])))
+            << kBatchRuleNames[r] << " dim " << dim << " i " << i;
+      }
+    }
+  }
+}
+
+// Microbenchmark of the batched update against UpdateValue.
+TEST(sparse_sgd_rule_batch_test, benchmark) {
+  const size_t dim = 64;
+  const size_t num = 100000;
+  auto rules = BatchRules(dim);
+  for (size_t r = 0; r < rules.size(); ++r) {
+    auto* rule = rules[r].get();
+    BatchRows rows(rule, num, dim);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < num; ++k) {
+      rule->UpdateValue(rows.w[k], rows.sgd[k], rows.grad[k], rows.scales[k]);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    rule->UpdateValueBatch(rows.w.data(),
+                           rows.sgd.data(),
+                           rows.grad.data(),
+                           rows.scales.data(),
+                           num);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "sparse sgd rule " << kBatchRuleNames[r] << " dim " << dim
+              << ": scalar "
+              << std::chrono::duration<double, std::milli>(mid - start).count()
+              << " ms, batch "
+              << std::chrono::duration<double, std::milli>(end - mid).count()
+              << " ms for " << num << " values" << std::endl;
+  }
+}
 }  // namespace distributed
 }  // namespace paddle
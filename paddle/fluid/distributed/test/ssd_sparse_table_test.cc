@@ -0,0 +1,228 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/ps/table/depends/ssd_cache.h"
+#include "paddle/fluid/distributed/ps/table/table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+PD_DECLARE_string(rocksdb_path);
+PD_DECLARE_int64(pserver_ssd_cache_capacity);
+
+namespace paddle {
+namespace distributed {
+
+const int kEmbedxDim = 8;
+const int kSelectDim = 3 + kEmbedxDim;
+const int kUpdateDim = 4 + kEmbedxDim;
+
+TEST(ClockPolicy, Evict) {
+  ClockPolicy policy;
+  for (uint64_t key = 0; key < 10; ++key) {
+    policy.Touch(key);
+  }
+  // the even keys are hot
+  for (int r = 0; r < 3; ++r) {
+    for (uint64_t key = 0; key < 10; key += 2) {
+      policy.Touch(key);
+    }
+  }
+  std::vector<uint64_t> victims;
+  policy.Evict(5, &victims);
+  ASSERT_EQ(victims.size(), 5UL);
+  for (auto key : victims) {
+    EXPECT_EQ(key % 2, 1UL);
+  }
+  EXPECT_EQ(policy.Size(), 5UL);
+
+  policy.Erase(0);
+  policy.Erase(0);
+  EXPECT_EQ(policy.Size(), 4UL);
+  victims.clear();
+  policy.Evict(10, &victims);
+  EXPECT_EQ(victims.size(), 4UL);
+  EXPECT_EQ(policy.Size(), 0UL);
+}
+
+static Table *CreateSSDTable(const std::string &path, int64_t capacity) {
+  FLAGS_rocksdb_path = path;
+  FLAGS_pserver_ssd_cache_capacity = capacity;
+  TableParameter table_config;
+  table_config.set_table_class("SSDSparseTable");
+  table_config.set_shard_num(10);
+  FsClientParameter fs_config;
+  Table *table = new SSDSparseTable();
+  table->SetShard(0, 1);
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(kEmbedxDim);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+
+  if (table->Initialize(table_config, fs_config) != 0) {
+    delete table;
+    return nullptr;
+  }
+  return table;
+}
+
+static void Pull(Table *table,
+                 const std::vector<uint64_t> &keys,
+                 std::vector<float> *values) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  values->assign(keys.size() * kSelectDim, 0);
+  TableContext context;
+  context.value_type = Sparse;
+  context.pull_context.pull_value = PullSparseValue(keys, fres, kEmbedxDim);
+  context.pull_context.values = values->data();
+  table->Pull(context);
+}
+
+static void Push(Table *table, const std::vector<uint64_t> &keys) {
+  std::vector<float> grads(keys.size() * kUpdateDim);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    for (int j = 0; j < kUpdateDim; ++j) {
+      grads[i * kUpdateDim + j] = 0.01 * (keys[i] % 7 + j);
+    }
+  }
+  TableContext context;
+  context.value_type = Sparse;
+  context.push_context.keys = keys.data();
+  context.push_context.values = grads.data();
+  context.num = keys.size();
+  table->Push(context);
+}
+
+// The values evicted to SSD come back unchanged, with only the capacity in
+// memory.
+TEST(SSDSparseTable, EvictAndReload) {
+  const int64_t capacity = 100;
+  Table *table = CreateSSDTable("./ssd_evict_test_db", capacity);
+  ASSERT_NE(table, nullptr);
+  auto *ssd_table = dynamic_cast<SSDSparseTable *>(table);
+
+  std::vector<uint64_t> keys(1000);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+  }
+  Push(table, keys);
+  const auto &stats = ssd_table->GetCacheStats();
+  EXPECT_LE(ssd_table->LocalSize(), capacity);
+  EXPECT_GT(stats.evicted.load(), 0UL);
+  // only the creation of the keys missed
+  EXPECT_EQ(stats.misses.load(), keys.size());
+
+  std::vector<float> first, second;
+  Pull(table, keys, &first);
+  // half of them go through the prefetch
+  std::vector<uint64_t> prefetch_keys(keys.begin(), keys.begin() + 500);
+  table->Prefetch(prefetch_keys.data(), prefetch_keys.size());
+  Pull(table, keys, &second);
+  ASSERT_EQ(first.size(), second.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    ASSERT_FLOAT_EQ(first[i], second[i]) << "value " << i;
+  }
+  EXPECT_LE(ssd_table->LocalSize(), capacity);
+  EXPECT_GT(stats.ssd_hits.load(), 0UL);
+  EXPECT_EQ(stats.misses.load(), keys.size());
+  VLOG(0) << "SSDSparseTable cache stat: " << stats.ToString();
+  delete table;
+}
+
+// The keys pulled before they exist are not resident, so they take no room
+// in the clock the pushed keys are evicted from.
+TEST(SSDSparseTable, MissedPullsNotTracked) {
+  const int64_t capacity = 100;
+  Table *table = CreateSSDTable("./ssd_missed_pull_test_db", capacity);
+  ASSERT_NE(table, nullptr);
+  auto *ssd_table = dynamic_cast<SSDSparseTable *>(table);
+
+  std::vector<uint64_t> missed_keys(1000), pushed_keys(200);
+  for (size_t i = 0; i < missed_keys.size(); ++i) {
+    missed_keys[i] = 10000 + i;
+  }
+  for (size_t i = 0; i < pushed_keys.size(); ++i) {
+    pushed_keys[i] = i;
+  }
+  std::vector<float> values;
+  Pull(table, missed_keys, &values);
+  EXPECT_EQ(ssd_table->LocalSize(), 0);
+  Push(table, pushed_keys);
+  EXPECT_LE(ssd_table->LocalSize(), capacity);
+  EXPECT_GT(ssd_table->GetCacheStats().evicted.load(), 0UL);
+  delete table;
+}
+
+// Zipf distributed pulls and pushes, reports the hit ratio of the memory
+// tier and the latency of the SSD reads. A benchmark, only run with
+// --gtest_also_run_disabled_tests.
+TEST(SSDSparseTable, DISABLED_ZipfBenchmark) {
+  const int key_num = 20000;
+  const int batch_num = 50;
+  const int batch_size = 2000;
+  Table *table = CreateSSDTable("./ssd_zipf_test_db", key_num / 10);
+  ASSERT_NE(table, nullptr);
+  auto *ssd_table = dynamic_cast<SSDSparseTable *>(table);
+
+  std::vector<double> weights(key_num);
+  for (int i = 0; i < key_num; ++i) {
+    weights[i] = 1.0 / std::pow(i + 1, 1.1);
+  }
+  std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+  std::mt19937 rng(0);
+  std::vector<uint64_t> keys(batch_size);
+  std::vector<float> values;
+  for (int b = 0; b < batch_num; ++b) {
+    for (auto &key : keys) {
+      key = zipf(rng);
+    }
+    table->Prefetch(keys.data(), keys.size());
+    Pull(table, keys, &values);
+    Push(table, keys);
+  }
+  const auto &stats = ssd_table->GetCacheStats();
+  EXPECT_GT(stats.HitRatio(), 0.4);
+  std::cout << "SSDSparseTable zipf benchmark: " << stats.ToString()
+            << std::endl;
+  delete table;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -431,6 +431,10 @@ std::vector<paddle::Tensor> RunBackward(
     (*hook)();
   }
   egr::Controller::Instance().ClearFinalBackwardHooks();
+  // Return the grad node memory beyond the working set of this step
+  if (auto* grad_node_pool = GradNodePool::ThreadLocal()) {
+    grad_node_pool->Release();
+  }
   if (!is_general_grad) return {};
   VLOG(3) << "Finish Backward";
   return GeneralGrad::Instance().GetResults(inputs, allow_unused, create_graph);
@@ -18,6 +18,7 @@
 
 #include "paddle/fluid/eager/api/utils/global_utils.h"
 #include "paddle/fluid/eager/eager_tensor.h"
+#include "paddle/fluid/eager/grad_node_pool.h"
 #include "paddle/fluid/eager/hooks.h"
 #include "paddle/phi/api/all.h"
 #include "paddle/phi/core/distributed/auto_parallel/dist_attr.h"
@@ -135,9 +136,10 @@ class GradSlotMeta {
   }
 
   void SetTensorMeta(const phi::DenseTensorMeta& meta) {
-    meta_ = std::make_shared<phi::DenseTensorMeta>(meta);
+    meta_ = meta;
+    has_meta_ = true;
   }
-  bool HasTensorMeta() const { return meta_ && meta_.get(); }
+  bool HasTensorMeta() const { return has_meta_; }
   const phi::DenseTensorMeta& GetTensorMeta() const {
     if (!HasTensorMeta()) {
       PADDLE_THROW(paddle::platform::errors::Fatal(
@@ -145,7 +147,7 @@ class GradSlotMeta {
           "You're expected to check Edge availability with HasTensorMeta()"
           "before calling GetTensorMeta() interface."));
     }
-    return *meta_.get();
+    return meta_;
   }
 
   void SetPlace(const phi::Place& place) { place_ = place; }
@@ -184,7 +186,10 @@ class GradSlotMeta {
  private:
   bool stop_gradient_{false};
   phi::Place place_;
-  std::shared_ptr<phi::DenseTensorMeta> meta_ = nullptr;
+  // Stored inline rather than behind a shared_ptr, this saves one heap
+  // allocation for every slot of every grad node.
+  bool has_meta_{false};
+  phi::DenseTensorMeta meta_;
   Edge adj_edge_;
   // For dygraph semi-auto parallel
   // Save the dist attr of the forward input Tensor for proper resharding
@@ -201,6 +206,16 @@ class GradNodeBase {
   // TODO(jiabin): Should we have other constructor here?
   virtual ~GradNodeBase() { VLOG(7) << "Destruct GradNodeBase"; }
 
+  /**
+   * Grad nodes are created for every forward op and released after backward,
+   * so their memory is recycled through GradNodePool. Since the destructor is
+   * virtual, the sized delete receives the size of the most derived node.
+   * **/
+  static void* operator new(size_t size) { return GradNodePool::Alloc(size); }
+  static void operator delete(void* ptr, size_t size) {
+    GradNodePool::Free(ptr, size);
+  }
+
   /**
    * operator() designed to contain the real backward execution logic, it should
    * be overridden by derived class defined for each operator. It accepts a
@@ -0,0 +1,141 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/eager/grad_node_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+
+COMMON_DECLARE_bool(eager_grad_node_pool);
+
+namespace egr {
+
+namespace {
+// Trivially destructible, so it is still valid while thread_local objects are
+// destroyed, e.g. when the last grad nodes are released at thread exit.
+thread_local bool tls_pool_destroyed = false;
+
+struct GradNodePoolHolder {
+  GradNodePool pool;
+  ~GradNodePoolHolder() { tls_pool_destroyed = true; }
+};
+}  // namespace
+
+GradNodePool::GradNodePool() {
+  for (size_t cls = 0; cls < kNumSizeClasses; ++cls) {
+    max_cached_[cls] = kDefaultMaxCachedBytes / ClassBytes(cls);
+  }
+}
+
+GradNodePool::~GradNodePool() {
+  for (auto& blocks : free_blocks_) {
+    for (void* block : blocks) {
+      ::operator delete(block);
+    }
+    blocks.clear();
+  }
+}
+
+GradNodePool* GradNodePool::ThreadLocal() {
+  if (!FLAGS_eager_grad_node_pool || tls_pool_destroyed) {
+    return nullptr;
+  }
+  static thread_local GradNodePoolHolder holder;
+  return &holder.pool;
+}
+
+void* GradNodePool::Alloc(size_t size) {
+  GradNodePool* pool = ThreadLocal();
+  if (pool) {
+    return pool->Allocate(size);
+  }
+  // The pool may be enabled before the node is freed, which then caches the
+  // block in its size class, so the block takes the whole size class.
+  return ::operator new(PooledBytes(size));
+}
+
+void GradNodePool::Free(void* ptr, size_t size) {
+  if (ptr == nullptr) return;
+  GradNodePool* pool = ThreadLocal();
+  if (pool) {
+    pool->Deallocate(ptr, size);
+  } else {
+    ::operator delete(ptr);
+  }
+}
+
+void* GradNodePool::Allocate(size_t size) {
+  if (size == 0 || size > kMaxPooledSize) {
+    return ::operator new(size);
+  }
+  size_t cls = SizeClass(size);
+  ++in_use_[cls];
+  peak_in_use_[cls] = std::max(peak_in_use_[cls], in_use_[cls]);
+  auto& blocks = free_blocks_[cls];
+  if (!blocks.empty()) {
+    void* block = blocks.back();
+    blocks.pop_back();
+    return block;
+  }
+  // Always allocate the whole size class, so that the block can be reused by
+  // any node of the same class wherever it is released.
+  return ::operator new(PooledBytes(size));
+}
+
+void GradNodePool::Deallocate(void* ptr, size_t size) {
+  if (size == 0 || size > kMaxPooledSize) {
+    ::operator delete(ptr);
+    return;
+  }
+  size_t cls = SizeClass(size);
+  // The block may come from another thread, so in_use_ can not go below zero
+  // on a consumer thread.
+  in_use_[cls] = std::max<int64_t>(in_use_[cls] - 1, 0);
+  auto& blocks = free_blocks_[cls];
+  if (blocks.size() < max_cached_[cls]) {
+    blocks.push_back(ptr);
+  } else {
+    ::operator delete(ptr);
+  }
+}
+
+void GradNodePool::Release() {
+  size_t released_bytes = 0;
+  for (size_t cls = 0; cls < kNumSizeClasses; ++cls) {
+    auto& blocks = free_blocks_[cls];
+    max_cached_[cls] = static_cast<size_t>(peak_in_use_[cls]);
+    while (blocks.size() > max_cached_[cls]) {
+      ::operator delete(blocks.back());
+      blocks.pop_back();
+      released_bytes += ClassBytes(cls);
+    }
+    peak_in_use_[cls] = in_use_[cls];
+  }
+  VLOG(6) << "GradNodePool released " << released_bytes << " bytes, "
+          << CachedBytes() << " bytes are still cached.";
+}
+
+size_t GradNodePool::CachedBytes() const {
+  size_t bytes = 0;
+  for (size_t cls = 0; cls < kNumSizeClasses; ++cls) {
+    bytes += free_blocks_[cls].size() * ClassBytes(cls);
+  }
+  return bytes;
+}
+
+}  // namespace egr
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "paddle/utils/test_macros.h"
+
+namespace egr {
+
+/**
+ * GradNodePool caches the memory of released grad nodes, so that the grad
+ * nodes created by the forward pass of the next step can reuse it instead of
+ * going back to malloc.
+ *
+ * Blocks are grouped into size classes of kGradNodePoolAlignment bytes. Every
+ * block is an independent allocation, hence a block allocated on one thread
+ * may safely be released on another one; it simply joins the free list of the
+ * releasing thread.
+ *
+ * A block of a pooled size takes its whole size class even when allocated
+ * with the pool disabled, as FLAGS_eager_grad_node_pool may be enabled
+ * before it is freed into a pool.
+ *
+ * Release() is called after each RunBackward. It trims every size class to
+ * the peak number of blocks used since the last call, which is the working set
+ * of one training step, and returns the rest to the system in bulk. Until the
+ * first call, e.g. on a thread only freeing the nodes of another one, a size
+ * class caches at most kDefaultMaxCachedBytes.
+ *
+ * NOTE: TensorWrappers are held by value in the generated grad nodes, so they
+ * are allocated together with the node.
+ **/
+class GradNodePool {
+ public:
+  static constexpr size_t kGradNodePoolAlignment = 64;
+  static constexpr size_t kMaxPooledSize = 4096;
+  static constexpr size_t kNumSizeClasses =
+      kMaxPooledSize / kGradNodePoolAlignment;
+  static constexpr size_t kDefaultMaxCachedBytes = 64 * 1024;
+
+  GradNodePool();
+  ~GradNodePool();
+
+  GradNodePool(const GradNodePool&) = delete;
+  GradNodePool& operator=(const GradNodePool&) = delete;
+
+  // Return the pool of the calling thread, nullptr if the pool is disabled by
+  // FLAGS_eager_grad_node_pool or the thread is being destroyed.
+  TEST_API static GradNodePool* ThreadLocal();
+
+  // Allocate/free through the pool of the calling thread, fallback to the
+  // global operator new/delete if there is no pool available.
+  TEST_API static void* Alloc(size_t size);
+  TEST_API static void Free(void* ptr, size_t size);
+
+  TEST_API void* Allocate(size_t size);
+  TEST_API void Deallocate(void* ptr, size_t size);
+
+  // Trim the cached blocks to the working set of the last step.
+  TEST_API void Release();
+
+  TEST_API size_t CachedBytes() const;
+
+ private:
+  static size_t SizeClass(size_t size) {
+    return (size + kGradNodePoolAlignment - 1) / kGradNodePoolAlignment - 1;
+  }
+  static size_t ClassBytes(size_t cls) {
+    return (cls + 1) * kGradNodePoolAlignment;
+  }
+  // The bytes of a block of size, whether allocated by a pool or not.
+  static size_t PooledBytes(size_t size) {
+    return size == 0 || size > kMaxPooledSize ? size
+                                              : ClassBytes(SizeClass(size));
+  }
+
+  std::array<std::vector<void*>, kNumSizeClasses> free_blocks_;
+  // Number of blocks handed out and not yet returned to this pool
+  std::array<int64_t, kNumSizeClasses> in_use_{};
+  // Peak of in_use_ since the last Release()
+  std::array<int64_t, kNumSizeClasses> peak_in_use_{};
+  // Upper bound of free_blocks_, decided by the last Release() or
+  // kDefaultMaxCachedBytes before the first one
+  std::array<size_t, kNumSizeClasses> max_cached_{};
+};
+
+}  // namespace egr
@@ -0,0 +1,317 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <new>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/workqueue/event_count.h"
+
+namespace paddle {
+namespace framework {
+
+/**
+ * BoundedMPMCQueue is a lock-free bounded multi-producer/multi-consumer ring.
+ *
+ * The i-th pushed element goes to cell i % capacity on turn i / capacity.
+ * A cell is free for the producers of turn t when its sequence is 2 * t and
+ * holds an element for the consumers of turn t when it is 2 * t + 1, so a
+ * producer (consumer) claims cells by advancing head_ (tail_) with a CAS once
+ * it sees them free (full). Batched operations claim a run of consecutive
+ * cells with a single CAS.
+ *
+ * The Try* methods never block. Push/Pop block on an EventCount when the queue
+ * is full/empty, which costs nothing on the fast path but one fence when
+ * there is no waiter. Close() wakes up all the waiters: producers fail from
+ * then on, and consumers fail once the remaining elements are drained.
+ **/
+template <typename T>
+class BoundedMPMCQueue {
+ public:
+  // Threads blocked at the same time on each side beyond this number spin
+  // with yield instead of sleeping on the EventCount.
+  static constexpr size_t kMaxWaiters = 64;
+
+  explicit BoundedMPMCQueue(size_t capacity)
+      : capacity_(std::max<size_t>(capacity, 1)),
+        cells_(new Cell[capacity_]),
+        not_empty_(kMaxWaiters),
+        not_full_(kMaxWaiters) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(Turn(i) * 2, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
+  BoundedMPMCQueue& operator=(const BoundedMPMCQueue&) = delete;
+
+  ~BoundedMPMCQueue() {
+    const size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    for (size_t pos = tail; pos < head; ++pos) {
+      Cell& cell = cells_[pos % capacity_];
+      if (cell.sequence.load(std::memory_order_acquire) == Turn(pos) * 2 + 1) {
+        cell.Data()->~T();
+      }
+    }
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+  // Only a snapshot if other threads are pushing or popping.
+  size_t Size() const {
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t head = head_.load(std::memory_order_acquire);
+    return head > tail ? std::min(head - tail, capacity_) : 0;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  bool Closed() const { return closed_.load(std::memory_order_acquire); }
+
+  void Close() {
+    closed_.store(true, std::memory_order_release);
+    not_empty_.Notify(true);
+    not_full_.Notify(true);
+  }
+
+  void Open() { closed_.store(false, std::memory_order_release); }
+
+  // Drop all the elements, returns the number of dropped elements.
+  size_t Clear() {
+    size_t cleared = 0;
+    T elem;
+    while (TryPop(&elem)) {
+      ++cleared;
+    }
+    return cleared;
+  }
+
+  bool TryPush(T&& elem) { return TryPushN(&elem, 1) == 1; }
+
+  bool TryPush(const T& elem) {
+    T copy(elem);
+    return TryPush(std::move(copy));
+  }
+
+  bool TryPop(T* elem) { return TryPopN(elem, 1) == 1; }
+
+  // Copy the oldest element without popping it, returns false if the queue is
+  // empty. It is only safe when no other thread pops at the same time.
+  bool TryPeek(T* elem) const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (CountReady(tail, 1, 1) == 0) return false;
+    *elem = *cells_[tail % capacity_].Data();
+    return true;
+  }
+
+  // Move up to n elements of items into the queue without blocking, returns
+  // the number of moved elements, which are items[0, ret).
+  size_t TryPushN(T* items, size_t n) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t m = 0;
+    for (;;) {
+      m = CountReady(head, n, 0);
+      if (m == 0) return 0;
+      if (head_.compare_exchange_weak(
+              head, head + m, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < m; ++i) {
+      Cell& cell = cells_[(head + i) % capacity_];
+      new (cell.Data()) T(std::move(items[i]));
+      cell.sequence.store(Turn(head + i) * 2 + 1, std::memory_order_release);
+    }
+    not_empty_.Notify(m > 1);
+    return m;
+  }
+
+  // Move up to n elements out of the queue without blocking, returns the
+  // number of elements written to out.
+  size_t TryPopN(T* out, size_t n) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t m = 0;
+    for (;;) {
+      m = CountReady(tail, n, 1);
+      if (m == 0) return 0;
+      if (tail_.compare_exchange_weak(
+              tail, tail + m, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < m; ++i) {
+      Cell& cell = cells_[(tail + i) % capacity_];
+      T* data = cell.Data();
+      out[i] = std::move(*data);
+      data->~T();
+      cell.sequence.store(Turn(tail + i) * 2 + 2, std::memory_order_release);
+    }
+    not_full_.Notify(m > 1);
+    return m;
+  }
+
+  // Blocking push, returns false if the queue is closed.
+  bool Push(T&& elem) { return PushN(&elem, 1) == 1; }
+
+  bool Push(const T& elem) {
+    T copy(elem);
+    return Push(std::move(copy));
+  }
+
+  // Blocking pop, returns false if the queue is closed and empty.
+  bool Pop(T* elem) { return PopN(elem, 1) == 1; }
+
+  // Move all n items into the queue, blocking while it is full. Returns less
+  // than n only if the queue is closed.
+  size_t PushN(T* items, size_t n) {
+    size_t finished = 0;
+    while (finished < n) {
+      if (Closed()) break;
+      size_t m = TryPushN(items + finished, n - finished);
+      if (m > 0) {
+        finished += m;
+        continue;
+      }
+      Wait(&not_full_, &full_waiters_, [this] {
+        return Closed() || CountReady(head_.load(), 1, 0) > 0;
+      });
+    }
+    return finished;
+  }
+
+  // Pop n elements, blocking while the queue is empty. Returns less than n
+  // only if the queue is closed and drained, or if once is set and at least
+  // one element has been popped.
+  size_t PopN(T* out, size_t n, bool once = false) {
+    size_t finished = 0;
+    while (finished < n) {
+      size_t m = TryPopN(out + finished, n - finished);
+      if (m > 0) {
+        finished += m;
+        if (once) break;
+        continue;
+      }
+      if (Closed()) {
+        // Elements pushed before Close() may still be in flight.
+        m = TryPopN(out + finished, n - finished);
+        if (m == 0) {
+          if (Size() == 0) break;
+          std::this_thread::yield();
+          continue;
+        }
+        finished += m;
+        if (once) break;
+        continue;
+      }
+      Wait(&not_empty_, &empty_waiters_, [this] {
+        return Closed() || CountReady(tail_.load(), 1, 1) > 0;
+      });
+    }
+    return finished;
+  }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<size_t> sequence{0};
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* Data() { return reinterpret_cast<T*>(&storage); }
+    const T* Data() const { return reinterpret_cast<const T*>(&storage); }
+  };
+
+  // EventCount needs a distinct waiter per blocked thread, slots are only
+  // taken on the slow path so a mutex is fine here.
+  class WaiterSlots {
+   public:
+    WaiterSlots() {
+      for (size_t i = 0; i < kMaxWaiters; ++i) {
+        free_.push_back(kMaxWaiters - 1 - i);
+      }
+    }
+
+    bool Acquire(size_t* slot) {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (free_.empty()) return false;
+      *slot = free_.back();
+      free_.pop_back();
+      return true;
+    }
+
+    void Release(size_t slot) {
+      std::lock_guard<std::mutex> lock(mu_);
+      free_.push_back(slot);
+    }
+
+   private:
+    std::mutex mu_;
+    std::vector<size_t> free_;
+  };
+
+  size_t Turn(size_t pos) const { return pos / capacity_; }
+
+  // Number of the consecutive cells from pos, at most n, which are ready for
+  // the producers (full = 0) or for the consumers (full = 1) of their turn.
+  size_t CountReady(size_t pos, size_t n, size_t full) const {
+    n = std::min(n, capacity_);
+    size_t m = 0;
+    while (m < n) {
+      const Cell& cell = cells_[(pos + m) % capacity_];
+      if (cell.sequence.load(std::memory_order_acquire) !=
+          Turn(pos + m) * 2 + full) {
+        break;
+      }
+      ++m;
+    }
+    return m;
+  }
+
+  template <typename Predicate>
+  void Wait(EventCount* ec, WaiterSlots* slots, Predicate ready) {
+    size_t slot = 0;
+    if (!slots->Acquire(&slot)) {
+      std::this_thread::yield();
+      return;
+    }
+    ec->Prewait();
+    if (ready()) {
+      ec->CancelWait();
+    } else {
+      ec->CommitWait(ec->GetWaiter(slot));
+    }
+    slots->Release(slot);
+  }
+
+  const size_t capacity_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) std::atomic<bool> closed_{false};
+
+  EventCount not_empty_;
+  EventCount not_full_;
+  WaiterSlots empty_waiters_;
+  WaiterSlots full_waiters_;
+};
+
+}  // namespace framework
+}  // namespace paddle
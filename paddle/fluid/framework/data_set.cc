@@ -22,6 +22,7 @@
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/framework/parallel_shuffle.h"
 #include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
@@ -46,6 +47,12 @@ COMMON_DECLARE_bool(query_dest_rank_by_multi_node);
 namespace paddle {
 namespace framework {
 
+// Shuffles run between passes while the readers are idle, so they may use
+// all the cores.
+static int GetShuffleThreadNum() {
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
 // constructor
 template <typename T>
 DatasetImpl<T>::DatasetImpl() {
@@ -696,7 +703,8 @@ void DatasetImpl<T>::LocalShuffle() {
   input_channel_->Close();
   std::vector<T> data;
   input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
+  ParallelShuffle(
+      &data, &fleet_ptr->LocalRandomEngine(), GetShuffleThreadNum());
   input_channel_->Open();
   input_channel_->Write(std::move(data));
   data.clear();
@@ -844,7 +852,8 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
   input_channel_->Close();
   std::vector<Record> data;
   input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
+  ParallelShuffle(
+      &data, &fleet_ptr->LocalRandomEngine(), GetShuffleThreadNum());
   input_channel_->Open();
   input_channel_->Write(std::move(data));
   data.clear();
@@ -875,14 +884,20 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
 #endif
     // auto fleet_ptr = framework::FleetWrapper::GetInstance();
     std::vector<Record> data;
+    // The archives are kept from batch to batch, so after the first batch
+    // their buffers are already large enough and serializing never grows
+    // them.
+    std::vector<paddle::framework::BinaryArchive> ars(this->trainer_num_);
+    std::vector<int> send_index(this->trainer_num_);
     while (this->input_channel_->Read(data)) {
-      std::vector<paddle::framework::BinaryArchive> ars(this->trainer_num_);
+      for (auto& ar : ars) {
+        ar.Clear();
+      }
       for (auto& t : data) {
         auto client_id = get_client_id(t);
         ars[client_id] << t;
       }
       std::vector<std::future<int32_t>> total_status;
-      std::vector<int> send_index(this->trainer_num_);
       for (int i = 0; i < this->trainer_num_; ++i) {
         send_index[i] = i;
       }
@@ -898,12 +913,11 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
         total_status.push_back(std::move(ret));
       }
       for (auto& t : total_status) {
-        t.wait();
+        if (t.valid()) {
+          t.wait();
+        }
       }
-      ars.clear();
-      ars.shrink_to_fit();
       data.clear();
-      data.shrink_to_fit();
       // currently we find bottleneck is server not able to handle large data
       // in time, so we can remove this sleep and set fleet_send_batch_size to
       // 1024, and set server thread to 24.
@@ -1318,9 +1332,9 @@ void MultiSlotDataset::PostprocessInstance() {
   // divide pv instance, and merge to input_channel_
   if (enable_pv_merge_) {
     auto fleet_ptr = framework::FleetWrapper::GetInstance();
-    std::shuffle(input_records_.begin(),
-                 input_records_.end(),
-                 fleet_ptr->LocalRandomEngine());
+    ParallelShuffle(&input_records_,
+                    &fleet_ptr->LocalRandomEngine(),
+                    GetShuffleThreadNum());
     input_channel_->Open();
     input_channel_->Write(std::move(input_records_));
     for (auto& pv_consume : multi_pv_consume_) {
@@ -1394,8 +1408,8 @@ void MultiSlotDataset::PreprocessInstance() {
       }
     }
 
-    std::shuffle(
-        pv_data.begin(), pv_data.end(), fleet_ptr->LocalRandomEngine());
+    ParallelShuffle(
+        &pv_data, &fleet_ptr->LocalRandomEngine(), GetShuffleThreadNum());
     input_pv_channel_->Open();
     input_pv_channel_->Write(std::move(pv_data));
 
@@ -0,0 +1,976 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/file_reader.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <zlib.h>
+#ifdef PADDLE_WITH_SNAPPY
+#include <snappy.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/enforce.h"
+
+COMMON_DECLARE_int32(fs_read_ahead_size);
+COMMON_DECLARE_bool(fs_read_direct_io);
+COMMON_DECLARE_int32(fs_decompress_num_threads);
+
+namespace paddle {
+namespace framework {
+
+ReadStreamOptions DefaultReadStreamOptions() {
+  ReadStreamOptions options;
+  if (FLAGS_fs_read_ahead_size > 0) {
+    options.block_size =
+        std::max<size_t>(FLAGS_fs_read_ahead_size / options.num_blocks, 1);
+  }
+  options.direct_io = FLAGS_fs_read_direct_io;
+  return options;
+}
+
+#ifdef __linux__
+
+static bool EndsWith(const std::string& path, const std::string& suffix) {
+  return path.size() >= suffix.size() &&
+         path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool IsSnappyPath(const std::string& path) {
+  return EndsWith(path, ".sz") || EndsWith(path, ".snappy");
+}
+
+bool ReadStreamSupports(const std::string& path) {
+#ifdef PADDLE_WITH_SNAPPY
+  return true;
+#else
+  return !IsSnappyPath(path);
+#endif
+}
+
+// Read exactly n bytes unless the stream ends, returns the bytes read.
+static size_t ReadFull(ReadStream* stream, char* buf, size_t n) {
+  size_t total = 0;
+  while (total < n) {
+    size_t m = stream->Read(buf + total, n - total);
+    if (m == 0) {
+      break;
+    }
+    total += m;
+  }
+  return total;
+}
+
+static uint32_t LoadLE16(const char* p) {
+  auto u = reinterpret_cast<const unsigned char*>(p);
+  return u[0] | (u[1] << 8);
+}
+
+static uint32_t LoadLE32(const char* p) {
+  auto u = reinterpret_cast<const unsigned char*>(p);
+  return u[0] | (u[1] << 8) | (u[2] << 16) |
+         (static_cast<uint32_t>(u[3]) << 24);
+}
+
+// Reads a local file ahead of the consumer in aligned blocks on a background
+// thread, which also does the blocking syscalls. A regular file smaller than
+// a block is read into a single block of its size by the consumer instead.
+class LocalFileStream : public ReadStream {
+ public:
+  static constexpr size_t kAlignment = 4096;
+
+  LocalFileStream(const std::string& path, const ReadStreamOptions& options)
+      : path_(path) {
+    int flags = O_RDONLY | O_CLOEXEC;
+    if (options.direct_io) {
+      fd_ = open(path.c_str(), flags | O_DIRECT);
+      if (fd_ >= 0) {
+        direct_io_ = true;
+      } else {
+        VLOG(3) << "Failed to open " << path
+                << " with O_DIRECT, fall back to buffered IO";
+      }
+    }
+    if (fd_ < 0) {
+      fd_ = open(path.c_str(), flags);
+    }
+    PADDLE_ENFORCE_GE(fd_,
+                      0,
+                      platform::errors::NotFound("Failed to open file %s: %s",
+                                                 path,
+                                                 strerror(errno)));
+    if (!direct_io_) {
+      posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    size_t block_size = std::max(options.block_size, kAlignment);
+    size_t num_blocks = std::max<size_t>(options.num_blocks, 2);
+    bool read_ahead = true;
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) &&
+        static_cast<size_t>(st.st_size) < block_size) {
+      // One more byte to reach the end of the file in the same block.
+      block_size = static_cast<size_t>(st.st_size) + 1;
+      num_blocks = 1;
+      read_ahead = false;
+    }
+    block_size_ = (block_size + kAlignment - 1) / kAlignment * kAlignment;
+    blocks_.resize(num_blocks);
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      void* data = nullptr;
+      PADDLE_ENFORCE_EQ(
+          posix_memalign(&data, kAlignment, block_size_),
+          0,
+          platform::errors::ResourceExhausted(
+              "Failed to allocate %d bytes of read-ahead buffer.",
+              block_size_));
+      blocks_[i].data = static_cast<char*>(data);
+      free_.push_back(i);
+    }
+    if (read_ahead) {
+      thread_ = std::thread([this] { ReadLoop(); });
+    }
+  }
+
+  ~LocalFileStream() override {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      cv_.notify_all();
+      thread_.join();
+    }
+    close(fd_);
+    for (auto& block : blocks_) {
+      free(block.data);
+    }
+  }
+
+  size_t Read(char* buf, size_t n) override {
+    size_t total = 0;
+    while (total < n) {
+      if (current_ == kNoBlock || offset_ == blocks_[current_].size) {
+        if (!NextBlock()) {
+          break;
+        }
+        continue;
+      }
+      const Block& block = blocks_[current_];
+      size_t m = std::min(n - total, block.size - offset_);
+      memcpy(buf + total, block.data + offset_, m);
+      offset_ += m;
+      total += m;
+    }
+    return total;
+  }
+
+ private:
+  static constexpr size_t kNoBlock = static_cast<size_t>(-1);
+
+  struct Block {
+    char* data{nullptr};
+    size_t size{0};
+  };
+
+  bool NextBlock() {
+    if (!thread_.joinable()) {
+      return ReadBlockInPlace();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (current_ != kNoBlock) {
+      free_.push_back(current_);
+      current_ = kNoBlock;
+      cv_.notify_all();
+    }
+    cv_.wait(lock, [this] { return !ready_.empty() || end_; });
+    if (ready_.empty()) {
+      PADDLE_ENFORCE_EQ(
+          error_.empty(),
+          true,
+          platform::errors::External(
+              "Failed to read file %s: %s", path_, error_));
+      return false;
+    }
+    current_ = ready_.front();
+    ready_.pop_front();
+    offset_ = 0;
+    return true;
+  }
+
+  void ReadLoop() {
+    for (;;) {
+      size_t index = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !free_.empty(); });
+        if (stop_) {
+          return;
+        }
+        index = free_.front();
+        free_.pop_front();
+      }
+
+      std::string error;
+      bool end = ReadBlock(&blocks_[index], &error);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(index);
+        if (end || !error.empty()) {
+          end_ = true;
+          error_ = error;
+        }
+      }
+      cv_.notify_all();
+      if (end || !error.empty()) {
+        return;
+      }
+    }
+  }
+
+  // Fill block from the file, returns whether the end of the file is
+  // reached. Sets error and stops on failures.
+  bool ReadBlock(Block* block, std::string* error) {
+    block->size = 0;
+    while (block->size < block_size_) {
+      ssize_t ret =
+          read(fd_, block->data + block->size, block_size_ - block->size);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        *error = strerror(errno);
+        return false;
+      }
+      if (ret == 0) {
+        return true;
+      }
+      block->size += ret;
+      // An unaligned O_DIRECT read can only be the tail of the file, and
+      // the next read from the unaligned offset would fail.
+      if (direct_io_ && ret % kAlignment != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Without the read-ahead thread the only block is refilled by the
+  // consumer, in case the file grew since it was opened.
+  bool ReadBlockInPlace() {
+    if (end_) {
+      return false;
+    }
+    std::string error;
+    end_ = ReadBlock(&blocks_[0], &error);
+    PADDLE_ENFORCE_EQ(
+        error.empty(),
+        true,
+        platform::errors::External(
+            "Failed to read file %s: %s", path_, error));
+    current_ = 0;
+    offset_ = 0;
+    return blocks_[0].size > 0;
+  }
+
+  std::string path_;
+  int fd_{-1};
+  bool direct_io_{false};
+  size_t block_size_{0};
+  std::vector<Block> blocks_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<size_t> free_;
+  std::deque<size_t> ready_;
+  bool end_{false};
+  bool stop_{false};
+  std::string error_;
+  std::thread thread_;
+
+  // Only accessed by the consumer.
+  size_t current_{kNoBlock};
+  size_t offset_{0};
+};
+
+// Serves some bytes already read from src before the rest of src.
+class PeekedStream : public ReadStream {
+ public:
+  PeekedStream(std::string head, std::unique_ptr<ReadStream> src)
+      : head_(std::move(head)), src_(std::move(src)) {}
+
+  size_t Read(char* buf, size_t n) override {
+    if (offset_ < head_.size()) {
+      size_t m = std::min(n, head_.size() - offset_);
+      memcpy(buf, head_.data() + offset_, m);
+      offset_ += m;
+      return m;
+    }
+    return src_->Read(buf, n);
+  }
+
+ private:
+  std::string head_;
+  size_t offset_{0};
+  std::unique_ptr<ReadStream> src_;
+};
+
+// Streaming inflate of a gzip file, members are decompressed one after
+// another like zcat does. Like zcat, the bytes after the last member which do
+// not make a gzip member, e.g. the zeros padding a tape block, are ignored.
+class GzipStream : public ReadStream {
+ public:
+  GzipStream(const std::string& path, std::unique_ptr<ReadStream> src)
+      : path_(path), src_(std::move(src)), in_(kInputSize) {
+    memset(&strm_, 0, sizeof(strm_));
+    // 32 enables the detection of the gzip header.
+    PADDLE_ENFORCE_EQ(inflateInit2(&strm_, 15 + 32),
+                      Z_OK,
+                      platform::errors::Fatal("Failed to initialize zlib."));
+  }
+
+  ~GzipStream() override { inflateEnd(&strm_); }
+
+  size_t Read(char* buf, size_t n) override {
+    strm_.next_out = reinterpret_cast<Bytef*>(buf);
+    strm_.avail_out = static_cast<uInt>(std::min<size_t>(n, UINT32_MAX));
+    const uInt avail_out = strm_.avail_out;
+    while (strm_.avail_out == avail_out && !end_) {
+      if (strm_.avail_in == 0) {
+        size_t m = src_->Read(in_.data(), in_.size());
+        if (m == 0) {
+          PADDLE_ENFORCE_EQ(member_end_ || InTrailer(),
+                            true,
+                            platform::errors::InvalidArgument(
+                                "Unexpected end of gzip file %s.", path_));
+          end_ = true;
+          break;
+        }
+        strm_.next_in = reinterpret_cast<Bytef*>(in_.data());
+        strm_.avail_in = static_cast<uInt>(m);
+      }
+      if (member_end_) {
+        inflateReset(&strm_);
+        member_end_ = false;
+        first_member_ = false;
+      }
+      int ret = inflate(&strm_, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END) {
+        member_end_ = true;
+      } else if (ret == Z_DATA_ERROR && InTrailer()) {
+        LOG(WARNING) << "Ignore the trailing garbage of gzip file " << path_;
+        end_ = true;
+      } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        PADDLE_THROW(platform::errors::InvalidArgument(
+            "Failed to decompress gzip file %s: %s",
+            path_,
+            strm_.msg != nullptr ? strm_.msg : "unknown error"));
+      }
+    }
+    return avail_out - strm_.avail_out;
+  }
+
+ private:
+  static constexpr size_t kInputSize = 256 << 10;
+
+  // Whether the bytes after the first member have not made any output, i.e.
+  // may be garbage instead of the header of a member.
+  bool InTrailer() const { return !first_member_ && strm_.total_out == 0; }
+
+  std::string path_;
+  std::unique_ptr<ReadStream> src_;
+  std::vector<char> in_;
+  z_stream strm_;
+  bool first_member_{true};
+  bool member_end_{false};
+  bool end_{false};
+};
+
+static ThreadPool* DecompressThreadPool() {
+  static std::unique_ptr<ThreadPool> pool(
+      FLAGS_fs_decompress_num_threads > 0
+          ? new ThreadPool(FLAGS_fs_decompress_num_threads)
+          : nullptr);
+  return pool.get();
+}
+
+// Decompresses formats made of independent blocks. The input is cut into
+// tasks of whole blocks, which are decoded on the shared thread pool while
+// the consumer reads the output of the previous tasks in order.
+class ParallelDecodeStream : public ReadStream {
+ public:
+  using DecodeFn = void (*)(const std::string& path,
+                            const std::string& in,
+                            std::string* out);
+
+  ParallelDecodeStream(const std::string& path,
+                       std::unique_ptr<ReadStream> src,
+                       DecodeFn decode,
+                       bool parallel)
+      : path_(path),
+        src_(std::move(src)),
+        decode_(decode),
+        pool_(parallel ? DecompressThreadPool() : nullptr),
+        max_pending_(pool_ != nullptr ? 2 * FLAGS_fs_decompress_num_threads
+                                      : 1) {}
+
+  ~ParallelDecodeStream() override {
+    for (auto& task : pending_) {
+      if (task->done.valid()) {
+        task->done.wait();
+      }
+    }
+  }
+
+  size_t Read(char* buf, size_t n) override {
+    while (offset_ == out_.size()) {
+      if (!NextOutput()) {
+        return 0;
+      }
+    }
+    size_t m = std::min(n, out_.size() - offset_);
+    memcpy(buf, out_.data() + offset_, m);
+    offset_ += m;
+    return m;
+  }
+
+ protected:
+  // Compressed input of a task, tasks are decoded independently.
+  static constexpr size_t kTaskInputSize = 1 << 20;
+
+  // Read the input of the next task, returns false at the end of src.
+  virtual bool ReadTask(ReadStream* src, std::string* in) = 0;
+
+  const std::string path_;
+
+ private:
+  struct Task {
+    std::string in;
+    std::string out;
+    std::exception_ptr error;
+    std::future<void> done;
+  };
+
+  static void RunTask(DecodeFn decode, const std::string& path, Task* task) {
+    try {
+      decode(path, task->in, &task->out);
+    } catch (...) {
+      task->error = std::current_exception();
+    }
+    std::string().swap(task->in);
+  }
+
+  void Schedule() {
+    while (!input_end_ && pending_.size() < max_pending_) {
+      std::unique_ptr<Task> task(new Task);
+      if (!ReadTask(src_.get(), &task->in)) {
+        input_end_ = true;
+        break;
+      }
+      if (pool_ == nullptr) {
+        RunTask(decode_, path_, task.get());
+      } else {
+        // The destructor waits for the pending tasks, so they can refer to
+        // the stream.
+        Task* raw = task.get();
+        task->done =
+            pool_->Run([this, raw]() { RunTask(decode_, path_, raw); });
+      }
+      pending_.push_back(std::move(task));
+    }
+  }
+
+  bool NextOutput() {
+    Schedule();
+    if (pending_.empty()) {
+      return false;
+    }
+    std::unique_ptr<Task> task = std::move(pending_.front());
+    pending_.pop_front();
+    if (task->done.valid()) {
+      task->done.wait();
+    }
+    if (task->error) {
+      std::rethrow_exception(task->error);
+    }
+    out_ = std::move(task->out);
+    offset_ = 0;
+    Schedule();
+    return true;
+  }
+
+  std::unique_ptr<ReadStream> src_;
+  DecodeFn decode_;
+  ThreadPool* pool_;
+  size_t max_pending_;
+  std::deque<std::unique_ptr<Task>> pending_;
+  bool input_end_{false};
+  std::string out_;
+  size_t offset_{0};
+};
+
+// BGZF, written by bgzip and htslib, is a series of gzip members of at most
+// 64KB, each of them carrying its compressed size in the BC extra field.
+class BgzfStream : public ParallelDecodeStream {
+ public:
+  static constexpr size_t kHeaderSize = 18;
+
+  static bool IsBgzfHeader(const char* h) {
+    auto u = reinterpret_cast<const unsigned char*>(h);
+    return u[0] == 0x1f && u[1] == 0x8b && u[2] == 8 && (u[3] & 4) != 0 &&
+           LoadLE16(h + 10) >= 6 && h[12] == 'B' && h[13] == 'C' &&
+           LoadLE16(h + 14) == 2;
+  }
+
+  BgzfStream(const std::string& path,
+             std::unique_ptr<ReadStream> src,
+             bool parallel)
+      : ParallelDecodeStream(path, std::move(src), &Decode, parallel) {}
+
+ protected:
+  bool ReadTask(ReadStream* src, std::string* in) override {
+    while (in->size() < kTaskInputSize) {
+      size_t start = in->size();
+      in->resize(start + kHeaderSize);
+      size_t m = ReadFull(src, &(*in)[start], kHeaderSize);
+      if (m == 0) {
+        in->resize(start);
+        break;
+      }
+      PADDLE_ENFORCE_EQ(
+          m == kHeaderSize && IsBgzfHeader(&(*in)[start]),
+          true,
+          platform::errors::InvalidArgument(
+              "Invalid BGZF block header in %s, the file is truncated or "
+              "mixes BGZF with plain gzip members.",
+              path_));
+      size_t block_size = LoadLE16(&(*in)[start + 16]) + 1;
+      in->resize(start + block_size);
+      m = ReadFull(src, &(*in)[start + kHeaderSize], block_size - kHeaderSize);
+      PADDLE_ENFORCE_EQ(
+          m,
+          block_size - kHeaderSize,
+          platform::errors::InvalidArgument(
+              "Unexpected end of BGZF file %s.", path_));
+    }
+    return !in->empty();
+  }
+
+ private:
+  static void Decode(const std::string& path,
+                     const std::string& in,
+                     std::string* out) {
+    size_t out_size = 0;
+    for (size_t pos = 0; pos < in.size();
+         pos += LoadLE16(&in[pos + 16]) + 1) {
+      size_t end = pos + LoadLE16(&in[pos + 16]) + 1;
+      out_size += LoadLE32(&in[end - 4]);
+    }
+    out->resize(out_size);
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    PADDLE_ENFORCE_EQ(inflateInit2(&strm, -15),
+                      Z_OK,
+                      platform::errors::Fatal("Failed to initialize zlib."));
+    size_t out_pos = 0;
+    int ret = Z_STREAM_END;
+    bool crc_ok = true;
+    for (size_t pos = 0; pos < in.size() && ret == Z_STREAM_END && crc_ok;) {
+      size_t end = pos + LoadLE16(&in[pos + 16]) + 1;
+      size_t payload = pos + 12 + LoadLE16(&in[pos + 10]);
+      uint32_t isize = LoadLE32(&in[end - 4]);
+      inflateReset(&strm);
+      strm.next_in =
+          reinterpret_cast<Bytef*>(const_cast<char*>(in.data() + payload));
+      strm.avail_in = static_cast<uInt>(end - 8 - payload);
+      strm.next_out = reinterpret_cast<Bytef*>(&(*out)[out_pos]);
+      strm.avail_out = isize;
+      ret = inflate(&strm, Z_FINISH);
+      if (ret == Z_STREAM_END) {
+        crc_ok = strm.avail_out == 0 &&
+                 crc32(0, reinterpret_cast<Bytef*>(&(*out)[out_pos]), isize) ==
+                     LoadLE32(&in[end - 8]);
+      }
+      out_pos += isize;
+      pos = end;
+    }
+    inflateEnd(&strm);
+    PADDLE_ENFORCE_EQ(ret == Z_STREAM_END && crc_ok,
+                      true,
+                      platform::errors::InvalidArgument(
+                          "Failed to decompress BGZF file %s: corrupted "
+                          "block.",
+                          path));
+  }
+};
+
+static std::unique_ptr<ReadStream> OpenGzipStream(
+    const std::string& path,
+    std::unique_ptr<ReadStream> file,
+    const ReadStreamOptions& options) {
+  std::string head(BgzfStream::kHeaderSize, '\0');
+  head.resize(ReadFull(file.get(), &head[0], head.size()));
+  bool bgzf = head.size() == BgzfStream::kHeaderSize &&
+              BgzfStream::IsBgzfHeader(&head[0]);
+  std::unique_ptr<ReadStream> src(
+      new PeekedStream(std::move(head), std::move(file)));
+  if (bgzf) {
+    return std::unique_ptr<ReadStream>(
+        new BgzfStream(path, std::move(src), options.parallel_decompress));
+  }
+  return std::unique_ptr<ReadStream>(new GzipStream(path, std::move(src)));
+}
+
+#ifdef PADDLE_WITH_SNAPPY
+static uint32_t Crc32c(const char* data, size_t n) {
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1;
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+  uint32_t crc = 0xFFFFFFFF;
+  auto u = reinterpret_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < n; ++i) {
+    crc = table[(crc ^ u[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+static uint32_t SnappyMaskedCrc(const char* data, size_t n) {
+  uint32_t crc = Crc32c(data, n);
+  return ((crc >> 15) | (crc << 17)) + 0xa282ead8;
+}
+
+static constexpr size_t kSnappyChunkHeaderSize = 4;
+static constexpr size_t kSnappyMaxChunkSize = 65536;
+static constexpr unsigned char kSnappyCompressedData = 0x00;
+static constexpr unsigned char kSnappyUncompressedData = 0x01;
+static constexpr unsigned char kSnappyStreamIdentifier = 0xff;
+
+// The snappy framing format, written by snzip and python-snappy: a series of
+// chunks of at most 64KB of uncompressed data, each with a masked CRC32-C.
+class SnappyFramedStream : public ParallelDecodeStream {
+ public:
+  SnappyFramedStream(const std::string& path,
+                     std::unique_ptr<ReadStream> src,
+                     bool parallel)
+      : ParallelDecodeStream(path, std::move(src), &Decode, parallel) {}
+
+ protected:
+  bool ReadTask(ReadStream* src, std::string* in) override {
+    while (in->size() < kTaskInputSize) {
+      size_t start = in->size();
+      in->resize(start + kSnappyChunkHeaderSize);
+      size_t m = ReadFull(src, &(*in)[start], kSnappyChunkHeaderSize);
+      if (m == 0) {
+        in->resize(start);
+        break;
+      }
+      PADDLE_ENFORCE_EQ(m,
+                        kSnappyChunkHeaderSize,
+                        platform::errors::InvalidArgument(
+                            "Unexpected end of snappy file %s.", path_));
+      size_t length = LoadLE32(&(*in)[start]) >> 8;
+      in->resize(start + kSnappyChunkHeaderSize + length);
+      m = ReadFull(src, &(*in)[start + kSnappyChunkHeaderSize], length);
+      PADDLE_ENFORCE_EQ(m,
+                        length,
+                        platform::errors::InvalidArgument(
+                            "Unexpected end of snappy file %s.", path_));
+      if (first_chunk_) {
+        auto type = static_cast<unsigned char>((*in)[start]);
+        PADDLE_ENFORCE_EQ(
+            type == kSnappyStreamIdentifier &&
+                in->compare(start + kSnappyChunkHeaderSize,
+                            std::string::npos,
+                            "sNaPpY") == 0,
+            true,
+            platform::errors::InvalidArgument(
+                "%s is not in the snappy framing format.", path_));
+        first_chunk_ = false;
+      }
+    }
+    return !in->empty();
+  }
+
+ private:
+  static void Decode(const std::string& path,
+                     const std::string& in,
+                     std::string* out) {
+    size_t pos = 0;
+    while (pos < in.size()) {
+      auto type = static_cast<unsigned char>(in[pos]);
+      size_t length = LoadLE32(&in[pos]) >> 8;
+      const char* data = in.data() + pos + kSnappyChunkHeaderSize;
+      pos += kSnappyChunkHeaderSize + length;
+      if (type == kSnappyStreamIdentifier || type >= 0x80) {
+        continue;
+      }
+      PADDLE_ENFORCE_EQ(
+          (type == kSnappyCompressedData ||
+           type == kSnappyUncompressedData) &&
+              length >= 4,
+          true,
+          platform::errors::InvalidArgument(
+              "Invalid chunk of type %d in snappy file %s.", type, path));
+      size_t out_pos = out->size();
+      if (type == kSnappyCompressedData) {
+        size_t out_size = 0;
+        PADDLE_ENFORCE_EQ(
+            snappy::GetUncompressedLength(data + 4, length - 4, &out_size),
+            true,
+            platform::errors::InvalidArgument(
+                "Corrupted chunk in snappy file %s.", path));
+        out->resize(out_pos + out_size);
+        PADDLE_ENFORCE_EQ(
+            snappy::RawUncompress(data + 4, length - 4, &(*out)[out_pos]),
+            true,
+            platform::errors::InvalidArgument(
+                "Corrupted chunk in snappy file %s.", path));
+      } else {
+        out->append(data + 4, length - 4);
+      }
+      PADDLE_ENFORCE_EQ(
+          SnappyMaskedCrc(out->data() + out_pos, out->size() - out_pos),
+          LoadLE32(data),
+          platform::errors::InvalidArgument(
+              "Checksum mismatch in snappy file %s.", path));
+    }
+  }
+
+  bool first_chunk_{true};
+};
+
+static void StoreLE32(uint32_t v, char* p) {
+  for (int k = 0; k < 4; ++k) {
+    p[k] = static_cast<char>((v >> (8 * k)) & 0xff);
+  }
+}
+
+// Compresses what is written in chunks of the snappy framing format, the
+// chunks which do not compress are stored as is.
+class SnappyFramedWriter {
+ public:
+  explicit SnappyFramedWriter(std::shared_ptr<FILE> file)
+      : file_(std::move(file)) {
+    pending_.reserve(kSnappyMaxChunkSize);
+    // The stream identifier starts the output of every writer, the reader
+    // skips the ones after the first when files are appended to.
+    WriteFull("\xff\x06\x00\x00sNaPpY", 10);
+  }
+
+  size_t Write(const char* buf, size_t n) {
+    for (size_t pos = 0; pos < n;) {
+      size_t m = std::min(n - pos, kSnappyMaxChunkSize - pending_.size());
+      pending_.append(buf + pos, m);
+      pos += m;
+      if (pending_.size() == kSnappyMaxChunkSize) {
+        Flush();
+      }
+    }
+    return n;
+  }
+
+  void Close() {
+    Flush();
+    PADDLE_ENFORCE_EQ(fflush(file_.get()),
+                      0,
+                      platform::errors::External("Failed to write file: %s",
+                                                 strerror(errno)));
+  }
+
+ private:
+  void Flush() {
+    if (pending_.empty()) {
+      return;
+    }
+    snappy::Compress(pending_.data(), pending_.size(), &compressed_);
+    const bool compressed = compressed_.size() < pending_.size();
+    const std::string& data = compressed ? compressed_ : pending_;
+    char header[kSnappyChunkHeaderSize + 4];
+    StoreLE32(static_cast<uint32_t>(data.size() + 4) << 8 |
+                  (compressed ? kSnappyCompressedData
+                              : kSnappyUncompressedData),
+              header);
+    StoreLE32(SnappyMaskedCrc(pending_.data(), pending_.size()),
+              header + kSnappyChunkHeaderSize);
+    WriteFull(header, sizeof(header));
+    WriteFull(data.data(), data.size());
+    pending_.clear();
+  }
+
+  void WriteFull(const char* data, size_t n) {
+    PADDLE_ENFORCE_EQ(fwrite(data, 1, n, file_.get()),
+                      n,
+                      platform::errors::External("Failed to write file: %s",
+                                                 strerror(errno)));
+  }
+
+  std::shared_ptr<FILE> file_;
+  std::string pending_;
+  std::string compressed_;
+};
+
+static ssize_t SnappyWriterCookieWrite(void* cookie,
+                                       const char* buf,
+                                       size_t size) {
+  try {
+    return static_cast<ssize_t>(
+        static_cast<SnappyFramedWriter*>(cookie)->Write(buf, size));
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    errno = EIO;
+    return 0;
+  }
+}
+
+static int SnappyWriterCookieClose(void* cookie) {
+  auto* writer = static_cast<SnappyFramedWriter*>(cookie);
+  int ret = 0;
+  try {
+    writer->Close();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    errno = EIO;
+    ret = EOF;
+  }
+  delete writer;
+  return ret;
+}
+
+std::shared_ptr<FILE> SnappyWriteFile(std::shared_ptr<FILE> file) {
+  std::unique_ptr<SnappyFramedWriter> writer(
+      new SnappyFramedWriter(std::move(file)));
+  cookie_io_functions_t funcs;
+  funcs.read = nullptr;
+  funcs.write = SnappyWriterCookieWrite;
+  funcs.seek = nullptr;
+  funcs.close = SnappyWriterCookieClose;
+  FILE* fp = fopencookie(writer.get(), "w", funcs);
+  PADDLE_ENFORCE_NOT_NULL(
+      fp,
+      platform::errors::ResourceExhausted("Failed to create FILE of stream."));
+  writer.release();
+  return {fp, [](FILE* fp) { fclose(fp); }};
+}
+#else
+std::shared_ptr<FILE> SnappyWriteFile(std::shared_ptr<FILE> file) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Snappy is not enabled in this build."));
+}
+#endif
+
+std::unique_ptr<ReadStream> OpenReadStream(const std::string& path,
+                                           const ReadStreamOptions& options) {
+  PADDLE_ENFORCE_EQ(ReadStreamSupports(path),
+                    true,
+                    platform::errors::Unimplemented(
+                        "Snappy is not enabled in this build, %s can not be "
+                        "decompressed.",
+                        path));
+  std::unique_ptr<ReadStream> file(new LocalFileStream(path, options));
+  if (EndsWith(path, ".gz")) {
+    return OpenGzipStream(path, std::move(file), options);
+  }
+#ifdef PADDLE_WITH_SNAPPY
+  if (IsSnappyPath(path)) {
+    return std::unique_ptr<ReadStream>(new SnappyFramedStream(
+        path, std::move(file), options.parallel_decompress));
+  }
+#endif
+  return file;
+}
+
+static ssize_t ReadStreamCookieRead(void* cookie, char* buf, size_t size) {
+  try {
+    return static_cast<ssize_t>(
+        static_cast<ReadStream*>(cookie)->Read(buf, size));
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    errno = EIO;
+    return -1;
+  }
+}
+
+static int ReadStreamCookieClose(void* cookie) {
+  delete static_cast<ReadStream*>(cookie);
+  return 0;
+}
+
+std::shared_ptr<FILE> ReadStreamToFile(std::unique_ptr<ReadStream> stream) {
+  cookie_io_functions_t funcs;
+  funcs.read = ReadStreamCookieRead;
+  funcs.write = nullptr;
+  funcs.seek = nullptr;
+  funcs.close = ReadStreamCookieClose;
+  FILE* fp = fopencookie(stream.get(), "r", funcs);
+  PADDLE_ENFORCE_NOT_NULL(
+      fp,
+      platform::errors::ResourceExhausted("Failed to create FILE of stream."));
+  stream.release();
+  return {fp, [](FILE* fp) { fclose(fp); }};
+}
+
+#else
+
+bool IsSnappyPath(const std::string& path) { return false; }
+
+bool ReadStreamSupports(const std::string& path) { return false; }
+
+std::unique_ptr<ReadStream> OpenReadStream(const std::string& path,
+                                           const ReadStreamOptions& options) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "OpenReadStream is only supported on Linux."));
+}
+
+std::shared_ptr<FILE> ReadStreamToFile(std::unique_ptr<ReadStream> stream) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "ReadStreamToFile is only supported on Linux."));
+}
+
+std::shared_ptr<FILE> SnappyWriteFile(std::shared_ptr<FILE> file) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "SnappyWriteFile is only supported on Linux."));
+}
+
+#endif
+
+}  // namespace framework
+}  // namespace paddle
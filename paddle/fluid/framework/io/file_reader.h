@@ -0,0 +1,77 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+
+namespace paddle {
+namespace framework {
+
+// In-process readers of local files, used by localfs_open_read instead of
+// forking a shell pipe per file.
+//
+// A file is read ahead by a background thread in large aligned blocks, and
+// decompressed in the reading thread or, when the format splits into
+// independent blocks (BGZF gzip, snappy framing), on a shared thread pool.
+class ReadStream {
+ public:
+  virtual ~ReadStream() = default;
+
+  // Read at most n bytes into buf, returns 0 only at the end of the stream.
+  // Throws on IO or decompression errors.
+  virtual size_t Read(char* buf, size_t n) = 0;
+};
+
+struct ReadStreamOptions {
+  // Size of each read-ahead block, rounded up to the page size.
+  size_t block_size = 4 << 20;
+  // Number of blocks read ahead of the reading thread.
+  size_t num_blocks = 4;
+  // Read with O_DIRECT, i.e. bypass the page cache. Falls back to buffered
+  // IO if the file system does not support it.
+  bool direct_io = false;
+  // Decompress independent blocks in parallel on the shared thread pool.
+  bool parallel_decompress = true;
+};
+
+// Options from FLAGS_fs_read_ahead_size and FLAGS_fs_read_direct_io.
+ReadStreamOptions DefaultReadStreamOptions();
+
+// Open path for reading, decompressing it according to its suffix: ".gz" is
+// gzip (concatenated members included), ".sz" and ".snappy" are the snappy
+// framing format. Other files are read as is.
+std::unique_ptr<ReadStream> OpenReadStream(const std::string& path,
+                                           const ReadStreamOptions& options);
+
+// Whether OpenReadStream can decompress path in this build.
+bool ReadStreamSupports(const std::string& path);
+
+// Whether path is in the snappy framing format by its suffix.
+bool IsSnappyPath(const std::string& path);
+
+// Wrap stream in a FILE*, which owns the stream. Errors of the stream are
+// logged and reported as EIO by the FILE*.
+std::shared_ptr<FILE> ReadStreamToFile(std::unique_ptr<ReadStream> stream);
+
+// Wrap file in a FILE* which compresses what is written to it into file, in
+// the snappy framing format OpenReadStream decompresses. Throws if snappy is
+// not enabled in this build.
+std::shared_ptr<FILE> SnappyWriteFile(std::shared_ptr<FILE> file);
+
+}  // namespace framework
+}  // namespace paddle
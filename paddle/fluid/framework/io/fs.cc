@@ -19,8 +19,12 @@ limitations under the License. */
 #include <memory>
 
 #include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/io/file_reader.h"
 #include "paddle/fluid/platform/enforce.h"
 
+COMMON_DECLARE_bool(fs_native_reader);
+
 namespace paddle {
 namespace framework {
 
@@ -56,6 +60,21 @@ static void fs_add_write_converter_internal(std::string& path,  // NOLINT
   }
 }
 
+static std::shared_ptr<FILE> fs_set_buffer_internal(std::shared_ptr<FILE> fp,
+                                                    size_t buffer_size) {
+  if (buffer_size > 0) {
+    char* buffer = new char[buffer_size];
+    CHECK_EQ(0, setvbuf(&*fp, buffer, _IOFBF, buffer_size));
+    fp = {&*fp, [fp, buffer](FILE*) mutable {  // NOLINT
+            CHECK(fp.unique());                // NOLINT
+            fp = nullptr;
+            delete[] buffer;
+          }};
+  }
+
+  return fp;
+}
+
 static std::shared_ptr<FILE> fs_open_internal(const std::string& path,
                                               bool is_pipe,
                                               const std::string& mode,
@@ -69,17 +88,7 @@ static std::shared_ptr<FILE> fs_open_internal(const std::string& path,
     fp = shell_popen(path, mode, err_no);
   }
 
-  if (buffer_size > 0) {
-    char* buffer = new char[buffer_size];
-    CHECK_EQ(0, setvbuf(&*fp, buffer, _IOFBF, buffer_size));
-    fp = {&*fp, [fp, buffer](FILE*) mutable {  // NOLINT
-            CHECK(fp.unique());                // NOLINT
-            fp = nullptr;
-            delete[] buffer;
-          }};
-  }
-
-  return fp;
+  return fs_set_buffer_internal(fp, buffer_size);
 }
 
 static bool fs_begin_with_internal(const std::string& path,
@@ -104,8 +113,33 @@ size_t localfs_buffer_size() { return localfs_buffer_size_internal(); }
 
 void localfs_set_buffer_size(size_t x) { localfs_buffer_size_internal() = x; }
 
+// Whether path is read and written in process, which decompresses and
+// compresses it by its suffix.
+static bool localfs_native_internal(const std::string& path,
+                                    const std::string& converter) {
+  // "cat" is the default pipe command of the datasets, it does not convert
+  // anything.
+  return FLAGS_fs_native_reader && ReadStreamSupports(path) &&
+         (converter.empty() || string::trim_spaces(converter) == "cat");
+}
+
+// Snappy files read back by the native reader are written in process, as
+// there is no snappy command to pipe them through.
+static std::shared_ptr<FILE> localfs_open_snappy_write(
+    const std::string& path, const std::string& mode) {
+  return fs_set_buffer_internal(
+      SnappyWriteFile(fs_open_internal(path, false, mode, 0)),
+      localfs_buffer_size());
+}
+
 std::shared_ptr<FILE> localfs_open_read(std::string path,
                                         const std::string& converter) {
+  if (localfs_native_internal(path, converter)) {
+    return fs_set_buffer_internal(
+        ReadStreamToFile(OpenReadStream(path, DefaultReadStreamOptions())),
+        localfs_buffer_size());
+  }
+
   bool is_pipe = false;
 
   if (fs_end_with_internal(path, ".gz")) {
@@ -121,6 +155,10 @@ std::shared_ptr<FILE> localfs_open_write(std::string path,
   shell_execute(
       string::format_string("mkdir -p $(dirname \"%s\")", path.c_str()));
 
+  if (IsSnappyPath(path) && localfs_native_internal(path, converter)) {
+    return localfs_open_snappy_write(path, "w");
+  }
+
   bool is_pipe = false;
 
   if (fs_end_with_internal(path, ".gz")) {
@@ -136,6 +174,10 @@ std::shared_ptr<FILE> localfs_open_append_write(std::string path,
   shell_execute(
       string::format_string("mkdir -p $(dirname \"%s\")", path.c_str()));
 
+  if (IsSnappyPath(path) && localfs_native_internal(path, converter)) {
+    return localfs_open_snappy_write(path, "a");
+  }
+
   bool is_pipe = false;
 
   if (fs_end_with_internal(path, ".gz")) {
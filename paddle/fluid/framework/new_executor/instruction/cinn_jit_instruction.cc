@@ -17,10 +17,15 @@
 #include "paddle/cinn/hlir/dialect/runtime/ir/jit_kernel_op.h"
 #include "paddle/cinn/hlir/dialect/runtime/ir/runtime_dialect.h"
 #include "paddle/cinn/hlir/framework/instruction.h"
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
+#include "paddle/cinn/hlir/framework/pir/shape_specializer.h"
 #include "paddle/cinn/hlir/framework/pir_compiler.h"
 #include "paddle/common/errors.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
 #include "paddle/fluid/framework/new_executor/pir_adaptor/pir_adaptor_util.h"
 #include "paddle/fluid/framework/paddle2cinn/transform_type.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/pir/transforms/pd_op_to_kernel_pass.h"
 #if defined(PADDLE_WITH_CUDA)
 #include "paddle/cinn/runtime/cinn_runtime.h"
 #endif
@@ -125,6 +130,95 @@ class CinnJitInstruction::FnPtrImpl {
   std::vector<cinn_pod_value_t> func_args_;
 };
 
+// Dispatches the runs to the kernels specialized for their shapes, leaving
+// the others to the generic kernel.
+class CinnJitInstruction::ShapeDispatcher {
+  using CINNKernelInfo = cinn::hlir::framework::pir::CINNKernelInfo;
+  using ShapeSpecializer = cinn::hlir::framework::pir::ShapeSpecializer;
+
+ public:
+  explicit ShapeDispatcher(
+      const std::shared_ptr<ShapeSpecializer>& shape_specializer)
+      : dispatcher_(shape_specializer, [](const CINNKernelInfo& kernel_info) {
+          return std::make_unique<FnPtrImpl>(kernel_info);
+        }) {}
+
+  // Returns the kernel specialized for the shape of kernel_args, nullptr if
+  // there is none yet.
+  FnPtrImpl* Dispatch(const std::vector<phi::DenseTensor*>& kernel_args) {
+    shape_.clear();
+    for (const auto& dim : dispatcher_.SymbolDims()) {
+      shape_.push_back(kernel_args[dim.arg_idx]->dims().at(dim.dim_idx));
+    }
+    return dispatcher_.Dispatch(shape_);
+  }
+
+ private:
+  cinn::hlir::framework::pir::ShapeDispatcher<FnPtrImpl> dispatcher_;
+  ShapeSpecializer::Shape shape_;
+};
+
+// Runs the phi kernels of the fallback program of a kernel compiled in the
+// background, in a scope of its own sharing the data of the kernel args.
+class CinnJitInstruction::FallbackImpl {
+  using AsyncKernel = cinn::hlir::framework::pir::AsyncKernel;
+
+ public:
+  FallbackImpl(const AsyncKernel& async_kernel,
+               const platform::Place& place,
+               int32_t input_tensor_size,
+               int32_t output_tensor_size)
+      : kernel_program_(paddle::dialect::PdOpLowerToKernelPass(
+            async_kernel.fallback_program(), place)) {
+    interpreter::ExecutionConfig execution_config;
+    for (int32_t i = 0; i < input_tensor_size; ++i) {
+      input_names_.push_back(AsyncKernel::FallbackInputName(i));
+      execution_config.skip_gc_vars.insert(input_names_.back());
+    }
+    for (int32_t i = 0; i < output_tensor_size; ++i) {
+      output_names_.push_back(AsyncKernel::FallbackOutputName(i));
+      execution_config.skip_gc_vars.insert(output_names_.back());
+    }
+    for (const auto& name : input_names_) {
+      scope_.Var(name)->GetMutable<phi::DenseTensor>();
+    }
+    interpreter_core_ =
+        std::make_unique<InterpreterCore>(place,
+                                          std::vector<std::string>{},
+                                          kernel_program_->block(),
+                                          &scope_,
+                                          execution_config);
+  }
+
+  void Run(const std::vector<phi::DenseTensor*>& kernel_args) {
+    for (size_t i = 0; i < input_names_.size(); ++i) {
+      scope_.FindVar(input_names_[i])
+          ->GetMutable<phi::DenseTensor>()
+          ->ShareDataWith(*kernel_args[i]);
+    }
+    interpreter_core_->Run({}, /*need_fetch=*/false);
+    // The scope variables are skipped by gc, so they are cleared once shared:
+    // the next run then allocates new outputs instead of overwriting the
+    // ones handed out, and the scope holds no reference to the inputs.
+    for (size_t i = 0; i < output_names_.size(); ++i) {
+      auto* out =
+          scope_.FindVar(output_names_[i])->GetMutable<phi::DenseTensor>();
+      kernel_args[input_names_.size() + i]->ShareDataWith(*out);
+      out->clear();
+    }
+    for (const auto& name : input_names_) {
+      scope_.FindVar(name)->GetMutable<phi::DenseTensor>()->clear();
+    }
+  }
+
+ private:
+  std::unique_ptr<::pir::Program> kernel_program_;
+  Scope scope_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+  std::unique_ptr<InterpreterCore> interpreter_core_;
+};
+
 CinnJitInstruction::CinnJitInstruction(
     size_t id,
     const platform::Place& place,
@@ -132,13 +226,23 @@ CinnJitInstruction::CinnJitInstruction(
     const ValueExecutionInfo* value_exec_info)
     : InstructionBase(id, place) {
   auto jit_kernel_op = op->dyn_cast<cinn::dialect::JitKernelOp>();
-  fn_ptr_impl_ = std::make_shared<FnPtrImpl>(jit_kernel_op.cinn_kernel_info());
   op_ = op;
   input_tensor_size = op->num_operands();
   output_tensor_size = op->num_results();
 
   place_ = place;
 
+  const auto& kernel_info = jit_kernel_op.cinn_kernel_info();
+  if (kernel_info.async_kernel) {
+    async_kernel_ = kernel_info.async_kernel;
+    if (async_kernel_->fallback_program()) {
+      fallback_impl_ = std::make_shared<FallbackImpl>(
+          *async_kernel_, place_, input_tensor_size, output_tensor_size);
+    }
+  } else {
+    SetKernelInfo(kernel_info);
+  }
+
   InitInputsOutputsIds(op, *value_exec_info);
 
   for (size_t i = 0; i < op->num_operands(); ++i) {
@@ -177,12 +281,36 @@ CinnJitInstruction::CinnJitInstruction(
   }
 }
 
+void CinnJitInstruction::SetKernelInfo(
+    const cinn::hlir::framework::pir::CINNKernelInfo& kernel_info) {
+  fn_ptr_impl_ = std::make_shared<FnPtrImpl>(kernel_info);
+  shape_dispatcher_ = nullptr;
+  if (kernel_info.shape_specializer) {
+    shape_dispatcher_ =
+        std::make_shared<ShapeDispatcher>(kernel_info.shape_specializer);
+  }
+}
+
 void CinnJitInstruction::Run() {
 #if defined(PADDLE_WITH_CUDA)
   auto gpu_ctx = static_cast<phi::GPUContext*>(dev_ctx_);
 
   auto stream = gpu_ctx->stream();
 
+  // 1. run the phi kernels until the kernel is compiled in the background
+  if (async_kernel_) {
+    if (!async_kernel_->IsReady() && fallback_impl_) {
+      async_kernel_->AddFallbackRun();
+      fallback_impl_->Run(tensor_args_);
+      return;
+    }
+    SetKernelInfo(async_kernel_->Wait());
+    VLOG(1) << "Swap in " << async_kernel_->fn_name() << " after "
+            << async_kernel_->num_fallback_runs() << " fallback runs.";
+    async_kernel_ = nullptr;
+    fallback_impl_ = nullptr;
+  }
+
   if (FLAGS_cinn_bucket_compile && need_update_shape) {
     fn_ptr_impl_->InferShape(
         tensor_args_, input_tensor_size, output_tensor_size);
@@ -191,8 +319,14 @@ void CinnJitInstruction::Run() {
     gpu_ctx->Alloc(tensor_args_[i], tensor_args_[i]->dtype());
   }
 
-  // 2. exexute kernel
-  fn_ptr_impl_->Run(tensor_args_, static_cast<void*>(stream));
+  // 2. exexute kernel, the one specialized for the shapes if compiled
+  FnPtrImpl* fn_ptr_impl = fn_ptr_impl_.get();
+  if (shape_dispatcher_) {
+    if (FnPtrImpl* specialized = shape_dispatcher_->Dispatch(tensor_args_)) {
+      fn_ptr_impl = specialized;
+    }
+  }
+  fn_ptr_impl->Run(tensor_args_, static_cast<void*>(stream));
 #else
   VLOG(0) << "Not Supported: cinn jit instruction currently does not "
              "support non-CUDA kernel";
@@ -21,6 +21,11 @@ namespace pir {
 class Operation;
 }
 
+namespace cinn::hlir::framework::pir {
+class AsyncKernel;
+struct CINNKernelInfo;
+}  // namespace cinn::hlir::framework::pir
+
 namespace paddle {
 namespace framework {
 class Scope;
@@ -42,8 +47,20 @@ class CinnJitInstruction : public InstructionBase {
 
  private:
   class FnPtrImpl;
+  class ShapeDispatcher;
+  class FallbackImpl;
+
+  void SetKernelInfo(
+      const cinn::hlir::framework::pir::CINNKernelInfo& kernel_info);
 
   std::shared_ptr<FnPtrImpl> fn_ptr_impl_{nullptr};
+  // Set if the kernel is specialized for the static shapes it runs with.
+  std::shared_ptr<ShapeDispatcher> shape_dispatcher_{nullptr};
+  // Set until the kernel compiled in the background is swapped in, the runs
+  // meanwhile going to the phi kernels of fallback_impl_ if there is one.
+  std::shared_ptr<cinn::hlir::framework::pir::AsyncKernel> async_kernel_{
+      nullptr};
+  std::shared_ptr<FallbackImpl> fallback_impl_{nullptr};
 
   platform::Place place_;
 
@@ -0,0 +1,164 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// Below this size the threads cost more than they save.
+constexpr size_t kParallelShuffleMinSize = 1 << 16;
+
+// Run fn(tid) for every tid in [0, num_threads), tid 0 on the caller.
+template <typename Fn>
+void RunOnThreads(int num_threads, Fn fn) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int t = 1; t < num_threads; ++t) {
+    threads.emplace_back(fn, t);
+  }
+  fn(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * Fill perm with a uniform random permutation of [0, n) using num_threads
+ * threads.
+ *
+ * Every index is sent to one of the buckets uniformly at random, the buckets
+ * are laid out one after another, then each bucket is shuffled by
+ * Fisher-Yates on its own. Since the buckets of the indices are independent
+ * and the order inside every bucket is uniform, so is the permutation. All
+ * the random numbers derive from engine, the result only depends on the
+ * state of engine and on num_threads.
+ **/
+template <typename IndexT, typename Engine>
+void ParallelRandomPermutation(size_t n,
+                               Engine* engine,
+                               int num_threads,
+                               std::vector<IndexT>* perm) {
+  perm->resize(n);
+  if (num_threads <= 1 || n < kParallelShuffleMinSize) {
+    std::iota(perm->begin(), perm->end(), IndexT(0));
+    std::shuffle(perm->begin(), perm->end(), *engine);
+    return;
+  }
+
+  // A power of two, so that masking the random bits keeps them uniform.
+  size_t num_buckets = 1;
+  while (num_buckets < 4 * static_cast<size_t>(num_threads) &&
+         num_buckets < 256) {
+    num_buckets *= 2;
+  }
+  std::uniform_int_distribution<uint64_t> seed_dist;
+  std::vector<uint64_t> seeds(2 * num_threads);
+  for (auto& seed : seeds) {
+    seed = seed_dist(*engine);
+  }
+
+  const size_t chunk = (n + num_threads - 1) / num_threads;
+  std::vector<uint8_t> bucket_of(n);
+  std::vector<size_t> offsets(num_threads * num_buckets, 0);
+  RunOnThreads(num_threads, [&](int t) {
+    std::mt19937_64 rng(seeds[t]);
+    size_t* count = &offsets[t * num_buckets];
+    const size_t begin = std::min(n, t * chunk);
+    const size_t end = std::min(n, begin + chunk);
+    for (size_t i = begin; i < end; ++i) {
+      uint8_t b = static_cast<uint8_t>(rng() & (num_buckets - 1));
+      bucket_of[i] = b;
+      ++count[b];
+    }
+  });
+
+  // Bucket b of thread t goes after bucket b of the previous threads.
+  std::vector<size_t> bucket_begin(num_buckets + 1);
+  size_t offset = 0;
+  for (size_t b = 0; b < num_buckets; ++b) {
+    bucket_begin[b] = offset;
+    for (int t = 0; t < num_threads; ++t) {
+      size_t count = offsets[t * num_buckets + b];
+      offsets[t * num_buckets + b] = offset;
+      offset += count;
+    }
+  }
+  bucket_begin[num_buckets] = n;
+
+  RunOnThreads(num_threads, [&](int t) {
+    size_t* next = &offsets[t * num_buckets];
+    const size_t begin = std::min(n, t * chunk);
+    const size_t end = std::min(n, begin + chunk);
+    for (size_t i = begin; i < end; ++i) {
+      (*perm)[next[bucket_of[i]]++] = static_cast<IndexT>(i);
+    }
+  });
+
+  RunOnThreads(num_threads, [&](int t) {
+    std::mt19937_64 rng(seeds[num_threads + t]);
+    for (size_t b = t; b < num_buckets; b += num_threads) {
+      std::shuffle(perm->begin() + bucket_begin[b],
+                   perm->begin() + bucket_begin[b + 1],
+                   rng);
+    }
+  });
+}
+
+// Shuffle data uniformly at random: permute 32-bit (or 64-bit) indices in
+// parallel, then gather the elements in parallel, so that every element is
+// moved once instead of being swapped around by std::shuffle.
+template <typename T, typename Engine>
+void ParallelShuffle(std::vector<T>* data, Engine* engine, int num_threads) {
+  const size_t n = data->size();
+  if (num_threads <= 1 || n < kParallelShuffleMinSize) {
+    std::shuffle(data->begin(), data->end(), *engine);
+    return;
+  }
+
+  auto gather = [&](const auto& perm) {
+    std::vector<T> out(n);
+    const size_t chunk = (n + num_threads - 1) / num_threads;
+    RunOnThreads(num_threads, [&](int t) {
+      const size_t begin = std::min(n, t * chunk);
+      const size_t end = std::min(n, begin + chunk);
+      for (size_t i = begin; i < end; ++i) {
+        out[i] = std::move((*data)[perm[i]]);
+      }
+    });
+    data->swap(out);
+  };
+
+  if (n <= std::numeric_limits<uint32_t>::max()) {
+    std::vector<uint32_t> perm;
+    ParallelRandomPermutation(n, engine, num_threads, &perm);
+    gather(perm);
+  } else {
+    std::vector<uint64_t> perm;
+    ParallelRandomPermutation(n, engine, num_threads, &perm);
+    gather(perm);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
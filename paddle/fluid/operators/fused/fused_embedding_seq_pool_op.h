@@ -119,8 +119,11 @@ struct EmbeddingVSumFunctor {
       auto emb_seqpool = phi::jit::KernelFuncs<phi::jit::EmbSeqPoolTuple<T>,
                                                platform::CPUPlace>::Cache()
                              .At(attr);
-      emb_seqpool(
-          table, ids + ids_lod[i] * idx_width, output + i * out_width, &attr);
+      emb_seqpool(table,
+                  ids + ids_lod[i] * idx_width,
+                  nullptr,
+                  output + i * out_width,
+                  &attr);
     }
   }
 };
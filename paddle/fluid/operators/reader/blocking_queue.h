@@ -14,10 +14,12 @@
 
 #pragma once
 
-#include <condition_variable>  // NOLINT
-#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
 #include <utility>
 
+#include "paddle/fluid/framework/bounded_mpmc_queue.h"
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -31,6 +33,10 @@ class BlockingQueue {
   // framework::Channel, but which has currently a deadlock bug. BlockingQueue
   // is a workaround and a simplified version of framework::Channel as it
   // doesn't support GPU and it implements on buffered blocking queue.
+  //
+  // The elements are kept in a lock-free framework::BoundedMPMCQueue, so the
+  // reader threads and the trainer threads do not contend on a mutex for
+  // every batch.
  public:
   explicit BlockingQueue(size_t capacity, bool speed_test_mode = false)
       : capacity_(capacity), speed_test_mode_(speed_test_mode) {
@@ -40,135 +46,87 @@ class BlockingQueue {
                           "The capacity of a reader::BlockingQueue must be "
                           "greater than 0, but received capacity is %d.",
                           capacity_));
+    queue_ = std::make_unique<framework::BoundedMPMCQueue<T>>(capacity_);
   }
 
   bool Send(const T& elem) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    send_cv_.wait(
-        lock, [&] { return queue_.size() < capacity_ || closed_ || killed_; });
-    if (killed_) {
-      VLOG(3)
-          << "WARNING:: Sending an element to a killed reader::BlockingQueue";
-      return false;
-    }
-    if (closed_) {
-      VLOG(5)
-          << "WARNING: Sending an element to a closed reader::BlockingQueue.";
-      return false;
-    }
-    PADDLE_ENFORCE_LT(
-        queue_.size(),
-        capacity_,
-        phi::errors::PermissionDenied(
-            "The queue size cannot exceed the set queue capacity. Expected "
-            "queue size is less than %d. But received %d",
-            capacity_,
-            queue_.size()));
-    queue_.push_back(elem);
-    receive_cv_.notify_one();
-    return true;
+    T copy(elem);
+    return Send(std::move(copy));
   }
 
   bool Send(T&& elem) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    send_cv_.wait(
-        lock, [&] { return queue_.size() < capacity_ || closed_ || killed_; });
-    if (killed_) {
+    if (killed_.load(std::memory_order_acquire)) {
       VLOG(3)
           << "WARNING:: Sending an element to a killed reader::BlockingQueue";
       return false;
     }
-    if (closed_) {
-      VLOG(5)
-          << "WARNING: Sending an element to a closed reader::BlockingQueue.";
+    if (!queue_->Push(std::move(elem))) {
+      if (killed_.load(std::memory_order_acquire)) {
+        VLOG(3) << "WARNING:: Sending an element to a killed "
+                   "reader::BlockingQueue";
+      } else {
+        VLOG(5)
+            << "WARNING: Sending an element to a closed reader::BlockingQueue.";
+      }
       return false;
     }
-    PADDLE_ENFORCE_LT(
-        queue_.size(),
-        capacity_,
-        phi::errors::PermissionDenied(
-            "The queue size cannot exceed the set queue capacity. Expected "
-            "queue size is less than %d. But received %d",
-            capacity_,
-            queue_.size()));
-    queue_.emplace_back(std::move(elem));
-    receive_cv_.notify_one();
     return true;
   }
 
   bool Receive(T* elem) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    receive_cv_.wait(lock,
-                     [&] { return !queue_.empty() || closed_ || killed_; });
-    EnforceNotKilled();
-    if (!queue_.empty()) {
-      PADDLE_ENFORCE_NOT_NULL(
-          elem,
-          phi::errors::InvalidArgument(
-              "The holder to receive queue data is null pointer."));
-      *elem = queue_.front();
-      if (LIKELY(!speed_test_mode_)) {
-        queue_.pop_front();
+    PADDLE_ENFORCE_NOT_NULL(
+        elem,
+        phi::errors::InvalidArgument(
+            "The holder to receive queue data is null pointer."));
+    bool received = false;
+    if (UNLIKELY(speed_test_mode_)) {
+      // Keep returning the first element, which is never popped.
+      while (!(received = queue_->TryPeek(elem)) && !queue_->Closed()) {
+        std::this_thread::yield();
       }
-      send_cv_.notify_one();
-      return true;
     } else {
-      PADDLE_ENFORCE_EQ(closed_,
-                        true,
-                        phi::errors::PermissionDenied(
-                            "Blocking queue status error, if queue is empty "
-                            "when pop data, it should be closed."));
-      VLOG(3) << "queue is closed! return nothing.";
-      return false;
+      received = queue_->Pop(elem);
     }
+    EnforceNotKilled();
+    if (received) {
+      return true;
+    }
+    PADDLE_ENFORCE_EQ(queue_->Closed(),
+                      true,
+                      phi::errors::PermissionDenied(
+                          "Blocking queue status error, if queue is empty "
+                          "when pop data, it should be closed."));
+    VLOG(3) << "queue is closed! return nothing.";
+    return false;
   }
 
   void ReOpen() {
-    std::lock_guard<std::mutex> lock(mutex_);
     EnforceNotKilled();
     VLOG(1) << "reopen queue";
-    closed_ = false;
-    std::deque<T> new_deque;
-    queue_.swap(new_deque);
-    send_cv_.notify_all();
-    receive_cv_.notify_all();
+    queue_->Clear();
+    queue_->Open();
   }
 
   void Close() {
-    std::lock_guard<std::mutex> lock(mutex_);
     VLOG(1) << "close queue";
-    closed_ = true;
-    send_cv_.notify_all();
-    receive_cv_.notify_all();
+    queue_->Close();
   }
 
-  bool IsClosed() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return closed_;
-  }
+  bool IsClosed() const { return queue_->Closed(); }
 
-  size_t Cap() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return capacity_;
-  }
+  size_t Cap() const { return capacity_; }
 
-  size_t Size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.size();
-  }
+  size_t Size() const { return queue_->Size(); }
 
   void Kill() {
-    std::lock_guard<std::mutex> lock(mutex_);
     VLOG(1) << "kill queue";
-    closed_ = true;
-    killed_ = true;
-    send_cv_.notify_all();
-    receive_cv_.notify_all();
+    killed_.store(true, std::memory_order_release);
+    queue_->Close();
   }
 
  private:
   inline void EnforceNotKilled() {
-    PADDLE_ENFORCE_NE(killed_,
+    PADDLE_ENFORCE_NE(killed_.load(std::memory_order_acquire),
                       true,
                       phi::errors::Fatal("Blocking queue is killed because the "
                                          "data reader raises an exception."));
@@ -177,13 +135,9 @@ class BlockingQueue {
  private:
   size_t capacity_;
   bool speed_test_mode_;
-  bool closed_{false};
-  bool killed_{false};  // the queue is broken since exception raises
-  std::deque<T> queue_;
-
-  mutable std::mutex mutex_;
-  mutable std::condition_variable receive_cv_;
-  mutable std::condition_variable send_cv_;
+  // the queue is broken since exception raises
+  std::atomic<bool> killed_{false};
+  std::unique_ptr<framework::BoundedMPMCQueue<T>> queue_;
 };
 }  // namespace reader
 }  // namespace operators
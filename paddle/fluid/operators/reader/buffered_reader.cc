@@ -14,6 +14,9 @@
 
 #include "paddle/fluid/operators/reader/buffered_reader.h"
 
+#include <chrono>
+
+#include "paddle/common/flags.h"
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/platform/device/device_wrapper.h"
 #include "paddle/fluid/platform/profiler.h"
@@ -22,19 +25,15 @@
 #include "paddle/phi/backends/device_guard.h"
 #include "paddle/phi/backends/device_manager.h"
 
+COMMON_DECLARE_int32(reader_prefetch_num_threads);
+
 namespace paddle {
 namespace operators {
 namespace reader {
 BufferedReader::~BufferedReader() {
   VLOG(1) << "~BufferedReader";
   reader_->Shutdown();
-  while (!position_.empty()) {
-    auto &front = position_.front();
-    if (front.valid()) {
-      front.wait();
-    }
-    position_.pop();
-  }
+  WaitAll();
 }
 
 BufferedReader::BufferedReader(
@@ -43,7 +42,7 @@ BufferedReader::BufferedReader(
     size_t buffer_size,
     bool pin_memory)
     : framework::DecoratedReader(reader),
-      thread_pool_(1),
+      thread_pool_(std::max(FLAGS_reader_prefetch_num_threads, 1)),
       place_(place),
       buffer_size_(buffer_size),
       pin_memory_(pin_memory) {
@@ -103,6 +102,40 @@ BufferedReader::BufferedReader(
   ReadTillBufferFullAsync();
 }
 
+void BufferedReader::WaitAll() {
+  while (!position_.empty()) {
+    auto &front = position_.front();
+    if (front.valid()) {
+      front.wait();
+    }
+    position_.pop();
+  }
+  ready_count_ = 0;
+}
+
+void BufferedReader::ReadInOrder(size_t ticket, TensorVec *cpu) {
+  std::unique_lock<std::mutex> lock(read_mutex_);
+  read_cv_.wait(lock, [&] { return read_ticket_ == ticket; });
+  // Pass the turn on even if ReadNext throws, otherwise the following
+  // tickets would wait forever.
+  auto pass_turn = [this]() {
+    ++read_ticket_;
+    read_cv_.notify_all();
+  };
+  try {
+    reader_->ReadNext(cpu);
+  } catch (...) {
+    pass_turn();
+    throw;
+  }
+  pass_turn();
+}
+
+BufferedReaderStats BufferedReader::GetStats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
 void BufferedReader::ReadTillBufferFullAsync() {
   for (size_t i = 0; i < buffer_size_; ++i) {
     ReadAsync(i);
@@ -110,12 +143,17 @@ void BufferedReader::ReadTillBufferFullAsync() {
 }
 
 void BufferedReader::ReadAsync(size_t i) {
-  position_.emplace(thread_pool_.enqueue([this, i]() -> size_t {
+  size_t ticket = next_ticket_++;
+  position_.emplace(thread_pool_.enqueue([this, i, ticket]() -> size_t {
+    auto mark_ready = [this](size_t pos) {
+      ready_count_.fetch_add(1, std::memory_order_relaxed);
+      return pos;
+    };
     TensorVec &cpu = cpu_buffer_[i];
-    reader_->ReadNext(&cpu);
+    ReadInOrder(ticket, &cpu);
 
     if (cpu.empty()) {
-      return -1UL;
+      return mark_ready(-1UL);
     }
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)  // @{ Group GPU Place
@@ -349,15 +387,20 @@ void BufferedReader::ReadAsync(size_t i) {
       custom_device_stream_->Synchronize();
     }
 #endif
-    return i;
+    return mark_ready(i);
   }));
 }
 
 void BufferedReader::ShutdownImpl() {
   VLOG(1) << "ShutdownImpl";
   reader_->Shutdown();
-  while (!position_.empty()) {
-    position_.pop();
+  // The pending tasks hold tickets, they have to finish before the tickets
+  // are reset.
+  WaitAll();
+  {
+    std::lock_guard<std::mutex> lock(read_mutex_);
+    next_ticket_ = 0;
+    read_ticket_ = 0;
   }
   prev_pos_ = -1UL;
 }
@@ -372,8 +415,30 @@ void BufferedReader::ReadNextImpl(paddle::framework::LoDTensorArray *out) {
     out->clear();
     return;
   }
-  size_t i = position_.front().get();
+  auto &front = position_.front();
+  const int64_t ready_depth = ready_count_.load(std::memory_order_relaxed);
+  const bool stall =
+      front.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+  auto start = std::chrono::steady_clock::now();
+  size_t i = front.get();
   position_.pop();
+  ready_count_.fetch_sub(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.batches;
+    stats_.ready_depth = ready_depth;
+    if (stall) {
+      ++stats_.stalls;
+      stats_.stall_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    }
+    VLOG_IF(2, stats_.batches % 100 == 0)
+        << "BufferedReader " << stats_.batches << " batches, "
+        << stats_.stalls << " stalls of " << stats_.stall_us
+        << " us in total, " << ready_depth << " of " << buffer_size_
+        << " batches ready";
+  }
 
   if (i == -1UL) {
     ReadNextImpl(out);
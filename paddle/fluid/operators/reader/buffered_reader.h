@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <list>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <vector>
 
@@ -38,6 +41,16 @@ namespace paddle {
 namespace operators {
 namespace reader {
 
+// Counters of the input pipeline, a stall is a ReadNext call which has to
+// wait for the prefetch, i.e. the input pipeline is the bottleneck.
+struct BufferedReaderStats {
+  int64_t batches{0};
+  int64_t stalls{0};
+  int64_t stall_us{0};
+  // Number of prefetched batches ready at the last ReadNext call
+  int64_t ready_depth{0};
+};
+
 class BufferedReader : public framework::DecoratedReader {
   using TensorVec = paddle::framework::LoDTensorArray;
   using VecFuture = std::future<TensorVec>;
@@ -52,11 +65,18 @@ class BufferedReader : public framework::DecoratedReader {
 
   platform::Place GetPlace() const { return place_; }
 
+  BufferedReaderStats GetStats() const;
+
  private:
   void ReadTillBufferFullAsync();
 
   void ReadAsync(size_t i);
 
+  // Read the next batch of the underlying reader in the order of ticket.
+  void ReadInOrder(size_t ticket, TensorVec* cpu);
+
+  void WaitAll();
+
  protected:
   void ShutdownImpl() override;
   void StartImpl() override;
@@ -70,6 +90,17 @@ class BufferedReader : public framework::DecoratedReader {
 
   std::queue<std::future<size_t>> position_;
 
+  // With several prefetch threads the tasks may start out of order, tickets
+  // keep the batches in the order of the underlying reader.
+  std::mutex read_mutex_;
+  std::condition_variable read_cv_;
+  size_t next_ticket_{0};
+  size_t read_ticket_{0};
+
+  std::atomic<int64_t> ready_count_{0};
+  mutable std::mutex stats_mutex_;
+  BufferedReaderStats stats_;
+
   // The buffer for reading data.
   // NOTE: the simplest way to implement buffered reader is do not use any
   // buffer, just read async and create futures as buffer size. However, to
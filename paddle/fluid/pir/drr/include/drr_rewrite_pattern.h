@@ -54,10 +54,12 @@ class DrrRewritePattern : public pir::RewritePattern {
   bool PatternGraphMatch(pir::Operation* op,
                          MatchContextImpl* source_pattern_match_ctx) const;
 
+  // Checks the operands and results of op against the anchor, before the
+  // source pattern graph is matched from it.
+  bool AnchorMatch(pir::Operation* op) const;
+
   std::unordered_map<const OpCall*, std::unordered_set<pir::Operation*>>
-  FindCandidateIrOutputOp(pir::Operation* op,
-                          const OpCall* anchor,
-                          const SourcePatternGraph& source_pattern_graph) const;
+  FindCandidateIrOutputOp(pir::Operation* op, const OpCall* anchor) const;
 
   void DfsVisitor(
       const OpCall* drr_op,
@@ -98,6 +100,10 @@ class DrrRewritePattern : public pir::RewritePattern {
  private:
   const std::string pattern_name_;
   const std::shared_ptr<SourcePatternGraph> source_pattern_graph_;
+  // The output ops of the source pattern graph, and the one of them the
+  // pattern is rooted at.
+  const std::unordered_set<const OpCall*> drr_output_op_set_;
+  const OpCall* anchor_;
   const std::vector<Constraint> constraints_;
   const std::vector<PostProcess> post_processes_;
   const std::shared_ptr<ResultPatternGraph> result_pattern_graph_;
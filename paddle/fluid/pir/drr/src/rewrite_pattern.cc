@@ -41,6 +41,8 @@ DrrRewritePattern::DrrRewritePattern(
           {}),
       pattern_name_(pattern_name),
       source_pattern_graph_(drr_context.source_pattern_graph()),
+      drr_output_op_set_(source_pattern_graph_->OutputNodes()),
+      anchor_(*drr_output_op_set_.begin()),
       constraints_(drr_context.constraints()),
       post_processes_(drr_context.post_processes()),
       result_pattern_graph_(drr_context.result_pattern_graph()),
@@ -79,10 +81,11 @@ bool DrrRewritePattern::MatchAndRewrite(
 bool DrrRewritePattern::PatternGraphMatch(
     pir::Operation* op, MatchContextImpl* source_pattern_match_ctx) const {
   VLOG(6) << "PatternGraphMatch Start: op(" << op->name() << ")";
-  const OpCall* anchor = *source_pattern_graph_->OutputNodes().begin();
+  if (!AnchorMatch(op)) {
+    return false;
+  }
   std::unordered_map<const OpCall*, std::unordered_set<pir::Operation*>>
-      bind_map =
-          FindCandidateIrOutputOp(op, anchor, *(source_pattern_graph_.get()));
+      bind_map = FindCandidateIrOutputOp(op, anchor_);
   if (bind_map.empty()) {
     return false;
   }
@@ -134,23 +137,53 @@ bool DrrRewritePattern::PatternGraphMatch(
   return permute(permute, 0);
 }
 
+bool DrrRewritePattern::AnchorMatch(pir::Operation* op) const {
+  if (anchor_->name() != op->name()) {
+    return false;
+  }
+  const auto& drr_input_tensors = anchor_->inputs();
+  if (drr_input_tensors.size() != op->num_operands() ||
+      anchor_->outputs().size() != op->num_results()) {
+    return false;
+  }
+  // The producers of the operands are the first ops matched from the anchor,
+  // so most of the ops the pattern never applies to fail here, before the
+  // match contexts are created.
+  for (size_t i = 0; i < drr_input_tensors.size(); ++i) {
+    pir::Value ir_value = op->operand_source(i);
+    if (drr_input_tensors[i]->is_none()) {
+      if (ir_value) {
+        return false;
+      }
+      continue;
+    }
+    const OpCall* drr_producer_op = drr_input_tensors[i]->producer();
+    if (drr_producer_op == nullptr) {
+      continue;
+    }
+    if (!ir_value || ir_value.defining_op() == nullptr ||
+        drr_input_tensors[i]->consumers().size() != ir_value.use_count() ||
+        drr_producer_op->name() != ir_value.defining_op()->name()) {
+      VLOG(8) << anchor_->name() << " Match failed at the producer of input["
+              << i << "].";
+      return false;
+    }
+  }
+  return true;
+}
+
 std::unordered_map<const OpCall*, std::unordered_set<pir::Operation*>>
-DrrRewritePattern::FindCandidateIrOutputOp(
-    pir::Operation* op,
-    const OpCall* anchor,
-    const SourcePatternGraph& source_pattern_graph) const {
-  // get source pattern output op
-  std::unordered_set<const OpCall*> drr_output_op_set =
-      source_pattern_graph.OutputNodes();
+DrrRewritePattern::FindCandidateIrOutputOp(pir::Operation* op,
+                                           const OpCall* anchor) const {
   std::unordered_map<const OpCall*, std::unordered_set<pir::Operation*>>
       output_op_bind_map{{anchor, {op}}};
-  if (drr_output_op_set.size() == 1) {
+  if (drr_output_op_set_.size() == 1) {
     return output_op_bind_map;
   }
   std::unordered_set<const OpCall*> drr_visited_ops{anchor};
   DfsVisitor(
-      anchor, op, drr_output_op_set, &drr_visited_ops, &output_op_bind_map);
-  if (output_op_bind_map.size() != drr_output_op_set.size()) {
+      anchor, op, drr_output_op_set_, &drr_visited_ops, &output_op_bind_map);
+  if (output_op_bind_map.size() != drr_output_op_set_.size()) {
     return {};
   }
   return output_op_bind_map;
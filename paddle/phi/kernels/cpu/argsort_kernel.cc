@@ -19,70 +19,32 @@
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/parallel_sort.h"
 #include "paddle/phi/kernels/transpose_kernel.h"
 
 namespace phi {
 
+// The sort is always stable, since ties are ordered by their positions.
 template <typename T, typename Type>
 static void FullSort(Type input_height,
                      Type input_width,
-                     int input_dim,
                      const DenseTensor* input,
                      T* t_out,
                      Type* t_indices,
-                     bool descending,
-                     bool stable) {
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-  for (Type i = 0; i < input_height; ++i) {
-    std::vector<std::pair<T, Type>> col_vec;
-    col_vec.reserve(input_width);
-    if (input_dim == 1) {
-      auto e_input = EigenVector<T>::Flatten(*input);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.push_back(std::pair<T, Type>(e_input(j), j));
-      }
-    } else {
-      auto e_input = EigenMatrix<T>::Reshape(*input, input_dim - 1);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.push_back(std::pair<T, Type>(e_input(i, j), j));
-      }
-    }
-    if (stable) {
-      std::stable_sort(
-          col_vec.begin(),
-          col_vec.end(),
-          [&](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-            if (descending)
-              return (std::isnan(static_cast<double>(l.first)) &&
-                      !std::isnan(static_cast<double>(r.first))) ||
-                     (l.first > r.first);
-            else
-              return (!std::isnan(static_cast<double>(l.first)) &&
-                      std::isnan(static_cast<double>(r.first))) ||
-                     (l.first < r.first);
-          });
-    } else {
-      std::sort(col_vec.begin(),
-                col_vec.end(),
-                [&](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-                  if (descending)
-                    return (std::isnan(static_cast<double>(l.first)) &&
-                            !std::isnan(static_cast<double>(r.first))) ||
-                           (l.first > r.first);
-                  else
-                    return (!std::isnan(static_cast<double>(l.first)) &&
-                            std::isnan(static_cast<double>(r.first))) ||
-                           (l.first < r.first);
-                });
-    }
-
-    for (Type j = 0; j < input_width; ++j) {
-      t_out[i * input_width + j] = col_vec[j].first;
-      t_indices[i * input_width + j] = col_vec[j].second;
-    }
-  }
+                     bool descending) {
+  const T* input_data = input->data<T>();
+  funcs::ForEachSortRow<T>(
+      input_height,
+      input_width,
+      [&](Type i, funcs::SortWorkspace<T>* ws, int num_threads) {
+        funcs::SortRow(input_data + i * input_width,
+                       input_width,
+                       descending,
+                       t_out + i * input_width,
+                       t_indices + i * input_width,
+                       ws,
+                       num_threads);
+      });
 }
 
 template <typename T, typename Context>
@@ -90,7 +52,7 @@ void ArgsortKernel(const Context& dev_ctx,
                    const DenseTensor& input,
                    int axis,
                    bool descending,
-                   bool stable,
+                   bool stable UNUSED,
                    DenseTensor* output,
                    DenseTensor* indices) {
   auto in_dims = input.dims();
@@ -114,12 +76,10 @@ void ArgsortKernel(const Context& dev_ctx,
     int64_t* ids_data = dev_ctx.template Alloc<int64_t>(indices);
     FullSort<T, int64_t>(input_height,
                          input_width,
-                         in_dims.size(),
                          &input,
                          out_data,
                          ids_data,
-                         descending,
-                         stable);
+                         descending);
   } else {
     // If not full sort do transpose
     std::vector<int> trans;
@@ -156,12 +116,10 @@ void ArgsortKernel(const Context& dev_ctx,
 
     FullSort<T, int64_t>(input_height,
                          input_width,
-                         in_dims.size(),
                          &trans_inp,
                          t_out,
                          t_ind,
-                         descending,
-                         stable);
+                         descending);
 
     dev_ctx.template Alloc<int64_t>(indices);
     TransposeKernel<int64_t, Context>(dev_ctx, tmp_indices, trans, indices);
@@ -14,6 +14,10 @@
 
 #include "paddle/phi/kernels/embedding_grad_kernel.h"
 
+#if defined(_OPENMP) && !defined(PADDLE_WITH_CUDA)
+#include <omp.h>
+#endif
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -57,12 +61,8 @@ struct EmbeddingGradCPUFunctor {
       dev_ctx_.template Alloc<T>(weight_grad_);
       auto* d_table_data = weight_grad_->data<T>();
 
-      memset(d_table_data, 0, weight_grad_->numel() * sizeof(T));
       for (int64_t i = 0; i < ids_num; ++i) {
-        if (padding_idx_ != kNoPadding && ids_data[i] == padding_idx_) {
-          // the gradient of padding_idx should be 0, already done by memset, so
-          // do nothing.
-        } else {
+        if (padding_idx_ == kNoPadding || ids_data[i] != padding_idx_) {
           PADDLE_ENFORCE_LT(
               ids_data[i],
               N,
@@ -83,8 +83,42 @@ struct EmbeddingGradCPUFunctor {
                   "value.",
                   N,
                   ids_data[i]));
-          for (int j = 0; j < D; ++j) {
-            d_table_data[ids_data[i] * D + j] += d_output_data[i * D + j];
+        }
+      }
+
+      // Every thread owns a contiguous block of the table rows, it zeros them
+      // and accumulates the ids falling in them in the order of ids. So there
+      // is no write conflict and the result does not depend on the number of
+      // threads.
+#if defined(_OPENMP) && !defined(PADDLE_WITH_CUDA)
+      const bool parallel = ids_num * D >= kEmbeddingParallelMinNumel;
+#pragma omp parallel if (parallel)
+#endif
+      {
+#if defined(_OPENMP) && !defined(PADDLE_WITH_CUDA)
+        int64_t tid = omp_get_thread_num();
+        int64_t num_threads = omp_get_num_threads();
+#else
+        int64_t tid = 0;
+        int64_t num_threads = 1;
+#endif
+        int64_t rows_per_thread = (N + num_threads - 1) / num_threads;
+        int64_t row_begin = std::min(N, tid * rows_per_thread);
+        int64_t row_end = std::min(N, row_begin + rows_per_thread);
+        memset(d_table_data + row_begin * D,
+               0,
+               (row_end - row_begin) * D * sizeof(T));
+        for (int64_t i = 0; i < ids_num; ++i) {
+          int64_t id = ids_data[i];
+          // the gradient of padding_idx should be 0, already done by memset
+          if (id < row_begin || id >= row_end ||
+              (padding_idx_ != kNoPadding && id == padding_idx_)) {
+            continue;
+          }
+          T* dst = d_table_data + id * D;
+          const T* src = d_output_data + i * D;
+          for (int64_t j = 0; j < D; ++j) {
+            dst[j] += src[j];
           }
         }
       }
@@ -49,7 +49,7 @@ struct EmbeddingCPUFunctor {
     auto* output = out_->data<T>();
 
     for (int64_t i = 0; i < ids_numel; ++i) {
-      if (padding_idx_ == kNoPadding && ids[i] != padding_idx_) {
+      if (padding_idx_ == kNoPadding || ids[i] != padding_idx_) {
         PADDLE_ENFORCE_LT(
             ids[i],
             row_number,
@@ -71,16 +71,23 @@ struct EmbeddingCPUFunctor {
       }
     }
 
+    const int64_t* ids_data = ids.data();
 #if defined(_OPENMP) && !defined(PADDLE_WITH_CUDA)
-#pragma omp parallel for
+    const bool parallel = ids_numel * row_width >= kEmbeddingParallelMinNumel;
+#pragma omp parallel for schedule(static) if (parallel)
 #endif
-
     for (int64_t i = 0; i < ids_numel; ++i) {
-      if (padding_idx_ != kNoPadding && ids[i] == padding_idx_) {
+      if (i + kEmbeddingPrefetchDistance < ids_numel) {
+        int64_t next = ids_data[i + kEmbeddingPrefetchDistance];
+        if (next != padding_idx_) {
+          PrefetchEmbeddingRow(table + next * row_width, row_width);
+        }
+      }
+      if (padding_idx_ != kNoPadding && ids_data[i] == padding_idx_) {
         memset(output + i * row_width, 0, row_width * sizeof(T));
       } else {
         memcpy(output + i * row_width,
-               table + ids[i] * row_width,
+               table + ids_data[i] * row_width,
                row_width * sizeof(T));
       }
     }
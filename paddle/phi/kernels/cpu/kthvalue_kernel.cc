@@ -18,58 +18,29 @@
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/parallel_sort.h"
 
 namespace phi {
 template <typename T, typename Type>
 static void getKthvalue(Type input_height,
                         Type input_width,
-                        int input_dim,
                         const DenseTensor* input,
                         T* t_out,
                         Type* t_indices,
                         const int& k) {
-  bool partial_sort_flag = (k * 64) < input_width;
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-  for (Type i = 0; i < input_height; ++i) {
-    std::vector<std::pair<T, Type>> col_vec;
-    col_vec.reserve(input_width);
-    if (input_dim == 1) {
-      auto e_input = EigenVector<T>::Flatten(*input);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.emplace_back(std::pair<T, Type>(e_input(j), j));
-      }
-    } else {
-      auto e_input = EigenMatrix<T>::Reshape(*input, input_dim - 1);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.emplace_back(std::pair<T, Type>(e_input(i, j), j));
-      }
-    }
-    if (partial_sort_flag) {
-      std::partial_sort(
-          col_vec.begin(),
-          col_vec.begin() + k,
-          col_vec.end(),
-          [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-            return (!std::isnan(static_cast<double>(l.first)) &&
-                    std::isnan(static_cast<double>(r.first))) ||
-                   (l.first < r.first);
-          });
-    } else {
-      std::nth_element(
-          col_vec.begin(),
-          col_vec.begin() + k - 1,
-          col_vec.end(),
-          [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-            return (!std::isnan(static_cast<double>(l.first)) &&
-                    std::isnan(static_cast<double>(r.first))) ||
-                   (l.first < r.first);
-          });
-    }
-    t_out[i] = col_vec[k - 1].first;
-    t_indices[i] = col_vec[k - 1].second;
-  }
+  const T* input_data = input->data<T>();
+  funcs::ForEachSortRow<T>(
+      input_height,
+      input_width,
+      [&](Type i, funcs::SortWorkspace<T>* ws, int num_threads) {
+        funcs::KthValueRow(input_data + i * input_width,
+                           input_width,
+                           k,
+                           t_out + i,
+                           t_indices + i,
+                           ws,
+                           num_threads);
+      });
 }
 
 template <typename T, typename Context>
@@ -105,7 +76,6 @@ void KthvalueKernel(const Context& dev_ctx,
     const int64_t& input_width = in_dims[in_dims.size() - 1];
     getKthvalue<T, int64_t>(input_height,
                             input_width,
-                            in_dims.size(),
                             &x,
                             output_data,
                             indices_data,
@@ -157,7 +127,7 @@ void KthvalueKernel(const Context& dev_ctx,
     tmp_indices.Resize(trans_out_dims);
     int64_t* t_ind = dev_ctx.template Alloc<int64_t>(&tmp_indices);
     getKthvalue<T, int64_t>(
-        input_height, input_width, in_dims.size(), &trans_inp, t_out, t_ind, k);
+        input_height, input_width, &trans_inp, t_out, t_ind, k);
     funcs::TransCompute<phi::CPUContext, int64_t>(
         ndims, dev_ctx, tmp_indices, indices, trans);
     funcs::TransCompute<phi::CPUContext, T>(
@@ -14,11 +14,32 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "paddle/phi/core/dense_tensor.h"
 
 namespace phi {
 constexpr int64_t kNoPadding = -1;
 
+// The rows of ids[i + kEmbeddingPrefetchDistance] are prefetched while row
+// ids[i] is copied, since random rows of a large table miss the cache.
+constexpr int64_t kEmbeddingPrefetchDistance = 8;
+constexpr int64_t kEmbeddingPrefetchMaxBytes = 512;
+// Skip the thread pool for lookups smaller than this number of elements.
+constexpr int64_t kEmbeddingParallelMinNumel = 1 << 15;
+
+template <typename T>
+inline void PrefetchEmbeddingRow(const T *row, int64_t row_width) {
+#if defined(__GNUC__) || defined(__clang__)
+  const char *ptr = reinterpret_cast<const char *>(row);
+  int64_t bytes = std::min<int64_t>(row_width * sizeof(T),
+                                    kEmbeddingPrefetchMaxBytes);
+  for (int64_t offset = 0; offset < bytes; offset += 64) {
+    __builtin_prefetch(ptr + offset, 0, 1);
+  }
+#endif
+}
+
 template <typename InT, typename OutT>
 static std::vector<OutT> CopyIdsToVector(const DenseTensor &ids) {
   auto numel = ids.numel();
@@ -272,7 +272,8 @@ void BenchKernelSeqPool() {
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelEmbSeqPool() {
   using T = typename KernelTuple::data_type;
-  std::vector<jit::SeqPoolType> pool_types = {jit::SeqPoolType::kSum};
+  std::vector<jit::SeqPoolType> pool_types = {
+      jit::SeqPoolType::kSum, jit::SeqPoolType::kAvg, jit::SeqPoolType::kSqrt};
   int64_t tbl_h = 1e4;
   for (int tbl_w : {10, 16, 256}) {
     phi::DenseTensor table;
@@ -295,7 +296,7 @@ void BenchKernelEmbSeqPool() {
           const int64_t* idx_data = idx.data<int64_t>();
           T* o_data = out.mutable_data<T>(PlaceType());
           BenchAllImpls<KernelTuple, PlaceType>(
-              attr, table_data, idx_data, o_data, &attr);
+              attr, table_data, idx_data, nullptr, o_data, &attr);
         }
       }
     }
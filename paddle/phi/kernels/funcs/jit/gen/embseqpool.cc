@@ -24,10 +24,27 @@ namespace phi {
 namespace jit {
 namespace gen {
 
+void EmbSeqPoolJitCode::genScale() {
+  xmm_t xmm_scale = xmm_t(ymm_scale.getIdx());
+  xmm_t xmm_one = xmm_t(ymm_weight.getIdx());
+  vcvtsi2ss(xmm_scale, xmm_scale, reg_idx_height);
+  if (type_ == SeqPoolType::kSqrt) {
+    vsqrtss(xmm_scale, xmm_scale, xmm_scale);
+  }
+  mov(reg_tmp.cvt32(), 0x3f800000);  // 1.f
+  vmovd(xmm_one, reg_tmp.cvt32());
+  vdivss(xmm_scale, xmm_one, xmm_scale);
+  // vbroadcastss from register needs avx2
+  vshufps(xmm_scale, xmm_scale, xmm_scale, 0);
+  vinsertf128(ymm_scale, ymm_scale, xmm_scale, 1);
+}
+
 void EmbSeqPoolJitCode::genCode() {
   preCode();
   constexpr int block = YMM_FLOAT_BLOCK;
-  constexpr int max_num_regs = 8;
+  // ymm14 and ymm15 hold the scale and the weight if they are needed
+  const bool with_scale = type_ != SeqPoolType::kSum;
+  const int max_num_regs = (with_scale || with_weights_) ? 7 : 8;
   const int num_block = tbl_w_ / block;
   const int num_groups = num_block / max_num_regs;
   const size_t block_size = sizeof(float) * block;
@@ -37,15 +54,24 @@ void EmbSeqPoolJitCode::genCode() {
     groups.push_back(rest_num_regs);
   }
 
-  // protect param_dst
+  // protect param_dst and param_weights
   mov(reg_ptr_param_dst, param_dst);
-  mov(reg_idx_width_in_byte,
-      qword[param_attr + offsetof(emb_seq_pool_attr_t, index_width)]);
+  mov(reg_ptr_weights, param_weights);
+  // param_attr shares r8 with reg_idx_width_in_byte, so load height first
   mov(reg_idx_height,
       qword[param_attr + offsetof(emb_seq_pool_attr_t, index_height)]);
+  mov(reg_idx_width_in_byte,
+      qword[param_attr + offsetof(emb_seq_pool_attr_t, index_width)]);
+  if (with_weights_) {
+    mov(reg_weights_width_in_byte, reg_idx_width_in_byte);
+    shl(reg_weights_width_in_byte, 2);  // * sizeof(float)
+  }
   mov(rax, sizeof(int64_t));
   mul(reg_idx_width_in_byte);
   mov(reg_idx_width_in_byte, rax);
+  if (with_scale) {
+    genScale();
+  }
   const size_t tbl_width_in_byte = sizeof(float) * tbl_w_;
   int acc_num_regs = 0;
   for (int num_regs : groups) {
@@ -64,9 +90,19 @@ void EmbSeqPoolJitCode::genCode() {
       mul(reg_idx);
       mov(reg_ptr_tbl_i, rax);        // reg is offset now
       add(reg_ptr_tbl_i, param_tbl);  // reg is ptr_i now
+      if (with_weights_) {
+        // the weights have the same layout as idx with half the element size
+        mov(reg_ptr_weights_i, reg_idx_w_i_in_byte);
+        shr(reg_ptr_weights_i, 1);
+        add(reg_ptr_weights_i, reg_ptr_weights);
+        vbroadcastss(ymm_weight, ptr[reg_ptr_weights_i]);
+      }
       size_t w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
         vmovups(ymm_t(reg_i + num_regs), ptr[reg_ptr_tbl_i + w_offset]);
+        if (with_weights_) {
+          vmulps(ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs), ymm_weight);
+        }
         w_offset += block_size;
       }
       add(reg_ptr_idx_i, reg_idx_width_in_byte);
@@ -89,9 +125,16 @@ void EmbSeqPoolJitCode::genCode() {
         mul(reg_idx);
         mov(reg_ptr_tbl_i, rax);
         add(reg_ptr_tbl_i, param_tbl);
+        if (with_weights_) {
+          add(reg_ptr_weights_i, reg_weights_width_in_byte);
+          vbroadcastss(ymm_weight, ptr[reg_ptr_weights_i]);
+        }
         size_t w_offset = 0;
         for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
           vmovups(ymm_t(reg_i), ptr[reg_ptr_tbl_i + w_offset]);
+          if (with_weights_) {
+            vmulps(ymm_t(reg_i), ymm_t(reg_i), ymm_weight);
+          }
           vaddps(
               ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs), ymm_t(reg_i));
           w_offset += block_size;
@@ -101,9 +144,11 @@ void EmbSeqPoolJitCode::genCode() {
         jl(l_next_idx_h, T_NEAR);
       }  // end of idx h
       L(l_save_now);
-      // avg or sqrt here, if needed
       w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
+        if (with_scale) {
+          vmulps(ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs), ymm_scale);
+        }
         vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i + num_regs));
         w_offset += block_size;
       }
@@ -126,7 +171,7 @@ class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
            attr.table_width % YMM_FLOAT_BLOCK == 0;
   }
   size_t CodeSize(const emb_seq_pool_attr_t& attr) const override {
-    return 96 + (attr.table_width / YMM_FLOAT_BLOCK) * 96 * 8;
+    return 192 + (attr.table_width / YMM_FLOAT_BLOCK) * 128 * 8;
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const emb_seq_pool_attr_t& attr) const override {
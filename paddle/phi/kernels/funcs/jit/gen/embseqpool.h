@@ -31,10 +31,8 @@ class EmbSeqPoolJitCode : public JitCode {
                              void* code_ptr = nullptr)
       : JitCode(code_size, code_ptr),
         tbl_w_(attr.table_width),
-        type_(attr.pool_type) {
-    if (type_ != SeqPoolType::kSum) {
-      PADDLE_THROW(phi::errors::Unimplemented("Only supports sum pool yet."));
-    }
+        type_(attr.pool_type),
+        with_weights_(attr.with_weights) {
     this->genCode();
   }
 
@@ -47,18 +45,26 @@ class EmbSeqPoolJitCode : public JitCode {
     } else if (type_ == SeqPoolType::kSqrt) {
       base += "_Sqrt";
     }
+    if (with_weights_) {
+      base += "_Weighted";
+    }
     base += ("_W" + std::to_string(tbl_w_));
     return base;
   }
   void genCode() override;
 
  private:
+  // broadcast 1/h or 1/sqrt(h) of the runtime index_height to ymm_scale
+  void genScale();
+
   int tbl_w_;
   SeqPoolType type_;
+  bool with_weights_;
   reg64_t param_tbl{abi_param1};
   reg64_t param_idx{abi_param2};
-  reg64_t param_dst{abi_param3};
-  reg64_t param_attr{abi_param4};
+  reg64_t param_weights{abi_param3};
+  reg64_t param_dst{abi_param4};
+  reg64_t param_attr{abi_param5};
 
   reg64_t reg_tmp{rax};
 
@@ -73,6 +79,15 @@ class EmbSeqPoolJitCode : public JitCode {
 
   reg64_t reg_idx_w_i_in_byte{r14};
   reg64_t reg_idx_h_end{r15};
+
+  // rdx is used in mul, so keep weights in callee saved registers
+  reg64_t reg_ptr_weights{rbx};
+  reg64_t reg_ptr_weights_i{rbp};
+  // param_dst is copied before, so rcx is free to use
+  reg64_t reg_weights_width_in_byte{rcx};
+
+  ymm_t ymm_scale = ymm_t(14);
+  ymm_t ymm_weight = ymm_t(15);
 };
 
 }  // namespace gen
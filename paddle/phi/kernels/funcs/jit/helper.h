@@ -275,7 +275,8 @@ inline std::ostream& operator<<(std::ostream& os,
   os << "table_height[" << attr.table_height << "],table_width["
      << attr.table_width << "],index_height[" << attr.index_height
      << "],index_width[" << attr.index_width << "],output_width["
-     << attr.out_width << "],pool_type[" << to_string(attr.pool_type) << "]";
+     << attr.out_width << "],pool_type[" << to_string(attr.pool_type)
+     << "],with_weights[" << attr.with_weights << "]";
   return os;
 }
 
@@ -212,21 +212,26 @@ typedef struct emb_seq_pool_attr_s {
   int64_t index_height, index_width;
   int64_t out_width;
   SeqPoolType pool_type;
+  // whether each index has a weight, which scales its row before pooling
+  bool with_weights{false};
   emb_seq_pool_attr_s() = default;
   explicit emb_seq_pool_attr_s(int64_t tbl_height,
                                int64_t tbl_width,
                                int64_t idx_height,
                                int64_t idx_width,
                                int64_t output_width,
-                               SeqPoolType seqpool_type = SeqPoolType::kSum)
+                               SeqPoolType seqpool_type = SeqPoolType::kSum,
+                               bool weighted = false)
       : table_height(tbl_height),
         table_width(tbl_width),
         index_height(idx_height),
         index_width(idx_width),
         out_width(output_width),
-        pool_type(seqpool_type) {}
+        pool_type(seqpool_type),
+        with_weights(weighted) {}
 } emb_seq_pool_attr_t;
 
+// table, idx, weights(same shape as idx, only read when with_weights), out
 template <typename T>
 struct EmbSeqPoolTuple {
   static constexpr KernelType kernel_type = kEmbSeqPool;
@@ -234,6 +239,7 @@ struct EmbSeqPoolTuple {
   typedef emb_seq_pool_attr_t attr_type;
   typedef void (*func_type)(const T*,
                             const int64_t*,
+                            const T*,
                             T*,
                             const emb_seq_pool_attr_t*);
 };
@@ -58,7 +58,10 @@ int64_t JitCodeKey<matmul_attr_t>(const matmul_attr_t& attr) {
 
 template <>
 int64_t JitCodeKey<emb_seq_pool_attr_t>(const emb_seq_pool_attr_t& attr) {
-  return attr.table_width;
+  std::array<int64_t, 3> keys = {attr.table_width,
+                                 static_cast<int64_t>(attr.pool_type),
+                                 static_cast<int64_t>(attr.with_weights)};
+  return static_cast<int64_t>(XXH64(keys.data(), sizeof(int64_t) * 3, 0));
 }
 
 template <>
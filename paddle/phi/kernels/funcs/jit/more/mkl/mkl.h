@@ -102,6 +102,7 @@ void SeqPool(const T* x, T* y, const seq_pool_attr_t* attr) {
 template <typename T>
 void EmbSeqPool(const T* table,
                 const int64_t* idx,
+                const T* weights,
                 T* out,
                 const emb_seq_pool_attr_t* attr) {
   PADDLE_ENFORCE_EQ(
@@ -134,21 +135,38 @@ void EmbSeqPool(const T* table,
 
   for (int64_t w = 0; w != attr->index_width; ++w) {
     check_idx_value_valid(w);
-    VCopy<T>(table + idx[w] * attr->table_width,
-             out + w * attr->table_width,
-             attr->table_width);
+    if (attr->with_weights) {
+      VScal<T>(weights + w,
+               table + idx[w] * attr->table_width,
+               out + w * attr->table_width,
+               attr->table_width);
+    } else {
+      VCopy<T>(table + idx[w] * attr->table_width,
+               out + w * attr->table_width,
+               attr->table_width);
+    }
   }
 
   for (int64_t h = 1; h < attr->index_height; ++h) {
     for (int64_t w = 0; w < attr->index_width; ++w) {
       int64_t i = h * attr->index_width + w;
       check_idx_value_valid(i);
-      VAXPY<T>(static_cast<T>(1),
+      VAXPY<T>(attr->with_weights ? weights[i] : static_cast<T>(1),
                table + idx[i] * attr->table_width,
                out + w * attr->table_width,
                attr->table_width);
     }
   }
+
+  if (attr->pool_type != SeqPoolType::kSum && attr->index_height > 1) {
+    T scalar = static_cast<T>(1);
+    if (attr->pool_type == SeqPoolType::kAvg) {
+      scalar = scalar / static_cast<T>(attr->index_height);
+    } else {
+      scalar = scalar / std::sqrt(static_cast<T>(attr->index_height));
+    }
+    VScal<T>(&scalar, out, out, attr->out_width);
+  }
 }
 
 template <typename T>
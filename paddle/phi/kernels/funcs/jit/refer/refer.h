@@ -397,10 +397,12 @@ void MatMul(const T* A, const T* B, T* C, const matmul_attr_t* attr) {
 // embedding seq pool
 // table is a matrix with (tbl_h, tbl_w)
 // idx is a matrix with (idx_h, idx_w)
+// weights is a matrix with (idx_h, idx_w), only used if attr->with_weights
 // output is a vector with length tbl_w * idx_w
 template <typename T>
 void EmbSeqPool(const T* table,
                 const int64_t* idx,
+                const T* weights,
                 T* out,
                 const emb_seq_pool_attr_t* attr) {
   PADDLE_ENFORCE_EQ(
@@ -434,20 +436,42 @@ void EmbSeqPool(const T* table,
 
   for (int64_t w = 0; w != attr->index_width; ++w) {
     check_idx_value_valid(w);
-    std::memcpy(out + w * attr->table_width,
-                table + idx[w] * attr->table_width,
-                attr->table_width * sizeof(T));
+    if (attr->with_weights) {
+      VScal(weights + w,
+            table + idx[w] * attr->table_width,
+            out + w * attr->table_width,
+            attr->table_width);
+    } else {
+      std::memcpy(out + w * attr->table_width,
+                  table + idx[w] * attr->table_width,
+                  attr->table_width * sizeof(T));
+    }
   }
 
   for (int64_t h = 1; h < attr->index_height; ++h) {
     for (int64_t w = 0; w < attr->index_width; ++w) {
       int64_t i = h * attr->index_width + w;
       check_idx_value_valid(i);
-      VAdd(table + idx[i] * attr->table_width,
-           out + w * attr->table_width,
-           out + w * attr->table_width,
-           attr->table_width);
+      const T* row = table + idx[i] * attr->table_width;
+      T* dst = out + w * attr->table_width;
+      if (attr->with_weights) {
+        for (int64_t j = 0; j < attr->table_width; ++j) {
+          dst[j] += weights[i] * row[j];
+        }
+      } else {
+        VAdd(row, dst, dst, attr->table_width);
+      }
+    }
+  }
+
+  if (attr->pool_type != SeqPoolType::kSum && attr->index_height > 1) {
+    T scalar = static_cast<T>(1);
+    if (attr->pool_type == SeqPoolType::kAvg) {
+      scalar = scalar / static_cast<T>(attr->index_height);
+    } else {
+      scalar = scalar / std::sqrt(static_cast<T>(attr->index_height));
     }
+    VScal<T>(&scalar, out, out, attr->out_width);
   }
 }
 
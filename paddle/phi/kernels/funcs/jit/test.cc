@@ -594,7 +594,7 @@ void TestKernelEmbSeqPool() {
   VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
   int64_t tbl_h = 1e4;
   std::vector<jit::SeqPoolType> pool_types = {
-      jit::SeqPoolType::kSum};  // only support sum yet
+      jit::SeqPoolType::kSum, jit::SeqPoolType::kAvg, jit::SeqPoolType::kSqrt};
   auto test_sizes = TestSizes();
   test_sizes.erase(std::remove(test_sizes.begin(), test_sizes.end(), 1000),
                    test_sizes.end());
@@ -603,45 +603,52 @@ void TestKernelEmbSeqPool() {
     RandomVec<T>(tbl_h * tbl_w, table.data());
     const T* table_data = table.data();
     for (auto type : pool_types) {
-      for (int idx_w : {1, 2, 10, 16}) {
-        for (int idx_h : {1, 2, 9, 13, 16}) {
-          auto ref = jit::GetReferFunc<KernelTuple>();
-          EXPECT_TRUE(ref != nullptr);
-          std::vector<int64_t> idx(idx_h * idx_w);
-          RandomVec<int64_t>(idx_h * idx_w, idx.data(), 0, tbl_h - 1);
-          int64_t out_w = tbl_w * idx_w;
-          std::vector<T> oref(out_w);
-          const int64_t* idx_data = idx.data();
-          T* o_data = oref.data();
-          jit::emb_seq_pool_attr_t attr(
-              tbl_h, tbl_w, idx_h, idx_w, out_w, type);
-          ref(table_data, idx_data, o_data, &attr);
-
-          auto verifier = [](const typename KernelTuple::func_type tgt,
-                             const std::vector<T>& table,
-                             const std::vector<int64_t>& idx,
-                             const std::vector<T>& oref,
-                             const typename KernelTuple::attr_type& attr) {
-            EXPECT_TRUE(tgt != nullptr);
-            EXPECT_EQ(
-                table.size(),
-                static_cast<size_t>(attr.table_height * attr.table_width));
-            EXPECT_EQ(
-                idx.size(),
-                static_cast<size_t>(attr.index_height * attr.index_width));
-            EXPECT_EQ(oref.size(),
-                      static_cast<size_t>(attr.table_width * attr.index_width));
-            const T* table_data = table.data();
+      for (bool weighted : {false, true}) {
+        for (int idx_w : {1, 2, 10, 16}) {
+          for (int idx_h : {1, 2, 9, 13, 16}) {
+            auto ref = jit::GetReferFunc<KernelTuple>();
+            EXPECT_TRUE(ref != nullptr);
+            std::vector<int64_t> idx(idx_h * idx_w);
+            RandomVec<int64_t>(idx_h * idx_w, idx.data(), 0, tbl_h - 1);
+            std::vector<T> weights(idx_h * idx_w);
+            RandomVec<T>(idx_h * idx_w, weights.data());
+            int64_t out_w = tbl_w * idx_w;
+            std::vector<T> oref(out_w);
             const int64_t* idx_data = idx.data();
-            const T* oref_data = oref.data();
-            int o_w = oref.size();
-            std::vector<T> out(o_w);
-            T* o_data = out.data();
-            tgt(table_data, idx_data, o_data, &attr);
-            ExpectEQ<T>(o_data, oref_data, o_w);
-          };
-          TestAllImpls<KernelTuple, PlaceType>(
-              attr, verifier, table, idx, oref, attr);
+            const T* w_data = weights.data();
+            T* o_data = oref.data();
+            jit::emb_seq_pool_attr_t attr(
+                tbl_h, tbl_w, idx_h, idx_w, out_w, type, weighted);
+            ref(table_data, idx_data, w_data, o_data, &attr);
+
+            auto verifier = [](const typename KernelTuple::func_type tgt,
+                               const std::vector<T>& table,
+                               const std::vector<int64_t>& idx,
+                               const std::vector<T>& weights,
+                               const std::vector<T>& oref,
+                               const typename KernelTuple::attr_type& attr) {
+              EXPECT_TRUE(tgt != nullptr);
+              EXPECT_EQ(
+                  table.size(),
+                  static_cast<size_t>(attr.table_height * attr.table_width));
+              EXPECT_EQ(
+                  idx.size(),
+                  static_cast<size_t>(attr.index_height * attr.index_width));
+              EXPECT_EQ(
+                  oref.size(),
+                  static_cast<size_t>(attr.table_width * attr.index_width));
+              const T* table_data = table.data();
+              const int64_t* idx_data = idx.data();
+              const T* oref_data = oref.data();
+              int o_w = oref.size();
+              std::vector<T> out(o_w);
+              T* o_data = out.data();
+              tgt(table_data, idx_data, weights.data(), o_data, &attr);
+              ExpectEQ<T>(o_data, oref_data, o_w);
+            };
+            TestAllImpls<KernelTuple, PlaceType>(
+                attr, verifier, table, idx, weights, oref, attr);
+          }
         }
       }
     }
@@ -1257,7 +1264,7 @@ TEST(JITKernel_helper, attr) {
 
   out.str("");
   out << jit::emb_seq_pool_attr_t(1, 2, 3, 4, 5, jit::SeqPoolType::kAvg);
-  EXPECT_EQ(out.str().size(), 93UL);
+  EXPECT_EQ(out.str().size(), 109UL);
 
   out.str("");
   out << jit::sgd_attr_t(1, 2, 3, 4, 5);
@@ -1362,18 +1369,24 @@ TEST(JITKernel_key, emb_seq_pool) {
   jit::emb_seq_pool_attr_t attr3(10, 2, 9, 8, 7, jit::SeqPoolType::kAvg);
   jit::emb_seq_pool_attr_t attr4(10, 3, 9, 8, 7, jit::SeqPoolType::kSum);
   jit::emb_seq_pool_attr_t attr5(1, 6, 3, 4, 5, jit::SeqPoolType::kSum);
+  jit::emb_seq_pool_attr_t attr6(10, 2, 9, 8, 7, jit::SeqPoolType::kSum);
+  jit::emb_seq_pool_attr_t attr7(1, 2, 3, 4, 5, jit::SeqPoolType::kSum, true);
 
   auto key1 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr1);
   auto key2 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr2);
   auto key3 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr3);
   auto key4 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr4);
   auto key5 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr5);
+  auto key6 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr6);
+  auto key7 = jit::JitCodeKey<jit::emb_seq_pool_attr_t>(attr7);
 
   EXPECT_TRUE(key1 == key2);
-  EXPECT_TRUE(key2 == key3);
+  EXPECT_TRUE(key2 == key6);
+  EXPECT_TRUE(key2 != key3);
   EXPECT_TRUE(key2 != key4);
   EXPECT_TRUE(key2 != key5);
   EXPECT_TRUE(key4 != key5);
+  EXPECT_TRUE(key2 != key7);
 }
 
 TEST(JITKernel_key, adam) {
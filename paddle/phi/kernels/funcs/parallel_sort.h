@@ -0,0 +1,645 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+// Sort and selection routines shared by the CPU sort, argsort, topk,
+// kthvalue and unique kernels.
+//
+// Values are first encoded into unsigned keys whose unsigned order is the
+// order of the values, so that the keys can be radix sorted and radix
+// selected. NaN is encoded as the largest key, and -0.0 is encoded as 0.0, to
+// keep the order used by the comparison based kernels. Every routine orders
+// equal keys by their position, so the results are deterministic, and a sort
+// is always stable.
+//
+// Rows are spread over the OpenMP threads. If there are fewer rows than
+// threads and the rows are long, each row is processed with all the threads
+// instead.
+
+namespace phi {
+namespace funcs {
+
+// Rows shorter than this are sorted by comparison.
+constexpr int64_t kRadixSortMinLength = 256;
+// Rows at least this long are split across the threads when there are not
+// enough rows to keep every thread busy.
+constexpr int64_t kParallelRowMinLength = 1 << 16;
+
+inline int GetSortNumThreads() {
+#ifdef PADDLE_WITH_MKLML
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+template <typename T>
+struct RadixKey;
+
+template <typename KeyT>
+inline KeyT EncodeFloatBits(KeyT bits, bool is_nan, bool is_zero) {
+  constexpr KeyT kSignBit =
+      static_cast<KeyT>(KeyT(1) << (sizeof(KeyT) * 8 - 1));
+  if (is_nan) return static_cast<KeyT>(~KeyT(0));
+  if (is_zero) return kSignBit;
+  return (bits & kSignBit) ? static_cast<KeyT>(~bits)
+                           : static_cast<KeyT>(bits | kSignBit);
+}
+
+template <typename T, typename UnsignedT>
+struct SignedIntRadixKey {
+  using KeyT = UnsignedT;
+  static KeyT Encode(T value) {
+    return static_cast<KeyT>(static_cast<KeyT>(value) ^
+                             (KeyT(1) << (sizeof(KeyT) * 8 - 1)));
+  }
+};
+
+template <>
+struct RadixKey<int32_t> : SignedIntRadixKey<int32_t, uint32_t> {};
+
+template <>
+struct RadixKey<int64_t> : SignedIntRadixKey<int64_t, uint64_t> {};
+
+template <>
+struct RadixKey<float> {
+  using KeyT = uint32_t;
+  static KeyT Encode(float value) {
+    KeyT bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return EncodeFloatBits<KeyT>(bits, std::isnan(value), value == 0.0f);
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  using KeyT = uint64_t;
+  static KeyT Encode(double value) {
+    KeyT bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return EncodeFloatBits<KeyT>(bits, std::isnan(value), value == 0.0);
+  }
+};
+
+template <>
+struct RadixKey<phi::dtype::float16> {
+  using KeyT = uint16_t;
+  static KeyT Encode(phi::dtype::float16 value) {
+    KeyT magnitude = value.x & 0x7fff;
+    return EncodeFloatBits<KeyT>(value.x, magnitude > 0x7c00, magnitude == 0);
+  }
+};
+
+template <>
+struct RadixKey<phi::dtype::bfloat16> {
+  using KeyT = uint16_t;
+  static KeyT Encode(phi::dtype::bfloat16 value) {
+    KeyT magnitude = value.x & 0x7fff;
+    return EncodeFloatBits<KeyT>(value.x, magnitude > 0x7f80, magnitude == 0);
+  }
+};
+
+// Encode n values into keys, reversing the order if descending.
+template <typename T>
+void EncodeRadixKeys(const T* in,
+                     int64_t n,
+                     bool descending,
+                     typename RadixKey<T>::KeyT* keys,
+                     int num_threads) {
+  using KeyT = typename RadixKey<T>::KeyT;
+  const KeyT flip = descending ? static_cast<KeyT>(~KeyT(0)) : KeyT(0);
+  if (num_threads <= 1) {
+    for (int64_t i = 0; i < n; ++i) {
+      keys[i] = RadixKey<T>::Encode(in[i]) ^ flip;
+    }
+    return;
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int64_t i = 0; i < n; ++i) {
+    keys[i] = RadixKey<T>::Encode(in[i]) ^ flip;
+  }
+}
+
+// Stable LSD radix sort of the (key, value) pairs by key, one byte per pass.
+// Passes on which all the keys share the same byte are skipped, which makes
+// sorting keys with a narrow range cheap. The result is written back into
+// keys and values, keys_buf and values_buf are scratch buffers of n elements.
+template <typename KeyT, typename ValueT>
+void RadixSortPairs(KeyT* keys,
+                    ValueT* values,
+                    KeyT* keys_buf,
+                    ValueT* values_buf,
+                    int64_t n,
+                    int num_threads = 1) {
+  constexpr int kPasses = sizeof(KeyT);
+  constexpr int kBuckets = 256;
+  if (n <= 1) return;
+  num_threads = static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>(num_threads, n / kParallelRowMinLength + 1)));
+  const int64_t chunk = (n + num_threads - 1) / num_threads;
+
+  // counts[thread][pass][bucket], the histograms of every pass are collected
+  // with one read of the keys.
+  std::vector<int64_t> counts(
+      static_cast<size_t>(num_threads) * kPasses * kBuckets, 0);
+  auto count_chunk = [&](const KeyT* src, int t, int first_pass, int passes) {
+    int64_t* thread_counts = counts.data() + t * kPasses * kBuckets;
+    const int64_t end = std::min(n, (t + 1) * chunk);
+    for (int64_t i = t * chunk; i < end; ++i) {
+      for (int pass = first_pass; pass < first_pass + passes; ++pass) {
+        ++thread_counts[pass * kBuckets + ((src[i] >> (pass * 8)) & 0xFF)];
+      }
+    }
+  };
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int t = 0; t < num_threads; ++t) {
+    count_chunk(keys, t, 0, kPasses);
+  }
+
+  KeyT* src_keys = keys;
+  ValueT* src_values = values;
+  KeyT* dst_keys = keys_buf;
+  ValueT* dst_values = values_buf;
+  std::vector<int64_t> offsets(static_cast<size_t>(num_threads) * kBuckets);
+  bool permuted = false;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    const int shift = pass * 8;
+    // The total of a bucket does not depend on the order of the keys
+    const int first_bucket = (src_keys[0] >> shift) & 0xFF;
+    int64_t first_bucket_total = 0;
+    for (int t = 0; t < num_threads; ++t) {
+      first_bucket_total +=
+          counts[(t * kPasses + pass) * kBuckets + first_bucket];
+    }
+    if (first_bucket_total == n) continue;
+
+    // The per thread histograms have to follow the current order of the keys
+    if (permuted && num_threads > 1) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+      for (int t = 0; t < num_threads; ++t) {
+        int64_t* pass_counts = counts.data() + (t * kPasses + pass) * kBuckets;
+        std::fill(pass_counts, pass_counts + kBuckets, 0);
+        count_chunk(src_keys, t, pass, 1);
+      }
+    }
+
+    int64_t running = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+      for (int t = 0; t < num_threads; ++t) {
+        offsets[t * kBuckets + b] = running;
+        running += counts[(t * kPasses + pass) * kBuckets + b];
+      }
+    }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+    for (int t = 0; t < num_threads; ++t) {
+      int64_t* thread_offsets = offsets.data() + t * kBuckets;
+      const int64_t end = std::min(n, (t + 1) * chunk);
+      for (int64_t i = t * chunk; i < end; ++i) {
+        int64_t pos = thread_offsets[(src_keys[i] >> shift) & 0xFF]++;
+        dst_keys[pos] = src_keys[i];
+        dst_values[pos] = src_values[i];
+      }
+    }
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+    permuted = true;
+  }
+
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    std::copy(src_values, src_values + n, values);
+  }
+}
+
+// Select the k smallest keys of keys[0, n) in the order of (key, position).
+// The threshold key is found byte by byte from the most significant one, each
+// level only scanning the candidates left by the previous one. The positions
+// of the selected keys are written to selected in ascending order, and
+// kth_position receives the position of the k-th smallest key. Either of them
+// may be nullptr.
+template <typename KeyT>
+void RadixSelect(const KeyT* keys,
+                 int64_t n,
+                 int64_t k,
+                 std::vector<int64_t>* candidates,
+                 std::vector<int64_t>* selected,
+                 int64_t* kth_position = nullptr) {
+  constexpr int kBits = sizeof(KeyT) * 8;
+  if (selected != nullptr) selected->clear();
+  candidates->clear();
+  k = std::min(k, n);
+  if (k <= 0) return;
+
+  KeyT prefix = 0;
+  int64_t remaining = k;
+  for (int shift = kBits - 8; shift >= 0; shift -= 8) {
+    int64_t hist[256] = {0};
+    const bool first_level = (shift == kBits - 8);
+    if (first_level) {
+      for (int64_t i = 0; i < n; ++i) {
+        ++hist[(keys[i] >> shift) & 0xFF];
+      }
+    } else {
+      for (int64_t pos : *candidates) {
+        ++hist[(keys[pos] >> shift) & 0xFF];
+      }
+    }
+    int bucket = 0;
+    while (remaining > hist[bucket]) {
+      remaining -= hist[bucket];
+      ++bucket;
+    }
+    prefix |= static_cast<KeyT>(static_cast<KeyT>(bucket) << shift);
+    const int64_t level_shift = shift;
+    auto in_bucket = [&](int64_t pos) {
+      return ((keys[pos] >> level_shift) & 0xFF) == bucket;
+    };
+    if (first_level) {
+      candidates->reserve(hist[bucket]);
+      for (int64_t i = 0; i < n; ++i) {
+        if (in_bucket(i)) candidates->push_back(i);
+      }
+    } else {
+      candidates->erase(std::stable_partition(
+                            candidates->begin(), candidates->end(), in_bucket),
+                        candidates->end());
+    }
+  }
+
+  // Now every candidate equals the threshold key `prefix`, and the first
+  // `remaining` of them are the ties to take.
+  if (kth_position != nullptr) {
+    *kth_position = (*candidates)[remaining - 1];
+  }
+  if (selected != nullptr) {
+    selected->reserve(k);
+    int64_t ties = 0;
+    for (int64_t i = 0; i < n; ++i) {
+      if (keys[i] < prefix || (keys[i] == prefix && ties++ < remaining)) {
+        selected->push_back(i);
+      }
+    }
+  }
+}
+
+template <typename T>
+struct SortWorkspace {
+  using KeyT = typename RadixKey<T>::KeyT;
+  std::vector<KeyT> keys;
+  std::vector<KeyT> keys_buf;
+  std::vector<int64_t> positions;
+  std::vector<int64_t> positions_buf;
+  std::vector<int64_t> candidates;
+  std::vector<int64_t> selected;
+  std::vector<std::pair<KeyT, int64_t>> pairs;
+};
+
+// Select the k smallest keys with the rows split over num_threads chunks. The
+// k smallest keys of the row are among the k smallest keys of their chunks,
+// so the selection is repeated on the union of the chunk results.
+template <typename KeyT>
+void ParallelRadixSelect(const KeyT* keys,
+                         int64_t n,
+                         int64_t k,
+                         int num_threads,
+                         std::vector<int64_t>* candidates,
+                         std::vector<int64_t>* selected,
+                         int64_t* kth_position = nullptr) {
+  k = std::min(k, n);
+  num_threads = static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>(num_threads, n / kParallelRowMinLength + 1)));
+  if (num_threads <= 1 || k * num_threads >= n) {
+    RadixSelect(keys, n, k, candidates, selected, kth_position);
+    return;
+  }
+  const int64_t chunk = (n + num_threads - 1) / num_threads;
+  std::vector<std::vector<int64_t>> chunk_selected(num_threads);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int t = 0; t < num_threads; ++t) {
+    const int64_t begin = std::min(n, t * chunk);
+    const int64_t len = std::min(n, begin + chunk) - begin;
+    std::vector<int64_t> chunk_candidates;
+    RadixSelect(
+        keys + begin, len, k, &chunk_candidates, &chunk_selected[t], nullptr);
+    for (auto& pos : chunk_selected[t]) pos += begin;
+  }
+
+  std::vector<int64_t> merged_positions;
+  merged_positions.reserve(k * num_threads);
+  for (const auto& positions : chunk_selected) {
+    merged_positions.insert(
+        merged_positions.end(), positions.begin(), positions.end());
+  }
+  std::vector<KeyT> merged_keys(merged_positions.size());
+  for (size_t i = 0; i < merged_positions.size(); ++i) {
+    merged_keys[i] = keys[merged_positions[i]];
+  }
+  int64_t merged_kth = 0;
+  RadixSelect(merged_keys.data(),
+              static_cast<int64_t>(merged_keys.size()),
+              k,
+              candidates,
+              selected,
+              &merged_kth);
+  if (selected != nullptr) {
+    for (auto& pos : *selected) pos = merged_positions[pos];
+  }
+  if (kth_position != nullptr) {
+    *kth_position = merged_positions[merged_kth];
+  }
+}
+
+// Sort n values in ascending or descending order, writing the sorted values to
+// out and their positions to out_positions.
+template <typename T, typename IndexT>
+void SortRow(const T* in,
+             int64_t n,
+             bool descending,
+             T* out,
+             IndexT* out_positions,
+             SortWorkspace<T>* ws,
+             int num_threads = 1) {
+  ws->keys.resize(n);
+  ws->positions.resize(n);
+  EncodeRadixKeys(in, n, descending, ws->keys.data(), num_threads);
+  std::iota(ws->positions.begin(), ws->positions.end(), 0);
+  if (n < kRadixSortMinLength) {
+    const auto& keys = ws->keys;
+    std::sort(ws->positions.begin(),
+              ws->positions.end(),
+              [&keys](int64_t l, int64_t r) {
+                return keys[l] < keys[r] || (keys[l] == keys[r] && l < r);
+              });
+  } else {
+    ws->keys_buf.resize(n);
+    ws->positions_buf.resize(n);
+    RadixSortPairs(ws->keys.data(),
+                   ws->positions.data(),
+                   ws->keys_buf.data(),
+                   ws->positions_buf.data(),
+                   n,
+                   num_threads);
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    const int64_t pos = ws->positions[i];
+    if (out != nullptr) out[i] = in[pos];
+    out_positions[i] = static_cast<IndexT>(pos);
+  }
+}
+
+// Select the k smallest keys of [begin, end) in the order of (key, position),
+// where key_at(i) returns the key at position i. Keys below the threshold are
+// kept in a buffer of 2k entries, which is cut back to the k smallest ones
+// with nth_element whenever it is full, and the threshold becomes the largest
+// key kept. When k is small nearly every key fails the threshold test, so this
+// is a single pass over the row without writing the keys out. The k selected
+// (key, position) pairs are appended to selected in no particular order.
+template <typename KeyT, typename KeyFn>
+void ThresholdSelect(KeyFn&& key_at,
+                     int64_t begin,
+                     int64_t end,
+                     int64_t k,
+                     std::vector<std::pair<KeyT, int64_t>>* selected) {
+  k = std::min(k, end - begin);
+  if (k <= 0) return;
+  std::vector<std::pair<KeyT, int64_t>> buffer;
+  buffer.reserve(2 * k);
+  auto cut = [&buffer, k]() {
+    std::nth_element(buffer.begin(), buffer.begin() + k - 1, buffer.end());
+    buffer.resize(k);
+  };
+  int64_t i = begin;
+  for (; i < end && static_cast<int64_t>(buffer.size()) < 2 * k; ++i) {
+    buffer.emplace_back(key_at(i), i);
+  }
+  if (i < end) {
+    cut();
+    // A later key equal to the threshold has a larger position, so it is
+    // never one of the k smallest.
+    KeyT threshold = buffer[k - 1].first;
+    for (; i < end; ++i) {
+      const KeyT key = key_at(i);
+      if (key < threshold) {
+        buffer.emplace_back(key, i);
+        if (static_cast<int64_t>(buffer.size()) == 2 * k) {
+          cut();
+          threshold = buffer[k - 1].first;
+        }
+      }
+    }
+  }
+  if (static_cast<int64_t>(buffer.size()) > k) cut();
+  selected->insert(selected->end(), buffer.begin(), buffer.end());
+}
+
+// Select the k smallest (key, position) pairs of n values encoded on the fly,
+// with the row split over num_threads chunks. The k smallest pairs of the row
+// are among the k smallest pairs of their chunks.
+template <typename T>
+void ParallelThresholdSelect(
+    const T* in,
+    int64_t n,
+    int64_t k,
+    bool descending,
+    int num_threads,
+    std::vector<std::pair<typename RadixKey<T>::KeyT, int64_t>>* selected) {
+  using KeyT = typename RadixKey<T>::KeyT;
+  const KeyT flip = descending ? static_cast<KeyT>(~KeyT(0)) : KeyT(0);
+  auto key_at = [in, flip](int64_t i) {
+    return static_cast<KeyT>(RadixKey<T>::Encode(in[i]) ^ flip);
+  };
+  selected->clear();
+  if (k <= 0) return;
+  num_threads = static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>(num_threads, n / kParallelRowMinLength + 1)));
+  if (num_threads <= 1) {
+    ThresholdSelect<KeyT>(key_at, 0, n, k, selected);
+    return;
+  }
+  const int64_t chunk = (n + num_threads - 1) / num_threads;
+  std::vector<std::vector<std::pair<KeyT, int64_t>>> chunk_selected(
+      num_threads);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int t = 0; t < num_threads; ++t) {
+    ThresholdSelect<KeyT>(key_at,
+                          std::min(n, t * chunk),
+                          std::min(n, (t + 1) * chunk),
+                          k,
+                          &chunk_selected[t]);
+  }
+  for (const auto& pairs : chunk_selected) {
+    selected->insert(selected->end(), pairs.begin(), pairs.end());
+  }
+  k = std::min<int64_t>(k, selected->size());
+  std::nth_element(
+      selected->begin(), selected->begin() + k - 1, selected->end());
+  selected->resize(k);
+}
+
+// Rows with k * kThresholdSelectRatio < n are selected by ThresholdSelect,
+// other rows by RadixSelect.
+constexpr int64_t kThresholdSelectRatio = 64;
+
+// Select the k largest (or smallest) of n values. If sorted is false, the
+// selected values are in the order of their positions.
+template <typename T, typename IndexT>
+void TopKRow(const T* in,
+             int64_t n,
+             int64_t k,
+             bool largest,
+             bool sorted,
+             T* out,
+             IndexT* out_positions,
+             SortWorkspace<T>* ws,
+             int num_threads = 1) {
+  using KeyT = typename RadixKey<T>::KeyT;
+  auto& selected = ws->selected;
+  if (k * kThresholdSelectRatio < n) {
+    auto& pairs = ws->pairs;
+    ParallelThresholdSelect(in, n, k, largest, num_threads, &pairs);
+    if (sorted) {
+      std::sort(pairs.begin(), pairs.end());
+    } else {
+      std::sort(pairs.begin(),
+                pairs.end(),
+                [](const std::pair<KeyT, int64_t>& l,
+                   const std::pair<KeyT, int64_t>& r) {
+                  return l.second < r.second;
+                });
+    }
+    selected.resize(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      selected[i] = pairs[i].second;
+    }
+  } else {
+    ws->keys.resize(n);
+    EncodeRadixKeys(in, n, largest, ws->keys.data(), num_threads);
+    ParallelRadixSelect(ws->keys.data(),
+                        n,
+                        k,
+                        num_threads,
+                        &ws->candidates,
+                        &selected,
+                        nullptr);
+    if (sorted) {
+      // The selection is in position order, so a stable sort by key orders it
+      // by (key, position).
+      const int64_t m = static_cast<int64_t>(selected.size());
+      std::vector<KeyT> selected_keys(m);
+      for (int64_t i = 0; i < m; ++i) {
+        selected_keys[i] = ws->keys[selected[i]];
+      }
+      ws->keys_buf.resize(m);
+      ws->positions_buf.resize(m);
+      RadixSortPairs(selected_keys.data(),
+                     selected.data(),
+                     ws->keys_buf.data(),
+                     ws->positions_buf.data(),
+                     m);
+    }
+  }
+  for (size_t i = 0; i < selected.size(); ++i) {
+    out[i] = in[selected[i]];
+    out_positions[i] = static_cast<IndexT>(selected[i]);
+  }
+}
+
+// Find the k-th (1-based) smallest of n values.
+template <typename T, typename IndexT>
+void KthValueRow(const T* in,
+                 int64_t n,
+                 int64_t k,
+                 T* out,
+                 IndexT* out_position,
+                 SortWorkspace<T>* ws,
+                 int num_threads = 1) {
+  int64_t kth_position = 0;
+  if (k * kThresholdSelectRatio < n) {
+    auto& pairs = ws->pairs;
+    ParallelThresholdSelect(in, n, k, false, num_threads, &pairs);
+    kth_position = std::max_element(pairs.begin(), pairs.end())->second;
+  } else {
+    ws->keys.resize(n);
+    EncodeRadixKeys(in, n, false, ws->keys.data(), num_threads);
+    ParallelRadixSelect(ws->keys.data(),
+                        n,
+                        k,
+                        num_threads,
+                        &ws->candidates,
+                        nullptr,
+                        &kth_position);
+  }
+  *out = in[kth_position];
+  *out_position = static_cast<IndexT>(kth_position);
+}
+
+// Run row_fn(row, workspace, num_threads) on each of the height rows of width
+// elements. Rows are spread over the threads, unless there are fewer rows than
+// threads and the rows are long enough to be split across the threads.
+template <typename T, typename RowFn>
+void ForEachSortRow(int64_t height, int64_t width, RowFn&& row_fn) {
+  const int num_threads = GetSortNumThreads();
+  if (num_threads > 1 && height < num_threads &&
+      width >= kParallelRowMinLength) {
+    SortWorkspace<T> ws;
+    for (int64_t i = 0; i < height; ++i) {
+      row_fn(i, &ws, num_threads);
+    }
+    return;
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+  {
+    SortWorkspace<T> ws;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+    for (int64_t i = 0; i < height; ++i) {
+      row_fn(i, &ws, 1);
+    }
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -16,20 +16,18 @@ limitations under the License. */
 
 #include <algorithm>
 #include <map>
+#include <numeric>
 #include <set>
 #include <vector>
 
 #include "paddle/common/ddim.h"
 #include "paddle/phi/core/mixed_vector.h"
+#include "paddle/phi/kernels/funcs/parallel_sort.h"
 
 #ifdef PADDLE_WITH_XPU
 #include "paddle/phi/backends/xpu/enforce_xpu.h"
 #endif
 
-#ifdef PADDLE_WITH_DNNL
-#include "paddle/phi/backends/onednn/axpy_handler.h"
-#endif
-
 #include "glog/logging.h"
 
 namespace phi {
@@ -435,70 +433,6 @@ typename std::enable_if<std::is_integral<T>::value>::type elementwise_add_to(
   }
 }
 
-template <typename T, typename DeviceContext>
-typename std::enable_if<std::is_same<T, phi::dtype::bfloat16>::value>::type
-add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
-                  const std::unordered_map<int64_t, size_t>& rows_to_id,
-                  int64_t input_width,
-                  const DeviceContext& context,
-                  T* out_data) {
-#ifndef PADDLE_WITH_DNNL
-  auto blas = phi::funcs::GetBlas<DeviceContext, T>(context);
-#endif
-  for (auto* input : inputs) {
-    if (input->rows().empty()) {
-      continue;
-    }
-    auto* input_data = input->value().data<T>();
-    auto& input_rows = input->rows();
-
-#ifdef PADDLE_WITH_DNNL
-    OneDNNContext onednn_context(context.GetPlace());
-    funcs::OneDNNAXPYHandler<T> axpy_handler(
-        input_width, T(1.f), onednn_context.GetEngine());
-    for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = rows_to_id.at(input_rows[i]);
-      axpy_handler(&input_data[i * input_width],
-                   &out_data[out_i * input_width]);
-    }
-#else
-    for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = rows_to_id.at(input_rows[i]);
-      elementwise_add_to<T, DeviceContext>(&blas,
-                                           static_cast<size_t>(input_width),
-                                           &input_data[i * input_width],
-                                           &out_data[out_i * input_width]);
-    }
-#endif
-  }
-}
-
-template <typename T, typename DeviceContext>
-typename std::enable_if<!std::is_same<T, phi::dtype::bfloat16>::value>::type
-add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
-                  const std::unordered_map<int64_t, size_t>& rows_to_id,
-                  int64_t input_width,
-                  const DeviceContext& context,
-                  T* out_data) {
-  VLOG(4) << "[CPU] add_sparse_inputs <" << typeid(T).name();
-  auto blas = phi::funcs::GetBlas<DeviceContext, T>(context);
-  for (auto* input : inputs) {
-    if (input->rows().empty()) {
-      continue;
-    }
-    auto* input_data = input->value().data<T>();
-    auto& input_rows = input->rows();
-
-    for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = rows_to_id.at(input_rows[i]);
-      elementwise_add_to<T, DeviceContext>(&blas,
-                                           static_cast<size_t>(input_width),
-                                           &input_data[i * input_width],
-                                           &out_data[out_i * input_width]);
-    }
-  }
-}
-
 template <typename DeviceContext, typename T>
 struct MergeAddImpl {
   phi::SelectedRows operator()(const DeviceContext& context,
@@ -540,7 +474,6 @@ struct MergeAddImpl {
     auto input_width = has_value_input->value().dims()[1];
     auto input_height = has_value_input->height();
     phi::SelectedRows& out = *output;
-    std::set<int64_t> merged_row_set;
     size_t row_num = 0;
     for (auto* input : inputs) {
       if (input->rows().empty()) {
@@ -556,24 +489,58 @@ struct MergeAddImpl {
           input->height(),
           phi::errors::InvalidArgument("All inputs should have same height."));
       row_num += input->rows().size();
-      merged_row_set.insert(input->rows().begin(), input->rows().end());
     }
 
+    // Stable radix sort the positions of all the input rows by row id, then
+    // each run of equal ids is one output row, which sums its input rows in
+    // the order of the inputs. The output rows come out sorted.
+    const int64_t n = static_cast<int64_t>(row_num);
+    std::vector<int64_t> merge_rows;
+    merge_rows.reserve(row_num);
+    std::vector<const T*> src_rows;
+    src_rows.reserve(row_num);
+    for (auto* in : inputs) {
+      if (in->rows().empty()) {
+        continue;
+      }
+      auto* in_data = in->value().data<T>();
+      for (size_t i = 0; i < in->rows().size(); ++i) {
+        merge_rows.push_back(in->rows()[i]);
+        src_rows.push_back(in_data + i * input_width);
+      }
+    }
+    using KeyT = typename RadixKey<int64_t>::KeyT;
+    std::vector<KeyT> keys(n);
+    std::vector<int64_t> positions(n);
+    const int num_threads =
+        n >= kParallelRowMinLength ? GetSortNumThreads() : 1;
+    EncodeRadixKeys(merge_rows.data(), n, false, keys.data(), num_threads);
+    std::iota(positions.begin(), positions.end(), 0);
+    {
+      std::vector<KeyT> keys_buf(n);
+      std::vector<int64_t> positions_buf(n);
+      RadixSortPairs(keys.data(),
+                     positions.data(),
+                     keys_buf.data(),
+                     positions_buf.data(),
+                     n,
+                     num_threads);
+    }
+    // run_begin[r] is the start of the r-th output row in the sorted order
+    std::vector<int64_t> run_begin;
+    for (int64_t i = 0; i < n; ++i) {
+      if (i == 0 || keys[i] != keys[i - 1]) run_begin.push_back(i);
+    }
+    const int64_t num_merged = static_cast<int64_t>(run_begin.size());
+    run_begin.push_back(n);
+
     out.set_height(input_height);
     DenseTensor* out_tensor = out.mutable_value();
-    out_tensor->Resize(common::make_ddim(
-        {static_cast<int64_t>(merged_row_set.size()), input_width}));
+    out_tensor->Resize(common::make_ddim({num_merged, input_width}));
     auto* out_data = context.template Alloc<T>(out_tensor);
 
-    if (merged_row_set.size() == row_num && !sorted_result) {
+    if (num_merged == n && !sorted_result) {
       // no duplicated ids, just concat the result together
-      std::vector<int64_t> merge_rows;
-      merge_rows.reserve(row_num);
-      // concat rows
-      for (auto* in : inputs) {
-        merge_rows.insert(
-            merge_rows.end(), in->rows().begin(), in->rows().end());
-      }
       out.set_rows(merge_rows);
       auto in_place = inputs[0]->place();
       auto out_place = out.place();
@@ -589,25 +556,28 @@ struct MergeAddImpl {
         copied_numel += static_cast<int64_t>(in_numel);
       }
     } else {
-      std::vector<int64_t> merge_rows(merged_row_set.begin(),
-                                      merged_row_set.end());
-
-      if (sorted_result) {
-        std::sort(merge_rows.begin(), merge_rows.end());
+      std::vector<int64_t> out_rows(num_merged);
+      for (int64_t r = 0; r < num_merged; ++r) {
+        out_rows[r] = merge_rows[positions[run_begin[r]]];
       }
+      out.set_rows(out_rows);
 
-      out.set_rows(merge_rows);
-
-      phi::funcs::SetConstant<DeviceContext, T> constant_functor;
-      constant_functor(context, out.mutable_value(), static_cast<T>(0.f));
-
-      std::unordered_map<int64_t, size_t> rows_to_id;
-      for (size_t i = 0; i < merge_rows.size(); ++i) {
-        rows_to_id[merge_rows[i]] = i;
+      // Every output row is written by one thread only, no zero filling or
+      // atomics are needed.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (n * input_width >= kParallelRowMinLength)
+#endif
+      for (int64_t r = 0; r < num_merged; ++r) {
+        T* dst = out_data + r * input_width;
+        const T* first = src_rows[positions[run_begin[r]]];
+        std::copy(first, first + input_width, dst);
+        for (int64_t i = run_begin[r] + 1; i < run_begin[r + 1]; ++i) {
+          const T* src = src_rows[positions[i]];
+          for (int64_t j = 0; j < input_width; ++j) {
+            dst[j] += src[j];
+          }
+        }
       }
-
-      add_sparse_inputs<T, DeviceContext>(
-          inputs, rows_to_id, input_width, context, out_data);
     }
   }
 };
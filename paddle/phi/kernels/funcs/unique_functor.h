@@ -13,12 +13,14 @@
 // limitations under the License.
 
 #pragma once
-#include <set>
+#include <numeric>
 
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/utils/data_type.h"
 #include "paddle/phi/kernels/funcs/concat_and_split_functor.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/parallel_sort.h"
+#include "paddle/utils/flat_hash_map.h"
 
 namespace phi {
 namespace funcs {
@@ -45,8 +47,8 @@ struct UniqueOpFunctor {
 
     int64_t j = 0;
 
-    // TODO(fangzeyang): Should optimize performance here.
-    std::unordered_map<InT, int64_t> dict;
+    // Open addressing keeps the probes of a lookup within a few cache lines
+    paddle::flat_hash_map<InT, int64_t> dict;
     std::vector<InT> uniq;
 
     PADDLE_ENFORCE_LT(
@@ -58,15 +60,12 @@ struct UniqueOpFunctor {
             in_->numel()));
 
     for (auto i = 0; i < in_->numel(); i++) {
-      auto it = dict.find(in_data[i]);
-      if (it == dict.end()) {
-        dict.emplace(std::make_pair(in_data[i], j));
+      auto it = dict.emplace(in_data[i], j);
+      if (it.second) {
         uniq.emplace_back(in_data[i]);
-        index_data[i] = static_cast<IndexT>(j);
         j++;
-      } else {
-        index_data[i] = static_cast<IndexT>(it->second);
       }
+      index_data[i] = static_cast<IndexT>(it.first->second);
     }
 
     if (count_ != nullptr) {
@@ -139,52 +138,64 @@ static void UniqueFlattendTensor(const Context& context,
                                  bool return_index,
                                  bool return_inverse,
                                  bool return_counts) {
+  // Stable sort the positions by value, then each run of equal values is one
+  // unique value, whose first position is the first occurrence.
   const InT* in_data = in.data<InT>();
-  std::set<InT> unique(in_data, in_data + in.numel());
-  out->Resize(common::make_ddim({static_cast<int64_t>(unique.size())}));
+  const int64_t numel = in.numel();
+  std::vector<typename RadixKey<InT>::KeyT> keys(numel);
+  std::vector<int64_t> positions(numel);
+  const int num_threads =
+      numel >= kParallelRowMinLength ? GetSortNumThreads() : 1;
+  EncodeRadixKeys(in_data, numel, false, keys.data(), num_threads);
+  std::iota(positions.begin(), positions.end(), 0);
+  {
+    std::vector<typename RadixKey<InT>::KeyT> keys_buf(numel);
+    std::vector<int64_t> positions_buf(numel);
+    RadixSortPairs(keys.data(),
+                   positions.data(),
+                   keys_buf.data(),
+                   positions_buf.data(),
+                   numel,
+                   num_threads);
+  }
+
+  // run_begin[u] is the start of the u-th run in the sorted order
+  std::vector<int64_t> run_begin;
+  for (int64_t i = 0; i < numel; ++i) {
+    if (i == 0 || keys[i] != keys[i - 1]) run_begin.push_back(i);
+  }
+  const int64_t num_unique = static_cast<int64_t>(run_begin.size());
+  run_begin.push_back(numel);
+
+  out->Resize(common::make_ddim({num_unique}));
   auto* out_data = context.template Alloc<InT>(out);
-  std::copy(unique.begin(), unique.end(), out_data);
+  for (int64_t u = 0; u < num_unique; ++u) {
+    out_data[u] = in_data[positions[run_begin[u]]];
+  }
 
   if (return_index) {
-    indices->Resize(common::make_ddim({out->numel()}));
+    indices->Resize(common::make_ddim({num_unique}));
     auto indices_data = context.template Alloc<IndexT>(indices);
-    std::unordered_map<InT, IndexT> indices_map;
-    indices_map.reserve(out->numel());
-    for (int64_t i = 0; i < in.numel(); ++i) {
-      if (indices_map.find(in_data[i]) != indices_map.end()) continue;
-      indices_map[in_data[i]] = i;
-    }
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      indices_data[i] = indices_map[out_data[i]];
+    for (int64_t u = 0; u < num_unique; ++u) {
+      indices_data[u] = static_cast<IndexT>(positions[run_begin[u]]);
     }
   }
 
   if (return_inverse) {
-    index->Resize(common::make_ddim({in.numel()}));
+    index->Resize(common::make_ddim({numel}));
     auto inverse_data = context.template Alloc<IndexT>(index);
-    std::unordered_map<InT, IndexT> inverse_map;
-    inverse_map.reserve(out->numel());
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      inverse_map[out_data[i]] = i;
-    }
-    for (int64_t i = 0; i < in.numel(); ++i) {
-      inverse_data[i] = inverse_map[in_data[i]];
+    for (int64_t u = 0; u < num_unique; ++u) {
+      for (int64_t i = run_begin[u]; i < run_begin[u + 1]; ++i) {
+        inverse_data[positions[i]] = static_cast<IndexT>(u);
+      }
     }
   }
 
   if (return_counts) {
-    count->Resize(common::make_ddim({out->numel()}));
+    count->Resize(common::make_ddim({num_unique}));
     auto count_data = context.template Alloc<IndexT>(count);
-    std::unordered_map<InT, IndexT> counts_map;
-    counts_map.reserve(out->numel());
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      counts_map[out_data[i]] = 0;
-    }
-    for (int64_t i = 0; i < in.numel(); i++) {
-      counts_map[in_data[i]] += 1;
-    }
-    for (int64_t i = 0; i < out->numel(); i++) {
-      count_data[i] = counts_map[out_data[i]];
+    for (int64_t u = 0; u < num_unique; ++u) {
+      count_data[u] = static_cast<IndexT>(run_begin[u + 1] - run_begin[u]);
     }
   }
 }
@@ -42,6 +42,8 @@ class IR_API InferSymbolicShapeContext {
   void SetShapeOrDataForValue(Value val,
                               const symbol::ShapeOrDataDimExprs& shape_or_data);
 
+  void EraseShapeOrDataForValue(Value val);
+
   void AddEqualCstr(const symbol::DimExpr& lhs, const symbol::DimExpr& rhs);
 
   bool IsEqual(const symbol::DimExpr& lhs, const symbol::DimExpr& rhs) const;
@@ -83,10 +85,20 @@ class IR_API ShapeConstraintIRAnalysis final
   ShapeConstraintIRAnalysis(ShapeConstraintIRAnalysis&&) = delete;
   void Init();
 
+  // Whether Init has been called, the values being inferred since.
+  bool IsInitialized() const { return initialized_; }
+
   const std::string GetNextSymName();
 
   const symbol::ShapeOrDataDimExprs& GetShapeOrDataForValue(Value val);
 
+  bool HasShapeOrDataForValue(Value val) const;
+
+  // Drops the shapes of the results of op and of the ops using them
+  // transitively, to be inferred again when queried once op is rewritten.
+  // The ops whose results were not inferred yet are not visited further.
+  void InvalidateShapeOrDataForOp(Operation* op);
+
   void SetShapeOrDataForValue(Value val,
                               const symbol::ShapeOrDataDimExprs& shape_or_data);
 
@@ -141,6 +153,7 @@ class IR_API ShapeConstraintIRAnalysis final
 
  private:
   InferSymbolicShapeContext context_;
+  bool initialized_{false};
 };
 
 class IR_API ShapeAnalysisManager {
@@ -20,6 +20,7 @@
 namespace pir {
 
 class FrozenRewritePatternSet;
+class ShapeConstraintIRAnalysis;
 
 /// This enum will control which ops will be added to the worklist during the
 /// match rewrite process
@@ -39,7 +40,8 @@ class IR_API GreedyRewriteConfig {
   bool use_top_down_traversal = false;
 
   /// Control the maximum number of iterations in the process of applying the
-  /// pattern, use `kNolimit` to represent unlimited.
+  /// pattern, use `kNolimit` to represent unlimited. It is not used with
+  /// FLAGS_pir_greedy_rewrite_by_worklist, which visits the region once.
   int64_t max_iterations = 10;
 
   /// Control the upper limit of rewrite times during each iteration, use
@@ -57,6 +59,12 @@ class IR_API GreedyRewriteConfig {
   /// - ExistingOps: only pre-existing ops are added to the worklist.
   GreedyRewriteStrictness strict_mode = GreedyRewriteStrictness::AnyOp;
 
+  /// If set, the symbolic shapes of the ops downstream of each rewrite are
+  /// invalidated in the analysis, to be inferred again when queried. It is
+  /// the analysis of the program with FLAGS_pir_incremental_shape_inference
+  /// if not set.
+  ShapeConstraintIRAnalysis* shape_analysis{nullptr};
+
   static constexpr int64_t kNoLimit = -1;
 };
 
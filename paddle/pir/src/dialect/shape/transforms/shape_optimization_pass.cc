@@ -25,6 +25,7 @@
 #include "paddle/pir/include/pass/pass_registry.h"
 
 COMMON_DECLARE_bool(pir_apply_shape_optimization_pass);
+COMMON_DECLARE_bool(pir_incremental_shape_inference);
 
 constexpr int vlog_level = 3;
 
@@ -226,10 +227,28 @@ void CheckInferSymWithInferMeta(
   }
 }
 
+// Whether the shapes of op are inferred and not invalidated since.
+bool HasShapeOrDataForAllResults(const Operation& op,
+                                 InferSymbolicShapeContext* infer_context) {
+  if (op.num_results() == 0) return false;
+  for (uint32_t i = 0; i < op.num_results(); ++i) {
+    if (op.result(i) && !infer_context->HasShapeOrDataForValue(op.result(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void InferSymExprForAllValues(ModuleOp module_op) {
   ShapeConstraintIRAnalysis& shape_analysis =
       ShapeAnalysisManager::Instance().Get(module_op.program());
-  shape_analysis.Init();
+  // The pattern rewrites since the last inference have invalidated the
+  // shapes of the ops downstream of them, which are inferred again only.
+  if (FLAGS_pir_incremental_shape_inference && shape_analysis.IsInitialized()) {
+    VLOG(vlog_level) << "Infer the symbolic shapes incrementally.";
+  } else {
+    shape_analysis.Init();
+  }
   auto infer_context = shape_analysis.GetInferSymbolicShapeContext();
   for (uint32_t i = 0; i < module_op->num_regions(); i++) {
     for (auto& block : module_op->region(i)) {
@@ -284,6 +303,10 @@ symbol::TensorShapeOrDataDimExprs CreateShapeOrDataByDDim(
 void InferSymExprForBlock(const Block& block,
                           InferSymbolicShapeContext* infer_context) {
   for (auto& op : block) {
+    if (FLAGS_pir_incremental_shape_inference &&
+        HasShapeOrDataForAllResults(op, infer_context)) {
+      continue;
+    }
     auto infer_symbolic_shape_interface =
         op.dyn_cast<pir::InferSymbolicShapeInterface>();
     if (infer_symbolic_shape_interface) {
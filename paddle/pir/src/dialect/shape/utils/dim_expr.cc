@@ -64,17 +64,22 @@ bool DimExprEqual(const std::string& lhs, const std::string& rhs) {
   return lhs == rhs;
 }
 
+// The nodes shared by DimExprs, e.g. the ones simplified to the same result,
+// are compared by pointer.
 bool DimExprEqual(const Negative<DimExpr>& lhs, const Negative<DimExpr>& rhs) {
-  return lhs->data == rhs->data;
+  return lhs.data == rhs.data || lhs->data == rhs->data;
 }
 
 bool DimExprEqual(const Reciprocal<DimExpr>& lhs,
                   const Reciprocal<DimExpr>& rhs) {
-  return lhs->data == rhs->data;
+  return lhs.data == rhs.data || lhs->data == rhs->data;
 }
 
 template <template <typename> class Op>
 bool DimExprEqual(const Op<DimExpr>& lhs, const Op<DimExpr>& rhs) {
+  if (&lhs.operands.vector() == &rhs.operands.vector()) {
+    return true;
+  }
   if (lhs.operands->size() != rhs.operands->size()) {
     return false;
   }
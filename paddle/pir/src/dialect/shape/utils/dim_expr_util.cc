@@ -880,7 +880,7 @@ void DoPass(bool* rewrited, DimExpr* expr) {
   *rewrited = *rewrited || (old_expr != *expr);
 }
 
-DimExpr Simplify(const DimExpr& expr) {
+DimExpr SimplifyImpl(const DimExpr& expr) {
   DimExpr ret = expr;
   for (bool keep_rewrite = true; keep_rewrite;) {
     keep_rewrite = false;
@@ -912,6 +912,54 @@ DimExpr Simplify(const DimExpr& expr) {
   return ret;
 }
 
+// The same DimExprs are simplified over and over by the shape inference and
+// the passes querying it, so the results are memoized per thread. A result is
+// memoized as the simplified form of itself too, so that the DimExprs
+// simplified to it share its nodes, which are compared by pointer.
+class SimplifiedDimExprCache final {
+ public:
+  static SimplifiedDimExprCache& Instance() {
+    thread_local SimplifiedDimExprCache cache;
+    return cache;
+  }
+
+  std::optional<DimExpr> Find(const DimExpr& expr) const {
+    const auto iter = simplified_.find(expr);
+    if (iter == simplified_.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
+
+  void Insert(const DimExpr& expr, const DimExpr& simplified) {
+    // Dropped at once when full, as the DimExprs of a program are simplified
+    // together.
+    if (simplified_.size() + 2 > kMaxSize) {
+      simplified_.clear();
+    }
+    simplified_.emplace(expr, simplified);
+    simplified_.emplace(simplified, simplified);
+  }
+
+ private:
+  static constexpr std::size_t kMaxSize = 1 << 16;
+
+  std::unordered_map<DimExpr, DimExpr> simplified_;
+};
+
+DimExpr Simplify(const DimExpr& expr) {
+  if (expr.isa<std::int64_t>() || expr.isa<std::string>()) {
+    return expr;
+  }
+  auto& cache = SimplifiedDimExprCache::Instance();
+  if (const auto& simplified = cache.Find(expr)) {
+    return simplified.value();
+  }
+  DimExpr simplified = SimplifyImpl(expr);
+  cache.Insert(expr, simplified);
+  return simplified;
+}
+
 }  // namespace
 
 DimExpr SimplifyDimExpr(const DimExpr& expr) { return Simplify(expr); }
@@ -134,6 +134,11 @@ void InferSymbolicShapeContext::SetShapeOrDataForValue(
   }
 }
 
+void InferSymbolicShapeContext::EraseShapeOrDataForValue(Value val) {
+  if (!val) return;
+  value_id_to_shape_or_data_.erase(val.impl()->id());
+}
+
 void InferSymbolicShapeContext::AddEqualCstr(const symbol::DimExpr& lhs,
                                              const symbol::DimExpr& rhs) {
   constraints_manager_.AddEqCstr(lhs, rhs);
@@ -210,7 +215,10 @@ void InferSymbolicShapeContext::PrintShapeOrDatas() const {
   }
 }
 
-void ShapeConstraintIRAnalysis::Init() { context_.Init(); }
+void ShapeConstraintIRAnalysis::Init() {
+  context_.Init();
+  initialized_ = true;
+}
 
 const std::string ShapeConstraintIRAnalysis::GetNextSymName() {
   return context_.GetNextSymName();
@@ -350,6 +358,40 @@ ShapeConstraintIRAnalysis::GetShapeOrDataForValue(Value val) {
   return context_.GetShapeOrDataForValue(val);
 }
 
+bool ShapeConstraintIRAnalysis::HasShapeOrDataForValue(Value val) const {
+  return context_.HasShapeOrDataForValue(val);
+}
+
+void ShapeConstraintIRAnalysis::InvalidateShapeOrDataForOp(Operation* op) {
+  std::unordered_set<Operation*> visited{op};
+  std::vector<Operation*> worklist{op};
+  while (!worklist.empty()) {
+    Operation* cur_op = worklist.back();
+    worklist.pop_back();
+    bool has_inferred_result = false;
+    for (auto result : cur_op->results()) {
+      if (context_.HasShapeOrDataForValue(result)) {
+        context_.EraseShapeOrDataForValue(result);
+        has_inferred_result = true;
+      }
+    }
+    if (!has_inferred_result && cur_op != op) continue;
+    for (auto result : cur_op->results()) {
+      for (auto iter = result.use_begin(); iter != result.use_end(); ++iter) {
+        // The results of the ops a user is nested in depend on it as well.
+        for (Operation* user = iter->owner(); user;
+             user = user->GetParentOp()) {
+          if (visited.insert(user).second) {
+            worklist.push_back(user);
+          }
+        }
+      }
+    }
+  }
+  VLOG(6) << "Invalidate the shapes of " << visited.size()
+          << " ops from " << op->name();
+}
+
 void ShapeConstraintIRAnalysis::SetShapeOrDataForValue(
     Value val, const symbol::ShapeOrDataDimExprs& shape_or_data) {
   context_.SetShapeOrDataForValue(val, shape_or_data);
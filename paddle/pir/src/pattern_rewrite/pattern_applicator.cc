@@ -25,9 +25,11 @@ PatternApplicator::PatternApplicator(
     : frozen_pattern_list_(frozen_pattern_list) {}
 
 void PatternApplicator::ApplyCostModel(const CostModel& model) {
-  // TODO(wilber): remove impossible patterns.
   patterns_.clear();
   for (const auto& it : frozen_pattern_list_.op_specific_native_patterns()) {
+    // Leave out the ops without patterns, for MatchAndRewrite to skip them
+    // by a single lookup.
+    if (it.second.empty()) continue;
     for (const RewritePattern* pattern : it.second) {
       patterns_[it.first].push_back(pattern);
     }
@@ -72,13 +74,15 @@ bool PatternApplicator::MatchAndRewrite(
     std::function<bool(const Pattern&)> can_apply,
     std::function<void(const Pattern&)> on_failure,
     std::function<bool(const Pattern&)> on_success) {
-  // whether there are patterns matching this operation type.
-  std::vector<const RewritePattern*> op_patterns;
+  // whether there are patterns matching this operation type. The list is
+  // referred to rather than copied, as it is looked up for every op visited.
+  const std::vector<const RewritePattern*>* op_patterns = nullptr;
   auto pattern_it = patterns_.find(op->info());
-  if (pattern_it != patterns_.end()) op_patterns = pattern_it->second;
+  if (pattern_it != patterns_.end()) op_patterns = &pattern_it->second;
 
-  unsigned op_it = 0, op_e = op_patterns.size();
+  unsigned op_it = 0, op_e = op_patterns ? op_patterns->size() : 0;
   unsigned any_it = 0, any_e = any_op_patterns_.size();
+  if (op_e == 0 && any_e == 0) return false;
   bool result = false;
   do {
     // Find the next pattern with the highest benefit.
@@ -86,7 +90,7 @@ bool PatternApplicator::MatchAndRewrite(
     unsigned* best_pattern_it = &op_it;
 
     // For specific patterns
-    if (op_it < op_e) best_pattern = op_patterns[op_it];
+    if (op_it < op_e) best_pattern = (*op_patterns)[op_it];
     // For op-agnostic patterns
     if (any_it < any_e &&
         (!best_pattern ||
@@ -23,15 +23,21 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "paddle/common/flags.h"
 #include "paddle/pir/include/core/block.h"
 #include "paddle/pir/include/core/ir_context.h"
 #include "paddle/pir/include/core/operation.h"
+#include "paddle/pir/include/core/program.h"
 #include "paddle/pir/include/core/region.h"
 #include "paddle/pir/include/core/value.h"
+#include "paddle/pir/include/dialect/shape/utils/shape_analysis.h"
 #include "paddle/pir/include/pattern_rewrite/frozen_rewrite_pattern_set.h"
 #include "paddle/pir/include/pattern_rewrite/pattern_applicator.h"
 #include "paddle/pir/include/pattern_rewrite/pattern_match.h"
 
+COMMON_DECLARE_bool(pir_greedy_rewrite_by_worklist);
+COMMON_DECLARE_bool(pir_incremental_shape_inference);
+
 namespace {
 
 class GreedyPatternRewriteDriver : public pir::PatternRewriter {
@@ -56,6 +62,8 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
   }
 
   std::pair<bool, int64_t> Simplify() {
+    if (FLAGS_pir_greedy_rewrite_by_worklist) return SimplifyByWorklist();
+
     int64_t sum_num_rewrites = 0;
     int64_t num_rewrites = 0;
     int64_t iteration = 0;
@@ -65,31 +73,54 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
           config_.max_iterations != pir::GreedyRewriteConfig::kNoLimit)
         break;
       VLOG(6) << "Iteration[" << iteration << "] for PatternRewrite";
-      worklist_.clear();
-      worklist_map_.clear();
-
-      for (auto& block_item : region_) {
-        for (auto& op_item : block_item) {
-          worklist_.push_back(&op_item);
-        }
-      }
-      if (config_.use_top_down_traversal) {
-        // Reverse the list so out pop-back loop process them in-order.
-        std::reverse(worklist_.begin(), worklist_.end());
-      }
-      for (size_t i = 0; i < worklist_.size(); ++i) {
-        worklist_map_[worklist_[i]] = i;
-        VLOG(6) << "worklist[" << i << "] is " << worklist_[i]->name();
-      }
+      SeedWorklist();
 
       num_rewrites = ProcessWorklist();
       sum_num_rewrites += num_rewrites;
     } while (num_rewrites != 0);
     bool converged = num_rewrites == 0;
+    VLOG(4) << "PatternRewrite visited " << num_visited_ops_ << " ops in "
+            << iteration << " iterations, rewrote " << sum_num_rewrites
+            << " times";
     return std::make_pair(converged, sum_num_rewrites);
   }
 
  private:
+  /// Visit the ops of the region once, and then only the ops the rewrites
+  /// add back by the notifications: the users of the replaced ops, the
+  /// updated and inserted ops, and the producers of the erased ops. It
+  /// converges once the worklist is drained.
+  std::pair<bool, int64_t> SimplifyByWorklist() {
+    SeedWorklist();
+    int64_t num_rewrites = ProcessWorklist();
+    // The removed ops are left as nullptr in worklist_, but not in
+    // worklist_map_.
+    bool converged = worklist_map_.empty();
+    VLOG(4) << "PatternRewrite visited " << num_visited_ops_
+            << " ops by worklist, rewrote " << num_rewrites << " times";
+    return std::make_pair(converged, num_rewrites);
+  }
+
+  /// Reset the worklist to all the ops of the region.
+  void SeedWorklist() {
+    worklist_.clear();
+    worklist_map_.clear();
+
+    for (auto& block_item : region_) {
+      for (auto& op_item : block_item) {
+        worklist_.push_back(&op_item);
+      }
+    }
+    if (config_.use_top_down_traversal) {
+      // Reverse the list so out pop-back loop process them in-order.
+      std::reverse(worklist_.begin(), worklist_.end());
+    }
+    for (size_t i = 0; i < worklist_.size(); ++i) {
+      worklist_map_[worklist_[i]] = i;
+      VLOG(6) << "worklist[" << i << "] is " << worklist_[i]->name();
+    }
+  }
+
   /// Process ops until the worklist is empty or `config.max_num_rewrites`
   /// is reached. Return `true` if any IR was changed.
   int64_t ProcessWorklist() {
@@ -100,6 +131,7 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
       auto* op = PopFromWorklist();
       if (op == nullptr) continue;
       VLOG(6) << "PopFromWorklist, get op: " << op->name();
+      ++num_visited_ops_;
 
       // TODO(wilber): ir is dead.
       // ...
@@ -123,11 +155,17 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
         AddToWorklist(it->owner());
       }
     }
+    // The users of op are invalidated along with it.
+    InvalidateShapeOrData(op);
   }
 
-  void FinalizeRootUpdate(pir::Operation* op) override { AddToWorklist(op); }
+  void FinalizeRootUpdate(pir::Operation* op) override {
+    AddToWorklist(op);
+    InvalidateShapeOrData(op);
+  }
 
   void NotifyOperationRemoved(pir::Operation* op) override {
+    InvalidateShapeOrData(op);
     for (uint32_t i = 0; i < op->num_operands(); ++i) {
       AddOperandToWorklist(op->operand_source(i));
     }
@@ -156,6 +194,12 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
     AddToWorklist(op);
   }
 
+  void InvalidateShapeOrData(pir::Operation* op) {
+    if (config_.shape_analysis) {
+      config_.shape_analysis->InvalidateShapeOrDataForOp(op);
+    }
+  }
+
   /// Add the given operation to the worklist.
   void AddToWorklist(pir::Operation* op) {
     if (config_.strict_mode == pir::GreedyRewriteStrictness::AnyOp ||
@@ -207,6 +251,7 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
   std::unordered_set<pir::Operation*> strict_mode_filtered_ops_;
   pir::Region& region_;
   pir::PatternApplicator matcher_;
+  int64_t num_visited_ops_{0};
 };
 
 }  // namespace
@@ -218,10 +263,22 @@ std::pair<bool, int64_t> ApplyPatternsGreedily(
     const FrozenRewritePatternSet& patterns,
     GreedyRewriteConfig config) {
   if (!config.region) config.region = &region;
+  if (!config.shape_analysis && FLAGS_pir_incremental_shape_inference &&
+      region.GetParent()) {
+    if (Program* program = region.GetParent()->GetParentProgram()) {
+      auto& shape_analysis = ShapeAnalysisManager::Instance().Get(program);
+      if (shape_analysis.IsInitialized()) {
+        config.shape_analysis = &shape_analysis;
+      }
+    }
+  }
 
   GreedyPatternRewriteDriver driver(region.ir_context(), patterns, config);
   auto [converged, num_rewrites] = driver.Simplify();
-  if (!converged) {
+  if (!converged && FLAGS_pir_greedy_rewrite_by_worklist) {
+    LOG(WARNING) << "The pattern rewrite did not converge after rewriting "
+                 << config.max_num_rewrites << " times";
+  } else if (!converged) {
     LOG(WARNING) << "The pattern rewrite did not converge after scanning "
                  << config.max_iterations << " times";
   }
@@ -0,0 +1,85 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+
+#ifdef CINN_USE_OPENMP
+#include <omp.h>
+#endif  // CINN_USE_OPENMP
+
+#include "paddle/cinn/runtime/cpu/thread_backend.h"
+#include "paddle/cinn/runtime/cpu/thread_pool.h"
+#include "paddle/cinn/utils/timer.h"
+
+namespace cinn {
+namespace runtime {
+namespace cpu {
+
+namespace {
+
+#ifdef CINN_USE_OPENMP
+// The OpenMP region per launch cinn_backend_parallel_launch used to open.
+class OpenMPParallelRuntime : public HostParallelRuntime {
+ public:
+  int NumThreads() const override { return max_concurrency(); }
+
+  void ParallelFor(int num_task,
+                   const std::function<void(int)>& fn) override {
+    omp_set_num_threads(num_task);
+#pragma omp parallel num_threads(num_task)
+    { fn(omp_get_thread_num()); }
+  }
+};
+#endif  // CINN_USE_OPENMP
+
+int EmptyTask(int task_id, int num_task, void* datas) { return 0; }
+
+// The average microseconds of a launch of empty tasks on runtime.
+double LaunchOverhead(std::shared_ptr<HostParallelRuntime> runtime) {
+  constexpr int kLaunches = 10000;
+  SetHostParallelRuntime(runtime);
+  cinn_backend_parallel_launch(&EmptyTask, nullptr, 0);
+  utils::Timer timer;
+  timer.Start();
+  for (int i = 0; i < kLaunches; ++i) {
+    cinn_backend_parallel_launch(&EmptyTask, nullptr, 0);
+  }
+  return timer.Stop() * 1000 / kLaunches;
+}
+
+}  // namespace
+
+TEST(HostParallelRuntime, LaunchOverhead) {
+  auto previous = GetHostParallelRuntime();
+  LOG(INFO) << "Work stealing pool of " << max_concurrency()
+            << " threads: "
+            << LaunchOverhead(
+                   std::make_shared<WorkStealingThreadPool>(max_concurrency()))
+            << " us per launch";
+#ifdef CINN_USE_OPENMP
+  LOG(INFO) << "OpenMP region per launch of " << max_concurrency()
+            << " threads: "
+            << LaunchOverhead(std::make_shared<OpenMPParallelRuntime>())
+            << " us per launch";
+#endif  // CINN_USE_OPENMP
+  SetHostParallelRuntime(previous);
+}
+
+}  // namespace cpu
+}  // namespace runtime
+}  // namespace cinn
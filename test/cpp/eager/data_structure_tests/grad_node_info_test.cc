@@ -14,14 +14,20 @@
 
 #include "paddle/fluid/eager/grad_node_info.h"
 
+#include <cstring>
+#include <vector>
+
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/eager_tensor.h"
 #include "paddle/fluid/eager/hooks.h"
 #include "paddle/phi/api/lib/utils/allocator.h"
 #include "test/cpp/eager/data_structure_tests/grad_node_test.h"
 
+COMMON_DECLARE_bool(eager_grad_node_pool);
+
 TEST(GradNodeInfo, GradSlotMeta) {
   auto grad_slot = egr::GradSlotMeta();
   VLOG(6) << "Set SetStopGradient";
@@ -160,3 +166,66 @@ TEST(GradNodeInfo, Edge) {
   CHECK_EQ(edge2.GetEdgeRankInfo().first, size_t(4));
   CHECK_EQ(edge2.GetEdgeRankInfo().second, size_t(5));
 }
+
+TEST(GradNodeInfo, GradNodePool) {
+  egr::GradNodePool pool;
+  VLOG(6) << "Test Reuse Released Block";
+  void* block0 = pool.Allocate(200);
+  pool.Deallocate(block0, 200);
+  CHECK_EQ(pool.CachedBytes(), size_t(256));
+  // Any size of the same size class reuses the cached block
+  void* block1 = pool.Allocate(250);
+  CHECK(block0 == block1);
+  CHECK_EQ(pool.CachedBytes(), size_t(0));
+
+  VLOG(6) << "Test Trim To Working Set";
+  void* block2 = pool.Allocate(250);
+  pool.Deallocate(block1, 250);
+  pool.Deallocate(block2, 250);
+  CHECK_EQ(pool.CachedBytes(), size_t(512));
+  pool.Release();
+  CHECK_EQ(pool.CachedBytes(), size_t(512));
+  // The next step only needs one block, the other one is released
+  block0 = pool.Allocate(250);
+  pool.Deallocate(block0, 250);
+  pool.Release();
+  CHECK_EQ(pool.CachedBytes(), size_t(256));
+
+  VLOG(6) << "Test Large Block Bypass Pool";
+  void* large = pool.Allocate(egr::GradNodePool::kMaxPooledSize + 1);
+  pool.Deallocate(large, egr::GradNodePool::kMaxPooledSize + 1);
+  CHECK_EQ(pool.CachedBytes(), size_t(256));
+}
+
+TEST(GradNodeInfo, GradNodePoolBoundedBeforeRelease) {
+  VLOG(6) << "Test Cache Bounded Without Release";
+  egr::GradNodePool pool;
+  constexpr size_t kSize = egr::GradNodePool::kMaxPooledSize;
+  std::vector<void*> blocks;
+  for (size_t i = 0;
+       i < 2 * egr::GradNodePool::kDefaultMaxCachedBytes / kSize;
+       ++i) {
+    blocks.push_back(pool.Allocate(kSize));
+  }
+  for (void* block : blocks) {
+    pool.Deallocate(block, kSize);
+  }
+  CHECK_EQ(pool.CachedBytes(), egr::GradNodePool::kDefaultMaxCachedBytes);
+}
+
+TEST(GradNodeInfo, GradNodePoolEnabledBeforeFree) {
+  VLOG(6) << "Test Block Allocated Without Pool Is Freed Into Pool";
+  FLAGS_eager_grad_node_pool = false;
+  void* block0 = egr::GradNodePool::Alloc(200);
+  FLAGS_eager_grad_node_pool = true;
+  egr::GradNodePool* pool = egr::GradNodePool::ThreadLocal();
+  CHECK(pool != nullptr);
+  size_t cached_bytes = pool->CachedBytes();
+  egr::GradNodePool::Free(block0, 200);
+  CHECK_EQ(pool->CachedBytes(), cached_bytes + 256);
+  // The cached block holds the whole size class
+  void* block1 = egr::GradNodePool::Alloc(256);
+  CHECK(block0 == block1);
+  memset(block1, 0, 256);
+  egr::GradNodePool::Free(block1, 256);
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/bounded_mpmc_queue.h"
+
+#include <chrono>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(BoundedMPMCQueue, TryPushPop) {
+  BoundedMPMCQueue<int> q(3);
+  EXPECT_EQ(q.Capacity(), 3UL);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(q.TryPush(i));
+  }
+  EXPECT_FALSE(q.TryPush(3));
+  EXPECT_EQ(q.Size(), 3UL);
+  int elem = -1;
+  // wrap around several times
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(q.TryPop(&elem));
+    EXPECT_EQ(elem, i);
+    EXPECT_TRUE(q.TryPush(i + 3));
+  }
+  EXPECT_EQ(q.Clear(), 3UL);
+  EXPECT_FALSE(q.TryPop(&elem));
+}
+
+TEST(BoundedMPMCQueue, Batch) {
+  BoundedMPMCQueue<std::unique_ptr<int>> q(4);
+  std::vector<std::unique_ptr<int>> items;
+  for (int i = 0; i < 6; ++i) {
+    items.emplace_back(new int(i));
+  }
+  EXPECT_EQ(q.TryPushN(items.data(), items.size()), 4UL);
+  std::vector<std::unique_ptr<int>> out(6);
+  EXPECT_EQ(q.TryPopN(out.data(), 3), 3UL);
+  EXPECT_EQ(q.TryPushN(items.data() + 4, 2), 2UL);
+  EXPECT_EQ(q.TryPopN(out.data() + 3, 6), 3UL);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(*out[i], i);
+  }
+}
+
+TEST(BoundedMPMCQueue, CapacityOne) {
+  BoundedMPMCQueue<int> q(1);
+  std::thread consumer([&] {
+    int elem = 0;
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_TRUE(q.Pop(&elem));
+      EXPECT_EQ(elem, i);
+    }
+  });
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(q.Push(i));
+  }
+  consumer.join();
+}
+
+TEST(BoundedMPMCQueue, Close) {
+  BoundedMPMCQueue<int> q(2);
+  std::thread producer([&] {
+    for (int i = 0; i < 5; ++i) {
+      if (!q.Push(i)) break;
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  q.Close();
+  producer.join();
+  int elem = 0;
+  EXPECT_TRUE(q.Pop(&elem));
+  EXPECT_TRUE(q.Pop(&elem));
+  EXPECT_FALSE(q.Pop(&elem));
+  EXPECT_FALSE(q.Push(1));
+  q.Open();
+  EXPECT_TRUE(q.Push(1));
+}
+
+// Mutex + condition variable baseline, the queue used by the readers before.
+template <typename T>
+class LockedQueue {
+ public:
+  explicit LockedQueue(size_t capacity) : capacity_(capacity) {}
+  void Push(T elem) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    send_cv_.wait(lock, [&] { return queue_.size() < capacity_; });
+    queue_.push_back(std::move(elem));
+    receive_cv_.notify_one();
+  }
+  void Pop(T* elem) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    receive_cv_.wait(lock, [&] { return !queue_.empty(); });
+    *elem = std::move(queue_.front());
+    queue_.pop_front();
+    send_cv_.notify_one();
+  }
+
+ private:
+  size_t capacity_;
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable receive_cv_;
+  std::condition_variable send_cv_;
+};
+
+// Every producer pushes num_per_producer values, the consumers check the sum.
+template <typename Queue>
+int64_t RunContention(Queue* q,
+                      int num_producers,
+                      int num_consumers,
+                      int64_t num_per_producer) {
+  const int64_t total = num_producers * num_per_producer;
+  std::atomic<int64_t> sum{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int p = 0; p < num_producers; ++p) {
+    threads.emplace_back([=] {
+      for (int64_t i = 0; i < num_per_producer; ++i) {
+        q->Push(i);
+      }
+    });
+  }
+  for (int c = 0; c < num_consumers; ++c) {
+    int64_t count = total / num_consumers + (c < total % num_consumers);
+    threads.emplace_back([=, &sum] {
+      int64_t local = 0;
+      int64_t elem = 0;
+      for (int64_t i = 0; i < count; ++i) {
+        q->Pop(&elem);
+        local += elem;
+      }
+      sum += local;
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  EXPECT_EQ(sum.load(),
+            num_producers * (num_per_producer * (num_per_producer - 1) / 2));
+  return us;
+}
+
+TEST(BoundedMPMCQueue, Contention) {
+  const int64_t num_per_producer = 100000;
+  for (int threads : {1, 4, 8}) {
+    BoundedMPMCQueue<int64_t> lock_free(64);
+    LockedQueue<int64_t> locked(64);
+    auto lock_free_us =
+        RunContention(&lock_free, threads, threads, num_per_producer);
+    auto locked_us = RunContention(&locked, threads, threads, num_per_producer);
+    LOG(INFO) << threads << " producers and " << threads
+              << " consumers: BoundedMPMCQueue takes " << lock_free_us
+              << " us, mutex queue takes " << locked_us << " us";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
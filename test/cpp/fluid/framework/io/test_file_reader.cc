@@ -0,0 +1,278 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+#ifdef PADDLE_WITH_SNAPPY
+#include <snappy.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/io/file_reader.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+#ifdef __linux__
+
+COMMON_DECLARE_bool(fs_native_reader);
+
+namespace paddle {
+namespace framework {
+
+static std::string MakeLines(int num_lines) {
+  std::string text;
+  for (int i = 0; i < num_lines; ++i) {
+    text += "line " + std::to_string(i) + " " + std::string(i % 97, 'x') + "\n";
+  }
+  return text;
+}
+
+static void WriteFile(const std::string& path, const std::string& data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(data.data(), data.size());
+}
+
+static std::string ReadAll(ReadStream* stream) {
+  std::string data;
+  char buf[1000];
+  size_t n = 0;
+  while ((n = stream->Read(buf, sizeof(buf))) > 0) {
+    data.append(buf, n);
+  }
+  return data;
+}
+
+// A gzip member holding data, with the BGZF extra field if bgzf is set.
+static std::string GzipMember(const std::string& data, bool bgzf) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  deflateInit2(&strm, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+  std::string deflated(deflateBound(&strm, data.size()), '\0');
+  strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  strm.avail_in = data.size();
+  strm.next_out = reinterpret_cast<Bytef*>(&deflated[0]);
+  strm.avail_out = deflated.size();
+  EXPECT_EQ(deflate(&strm, Z_FINISH), Z_STREAM_END);
+  deflated.resize(strm.total_out);
+  deflateEnd(&strm);
+
+  auto put16 = [](std::string* s, uint32_t v) {
+    s->push_back(v & 0xff);
+    s->push_back((v >> 8) & 0xff);
+  };
+  auto put32 = [&](std::string* s, uint32_t v) {
+    put16(s, v & 0xffff);
+    put16(s, v >> 16);
+  };
+  std::string member = {'\x1f', '\x8b', 8, bgzf ? '\x04' : '\0', 0, 0, 0, 0,
+                        0,      '\xff'};
+  if (bgzf) {
+    put16(&member, 6);
+    member += "BC";
+    put16(&member, 2);
+    put16(&member, 18 + deflated.size() + 8 - 1);
+  }
+  member += deflated;
+  put32(&member,
+        crc32(0,
+              reinterpret_cast<const Bytef*>(data.data()),
+              static_cast<uInt>(data.size())));
+  put32(&member, data.size());
+  return member;
+}
+
+TEST(FileReader, ReadAhead) {
+  std::string text = MakeLines(20000);
+  WriteFile("file_reader_plain.txt", text);
+  ReadStreamOptions options;
+  // Many small blocks to wrap around the read-ahead ring.
+  options.block_size = 4096;
+  options.num_blocks = 3;
+  auto stream = OpenReadStream("file_reader_plain.txt", options);
+  EXPECT_EQ(ReadAll(stream.get()), text);
+
+  options.direct_io = true;
+  stream = OpenReadStream("file_reader_plain.txt", options);
+  EXPECT_EQ(ReadAll(stream.get()), text);
+
+  EXPECT_ANY_THROW(OpenReadStream("file_reader_none.txt", options));
+}
+
+// Files smaller than a block are read without the read-ahead thread.
+TEST(FileReader, SmallFile) {
+  std::string text = MakeLines(10);
+  WriteFile("file_reader_small.txt", text);
+  ReadStreamOptions options;
+  auto stream = OpenReadStream("file_reader_small.txt", options);
+  EXPECT_EQ(ReadAll(stream.get()), text);
+
+  options.direct_io = true;
+  stream = OpenReadStream("file_reader_small.txt", options);
+  EXPECT_EQ(ReadAll(stream.get()), text);
+
+  WriteFile("file_reader_empty.txt", "");
+  stream = OpenReadStream("file_reader_empty.txt", options);
+  EXPECT_EQ(ReadAll(stream.get()), "");
+}
+
+TEST(FileReader, Gzip) {
+  std::string first = MakeLines(10000);
+  std::string second = MakeLines(300);
+  // Concatenated members, like the output of cat a.gz b.gz.
+  WriteFile("file_reader.gz",
+            GzipMember(first, false) + GzipMember(second, false));
+  auto stream = OpenReadStream("file_reader.gz", ReadStreamOptions());
+  EXPECT_EQ(ReadAll(stream.get()), first + second);
+
+  // The trailing garbage is ignored like zcat does.
+  WriteFile("file_reader_garbage.gz",
+            GzipMember(first, false) + std::string(1000, '\0'));
+  stream = OpenReadStream("file_reader_garbage.gz", ReadStreamOptions());
+  EXPECT_EQ(ReadAll(stream.get()), first);
+  WriteFile("file_reader_garbage_1.gz",
+            GzipMember(first, false) + GzipMember(second, false) + "garbage");
+  stream = OpenReadStream("file_reader_garbage_1.gz", ReadStreamOptions());
+  EXPECT_EQ(ReadAll(stream.get()), first + second);
+
+  std::string member = GzipMember(first, false);
+  WriteFile("file_reader_truncated.gz", member.substr(0, member.size() / 2));
+  stream = OpenReadStream("file_reader_truncated.gz", ReadStreamOptions());
+  EXPECT_ANY_THROW(ReadAll(stream.get()));
+}
+
+TEST(FileReader, Bgzf) {
+  std::string text = MakeLines(50000);
+  std::string bgzf;
+  for (size_t pos = 0; pos < text.size(); pos += 60000) {
+    bgzf += GzipMember(text.substr(pos, 60000), true);
+  }
+  // The empty end of file block of bgzip.
+  bgzf += GzipMember("", true);
+  WriteFile("file_reader_bgzf.gz", bgzf);
+
+  for (bool parallel : {false, true}) {
+    ReadStreamOptions options;
+    options.parallel_decompress = parallel;
+    auto stream = OpenReadStream("file_reader_bgzf.gz", options);
+    EXPECT_EQ(ReadAll(stream.get()), text);
+  }
+
+  bgzf[bgzf.size() / 2] ^= 0x55;
+  WriteFile("file_reader_corrupted.gz", bgzf);
+  auto stream = OpenReadStream("file_reader_corrupted.gz", ReadStreamOptions());
+  EXPECT_ANY_THROW(ReadAll(stream.get()));
+}
+
+TEST(FileReader, File) {
+  std::string text = MakeLines(1000);
+  WriteFile("file_reader_file.gz", GzipMember(text, false));
+  auto fp = ReadStreamToFile(
+      OpenReadStream("file_reader_file.gz", ReadStreamOptions()));
+  char line[256];
+  std::string read;
+  while (fgets(line, sizeof(line), fp.get()) != nullptr) {
+    read += line;
+  }
+  EXPECT_EQ(read, text);
+
+  int err_no = 0;
+  for (bool native : {false, true}) {
+    FLAGS_fs_native_reader = native;
+    fp = fs_open_read("file_reader_file.gz", &err_no, "cat");
+    read.clear();
+    while (fgets(line, sizeof(line), fp.get()) != nullptr) {
+      read += line;
+    }
+    EXPECT_EQ(read, text);
+  }
+  FLAGS_fs_native_reader = false;
+}
+
+#ifdef PADDLE_WITH_SNAPPY
+static uint32_t MaskedCrc32c(const std::string& data) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (unsigned char c : data) {
+    crc ^= c;
+    for (int k = 0; k < 8; ++k) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+    }
+  }
+  crc ^= 0xFFFFFFFF;
+  return ((crc >> 15) | (crc << 17)) + 0xa282ead8;
+}
+
+TEST(FileReader, Snappy) {
+  std::string text = MakeLines(20000);
+  std::string framed("\xff\x06\x00\x00sNaPpY", 10);
+  for (size_t pos = 0; pos < text.size(); pos += 65536) {
+    std::string chunk = text.substr(pos, 65536);
+    std::string compressed;
+    snappy::Compress(chunk.data(), chunk.size(), &compressed);
+    uint32_t crc = MaskedCrc32c(chunk);
+    uint32_t header = (compressed.size() + 4) << 8;
+    for (uint32_t v : {header, crc}) {
+      for (int k = 0; k < 4; ++k) {
+        framed.push_back((v >> (8 * k)) & 0xff);
+      }
+    }
+    framed += compressed;
+  }
+  WriteFile("file_reader.sz", framed);
+  auto stream = OpenReadStream("file_reader.sz", ReadStreamOptions());
+  EXPECT_EQ(ReadAll(stream.get()), text);
+
+  framed[framed.size() - 10] ^= 0x55;
+  WriteFile("file_reader_corrupted.sz", framed);
+  stream = OpenReadStream("file_reader_corrupted.sz", ReadStreamOptions());
+  EXPECT_ANY_THROW(ReadAll(stream.get()));
+}
+
+// What fs_open_write and fs_open_append_write write to a snappy file reads
+// back through fs_open_read.
+TEST(FileReader, SnappyWrite) {
+  FLAGS_fs_native_reader = true;
+  std::string first = MakeLines(20000);
+  std::string second = MakeLines(100);
+  int err_no = 0;
+  {
+    auto fp = fs_open_write("file_reader_write.sz", &err_no, "");
+    ASSERT_EQ(fwrite(first.data(), 1, first.size(), fp.get()), first.size());
+  }
+  {
+    auto fp = fs_open_append_write("file_reader_write.sz", &err_no, "");
+    ASSERT_EQ(fwrite(second.data(), 1, second.size(), fp.get()),
+              second.size());
+  }
+  auto stream = OpenReadStream("file_reader_write.sz", ReadStreamOptions());
+  EXPECT_EQ(ReadAll(stream.get()), first + second);
+
+  auto fp = fs_open_read("file_reader_write.sz", &err_no, "cat");
+  std::string read;
+  char buf[1000];
+  size_t n = 0;
+  while ((n = fread(buf, 1, sizeof(buf), fp.get())) > 0) {
+    read.append(buf, n);
+  }
+  EXPECT_EQ(read, first + second);
+  FLAGS_fs_native_reader = false;
+}
+#endif
+
+}  // namespace framework
+}  // namespace paddle
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/parallel_shuffle.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(ParallelShuffle, Permutation) {
+  std::default_random_engine engine(0);
+  for (int num_threads : {1, 3, 8, 300}) {
+    for (size_t n : {size_t(0), size_t(10), size_t(100003)}) {
+      std::vector<uint32_t> perm;
+      ParallelRandomPermutation(n, &engine, num_threads, &perm);
+      ASSERT_EQ(perm.size(), n);
+      std::vector<bool> seen(n, false);
+      for (auto i : perm) {
+        ASSERT_LT(i, n);
+        EXPECT_FALSE(seen[i]);
+        seen[i] = true;
+      }
+    }
+  }
+}
+
+TEST(ParallelShuffle, Deterministic) {
+  std::default_random_engine engine1(7);
+  std::default_random_engine engine2(7);
+  std::vector<uint64_t> perm1;
+  std::vector<uint64_t> perm2;
+  ParallelRandomPermutation(200000, &engine1, 4, &perm1);
+  ParallelRandomPermutation(200000, &engine2, 4, &perm2);
+  EXPECT_EQ(perm1, perm2);
+}
+
+// Every element should land in every block of positions equally often.
+TEST(ParallelShuffle, Uniform) {
+  const size_t n = kParallelShuffleMinSize;
+  const size_t num_blocks = 16;
+  const int rounds = 200;
+  std::default_random_engine engine(1);
+  // first[b] (last[b]) counts how often element 0 (n - 1) lands in block b
+  std::vector<int> first(num_blocks, 0);
+  std::vector<int> last(num_blocks, 0);
+  std::vector<uint32_t> perm;
+  for (int r = 0; r < rounds; ++r) {
+    ParallelRandomPermutation(n, &engine, 4, &perm);
+    for (size_t pos = 0; pos < n; ++pos) {
+      if (perm[pos] == 0) ++first[pos * num_blocks / n];
+      if (perm[pos] == n - 1) ++last[pos * num_blocks / n];
+    }
+  }
+  // The expectation is 12.5, a block empty or at three times that for a
+  // fixed element would point to a broken permutation.
+  for (size_t b = 0; b < num_blocks; ++b) {
+    EXPECT_GT(first[b], 0);
+    EXPECT_LT(first[b], 38);
+    EXPECT_GT(last[b], 0);
+    EXPECT_LT(last[b], 38);
+  }
+}
+
+TEST(ParallelShuffle, MoveOnly) {
+  const size_t n = 3 * kParallelShuffleMinSize + 5;
+  std::vector<std::unique_ptr<std::string>> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i].reset(new std::string(std::to_string(i)));
+  }
+  std::default_random_engine engine(2);
+  ParallelShuffle(&data, &engine, 6);
+  ASSERT_EQ(data.size(), n);
+  std::vector<bool> seen(n, false);
+  size_t fixed = 0;
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_NE(data[i], nullptr);
+    size_t value = std::stoul(*data[i]);
+    EXPECT_FALSE(seen[value]);
+    seen[value] = true;
+    fixed += value == i;
+  }
+  // About one fixed point is expected.
+  EXPECT_LT(fixed, 20UL);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,95 @@
+//   Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/buffered_reader.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+
+COMMON_DECLARE_int32(reader_prefetch_num_threads);
+
+using paddle::framework::LoDTensorArray;
+using paddle::operators::reader::BufferedReader;
+
+namespace {
+
+// Reads batches of one [2, 3] tensor filled with the index of the batch.
+class CountingReader : public paddle::framework::ReaderBase {
+ public:
+  explicit CountingReader(int num_batches)
+      : paddle::framework::ReaderBase(
+            {common::make_ddim({2, 3})},
+            {paddle::framework::proto::VarType::FP32},
+            {false}),
+        num_batches_(num_batches) {}
+
+  void ReadNextImpl(LoDTensorArray *out) override {
+    out->clear();
+    if (next_ >= num_batches_) {
+      return;
+    }
+    out->resize(1);
+    float *data = (*out)[0].mutable_data<float>(common::make_ddim({2, 3}),
+                                                paddle::platform::CPUPlace());
+    for (int i = 0; i < 6; ++i) {
+      data[i] = static_cast<float>(next_);
+    }
+    ++next_;
+  }
+
+ private:
+  int num_batches_;
+  int next_{0};
+};
+
+std::shared_ptr<BufferedReader> MakeReader(int num_batches) {
+  auto reader = std::make_shared<CountingReader>(num_batches);
+  return std::static_pointer_cast<BufferedReader>(
+      paddle::framework::MakeDecoratedReader<BufferedReader>(
+          reader,
+          paddle::platform::CPUPlace(),
+          /*buffer_size=*/2,
+          /*pin_memory=*/false));
+}
+
+void ExpectBatch(const LoDTensorArray &batch, float value) {
+  ASSERT_EQ(batch.size(), 1UL);
+  ASSERT_EQ(batch[0].numel(), 6);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(batch[0].data<float>()[i], value);
+  }
+}
+
+}  // namespace
+
+// With several prefetch threads the batches are still read in the order of
+// the underlying reader.
+TEST(BufferedReader, ReadInOrder) {
+  FLAGS_reader_prefetch_num_threads = 3;
+  constexpr int kNumBatches = 16;
+  auto reader = MakeReader(kNumBatches);
+
+  LoDTensorArray batch;
+  for (int i = 0; i < kNumBatches; ++i) {
+    reader->ReadNext(&batch);
+    ExpectBatch(batch, i);
+  }
+  reader->ReadNext(&batch);
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(reader->GetStats().batches, kNumBatches);
+  FLAGS_reader_prefetch_num_threads = 1;
+}
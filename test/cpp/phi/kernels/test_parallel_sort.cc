@@ -0,0 +1,167 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/kernels/funcs/parallel_sort.h"
+
+namespace phi {
+namespace tests {
+
+template <typename T>
+std::vector<T> RandomValues(int64_t n, int64_t range, bool with_nan) {
+  std::mt19937 gen(static_cast<unsigned>(n));
+  std::uniform_int_distribution<int64_t> dist(-range, range);
+  std::vector<T> values(n);
+  for (auto& value : values) {
+    value = static_cast<T>(dist(gen));
+  }
+  if (with_nan && n > 8) {
+    values[1] = static_cast<T>(NAN);
+    values[5] = static_cast<T>(-0.0);
+    values[6] = static_cast<T>(0.0);
+  }
+  return values;
+}
+
+// The order of the comparison based CPU kernels: NaN is the largest value and
+// ties keep their positions.
+template <typename T>
+std::vector<int64_t> ReferenceOrder(const std::vector<T>& values,
+                                    bool descending) {
+  std::vector<int64_t> order(values.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int64_t l, int64_t r) {
+    double a = static_cast<double>(values[l]);
+    double b = static_cast<double>(values[r]);
+    if (descending) return (std::isnan(a) && !std::isnan(b)) || a > b;
+    return (!std::isnan(a) && std::isnan(b)) || a < b;
+  });
+  return order;
+}
+
+template <typename T>
+void CheckSortAndSelect(int64_t n, int64_t range, int num_threads) {
+  auto values = RandomValues<T>(n, range, std::is_floating_point<T>::value);
+  funcs::SortWorkspace<T> ws;
+  for (bool descending : {false, true}) {
+    auto expected = ReferenceOrder(values, descending);
+
+    std::vector<T> out(n);
+    std::vector<int64_t> positions(n);
+    funcs::SortRow(values.data(),
+                   n,
+                   descending,
+                   out.data(),
+                   positions.data(),
+                   &ws,
+                   num_threads);
+    EXPECT_EQ(positions, expected);
+
+    for (int64_t k : {int64_t(1), n / 3 + 1, n}) {
+      std::vector<T> topk(k);
+      std::vector<int64_t> topk_positions(k);
+      funcs::TopKRow(values.data(),
+                     n,
+                     k,
+                     descending,
+                     true,
+                     topk.data(),
+                     topk_positions.data(),
+                     &ws,
+                     num_threads);
+      EXPECT_TRUE(std::equal(
+          topk_positions.begin(), topk_positions.end(), expected.begin()));
+
+      if (!descending) {
+        T kth;
+        int64_t kth_position;
+        funcs::KthValueRow(
+            values.data(), n, k, &kth, &kth_position, &ws, num_threads);
+        EXPECT_EQ(kth_position, expected[k - 1]);
+      }
+    }
+  }
+}
+
+TEST(parallel_sort, small_rows) {
+  for (int64_t n : {1, 7, 100, 1000}) {
+    CheckSortAndSelect<float>(n, 100, 1);
+    CheckSortAndSelect<double>(n, 1 << 30, 1);
+    CheckSortAndSelect<int32_t>(n, 10, 1);
+    CheckSortAndSelect<int64_t>(n, int64_t(1) << 40, 1);
+  }
+}
+
+TEST(parallel_sort, split_rows) {
+  const int64_t n = 4 * funcs::kParallelRowMinLength + 3;
+  CheckSortAndSelect<float>(n, 1000, 4);
+  CheckSortAndSelect<int64_t>(n, 50, 4);
+}
+
+TEST(parallel_sort, select_none) {
+  const int64_t n = 4 * funcs::kParallelRowMinLength + 3;
+  auto values = RandomValues<float>(n, 1000, true);
+  std::vector<std::pair<uint32_t, int64_t>> selected(1);
+  for (int num_threads : {1, 4}) {
+    funcs::ParallelThresholdSelect(
+        values.data(), n, 0, false, num_threads, &selected);
+    EXPECT_TRUE(selected.empty());
+  }
+}
+
+TEST(parallel_sort, topk_speed) {
+  const int64_t n = 100000;
+  const int64_t k = 100;
+  auto values = RandomValues<float>(n, 1 << 20, false);
+  std::vector<float> out(k);
+  std::vector<int64_t> positions(k);
+  funcs::SortWorkspace<float> ws;
+
+  auto start = std::chrono::steady_clock::now();
+  funcs::TopKRow(
+      values.data(), n, k, true, true, out.data(), positions.data(), &ws);
+  auto select_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::pair<float, int64_t>> pairs(n);
+  for (int64_t i = 0; i < n; ++i) pairs[i] = {values[i], i};
+  std::partial_sort(pairs.begin(),
+                    pairs.begin() + k,
+                    pairs.end(),
+                    [](const std::pair<float, int64_t>& l,
+                       const std::pair<float, int64_t>& r) {
+                      return l.first > r.first;
+                    });
+  auto partial_sort_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  LOG(INFO) << "topk of " << k << " in " << n
+            << " values: TopKRow takes " << select_us
+            << " us, partial sort takes " << partial_sort_us << " us";
+  for (int64_t i = 0; i < k; ++i) {
+    EXPECT_EQ(out[i], pairs[i].first);
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,151 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/hlir/dialect/operator/ir/cinn_op.h"
+#include "paddle/cinn/hlir/dialect/operator/ir/op_dialect.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/lowering_pass/utils.h"
+#include "paddle/cinn/hlir/framework/pir/async_compilation.h"
+#include "paddle/cinn/hlir/framework/pir/op_lowering_group.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/transforms/pd_op_to_kernel_pass.h"
+#include "paddle/pir/include/core/builtin_op.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+
+using cinn::hlir::framework::pir::AsyncKernel;
+using cinn::dialect::ir::details::OpLoweringGroup;
+using cinn::dialect::ir::details::OpLoweringGroupPtr;
+
+namespace {
+
+std::shared_ptr<::pir::Program> CreateProgram() {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
+  return std::make_shared<::pir::Program>(ctx);
+}
+
+OpLoweringGroupPtr CreateGroup(const std::vector<::pir::Operation*>& ops) {
+  auto group = std::make_shared<OpLoweringGroup>(ops);
+  group->mut_output_values().push_back(ops.back()->result(0));
+  return group;
+}
+
+}  // namespace
+
+// slice(broadcast(reduce_sum(reshape(scale(x))))), all of them cinn ops with
+// a transform rule to a pd op.
+TEST(FallbackProgram, RewriteCinnOps) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = builder
+               .Build<paddle::dialect::FullOp>(std::vector<int64_t>{4, 8},
+                                               2.0,
+                                               phi::DataType::FLOAT32,
+                                               phi::CPUPlace())
+               .result(0);
+  auto scale = builder.Build<cinn::dialect::ScaleOp>(x, 2.0, 1.0, true);
+  auto reshape = builder.Build<cinn::dialect::ReshapeOp>(
+      scale.result(0), std::vector<int>{8, 4});
+  auto sum = builder.Build<cinn::dialect::ReduceSumOp>(
+      reshape.result(0), std::vector<int64_t>{1}, false);
+  auto broadcast =
+      builder.Build<cinn::dialect::BroadcastOp>(sum.result(0),
+                                                std::vector<int64_t>{1},
+                                                std::vector<int64_t>{4, 8});
+  auto slice = builder.Build<cinn::dialect::SliceOp>(
+      broadcast.result(0),
+      std::vector<int64_t>{0},
+      std::vector<int64_t>{1},
+      std::vector<int64_t>{3},
+      std::vector<int64_t>{1},
+      std::vector<int64_t>{});
+
+  auto fallback_program =
+      cinn::dialect::ir::details::BuildFallbackProgram(CreateGroup(
+          {scale.operation(),
+           reshape.operation(),
+           sum.operation(),
+           broadcast.operation(),
+           slice.operation()}));
+  ASSERT_NE(fallback_program, nullptr);
+
+  std::vector<std::string> op_names;
+  for (auto& op : *fallback_program->block()) {
+    EXPECT_NE(op.dialect()->name(), "cinn_op");
+    op_names.push_back(op.name());
+  }
+  const std::vector<std::string> expected_op_names = {
+      paddle::dialect::DataOp::name(),
+      paddle::dialect::ScaleOp::name(),
+      paddle::dialect::ReshapeOp::name(),
+      paddle::dialect::SumOp::name(),
+      paddle::dialect::ExpandOp::name(),
+      paddle::dialect::SliceOp::name(),
+      ::pir::ShadowOutputOp::name()};
+  EXPECT_EQ(op_names, expected_op_names);
+
+  // Run the phi kernels the way the fallback of CinnJitInstruction does.
+  paddle::platform::Place place = paddle::platform::CPUPlace();
+  auto kernel_program =
+      paddle::dialect::PdOpLowerToKernelPass(fallback_program.get(), place);
+  const std::string input_name = AsyncKernel::FallbackInputName(0);
+  const std::string output_name = AsyncKernel::FallbackOutputName(0);
+  paddle::framework::Scope scope;
+  auto* input = scope.Var(input_name)->GetMutable<phi::DenseTensor>();
+  input->Resize(common::make_ddim({4, 8}));
+  float* input_data = input->mutable_data<float>(place);
+  for (int64_t i = 0; i < input->numel(); ++i) {
+    input_data[i] = 2.0;
+  }
+  paddle::framework::interpreter::ExecutionConfig execution_config;
+  execution_config.skip_gc_vars = {input_name, output_name};
+  paddle::framework::InterpreterCore executor(
+      place, {}, kernel_program->block(), &scope, execution_config);
+  executor.Run({}, /*need_fetch=*/false);
+
+  const auto& out = scope.FindVar(output_name)->Get<phi::DenseTensor>();
+  ASSERT_EQ(out.dims(), common::make_ddim({2, 8}));
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    // Each row of the reshaped x sums 4 elements of 2 * 2 + 1.
+    EXPECT_FLOAT_EQ(out.data<float>()[i], 20.0);
+  }
+}
+
+// expand only broadcasts x to the trailing dims of the output, so the group
+// has no fallback program.
+TEST(FallbackProgram, NoRuleForLeadingBroadcast) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = builder
+               .Build<paddle::dialect::FullOp>(std::vector<int64_t>{8},
+                                               1.0,
+                                               phi::DataType::FLOAT32,
+                                               phi::CPUPlace())
+               .result(0);
+  auto broadcast = builder.Build<cinn::dialect::BroadcastOp>(
+      x, std::vector<int64_t>{0}, std::vector<int64_t>{8, 4});
+
+  EXPECT_EQ(cinn::dialect::ir::details::BuildFallbackProgram(
+                CreateGroup({broadcast.operation()})),
+            nullptr);
+}
@@ -0,0 +1,229 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/hlir/dialect/operator/ir/manual_op.h"
+#include "paddle/cinn/hlir/dialect/operator/ir/op_dialect.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/add_store_in_fusion_op_pass.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/cinn_group_cluster_pass.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/horizontal_fusion_pass.h"
+#include "paddle/cinn/hlir/dialect/operator/transforms/lowering_pass/lower_cinn_fusion_op_pass.h"
+#include "paddle/cinn/hlir/dialect/runtime/ir/jit_kernel_op.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/transforms/pd_op_to_kernel_pass.h"
+#include "paddle/pir/include/core/builtin_type.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_dialect.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_op.h"
+#include "paddle/pir/include/pass/pass_manager.h"
+
+namespace {
+
+std::vector<::pir::Type> CreateDenseTensorTypes(const phi::DDim& dims) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ::pir::Type fp32_dtype = ::pir::Float32Type::get(ctx);
+  phi::DataLayout data_layout = phi::DataLayout::NCHW;
+  phi::LoD lod = {};
+  size_t offset = 0;
+  std::vector<::pir::Type> op_output_types = {::pir::DenseTensorType::get(
+      ctx, fp32_dtype, dims, data_layout, lod, offset)};
+  return op_output_types;
+}
+
+template <typename OpT>
+::pir::Value BuildUnaryGroup(::pir::Builder* builder,
+                             ::pir::Block* program_block,
+                             ::pir::Value x,
+                             const std::vector<int64_t>& shape) {
+  builder->SetInsertionPointToBlockEnd(program_block);
+  auto group_op = builder->Build<cinn::dialect::GroupOp>(
+      CreateDenseTensorTypes(common::make_ddim(shape)));
+  builder->SetInsertionPointToBlockEnd(group_op.block());
+  auto op = builder->Build<OpT>(x);
+  builder->Build<::pir::YieldOp>(std::vector<::pir::Value>{op.out()});
+  builder->SetInsertionPointToBlockEnd(program_block);
+  return group_op->result(0);
+}
+
+// sin(x) and cos(y) are independent, while exp reads sin(x).
+std::shared_ptr<::pir::Program> BuildIndependentGroupsProgram(
+    const std::vector<int64_t>& x_shape, const std::vector<int64_t>& y_shape) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<::pir::ControlFlowDialect>();
+
+  auto program = std::make_shared<::pir::Program>(ctx);
+  ::pir::Builder builder = ::pir::Builder(ctx, program->block());
+  const float value = 0.5;
+  auto full_x = builder.Build<paddle::dialect::FullOp>(
+      x_shape, value, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto full_y = builder.Build<paddle::dialect::FullOp>(
+      y_shape, value, phi::DataType::FLOAT32, phi::CPUPlace());
+
+  auto sin = BuildUnaryGroup<paddle::dialect::SinOp>(
+      &builder, program->block(), full_x.out(), x_shape);
+  auto cos = BuildUnaryGroup<paddle::dialect::CosOp>(
+      &builder, program->block(), full_y.out(), y_shape);
+  auto exp = BuildUnaryGroup<paddle::dialect::ExpOp>(
+      &builder, program->block(), sin, x_shape);
+
+  builder.Build<paddle::dialect::FetchOp>(exp, "exp", 0);
+  builder.Build<paddle::dialect::FetchOp>(cos, "cos", 1);
+  return program;
+}
+
+std::vector<cinn::dialect::FusionOp> GetFusionOps(::pir::Program* program) {
+  std::vector<cinn::dialect::FusionOp> fusion_ops;
+  for (auto& op : *program->block()) {
+    if (op.isa<cinn::dialect::FusionOp>()) {
+      fusion_ops.push_back(op.dyn_cast<cinn::dialect::FusionOp>());
+    }
+  }
+  return fusion_ops;
+}
+
+void RunHorizontalFusion(::pir::Program* program) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ::pir::PassManager pass_manager(ctx);
+  pass_manager.AddPass(cinn::dialect::ir::CreateCinnGroupClusterPass());
+  pass_manager.Run(program);
+  const size_t num_fusion_ops = GetFusionOps(program).size();
+
+  ::pir::PassManager horizontal_pass_manager(ctx);
+  horizontal_pass_manager.AddPass(
+      cinn::dialect::ir::CreateHorizontalFusionPass());
+  horizontal_pass_manager.Run(program);
+
+  std::stringstream ss;
+  program->Print(ss);
+  LOG(INFO) << "FusionOp count before/after horizontal fusion: "
+            << num_fusion_ops << "/" << GetFusionOps(program).size() << "\n"
+            << ss.str();
+}
+
+size_t CountJitKernelOps(::pir::Program* program) {
+  size_t num_kernels = 0;
+  for (auto& op : *program->block()) {
+    if (op.isa<cinn::dialect::JitKernelOp>()) ++num_kernels;
+  }
+  return num_kernels;
+}
+
+struct LoweringResult {
+  size_t num_kernels = 0;
+  std::vector<float> exp;
+  std::vector<float> cos;
+};
+
+// Lowers the groups of the program to the kernels of the default target and
+// runs them, with or without the horizontal fusion.
+LoweringResult LowerAndRun(::pir::Program* program, bool horizontal_fusion) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ::pir::PassManager pass_manager(ctx);
+  pass_manager.AddPass(cinn::dialect::ir::CreateCinnGroupClusterPass());
+  if (horizontal_fusion) {
+    pass_manager.AddPass(cinn::dialect::ir::CreateHorizontalFusionPass());
+  }
+  pass_manager.AddPass(cinn::dialect::ir::CreateAddStoreInFusionOpPass());
+  pass_manager.AddPass(cinn::dialect::ir::CreateLowerCinnFusionOpPass());
+  CHECK_EQ(pass_manager.Run(program), true);
+
+  LoweringResult result;
+  result.num_kernels = CountJitKernelOps(program);
+
+#ifdef CINN_WITH_CUDA
+  paddle::platform::Place place = paddle::platform::CUDAPlace(0);
+#else
+  paddle::platform::Place place = paddle::platform::CPUPlace();
+#endif
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(program, place);
+  paddle::framework::Scope exe_scope;
+  paddle::framework::InterpreterCore executor(
+      place, {"exp@fetch", "cos@fetch"}, kernel_program->block(), &exe_scope);
+  executor.Run({}, true);
+
+  auto GetFetched = [&](const std::string& name) {
+    const auto& tensor =
+        executor.local_scope()->FindVar(name)->Get<phi::DenseTensor>();
+    return std::vector<float>(tensor.data<float>(),
+                              tensor.data<float>() + tensor.numel());
+  };
+  result.exp = GetFetched("exp@fetch");
+  result.cos = GetFetched("cos@fetch");
+  return result;
+}
+
+}  // namespace
+
+TEST(HorizontalFusion, MergeIndependentGroups) {
+  std::shared_ptr<::pir::Program> program =
+      BuildIndependentGroupsProgram({16, 32}, {16, 32});
+  RunHorizontalFusion(program.get());
+
+  // sin(x) is merged with cos(y), the exp reading sin(x) is not.
+  auto fusion_ops = GetFusionOps(program.get());
+  ASSERT_EQ(fusion_ops.size(), 2u);
+  EXPECT_EQ(fusion_ops[0]->num_results(), 2u);
+  EXPECT_EQ(fusion_ops[0].GetOperators().size(), 3u);
+  EXPECT_EQ(fusion_ops[1]->num_results(), 1u);
+  EXPECT_EQ(fusion_ops[1].GetOperators().front()->operand_source(0),
+            fusion_ops[0]->result(0));
+}
+
+TEST(HorizontalFusion, KeepGroupsOfDifferentShapes) {
+  std::shared_ptr<::pir::Program> program =
+      BuildIndependentGroupsProgram({16, 32}, {32, 16});
+  RunHorizontalFusion(program.get());
+
+  auto fusion_ops = GetFusionOps(program.get());
+  ASSERT_EQ(fusion_ops.size(), 3u);
+  for (auto fusion_op : fusion_ops) {
+    EXPECT_EQ(fusion_op->num_results(), 1u);
+  }
+}
+
+// The merged fusion op lowers to one kernel computing the outputs of the
+// fusion ops it merges.
+TEST(HorizontalFusion, LowerMergedGroups) {
+  auto unmerged = LowerAndRun(
+      BuildIndependentGroupsProgram({16, 32}, {16, 32}).get(), false);
+  auto merged = LowerAndRun(
+      BuildIndependentGroupsProgram({16, 32}, {16, 32}).get(), true);
+  LOG(INFO) << "Kernel launches without/with horizontal fusion: "
+            << unmerged.num_kernels << "/" << merged.num_kernels;
+  EXPECT_EQ(merged.num_kernels + 1, unmerged.num_kernels);
+
+  ASSERT_EQ(merged.exp.size(), 16UL * 32UL);
+  ASSERT_EQ(merged.exp.size(), unmerged.exp.size());
+  ASSERT_EQ(merged.cos.size(), unmerged.cos.size());
+  for (size_t i = 0; i < merged.exp.size(); ++i) {
+    EXPECT_FLOAT_EQ(merged.exp[i], unmerged.exp[i]);
+    EXPECT_NEAR(merged.exp[i], std::exp(std::sin(0.5f)), 1e-5);
+  }
+  for (size_t i = 0; i < merged.cos.size(); ++i) {
+    EXPECT_FLOAT_EQ(merged.cos[i], unmerged.cos[i]);
+    EXPECT_NEAR(merged.cos[i], std::cos(0.5f), 1e-5);
+  }
+}
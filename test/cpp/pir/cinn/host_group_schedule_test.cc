@@ -0,0 +1,243 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/backends/llvm/execution_engine.h"
+#include "paddle/cinn/cinn.h"
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/common/test_helper.h"
+#include "paddle/cinn/hlir/framework/pir/op_lowering_impl.h"
+#include "paddle/cinn/ir/group_schedule/base_group_scheduler.h"
+#include "paddle/cinn/lang/lower.h"
+#include "paddle/cinn/optim/optimize.h"
+#include "paddle/cinn/runtime/cpu/use_extern_funcs.h"
+#include "paddle/cinn/utils/timer.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/activation_kernel.h"
+#include "paddle/phi/kernels/elementwise_multiply_kernel.h"
+#include "paddle/phi/kernels/elementwise_subtract_kernel.h"
+#include "paddle/phi/kernels/reduce_sum_kernel.h"
+
+// Fused groups of the host tactics against the same ops run one by one by
+// the phi kernels, and against the fused group without a group schedule.
+
+namespace cinn {
+namespace ir {
+
+using hlir::framework::pir::GroupInfo;
+using HostFunc = void (*)(void*, int32_t);
+
+constexpr int kM = 1024;
+constexpr int kN = 1024;
+constexpr int kRepeat = 20;
+
+// The average milliseconds of fn, after a warmup run.
+float Benchmark(const std::function<void()>& fn) {
+  fn();
+  utils::Timer timer;
+  timer.Start();
+  for (int i = 0; i < kRepeat; ++i) {
+    fn();
+  }
+  return timer.Stop() / kRepeat;
+}
+
+// Lowers the group computing the last of tensors, all but the temporary
+// ones, with the group schedule of the host if group_info is given.
+ir::LoweredFunc LowerGroup(const std::string& name,
+                           const std::vector<ir::Tensor>& tensors,
+                           const std::shared_ptr<GroupInfo>& group_info) {
+  const common::Target& target = common::DefaultHostTarget();
+  auto stages = CreateStages(tensors);
+  auto funcs = lang::LowerVec(
+      name, stages, tensors, {}, {}, nullptr, target, true);
+  CHECK_EQ(funcs.size(), 1U);
+  ir::Expr body = funcs[0]->body;
+  if (group_info != nullptr) {
+    ir::IRSchedule ir_sch(ir::ModuleExpr({body}),
+                          -1,
+                          false,
+                          utils::ErrorMessageLevel::kGeneral,
+                          /* is_dynamic_shape = */ true);
+    std::unique_ptr<GroupScheduler> group_scheduler =
+        GroupScheduler::Make(&ir_sch,
+                             {tensors.back()->name},
+                             target,
+                             /* is_dy_shape = */ true,
+                             group_info);
+    group_scheduler->Schedule();
+    body = group_scheduler->GetIRs().front().second;
+  }
+  VLOG(1) << name << ":\n" << body;
+  ir::LoweredFunc func =
+      ir::_LoweredFunc_::Make(funcs[0]->name,
+                              funcs[0]->args,
+                              body,
+                              lang::GetTempBuffers(funcs[0]->args, body));
+  return optim::Optimize(Expr(func), target, false).as_lowered_func_ref();
+}
+
+// Runs the group lowered with and without the group schedule and the phi
+// kernels, checks the results agree and prints their times.
+void RunHostGroup(
+    const std::string& name,
+    const std::vector<ir::Tensor>& tensors,
+    const std::shared_ptr<GroupInfo>& group_info,
+    const std::vector<int>& out_shape,
+    const std::function<void(const phi::CPUContext&,
+                             const phi::DenseTensor&,
+                             const phi::DenseTensor&,
+                             phi::DenseTensor*)>& run_phi) {
+  const common::Target& target = common::DefaultHostTarget();
+  ir::Module::Builder builder(name, target);
+  builder.AddFunction(LowerGroup(name + "_naive", tensors, nullptr));
+  builder.AddFunction(LowerGroup(name + "_scheduled", tensors, group_info));
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link<backends::CodeGenX86>(builder.Build());
+  auto naive_fn = reinterpret_cast<HostFunc>(jit->Lookup(name + "_naive"));
+  auto scheduled_fn =
+      reinterpret_cast<HostFunc>(jit->Lookup(name + "_scheduled"));
+  ASSERT_NE(naive_fn, nullptr);
+  ASSERT_NE(scheduled_fn, nullptr);
+
+  cinn_buffer_t* a_buf =
+      common::BufferBuilder(Float(32), {kM, kN}).set_random().Build();
+  cinn_buffer_t* b_buf =
+      common::BufferBuilder(Float(32), {kM, kN}).set_random().Build();
+  cinn_buffer_t* naive_buf =
+      common::BufferBuilder(Float(32), out_shape).set_zero().Build();
+  cinn_buffer_t* scheduled_buf =
+      common::BufferBuilder(Float(32), out_shape).set_zero().Build();
+  cinn_pod_value_t naive_args[] = {cinn_pod_value_t(a_buf),
+                                   cinn_pod_value_t(b_buf),
+                                   cinn_pod_value_t(naive_buf)};
+  cinn_pod_value_t scheduled_args[] = {cinn_pod_value_t(a_buf),
+                                       cinn_pod_value_t(b_buf),
+                                       cinn_pod_value_t(scheduled_buf)};
+
+  auto* ctx = static_cast<phi::CPUContext*>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+  phi::DenseTensor x, y, out;
+  x.Resize(phi::make_ddim({kM, kN}));
+  y.Resize(phi::make_ddim({kM, kN}));
+  std::memcpy(
+      ctx->Alloc<float>(&x), a_buf->memory, kM * kN * sizeof(float));
+  std::memcpy(
+      ctx->Alloc<float>(&y), b_buf->memory, kM * kN * sizeof(float));
+
+  float phi_ms = Benchmark([&] { run_phi(*ctx, x, y, &out); });
+  float naive_ms = Benchmark([&] { naive_fn(naive_args, 3); });
+  float scheduled_ms = Benchmark([&] { scheduled_fn(scheduled_args, 3); });
+  LOG(INFO) << name << ": phi kernels " << phi_ms << " ms, fused group "
+            << naive_ms << " ms, fused group with host tactics "
+            << scheduled_ms << " ms";
+
+  const float* expected = out.data<float>();
+  const float* naive = reinterpret_cast<float*>(naive_buf->memory);
+  const float* scheduled = reinterpret_cast<float*>(scheduled_buf->memory);
+  ASSERT_EQ(out.numel(), naive_buf->num_elements());
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    float tolerance = 1e-5f * std::max(std::abs(expected[i]), 1.0f);
+    ASSERT_NEAR(naive[i], expected[i], tolerance);
+    ASSERT_NEAR(scheduled[i], expected[i], tolerance * 16);
+  }
+}
+
+TEST(HostGroupSchedule, Elementwise) {
+  Context::Global().ResetNameId();
+  Expr M(kM), N(kN);
+  Placeholder<float> A("A", {M, N});
+  Placeholder<float> B("B", {M, N});
+  auto sub = Compute(
+      {M, N}, [&](Var i, Var j) { return A(i, j) - B(i, j); }, "sub");
+  auto exp = Compute(
+      {M, N}, [&](Var i, Var j) { return lang::Exp(sub(i, j)); }, "exp");
+  auto out = Compute(
+      {M, N}, [&](Var i, Var j) { return exp(i, j) * A(i, j); }, "out");
+
+  auto group_info = std::make_shared<GroupInfo>();
+  group_info->data_space = {kM, kN};
+  group_info->direct_output_var_names = {"out"};
+  RunHostGroup("elementwise",
+               {A, B, sub, exp, out},
+               group_info,
+               {kM, kN},
+               [](const phi::CPUContext& ctx,
+                  const phi::DenseTensor& x,
+                  const phi::DenseTensor& y,
+                  phi::DenseTensor* out) {
+                 phi::DenseTensor sub, exp;
+                 sub.Resize(x.dims());
+                 exp.Resize(x.dims());
+                 out->Resize(x.dims());
+                 phi::SubtractKernel<float>(ctx, x, y, &sub);
+                 phi::ExpKernel<float>(ctx, sub, &exp);
+                 phi::MultiplyKernel<float>(ctx, exp, x, out);
+               });
+}
+
+TEST(HostGroupSchedule, Reduce) {
+  Context::Global().ResetNameId();
+  Expr M(kM), N(kN);
+  Placeholder<float> A("A", {M, N});
+  Placeholder<float> B("B", {M, N});
+  auto sub = Compute(
+      {M, N}, [&](Var i, Var j) { return A(i, j) - B(i, j); }, "sub");
+  auto exp = Compute(
+      {M, N}, [&](Var i, Var j) { return lang::Exp(sub(i, j)); }, "exp");
+  Var k(kN, "k0");
+  auto out = Compute(
+      {M}, [&](Var i) { return lang::ReduceSum(exp(i, k), {k}); }, "out");
+
+  auto group_info = std::make_shared<GroupInfo>();
+  group_info->data_space = {kM, kN};
+  group_info->reduce_axis = {1};
+  group_info->reduce_var_names = {"out"};
+  group_info->direct_output_var_names = {"out"};
+  RunHostGroup("reduce",
+               {A, B, sub, exp, out},
+               group_info,
+               {kM},
+               [](const phi::CPUContext& ctx,
+                  const phi::DenseTensor& x,
+                  const phi::DenseTensor& y,
+                  phi::DenseTensor* out) {
+                 phi::DenseTensor sub, exp;
+                 sub.Resize(x.dims());
+                 exp.Resize(x.dims());
+                 out->Resize(phi::make_ddim({kM}));
+                 phi::SubtractKernel<float>(ctx, x, y, &sub);
+                 phi::ExpKernel<float>(ctx, sub, &exp);
+                 phi::SumKernel<float>(ctx,
+                                       exp,
+                                       phi::IntArray({1}),
+                                       phi::DataType::FLOAT32,
+                                       false,
+                                       out);
+               });
+}
+
+}  // namespace ir
+}  // namespace cinn
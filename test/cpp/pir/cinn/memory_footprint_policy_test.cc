@@ -0,0 +1,269 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "paddle/cinn/hlir/dialect/operator/ir/op_dialect.h"
+#include "paddle/cinn/operator_fusion/frontend/pattern.h"
+#include "paddle/cinn/operator_fusion/frontend/pattern_fuser.h"
+#include "paddle/cinn/operator_fusion/pattern_node.h"
+#include "paddle/cinn/operator_fusion/policy/memory_footprint_policy.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+
+namespace cinn::fusion {
+namespace {
+
+using Policy = MemoryFootprintPolicy<FrontendStage>;
+using NodePtr = PatternNodePtr<FrontendStage>;
+
+constexpr int64_t kRows = 64;
+constexpr int64_t kCols = 256;
+constexpr int64_t kTensorBytes = kRows * kCols * 4;
+constexpr int64_t kRowBytes = kCols * 4;
+
+std::shared_ptr<::pir::Program> CreateProgram() {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
+  return std::make_shared<::pir::Program>(ctx);
+}
+
+::pir::Value BuildInput(::pir::Builder* builder,
+                        const std::vector<int64_t>& shape) {
+  return builder
+      ->Build<paddle::dialect::DataOp>(
+          "x", shape, phi::DataType::FLOAT32, phi::CPUPlace())
+      .result(0);
+}
+
+// One node per op, each the only upstream of the next.
+std::vector<NodePtr> CreateChain(const std::vector<::pir::Operation*>& ops) {
+  std::vector<NodePtr> nodes;
+  for (auto* op : ops) {
+    nodes.push_back(
+        std::make_shared<PatternNode<FrontendStage>>(FrontendContent(op)));
+  }
+  for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+    nodes[i]->AddNodeToDownstream(nodes[i + 1]);
+    nodes[i + 1]->AddNodeToUpstream(nodes[i]);
+  }
+  return nodes;
+}
+
+// The score of merging the segments of a chain the way the plan does: the
+// bytes saved between each pair of neighbors in a segment, against the
+// working set of the whole segment.
+int64_t SplitScore(const Policy& policy,
+                   const std::vector<::pir::Operation*>& ops,
+                   const std::vector<bool>& merged) {
+  int64_t score = 0;
+  size_t begin = 0;
+  for (size_t end = 1; end <= ops.size(); ++end) {
+    if (end < ops.size() && merged[end - 1]) continue;
+    if (end - begin > 1) {
+      FusionCost cost;
+      std::vector<::pir::Operation*> segment(ops.begin() + begin,
+                                             ops.begin() + end);
+      for (size_t i = begin; i + 1 < end; ++i) {
+        cost.saved_bytes +=
+            policy.EstimateCost({ops[i]}, {ops[i + 1]}, ops[i + 1])
+                .saved_bytes;
+      }
+      const auto& segment_cost = policy.EstimateCost(segment, {}, ops[end - 1]);
+      cost.working_set_bytes = segment_cost.working_set_bytes;
+      cost.num_rows = segment_cost.num_rows;
+      score += policy.Score(cost);
+    }
+    begin = end;
+  }
+  return score;
+}
+
+}  // namespace
+
+TEST(MemoryFootprintPolicy, EstimateCost) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = BuildInput(&builder, {kRows, kCols});
+  auto exp = builder.Build<paddle::dialect::ExpOp>(x);
+  auto sin = builder.Build<paddle::dialect::SinOp>(exp.result(0));
+
+  // exp(x) is written and read back by sin, unless fused.
+  Policy policy({sin.result(0)}, 1 << 20, FusionPlanAlgorithm::kGreedy);
+  auto cost = policy.EstimateCost(
+      {exp.operation()}, {sin.operation()}, sin.operation());
+  EXPECT_EQ(cost.saved_bytes, 2 * kTensorBytes);
+  EXPECT_EQ(cost.working_set_bytes, 3 * kRowBytes);
+  EXPECT_EQ(cost.num_rows, kRows);
+  EXPECT_EQ(policy.Score(cost), cost.saved_bytes);
+
+  // Still written once as an output of the program.
+  Policy output_policy({exp.result(0), sin.result(0)},
+                       1 << 20,
+                       FusionPlanAlgorithm::kGreedy);
+  EXPECT_EQ(output_policy
+                .EstimateCost(
+                    {exp.operation()}, {sin.operation()}, sin.operation())
+                .saved_bytes,
+            kTensorBytes);
+}
+
+TEST(MemoryFootprintPolicy, ScoreSpills) {
+  Policy policy({}, 1024, FusionPlanAlgorithm::kGreedy);
+  FusionCost cost;
+  cost.saved_bytes = 1000;
+  cost.working_set_bytes = 1024;
+  cost.num_rows = 2;
+  EXPECT_EQ(policy.Score(cost), 1000);
+  // Each row spills and reloads the 476 bytes over the limit.
+  cost.working_set_bytes = 1500;
+  EXPECT_EQ(policy.Score(cost), 1000 - 476 * 2 * 2);
+}
+
+TEST(MemoryFootprintPolicy, CanFuseVeto) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = BuildInput(&builder, {kRows, kCols});
+  auto exp = builder.Build<paddle::dialect::ExpOp>(x);
+  auto sin = builder.Build<paddle::dialect::SinOp>(exp.result(0));
+  auto nodes = CreateChain({exp.operation(), sin.operation()});
+
+  Policy roomy_policy({sin.result(0)}, 1 << 20, FusionPlanAlgorithm::kGreedy);
+  EXPECT_TRUE(roomy_policy.CanFuse(nodes[0], nodes[1]));
+  // Every row spills far more than the intermediate it saves.
+  Policy tight_policy({sin.result(0)}, 16, FusionPlanAlgorithm::kGreedy);
+  EXPECT_FALSE(tight_policy.CanFuse(nodes[0], nodes[1]));
+  ASSERT_EQ(tight_policy.decisions().size(), 1UL);
+  EXPECT_FALSE(tight_policy.decisions()[0].planned);
+  EXPECT_LT(tight_policy.decisions()[0].score, 0);
+}
+
+// The chain x -> exp -> cast -> sin -> cos -> cast, of rows of different
+// bytes, is split the best way over a range of working set limits.
+TEST(MemoryFootprintPolicy, PlanChainsOptimalSplit) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = BuildInput(&builder, {kRows, kCols});
+  auto exp = builder.Build<paddle::dialect::ExpOp>(x);
+  auto cast = builder.Build<paddle::dialect::CastOp>(exp.result(0),
+                                                     phi::DataType::FLOAT64);
+  auto sin = builder.Build<paddle::dialect::SinOp>(cast.result(0));
+  auto cos = builder.Build<paddle::dialect::CosOp>(sin.result(0));
+  auto cast_back = builder.Build<paddle::dialect::CastOp>(
+      cos.result(0), phi::DataType::FLOAT32);
+  const std::vector<::pir::Operation*> ops = {exp.operation(),
+                                              cast.operation(),
+                                              sin.operation(),
+                                              cos.operation(),
+                                              cast_back.operation()};
+
+  for (int64_t limit = kRowBytes; limit <= 12 * kRowBytes;
+       limit += kRowBytes / 2) {
+    Policy policy({cast_back.result(0)}, limit, FusionPlanAlgorithm::kDP);
+    int64_t best_score = std::numeric_limits<int64_t>::min();
+    for (uint32_t mask = 0; mask < (1U << (ops.size() - 1)); ++mask) {
+      std::vector<bool> merged(ops.size() - 1);
+      for (size_t i = 0; i + 1 < ops.size(); ++i) {
+        merged[i] = mask & (1U << i);
+      }
+      best_score = std::max(best_score, SplitScore(policy, ops, merged));
+    }
+
+    auto nodes = CreateChain(ops);
+    policy.PlanFusion(nodes);
+    std::vector<bool> planned_merged;
+    for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+      planned_merged.push_back(policy.CanFuse(nodes[i], nodes[i + 1]));
+      EXPECT_TRUE(policy.decisions().back().planned);
+    }
+    EXPECT_EQ(SplitScore(policy, ops, planned_merged), best_score)
+        << "working set limit " << limit;
+  }
+}
+
+// exp(x) and sin(x) both merge into their add, which is left to the greedy
+// plan even by the dp.
+TEST(MemoryFootprintPolicy, PlanGreedily) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = BuildInput(&builder, {kRows, kCols});
+  auto exp = builder.Build<paddle::dialect::ExpOp>(x);
+  auto sin = builder.Build<paddle::dialect::SinOp>(x);
+  auto add =
+      builder.Build<paddle::dialect::AddOp>(exp.result(0), sin.result(0));
+  auto CreateNodes = [&] {
+    std::vector<NodePtr> nodes;
+    for (auto* op : {exp.operation(), sin.operation(), add.operation()}) {
+      nodes.push_back(
+          std::make_shared<PatternNode<FrontendStage>>(FrontendContent(op)));
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      nodes[i]->AddNodeToDownstream(nodes[2]);
+      nodes[2]->AddNodeToUpstream(nodes[i]);
+    }
+    return nodes;
+  };
+
+  for (auto algorithm :
+       {FusionPlanAlgorithm::kGreedy, FusionPlanAlgorithm::kDP}) {
+    // The rows of x, exp, sin and add fit.
+    Policy roomy_policy({add.result(0)}, 4 * kRowBytes, algorithm);
+    auto nodes = CreateNodes();
+    roomy_policy.PlanFusion(nodes);
+    EXPECT_TRUE(roomy_policy.CanFuse(nodes[0], nodes[2]));
+    EXPECT_TRUE(roomy_policy.CanFuse(nodes[1], nodes[2]));
+    for (const auto& decision : roomy_policy.decisions()) {
+      EXPECT_TRUE(decision.planned);
+    }
+
+    // Half of them fit, so each merge spills twice the bytes it saves.
+    Policy tight_policy({add.result(0)}, 2 * kRowBytes, algorithm);
+    nodes = CreateNodes();
+    tight_policy.PlanFusion(nodes);
+    EXPECT_FALSE(tight_policy.CanFuse(nodes[0], nodes[2]));
+    EXPECT_FALSE(tight_policy.CanFuse(nodes[1], nodes[2]));
+    for (const auto& decision : tight_policy.decisions()) {
+      EXPECT_TRUE(decision.planned);
+    }
+  }
+}
+
+// A tensor of seven dynamic dims is estimated at 1024^7 elements, which the
+// estimates saturate at instead of overflowing.
+TEST(MemoryFootprintPolicy, SaturateDynamicShapes) {
+  auto program = CreateProgram();
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  auto x = BuildInput(&builder, std::vector<int64_t>(7, -1));
+  auto exp = builder.Build<paddle::dialect::ExpOp>(x);
+  auto sin = builder.Build<paddle::dialect::SinOp>(exp.result(0));
+
+  Policy policy({sin.result(0)}, 1024, FusionPlanAlgorithm::kGreedy);
+  auto cost = policy.EstimateCost(
+      {exp.operation()}, {sin.operation()}, sin.operation());
+  EXPECT_GT(cost.saved_bytes, 0);
+  EXPECT_GT(cost.num_rows, 0);
+  const int64_t score = policy.Score(cost);
+  EXPECT_LE(score, cost.saved_bytes);
+  EXPECT_GT(score, std::numeric_limits<int64_t>::min() / 2);
+}
+
+}  // namespace cinn::fusion
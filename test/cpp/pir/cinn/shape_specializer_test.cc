@@ -0,0 +1,214 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/hlir/dialect/operator/ir/op_dialect.h"
+#include "paddle/cinn/hlir/framework/pir/op_lowering_group.h"
+#include "paddle/cinn/hlir/framework/pir/shape_specializer.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+#include "paddle/pir/include/dialect/shape/utils/shape_or_data_expr.h"
+
+PD_DECLARE_int32(cinn_max_shape_specializations);
+PD_DECLARE_int32(cinn_shape_specialize_threshold);
+
+using cinn::hlir::framework::pir::CINNKernelInfo;
+using cinn::hlir::framework::pir::CompilationResult;
+using cinn::hlir::framework::pir::OpLoweringGroup;
+using cinn::hlir::framework::pir::OpLoweringGroupPtr;
+using cinn::hlir::framework::pir::ShapeDispatcher;
+using cinn::hlir::framework::pir::ShapeSpecializer;
+
+namespace {
+
+struct FakeKernel {
+  std::string fn_name;
+};
+
+// exp(x) of x of [x_dim_0, 8], exp of [exp_dim_0, 8].
+std::shared_ptr<::pir::Program> BuildExpGroup(const symbol::DimExpr& x_dim_0,
+                                              const symbol::DimExpr& exp_dim_0,
+                                              OpLoweringGroupPtr* group) {
+  ::pir::IrContext* ctx = ::pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
+  auto program = std::make_shared<::pir::Program>(ctx);
+  ::pir::Builder builder(ctx, program->block());
+  const int64_t dim_0 = x_dim_0.isa<int64_t>() ? x_dim_0.Get<int64_t>() : -1;
+  auto x = builder
+               .Build<paddle::dialect::DataOp>("x",
+                                               std::vector<int64_t>{dim_0, 8},
+                                               phi::DataType::FLOAT32,
+                                               phi::CPUPlace())
+               .result(0);
+  auto exp = builder.Build<paddle::dialect::ExpOp>(x);
+
+  *group = std::make_shared<OpLoweringGroup>(
+      std::vector<::pir::Operation*>{exp.operation()});
+  (*group)->mut_output_ops().insert(exp.operation());
+  (*group)->mut_output_values().push_back(exp.result(0));
+  (*group)->SetShapeOrDataExprs(
+      x,
+      symbol::ShapeOrDataDimExprs(symbol::TensorShapeOrDataDimExprs(
+          {x_dim_0, symbol::DimExpr(8)})));
+  (*group)->SetShapeOrDataExprs(
+      exp.result(0),
+      symbol::ShapeOrDataDimExprs(symbol::TensorShapeOrDataDimExprs(
+          {exp_dim_0, symbol::DimExpr(8)})));
+  return program;
+}
+
+// Names the kernels after the static dim the group is specialized with.
+void SetFakeCompile(ShapeSpecializer* specializer,
+                    std::atomic<int>* num_compiled) {
+  specializer->SetCompileFunction(
+      [num_compiled](const OpLoweringGroupPtr& group,
+                     std::shared_ptr<CompilationResult>*) {
+        const auto& x = group->GetInputOpValues()[0];
+        const auto& dim = group->GetShapeOrDataExprs(x).shape()[0];
+        EXPECT_TRUE(dim.isa<int64_t>());
+        CINNKernelInfo kernel_info;
+        kernel_info.fn_name = "exp_" + std::to_string(dim.Get<int64_t>());
+        num_compiled->fetch_add(1);
+        return kernel_info;
+      });
+}
+
+// Dispatches shape until its specialized kernel is taken, for 10 seconds at
+// most.
+FakeKernel* WaitForKernel(ShapeDispatcher<FakeKernel>* dispatcher,
+                          const ShapeSpecializer::Shape& shape) {
+  for (int i = 0; i < 1000; ++i) {
+    if (FakeKernel* kernel = dispatcher->Dispatch(shape)) {
+      return kernel;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(ShapeSpecializer, Create) {
+  const auto& target = cinn::common::DefaultHostTarget();
+  OpLoweringGroupPtr group;
+
+  // Of static shape.
+  auto static_program =
+      BuildExpGroup(symbol::DimExpr(16), symbol::DimExpr(16), &group);
+  EXPECT_EQ(ShapeSpecializer::Create(target, group), nullptr);
+
+  // S1 is not a dim of the input.
+  auto unbound_program =
+      BuildExpGroup(symbol::DimExpr("S0"), symbol::DimExpr("S1"), &group);
+  EXPECT_EQ(ShapeSpecializer::Create(target, group), nullptr);
+
+  auto dynamic_program =
+      BuildExpGroup(symbol::DimExpr("S0"), symbol::DimExpr("S0"), &group);
+  auto specializer = ShapeSpecializer::Create(target, group);
+  ASSERT_NE(specializer, nullptr);
+  ASSERT_EQ(specializer->SymbolDims().size(), 1UL);
+  EXPECT_EQ(specializer->SymbolDims()[0].arg_idx, 0);
+  EXPECT_EQ(specializer->SymbolDims()[0].dim_idx, 0);
+}
+
+// The frequent shapes are dispatched to their kernels, up to
+// FLAGS_cinn_max_shape_specializations of them, the others to the generic
+// kernel.
+TEST(ShapeSpecializer, Dispatch) {
+  FLAGS_cinn_shape_specialize_threshold = 2;
+  FLAGS_cinn_max_shape_specializations = 2;
+  OpLoweringGroupPtr group;
+  auto program =
+      BuildExpGroup(symbol::DimExpr("S0"), symbol::DimExpr("S0"), &group);
+  auto specializer =
+      ShapeSpecializer::Create(cinn::common::DefaultHostTarget(), group);
+  ASSERT_NE(specializer, nullptr);
+  std::atomic<int> num_compiled{0};
+  SetFakeCompile(specializer.get(), &num_compiled);
+  ShapeDispatcher<FakeKernel> dispatcher(
+      specializer, [](const CINNKernelInfo& kernel_info) {
+        return std::make_unique<FakeKernel>(FakeKernel{kernel_info.fn_name});
+      });
+
+  // Run by the generic kernel until specialized.
+  EXPECT_EQ(dispatcher.Dispatch({16}), nullptr);
+  FakeKernel* kernel_16 = WaitForKernel(&dispatcher, {16});
+  ASSERT_NE(kernel_16, nullptr);
+  EXPECT_EQ(kernel_16->fn_name, "exp_16");
+  EXPECT_EQ(dispatcher.Dispatch({32}), nullptr);
+  EXPECT_EQ(dispatcher.Dispatch({16}), kernel_16);
+
+  FakeKernel* kernel_32 = WaitForKernel(&dispatcher, {32});
+  ASSERT_NE(kernel_32, nullptr);
+  EXPECT_EQ(kernel_32->fn_name, "exp_32");
+  EXPECT_EQ(dispatcher.Dispatch({16}), kernel_16);
+
+  // No room for a third specialization.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(dispatcher.Dispatch({64}), nullptr);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(dispatcher.Dispatch({64}), nullptr);
+  EXPECT_EQ(num_compiled.load(), 2);
+}
+
+// The instructions of identical groups share the specializer of the group
+// through the compilation cache, each of them dispatches to the kernels.
+TEST(ShapeSpecializer, SharedByDispatchers) {
+  FLAGS_cinn_shape_specialize_threshold = 2;
+  FLAGS_cinn_max_shape_specializations = 2;
+  OpLoweringGroupPtr group;
+  auto program =
+      BuildExpGroup(symbol::DimExpr("S0"), symbol::DimExpr("S0"), &group);
+  auto specializer =
+      ShapeSpecializer::Create(cinn::common::DefaultHostTarget(), group);
+  ASSERT_NE(specializer, nullptr);
+  std::atomic<int> num_compiled{0};
+  SetFakeCompile(specializer.get(), &num_compiled);
+  auto make_kernel = [](const CINNKernelInfo& kernel_info) {
+    return std::make_unique<FakeKernel>(FakeKernel{kernel_info.fn_name});
+  };
+  ShapeDispatcher<FakeKernel> first(specializer, make_kernel);
+  ShapeDispatcher<FakeKernel> second(specializer, make_kernel);
+
+  // The runs of both count towards the threshold.
+  EXPECT_EQ(first.Dispatch({16}), nullptr);
+  EXPECT_EQ(second.Dispatch({16}), nullptr);
+  FakeKernel* first_kernel = WaitForKernel(&first, {16});
+  ASSERT_NE(first_kernel, nullptr);
+  FakeKernel* second_kernel = second.Dispatch({16});
+  ASSERT_NE(second_kernel, nullptr);
+  EXPECT_EQ(first_kernel->fn_name, "exp_16");
+  EXPECT_EQ(second_kernel->fn_name, "exp_16");
+
+  // Later kernels reach both too.
+  EXPECT_EQ(second.Dispatch({32}), nullptr);
+  ASSERT_NE(WaitForKernel(&second, {32}), nullptr);
+  ASSERT_NE(first.Dispatch({32}), nullptr);
+  EXPECT_EQ(first.Dispatch({16}), first_kernel);
+  EXPECT_EQ(num_compiled.load(), 2);
+}
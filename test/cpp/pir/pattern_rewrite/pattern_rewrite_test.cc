@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -21,6 +22,7 @@
 #include <vector>
 
 #include "paddle/common/enforce.h"
+#include "paddle/common/flags.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_attribute.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
@@ -69,6 +71,8 @@ PD_DECLARE_KERNEL(conv2d, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(transpose, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(cummax, CPU, ALL_LAYOUT);
 
+COMMON_DECLARE_bool(pir_greedy_rewrite_by_worklist);
+
 // Define op1.
 class Operation1 : public pir::Op<Operation1> {
  public:
@@ -388,18 +392,7 @@ void BuildProgram(pir::Builder &builder) {  // NOLINT
   builder.Build<paddle::dialect::FetchOp>(add_out_1.out(), "out", 0);
 }
 
-TEST(pattern_rewrite, Patterns) {
-  pir::IrContext *ctx = pir::IrContext::Instance();
-
-  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
-  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
-
-  pir::Program program(ctx);
-  pir::Builder builder = pir::Builder(ctx, program.block());
-  BuildProgram(builder);
-
-  EXPECT_EQ(program.block()->size(), 27u);
-
+void RunPatternPasses(pir::IrContext *ctx, pir::Program *program) {
   pir::PassManager pm(ctx);
   pm.AddPass(std::make_unique<TestPass>());
   pm.AddPass(pir::CreateConv2dBnFusePass());
@@ -425,7 +418,38 @@ TEST(pattern_rewrite, Patterns) {
   //     true,
   //     true));
 
-  CHECK_EQ(pm.Run(&program), true);
+  CHECK_EQ(pm.Run(program), true);
+}
+
+TEST(pattern_rewrite, Patterns) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+
+  pir::Program program(ctx);
+  pir::Builder builder = pir::Builder(ctx, program.block());
+  BuildProgram(builder);
+
+  EXPECT_EQ(program.block()->size(), 27u);
+
+  RunPatternPasses(ctx, &program);
+  EXPECT_EQ(program.block()->size(), 17u);
+}
+
+TEST(pattern_rewrite, PatternsByWorklist) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+
+  pir::Program program(ctx);
+  pir::Builder builder = pir::Builder(ctx, program.block());
+  BuildProgram(builder);
+
+  FLAGS_pir_greedy_rewrite_by_worklist = true;
+  RunPatternPasses(ctx, &program);
+  FLAGS_pir_greedy_rewrite_by_worklist = false;
   EXPECT_EQ(program.block()->size(), 17u);
 }
 
@@ -629,3 +653,81 @@ TEST(constant_folding, ConstantFolding_MultiOutput) {
   CHECK_EQ(pm.Run(&program), true);
   EXPECT_EQ(program.block()->size(), 4u);
 }
+
+// Counts the ops it is tried on.
+class RedundantReluPattern
+    : public pir::OpRewritePattern<paddle::dialect::ReluOp> {
+ public:
+  using pir::OpRewritePattern<paddle::dialect::ReluOp>::OpRewritePattern;
+
+  bool MatchAndRewrite(paddle::dialect::ReluOp op,
+                       pir::PatternRewriter &rewriter) const override {
+    ++num_tried;
+    auto *prev_op = pir::GetDefiningOpForInput(op, 0);
+    if (!prev_op || !prev_op->isa<paddle::dialect::ReluOp>()) {
+      return false;
+    }
+    rewriter.ReplaceOp(op, {op->operand_source(0)});
+    return true;
+  }
+
+  static int64_t num_tried;
+};
+
+int64_t RedundantReluPattern::num_tried = 0;
+
+// Builds num_groups of relu(relu(full)), among ops no pattern applies to.
+void BuildRedundantReluProgram(pir::Program *program, int num_groups) {
+  pir::Builder builder =
+      pir::Builder(pir::IrContext::Instance(), program->block());
+  for (int i = 0; i < num_groups; ++i) {
+    auto full_op = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{16, 16}, 1.0);
+    auto relu_op = builder.Build<paddle::dialect::ReluOp>(full_op.out());
+    auto relu_op_1 = builder.Build<paddle::dialect::ReluOp>(relu_op.out());
+    builder.Build<paddle::dialect::FetchOp>(relu_op_1.out(), "out", i);
+  }
+}
+
+// Returns the number of the ops the pattern is tried on.
+int64_t RunRedundantReluPattern(bool by_worklist, int num_groups) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+  BuildRedundantReluProgram(&program, num_groups);
+
+  pir::RewritePatternSet ps(ctx);
+  ps.Add<RedundantReluPattern>(ctx);
+  pir::FrozenRewritePatternSet frozen_set(std::move(ps));
+
+  RedundantReluPattern::num_tried = 0;
+  FLAGS_pir_greedy_rewrite_by_worklist = by_worklist;
+  auto start = std::chrono::steady_clock::now();
+  auto [converged, num_rewrites] =
+      pir::ApplyPatternsGreedily(program.module_op().operation(), frozen_set);
+  auto cost_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  FLAGS_pir_greedy_rewrite_by_worklist = false;
+
+  EXPECT_TRUE(converged);
+  EXPECT_EQ(num_rewrites, num_groups);
+  EXPECT_EQ(program.block()->size(), static_cast<size_t>(num_groups * 3));
+  LOG(INFO) << (by_worklist ? "worklist" : "scanning") << " rewrite of "
+            << num_groups << " groups: tried "
+            << RedundantReluPattern::num_tried << " times in " << cost_us
+            << " us";
+  return RedundantReluPattern::num_tried;
+}
+
+TEST(pattern_rewrite, WorklistRevisitsAffectedOpsOnly) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+
+  constexpr int kNumGroups = 1000;
+  int64_t num_tried_by_scanning = RunRedundantReluPattern(false, kNumGroups);
+  int64_t num_tried_by_worklist = RunRedundantReluPattern(true, kNumGroups);
+  // Scanning tries the remaining relu of every group again to find that no
+  // pattern applies any more.
+  EXPECT_LT(num_tried_by_worklist, num_tried_by_scanning);
+}
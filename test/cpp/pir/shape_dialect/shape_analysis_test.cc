@@ -96,3 +96,39 @@ TEST(shape_optimization, shape_optimization_pass) {
   EXPECT_TRUE(
       shape_analysis.IsProductEqual(data_op_x_res, 3, 5, data_op_y_res, 1, 2));
 }
+
+TEST(shape_optimization, invalidate_shape_or_data_for_op) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+  pir::Builder builder = ::pir::Builder(ctx, program.block());
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::shape::ShapeDialect>();
+
+  auto data_op = builder.Build<paddle::dialect::DataOp>(
+      "x",
+      std::vector<int64_t>({-1, 64}),
+      phi::DataType::FLOAT32,
+      phi::Place());
+  auto abs_op = builder.Build<paddle::dialect::AbsOp>(data_op.result(0));
+  auto relu_op = builder.Build<paddle::dialect::ReluOp>(abs_op.result(0));
+
+  pir::PassManager pm(ctx);
+  pm.AddPass(pir::CreateShapeOptimizationPass());
+  pm.Run(&program);
+
+  pir::ShapeConstraintIRAnalysis& shape_analysis =
+      pir::ShapeAnalysisManager::Instance().Get(&program);
+  const symbol::ShapeOrDataDimExprs relu_shape_or_data =
+      shape_analysis.GetShapeOrDataForValue(relu_op.result(0));
+
+  // Only the ops downstream of abs_op are invalidated.
+  shape_analysis.InvalidateShapeOrDataForOp(abs_op);
+  EXPECT_TRUE(shape_analysis.HasShapeOrDataForValue(data_op.result(0)));
+  EXPECT_FALSE(shape_analysis.HasShapeOrDataForValue(abs_op.result(0)));
+  EXPECT_FALSE(shape_analysis.HasShapeOrDataForValue(relu_op.result(0)));
+
+  // And inferred again when queried.
+  EXPECT_EQ(shape_analysis.GetShapeOrDataForValue(relu_op.result(0)),
+            relu_shape_or_data);
+  EXPECT_TRUE(shape_analysis.HasShapeOrDataForValue(abs_op.result(0)));
+}
@@ -144,4 +144,24 @@ TEST(Simplify, NestSymbolicMulAddUnit) {
   ASSERT_TRUE((simplified_dim_expr.Has<std::string>()));
   ASSERT_TRUE((simplified_dim_expr == sym));
 }
+
+TEST(Simplify, MemoizedResultIsShared) {
+  DimExpr sym0 = MakeSymbolic();
+  DimExpr sym1 = MakeSymbolic();
+  DimExpr sym2 = MakeSymbolic();
+  // Equal DimExprs built apart.
+  DimExpr lhs = BD(BD(sym0, sym1), sym2);
+  DimExpr rhs = BD(BD(sym0, sym1), sym2);
+
+  DimExpr simplified_lhs = SimplifyDimExpr(lhs);
+  DimExpr simplified_rhs = SimplifyDimExpr(rhs);
+  ASSERT_EQ(simplified_lhs, simplified_rhs);
+  ASSERT_TRUE(simplified_lhs.Has<Broadcast<DimExpr>>());
+  ASSERT_EQ(&simplified_lhs.Get<Broadcast<DimExpr>>().operands.vector(),
+            &simplified_rhs.Get<Broadcast<DimExpr>>().operands.vector());
+  // A simplified DimExpr is simplified to itself.
+  DimExpr resimplified = SimplifyDimExpr(simplified_lhs);
+  ASSERT_EQ(&resimplified.Get<Broadcast<DimExpr>>().operands.vector(),
+            &simplified_lhs.Get<Broadcast<DimExpr>>().operands.vector());
+}
 }  // namespace symbol::test